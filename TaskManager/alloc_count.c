@@ -0,0 +1,32 @@
+#include <stdlib.h>
+
+/*
+ * Counts calls into malloc, calloc and realloc for the status line. Only
+ * process_manager links this object: libtaskmgr must never replace the
+ * allocator of the program that embeds it, so overhead.c finds the
+ * counter through a weak reference and reports 0 when it is absent.
+ */
+
+unsigned long overhead_alloc_calls;
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+// Every allocation in the process, libc's own included, passes through these and is counted
+void *malloc(size_t size) {
+    __atomic_add_fetch(&overhead_alloc_calls, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    __atomic_add_fetch(&overhead_alloc_calls, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&overhead_alloc_calls, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+#endif
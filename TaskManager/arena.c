@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+#define ARENA_MIN_SIZE 16384
+
+struct arena_chunk {
+    arena_chunk_t *next;
+    size_t size;
+    _Alignas(ARENA_ALIGN) char data[];
+};
+
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    // Sizes this close to SIZE_MAX would wrap when aligned or given a chunk header
+    if (size > SIZE_MAX - sizeof(arena_chunk_t) - ARENA_ALIGN) return NULL;
+    size = align_up(size ? size : 1);
+    if (arena->base && size <= arena->size - arena->used) {
+        void *p = arena->base + arena->used;
+        arena->used += size;
+        return p;
+    }
+
+    // Served separately this cycle; arena_reset folds the spill into the next size
+    arena_chunk_t *chunk = malloc(sizeof(arena_chunk_t) + size);
+    if (!chunk) return NULL;
+    chunk->next = arena->overflow;
+    chunk->size = size;
+    arena->overflow = chunk;
+    arena->spilled += size;
+    return chunk->data;
+}
+
+void *arena_extend(arena_t *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (ptr && new_size <= old_size) return ptr;
+    if (new_size > SIZE_MAX - sizeof(arena_chunk_t) - ARENA_ALIGN) return NULL;
+    old_size = align_up(old_size);
+    new_size = align_up(new_size);
+    if (ptr && arena->base && (char *)ptr + old_size == arena->base + arena->used &&
+        new_size - old_size <= arena->size - arena->used) {
+        arena->used += new_size - old_size;
+        return ptr;
+    }
+
+    void *p = arena_alloc(arena, new_size);
+    if (p && ptr) memcpy(p, ptr, old_size);
+    return p;
+}
+
+static void free_overflow(arena_t *arena) {
+    while (arena->overflow) {
+        arena_chunk_t *next = arena->overflow->next;
+        free(arena->overflow);
+        arena->overflow = next;
+    }
+}
+
+void arena_reset(arena_t *arena) {
+    if (arena->overflow) {
+        // Everything of the last cycle has to fit next time, with room to spare
+        size_t needed = arena->used + arena->spilled;
+        size_t size = arena->size ? arena->size : ARENA_MIN_SIZE;
+        while (size < needed + needed / 2) size *= 2;
+
+        free_overflow(arena);
+        char *base = malloc(size);
+        if (base) {
+            free(arena->base);
+            arena->base = base;
+            arena->size = size;
+        }
+    }
+    arena->used = 0;
+    arena->spilled = 0;
+}
+
+void arena_free(arena_t *arena) {
+    free_overflow(arena);
+    free(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
@@ -0,0 +1,51 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct arena_chunk arena_chunk_t;
+
+// Bump allocator for the variable-length data of one refresh, recycled with its snapshot
+typedef struct {
+    char *base;
+    size_t size;
+    size_t used;
+    size_t spilled;                 // Bytes that did not fit this cycle and went to overflow chunks
+    arena_chunk_t *overflow;
+} arena_t;
+
+/**
+ * Allocates from the arena. Requests that do not fit go to a separate
+ * chunk; the next arena_reset then grows the arena so they fit in place.
+ * @param arena The arena
+ * @param size Bytes wanted
+ * @return 16-byte aligned memory valid until the next reset, NULL if out of memory
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Grows an allocation. The most recent allocation grows in place when
+ * there is room; anything else is copied to a new allocation. A size no
+ * larger than the current one leaves the allocation as it is.
+ * @param arena The arena
+ * @param ptr The allocation, or NULL
+ * @param old_size Its current size
+ * @param new_size The size wanted
+ * @return The (possibly moved) allocation, NULL if out of memory
+ */
+void *arena_extend(arena_t *arena, void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * Releases everything allocated since the last reset at once. Calls into
+ * malloc only when the last cycle spilled out of the arena.
+ * @param arena The arena
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * Frees the arena's memory
+ * @param arena The arena
+ */
+void arena_free(arena_t *arena);
+
+#endif
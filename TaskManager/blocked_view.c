@@ -0,0 +1,537 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
+#include "blocked_view.h"
+#include "proc_snapshot.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define BLOCKED_REFRESH_MS 1000
+#define BLOCKED_DEFAULT_SLEEP 10    // Seconds an S thread must go without running
+#define MAX_GROUPS 256
+#define GROUP_ROWS 10
+#define MAX_MOUNTS 512
+#define PF_KTHREAD 0x00200000       // Task flag marking kernel threads in /proc/<pid>/stat
+
+// Per-thread state carried between refreshes, sorted by TID
+typedef struct {
+    pid_t tid;
+    unsigned long long starttime;
+    unsigned long long timeslices;  // schedstat run count; unchanged means it never ran
+    char state;
+    double since;                   // When the thread entered its current wait
+} thread_track_t;
+
+typedef struct {
+    pid_t tid;
+    pid_t pid;
+    char state;
+    int kernel_thread;
+    char comm[16];
+    double age;
+    char syscall[24];               // Name, or "#" and a 64-bit syscall number
+    char site[64];
+    char target[160];
+} blocked_thread_t;
+
+typedef struct {
+    char key[160];
+    int count;
+    int uninterruptible;
+    double oldest;
+    char processes[48];
+} blocked_group_t;
+
+typedef struct {
+    unsigned int major, minor;
+    char mountpoint[128];
+    char source[96];
+} mount_entry_t;
+
+typedef struct {
+    long nr;
+    const char *name;
+    int fd_arg;                     // First argument is a file descriptor
+} syscall_entry_t;
+
+#define SYSCALL_FD(name) { SYS_##name, #name, 1 }
+#define SYSCALL(name) { SYS_##name, #name, 0 }
+
+// Syscalls a blocked thread is commonly found in; numbers differ per architecture
+static const syscall_entry_t syscall_table[] = {
+#ifdef __linux__
+    SYSCALL_FD(read), SYSCALL_FD(write), SYSCALL_FD(pread64), SYSCALL_FD(pwrite64),
+    SYSCALL_FD(readv), SYSCALL_FD(writev), SYSCALL_FD(preadv), SYSCALL_FD(pwritev),
+    SYSCALL_FD(fsync), SYSCALL_FD(fdatasync), SYSCALL_FD(sync_file_range), SYSCALL_FD(syncfs),
+    SYSCALL_FD(ftruncate), SYSCALL_FD(fallocate), SYSCALL_FD(flock), SYSCALL_FD(fcntl),
+    SYSCALL_FD(ioctl), SYSCALL_FD(getdents64), SYSCALL_FD(close),
+    SYSCALL_FD(recvfrom), SYSCALL_FD(sendto), SYSCALL_FD(recvmsg), SYSCALL_FD(sendmsg),
+    SYSCALL_FD(accept), SYSCALL_FD(accept4), SYSCALL_FD(connect),
+    SYSCALL_FD(epoll_pwait), SYSCALL_FD(io_uring_enter),
+#ifdef SYS_epoll_wait
+    SYSCALL_FD(epoll_wait),
+#endif
+#ifdef SYS_open
+    SYSCALL(open),
+#endif
+#ifdef SYS_poll
+    SYSCALL(poll),
+#endif
+#ifdef SYS_select
+    SYSCALL(select),
+#endif
+#ifdef SYS_newfstatat
+    SYSCALL(newfstatat),
+#endif
+    SYSCALL(openat), SYSCALL(statx), SYSCALL(unlinkat), SYSCALL(renameat2), SYSCALL(mkdirat),
+    SYSCALL(futex), SYSCALL(nanosleep), SYSCALL(clock_nanosleep), SYSCALL(wait4), SYSCALL(waitid),
+    SYSCALL(ppoll), SYSCALL(pselect6), SYSCALL(io_getevents), SYSCALL(sync), SYSCALL(msync),
+    SYSCALL(mmap), SYSCALL(munmap), SYSCALL(madvise), SYSCALL(execve), SYSCALL(exit_group),
+#endif
+    { -1, NULL, 0 }
+};
+
+static mount_entry_t mounts[MAX_MOUNTS];
+static int mount_count;
+static int stack_denied;
+
+static const syscall_entry_t *find_syscall(long nr) {
+    for (int i = 0; syscall_table[i].name != NULL; i++) {
+        if (syscall_table[i].nr == nr) return &syscall_table[i];
+    }
+    return NULL;
+}
+
+static ssize_t read_task_file(pid_t pid, pid_t tid, const char *name, char *buf, size_t size) {
+    char path[96];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/%s", pid, tid, name);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t len = read(fd, buf, size - 1);
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    if (len < 0) return -1;
+    buf[len] = '\0';
+    return len;
+}
+
+// Maps device numbers to mounts so a blocked file is reported by filesystem, NFS exports included
+static void load_mounts(void) {
+    FILE *fp = fopen("/proc/self/mountinfo", "r");
+    mount_count = 0;
+    if (!fp) return;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), fp) && mount_count < MAX_MOUNTS) {
+        mount_entry_t *m = &mounts[mount_count];
+        char *sep = strstr(line, " - ");
+        if (!sep || sscanf(line, "%*d %*d %u:%u %*s %127s", &m->major, &m->minor, m->mountpoint) != 3) continue;
+        if (sscanf(sep + 3, "%*s %95s", m->source) != 1) continue;
+        mount_count++;
+    }
+    fclose(fp);
+}
+
+static const mount_entry_t *find_mount(unsigned int maj, unsigned int min) {
+    for (int i = 0; i < mount_count; i++) {
+        if (mounts[i].major == maj && mounts[i].minor == min) return &mounts[i];
+    }
+    return NULL;
+}
+
+// Wait site from wchan, or the first non-scheduler frame of the kernel stack
+static void read_wait_site(pid_t pid, pid_t tid, char *site, size_t size) {
+    char buf[2048];
+    if (read_task_file(pid, tid, "wchan", buf, sizeof(buf)) > 0 && strcmp(buf, "0") != 0) {
+        snprintf(site, size, "%.*s", (int)size - 1, buf);
+        return;
+    }
+
+    if (read_task_file(pid, tid, "stack", buf, sizeof(buf)) <= 0) {
+        if (errno == EACCES || errno == EPERM) stack_denied = 1;
+        snprintf(site, size, "?");
+        return;
+    }
+
+    static const char *scheduler[] = {"__switch_to", "__schedule", "schedule", "io_schedule",
+                                      "preempt_schedule", NULL};
+    char *line = buf;
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        char *name = strchr(line, ']');
+        if (name) {
+            name += 2;
+            name[strcspn(name, "+")] = '\0';
+            int skip = 0;
+            for (int i = 0; scheduler[i]; i++) {
+                if (strncmp(name, scheduler[i], strlen(scheduler[i])) == 0) skip = 1;
+            }
+            if (!skip && *name) {
+                snprintf(site, size, "%s", name);
+                return;
+            }
+        }
+        line = next;
+    }
+    snprintf(site, size, "?");
+}
+
+// Classifies the file behind an fd: device nodes by path, regular files by their mount
+static void describe_fd(pid_t pid, int fd, char *target, size_t size) {
+    char path[64], link[PATH_MAX];
+    snprintf(path, sizeof(path), "/proc/%d/fd/%d", pid, fd);
+    ssize_t len = readlink(path, link, sizeof(link) - 1);
+    if (len < 0) {
+        snprintf(target, size, "fd %d", fd);
+        return;
+    }
+    link[len] = '\0';
+
+    if (strncmp(link, "socket:", 7) == 0 || strncmp(link, "pipe:", 5) == 0) {
+        link[strcspn(link, ":")] = '\0';
+        snprintf(target, size, "%.*s", (int)size - 1, link);
+        return;
+    }
+
+    struct stat st;
+    if (link[0] != '/' || stat(path, &st) != 0 || S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode)) {
+        snprintf(target, size, "%.*s", (int)size - 1, link);
+        return;
+    }
+
+    const mount_entry_t *m = find_mount(major(st.st_dev), minor(st.st_dev));
+    if (m) {
+        snprintf(target, size, "%s on %s", m->source, m->mountpoint);
+    } else {
+        snprintf(target, size, "dev %u:%u", major(st.st_dev), minor(st.st_dev));
+    }
+}
+
+static void inspect_thread(blocked_thread_t *t) {
+    read_wait_site(t->pid, t->tid, t->site, sizeof(t->site));
+
+    // Kernel threads report a zeroed syscall line, which would read as read(0)
+    if (t->kernel_thread) {
+        snprintf(t->syscall, sizeof(t->syscall), "-");
+        snprintf(t->target, sizeof(t->target), "(kernel thread)");
+        return;
+    }
+
+    char buf[256];
+    if (read_task_file(t->pid, t->tid, "syscall", buf, sizeof(buf)) <= 0) {
+        snprintf(t->syscall, sizeof(t->syscall), "?");
+        snprintf(t->target, sizeof(t->target), "(syscall unreadable)");
+        return;
+    }
+    if (strncmp(buf, "running", 7) == 0) {
+        snprintf(t->syscall, sizeof(t->syscall), "running");
+        snprintf(t->target, sizeof(t->target), "(running)");
+        return;
+    }
+
+    char *p;
+    long nr = strtol(buf, &p, 10);
+    unsigned long long arg1 = strtoull(p, NULL, 0);
+    if (nr < 0) {
+        // Blocked inside the kernel without a syscall: a page fault or a kernel thread
+        snprintf(t->syscall, sizeof(t->syscall), "-");
+        snprintf(t->target, sizeof(t->target), "(no syscall: fault or kernel thread)");
+        return;
+    }
+
+    const syscall_entry_t *sc = find_syscall(nr);
+    if (sc) {
+        snprintf(t->syscall, sizeof(t->syscall), "%s", sc->name);
+    } else {
+        snprintf(t->syscall, sizeof(t->syscall), "#%ld", nr);
+    }
+
+    if (sc && sc->fd_arg && arg1 < INT_MAX) {
+        describe_fd(t->pid, (int)arg1, t->target, sizeof(t->target));
+    } else {
+        snprintf(t->target, sizeof(t->target), "(no fd: %s)", t->syscall);
+    }
+}
+
+static int compare_track(const void *a, const void *b) {
+    pid_t ta = ((const thread_track_t *)a)->tid, tb = ((const thread_track_t *)b)->tid;
+    return (ta > tb) - (ta < tb);
+}
+
+static int compare_age(const void *a, const void *b) {
+    double aa = ((const blocked_thread_t *)a)->age, ab = ((const blocked_thread_t *)b)->age;
+    return (aa < ab) - (aa > ab);
+}
+
+static int compare_group(const void *a, const void *b) {
+    const blocked_group_t *ga = a, *gb = b;
+    if (ga->count != gb->count) return gb->count - ga->count;
+    return (ga->oldest < gb->oldest) - (ga->oldest > gb->oldest);
+}
+
+typedef struct {
+    thread_track_t *tracks;
+    int count;
+    int capacity;
+} track_list_t;
+
+static thread_track_t *track_append(track_list_t *list) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 1024;
+        thread_track_t *grown = realloc(list->tracks, capacity * sizeof(thread_track_t));
+        if (!grown) return NULL;
+        list->tracks = grown;
+        list->capacity = capacity;
+    }
+    return &list->tracks[list->count++];
+}
+
+/**
+ * Walks every thread in scope, carrying wait ages over from the previous
+ * refresh. Returns the number of threads scanned; blocked ones are
+ * appended to *blocked.
+ */
+static int scan_threads(const track_list_t *previous, track_list_t *current, double now, int sleep_threshold,
+                        blocked_thread_t **blocked, int *blocked_count, int *blocked_capacity) {
+    pid_t *pids;
+    double start = overhead_clock();
+    int pid_count = snapshot_scope_pids(&pids);
+    overhead_record(PHASE_ENUMERATE, start);
+    if (pid_count < 0) return -1;
+
+    int scanned = 0;
+    current->count = 0;
+    *blocked_count = 0;
+    start = overhead_clock();
+    for (int i = 0; i < pid_count; i++) {
+        char task_path[64];
+        snprintf(task_path, sizeof(task_path), "/proc/%d/task", pids[i]);
+        DIR *dir = opendir(task_path);
+        if (!dir) continue;
+
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+            pid_t tid = atoi(entry->d_name);
+            char buf[1024];
+            if (read_task_file(pids[i], tid, "stat", buf, sizeof(buf)) <= 0) continue;
+            scanned++;
+
+            char *open_paren = strchr(buf, '(');
+            char *close_paren = strrchr(buf, ')');
+            if (!open_paren || !close_paren) continue;
+            char state;
+            unsigned int flags = 0;
+            unsigned long long starttime = 0;
+            if (sscanf(close_paren + 2, "%c %*d %*d %*d %*d %*d %u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+                       &state, &flags, &starttime) < 1) {
+                continue;
+            }
+            if (state != 'D' && (state != 'S' || sleep_threshold <= 0)) continue;
+
+            // A thread that ran since the last refresh starts its wait over
+            unsigned long long timeslices = (unsigned long long)-1;
+            char sched[128];
+            if (read_task_file(pids[i], tid, "schedstat", sched, sizeof(sched)) > 0) {
+                sscanf(sched, "%*u %*u %llu", &timeslices);
+            }
+
+            thread_track_t key = {.tid = tid};
+            const thread_track_t *old = previous->count
+                ? bsearch(&key, previous->tracks, previous->count, sizeof(thread_track_t), compare_track)
+                : NULL;
+            thread_track_t *track = track_append(current);
+            if (!track) continue;
+            track->tid = tid;
+            track->state = state;
+            track->starttime = starttime;
+            track->timeslices = timeslices;
+            track->since = old && old->state == state && old->starttime == starttime && old->timeslices == timeslices
+                ? old->since : now;
+
+            double age = now - track->since;
+            if (state == 'S' && age < sleep_threshold) continue;
+
+            if (*blocked_count == *blocked_capacity) {
+                int capacity = *blocked_capacity ? *blocked_capacity * 2 : 256;
+                blocked_thread_t *grown = realloc(*blocked, capacity * sizeof(blocked_thread_t));
+                if (!grown) continue;
+                *blocked = grown;
+                *blocked_capacity = capacity;
+            }
+            blocked_thread_t *t = &(*blocked)[(*blocked_count)++];
+            t->tid = tid;
+            t->pid = pids[i];
+            t->state = state;
+            t->kernel_thread = (flags & PF_KTHREAD) != 0;
+            t->age = age;
+            int comm_len = (int)(close_paren - open_paren - 1);
+            snprintf(t->comm, sizeof(t->comm), "%.*s", comm_len, open_paren + 1);
+            inspect_thread(t);
+        }
+        closedir(dir);
+    }
+    overhead_record(PHASE_READ, start);
+    free(pids);
+
+    start = overhead_clock();
+    qsort(current->tracks, current->count, sizeof(thread_track_t), compare_track);
+    overhead_record(PHASE_SORT, start);
+    return scanned;
+}
+
+// Whole-name match against the comma-separated process list
+static int lists_process(const char *list, const char *comm) {
+    size_t len = strlen(comm);
+    for (const char *p = list; *p; ) {
+        size_t token = strcspn(p, ",");
+        if (token == len && strncmp(p, comm, len) == 0) return 1;
+        p += token;
+        if (*p) p++;
+    }
+    return 0;
+}
+
+static void add_to_group(blocked_group_t *groups, int *group_count, const char *key, const blocked_thread_t *t) {
+    blocked_group_t *g = NULL;
+    for (int i = 0; i < *group_count; i++) {
+        if (strcmp(groups[i].key, key) == 0) {
+            g = &groups[i];
+            break;
+        }
+    }
+    if (!g) {
+        // Past the cap, everything left lands in one overflow bucket
+        if (*group_count == MAX_GROUPS) {
+            g = &groups[MAX_GROUPS - 1];
+            snprintf(g->key, sizeof(g->key), "(other)");
+        } else {
+            g = &groups[(*group_count)++];
+            memset(g, 0, sizeof(*g));
+            snprintf(g->key, sizeof(g->key), "%s", key);
+        }
+    }
+
+    g->count++;
+    if (t->state == 'D') g->uninterruptible++;
+    if (t->age > g->oldest) g->oldest = t->age;
+    if (!lists_process(g->processes, t->comm)) {
+        size_t used = strlen(g->processes);
+        if (used + strlen(t->comm) + 2 < sizeof(g->processes)) {
+            snprintf(g->processes + used, sizeof(g->processes) - used, "%s%s", used ? "," : "", t->comm);
+        } else if (used + 4 < sizeof(g->processes) && strcmp(g->processes + used - 3, "...") != 0) {
+            strcat(g->processes, ",...");
+        }
+    }
+}
+
+static void render_groups(const char *title, blocked_group_t *groups, int group_count) {
+    qsort(groups, group_count, sizeof(blocked_group_t), compare_group);
+    printf("\n%6s %5s %7s  %-44s %s\n", "COUNT", "D", "OLDEST", title, "PROCESSES");
+    for (int i = 0; i < group_count && i < GROUP_ROWS; i++) {
+        printf("%6d %5d %6.0fs  %-44.44s %s\n", groups[i].count, groups[i].uninterruptible,
+               groups[i].oldest, groups[i].key, groups[i].processes);
+    }
+    if (group_count > GROUP_ROWS) printf("  ... %d more\n", group_count - GROUP_ROWS);
+}
+
+static void render_blocked(blocked_thread_t *blocked, int count, int scanned, int sleep_threshold) {
+    static blocked_group_t sites[MAX_GROUPS], targets[MAX_GROUPS];
+    int site_count = 0, target_count = 0, uninterruptible = 0;
+
+    for (int i = 0; i < count; i++) {
+        add_to_group(sites, &site_count, blocked[i].site, &blocked[i]);
+        add_to_group(targets, &target_count, blocked[i].target, &blocked[i]);
+        if (blocked[i].state == 'D') uninterruptible++;
+    }
+
+    printf("\033[2J\033[H");
+    printf("===== Blocked Tasks =====\n");
+    char scope[600];
+    snapshot_describe_scope(scope, sizeof(scope));
+    printf("Scope: %s | %d threads scanned\n", scope, scanned);
+    printf("%d blocked: %d in D", count, uninterruptible);
+    if (sleep_threshold > 0) {
+        printf(", %d in S without running for %ds or more", count - uninterruptible, sleep_threshold);
+    }
+    printf(" (ages count from when this view first saw the wait)\n");
+    if (stack_denied) printf("Kernel stacks unreadable (needs CAP_SYS_ADMIN); wait sites rely on wchan alone\n");
+
+    if (count == 0) {
+        printf("\nNo blocked threads.\n");
+        return;
+    }
+
+    render_groups("WAIT SITE", sites, site_count);
+    render_groups("FILE/DEVICE", targets, target_count);
+
+    int rows = terminal_rows() - 2 * GROUP_ROWS - 16;
+    if (rows < 5) rows = 5;
+    qsort(blocked, count, sizeof(blocked_thread_t), compare_age);
+    printf("\n%8s %8s %c %6s %-15s %-14s %-24s %s\n", "TID", "PID", 'S', "AGE", "COMMAND", "SYSCALL", "WAIT SITE", "FILE/DEVICE");
+    for (int i = 0; i < count && i < rows; i++) {
+        const blocked_thread_t *t = &blocked[i];
+        printf("%8d %8d %c %5.0fs %-15.15s %-14.14s %-24.24s %s\n", t->tid, t->pid, t->state, t->age,
+               t->comm, t->syscall, t->site, t->target);
+    }
+}
+
+void show_blocked_tasks(void) {
+    if (!snapshot_supported()) {
+        printf("Blocked task analysis needs /proc (Linux only)\n");
+        return;
+    }
+
+    char input[32];
+    int sleep_threshold = BLOCKED_DEFAULT_SLEEP;
+    printf("Also report S threads idle for at least N seconds (default %d, 0 for D only): ", BLOCKED_DEFAULT_SLEEP);
+    if (fgets(input, sizeof(input), stdin) != NULL && input[0] != '\n') {
+        sleep_threshold = atoi(input);
+    }
+
+    load_mounts();
+    stack_denied = 0;
+
+    track_list_t tracks[2] = {{0}, {0}};
+    int cur = 0;
+    blocked_thread_t *blocked = NULL;
+    int blocked_count = 0, blocked_capacity = 0;
+
+    overhead_begin(BLOCKED_REFRESH_MS);
+    int interval = BLOCKED_REFRESH_MS;
+    do {
+        int scanned = scan_threads(&tracks[cur ^ 1], &tracks[cur], overhead_clock(), sleep_threshold,
+                                   &blocked, &blocked_count, &blocked_capacity);
+        if (scanned < 0) {
+            printf("Failed to list processes\n");
+            break;
+        }
+        cur ^= 1;
+
+        double start = overhead_clock();
+        render_blocked(blocked, blocked_count, scanned, sleep_threshold);
+        overhead_record(PHASE_RENDER, start);
+        interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to return\n");
+        fflush(stdout);
+    } while (!wait_for_refresh(interval));
+
+    free(tracks[0].tracks);
+    free(tracks[1].tracks);
+    free(blocked);
+}
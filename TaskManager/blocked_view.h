@@ -0,0 +1,12 @@
+#ifndef BLOCKED_VIEW_H
+#define BLOCKED_VIEW_H
+
+/**
+ * Live analyser for threads in uninterruptible sleep (D) or stuck in S.
+ * Reads wchan, syscall and, when permitted, the kernel stack of each
+ * blocked thread and groups them by wait site and by the file or device
+ * they are blocked on.
+ */
+void show_blocked_tasks(void);
+
+#endif
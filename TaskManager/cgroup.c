@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include "cgroup.h"
+
+#define CGROUP_READ_SIZE 4096      // Per level of the walk, for cgroup.procs and the directory listing
+
+const char *cgroup_root(void) {
+    if (access("/sys/fs/cgroup/cgroup.controllers", R_OK) != 0 &&
+        access("/sys/fs/cgroup/unified/cgroup.controllers", R_OK) == 0) {
+        return "/sys/fs/cgroup/unified";
+    }
+    return "/sys/fs/cgroup";
+}
+
+int cgroup_v2_available(void) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/cgroup.controllers", cgroup_root());
+    return access(path, R_OK) == 0;
+}
+
+// What getdents64 fills a directory buffer with
+typedef struct {
+    uint64_t ino;
+    int64_t off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[];
+} cgroup_dirent_t;
+
+// Passes the PIDs of <dir>/cgroup.procs to add; -1 if there is no such file, 0 if add stopped the walk
+static int read_procs(const char *dir, cgroup_pid_fn add, void *ctx, int *count) {
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/cgroup.procs", dir) >= (int)sizeof(path)) return -1;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    // A PID can straddle two reads, so the digits carry over
+    char buf[CGROUP_READ_SIZE];
+    pid_t pid = 0;
+    int digits = 0, result = 1;
+    ssize_t len;
+    while (result > 0 && (len = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < len && result > 0; i++) {
+            if (isdigit((unsigned char)buf[i])) {
+                pid = pid * 10 + (buf[i] - '0');
+                digits = 1;
+                continue;
+            }
+            if (!digits) continue;
+            if (add(pid, ctx)) (*count)++;
+            else result = 0;
+            pid = 0;
+            digits = 0;
+        }
+    }
+    if (result > 0 && digits) {
+        if (add(pid, ctx)) (*count)++;
+        else result = 0;
+    }
+    close(fd);
+    return result;
+}
+
+// Reads <dir>/cgroup.procs, then recurses into child cgroups; each level lists its own directory
+static int walk_cgroup(const char *dir, int recursive, cgroup_pid_fn add, void *ctx, int *count) {
+    int result = read_procs(dir, add, ctx, count);
+    if (result <= 0 || !recursive) return result;
+
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return 1;
+    uint64_t entries[CGROUP_READ_SIZE / sizeof(uint64_t)];     // Keeps the entries aligned
+    char path[PATH_MAX];
+    long len;
+    while (result > 0 && (len = syscall(SYS_getdents64, fd, entries, sizeof(entries))) > 0) {
+        for (long offset = 0; offset < len && result > 0;) {
+            const cgroup_dirent_t *entry = (const cgroup_dirent_t *)((const char *)entries + offset);
+            offset += entry->reclen;
+            if (entry->type != DT_DIR || entry->name[0] == '.') continue;
+            if (snprintf(path, sizeof(path), "%s/%s", dir, entry->name) >= (int)sizeof(path)) continue;
+            // A child removed since the listing has no cgroup.procs and is skipped
+            if (walk_cgroup(path, 1, add, ctx, count) == 0) result = 0;
+        }
+    }
+    close(fd);
+    return result;
+}
+
+int cgroup_for_each_pid(const char *path, int recursive, cgroup_pid_fn add, void *ctx) {
+    char dir[PATH_MAX];
+    while (*path == '/') path++;
+    snprintf(dir, sizeof(dir), "%s%s%s", cgroup_root(), *path ? "/" : "", path);
+
+    int count = 0;
+    if (walk_cgroup(dir, recursive, add, ctx, &count) < 0) return -1;
+    return count;
+}
+
+// PIDs gathered by cgroup_collect_pids on the heap
+typedef struct {
+    pid_t *pids;
+    int count;
+    int capacity;
+} heap_pids_t;
+
+static int append_heap_pid(pid_t pid, void *ctx) {
+    heap_pids_t *list = ctx;
+    if (list->count == list->capacity) {
+        int grown_capacity = list->capacity ? list->capacity * 2 : 256;
+        pid_t *grown = realloc(list->pids, grown_capacity * sizeof(pid_t));
+        if (!grown) return 0;
+        list->pids = grown;
+        list->capacity = grown_capacity;
+    }
+    list->pids[list->count++] = pid;
+    return 1;
+}
+
+int cgroup_collect_pids(const char *path, int recursive, pid_t **pids) {
+    heap_pids_t list = { NULL, 0, 0 };
+    int count = cgroup_for_each_pid(path, recursive, append_heap_pid, &list);
+    if (count < 0) {
+        free(list.pids);
+        list.pids = NULL;
+    }
+    *pids = list.pids;
+    return count;
+}
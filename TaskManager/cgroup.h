@@ -0,0 +1,42 @@
+#ifndef CGROUP_H
+#define CGROUP_H
+
+#include <sys/types.h>
+
+/**
+ * Checks whether a unified (v2) cgroup hierarchy is mounted, either at
+ * /sys/fs/cgroup or at /sys/fs/cgroup/unified on hybrid hosts
+ * @return 1 if cgroup v2 is available, 0 otherwise
+ */
+int cgroup_v2_available(void);
+
+/**
+ * Returns the mount point of the unified cgroup hierarchy
+ */
+const char *cgroup_root(void);
+
+// Receives one member PID; returning 0 stops the walk
+typedef int (*cgroup_pid_fn)(pid_t pid, void *ctx);
+
+/**
+ * Passes the member PIDs of a cgroup to a callback. Files are read with
+ * read and directories listed with getdents64 into stack buffers, so the
+ * walk itself allocates nothing.
+ * @param path Cgroup path relative to cgroup_root() ("" or "/" for the root)
+ * @param recursive 1 to include every descendant cgroup
+ * @param add Called for every PID
+ * @param ctx Passed to add
+ * @return Number of PIDs add accepted, -1 if the cgroup does not exist
+ */
+int cgroup_for_each_pid(const char *path, int recursive, cgroup_pid_fn add, void *ctx);
+
+/**
+ * Collects the member PIDs of a cgroup from cgroup.procs
+ * @param path Cgroup path relative to cgroup_root() ("" or "/" for the root)
+ * @param recursive 1 to include every descendant cgroup
+ * @param pids Receives a malloc'ed array the caller must free; NULL when the cgroup does not exist
+ * @return Number of PIDs, -1 if the cgroup does not exist
+ */
+int cgroup_collect_pids(const char *path, int recursive, pid_t **pids);
+
+#endif
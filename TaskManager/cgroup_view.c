@@ -0,0 +1,483 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include "cgroup_view.h"
+#include "cgroup.h"
+#include "proc_snapshot.h"
+#include "process_manager.h"
+#include "overhead.h"
+
+static int read_small_file(const char *path, char *buf, size_t size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t len = read(fd, buf, size - 1);
+    close(fd);
+    if (len < 0) return -1;
+    buf[len] = '\0';
+    return (int)len;
+}
+
+#ifdef __linux__
+#include <sys/inotify.h>
+
+#define MAX_CGROUPS 4096
+#define CGROUP_PATH_MAX 512
+#define CGROUP_REFRESH_MS 2000
+#define CGROUP_MAX_ROWS 50
+
+typedef struct {
+    unsigned long long cpu_usage_usec;
+    unsigned long long cpu_user_usec;
+    unsigned long long cpu_system_usec;
+    unsigned long long throttled_usec;
+    unsigned long long memory_current;
+    unsigned long long memory_anon;
+    unsigned long long memory_file;
+    unsigned long long io_rbytes;
+    unsigned long long io_wbytes;
+    float cpu_some;                 // Pressure avg10 percentages
+    float memory_some;
+    float memory_full;
+    float io_some;
+    float io_full;
+} cgroup_stats_t;
+
+typedef struct {
+    char path[CGROUP_PATH_MAX];     // Relative to cgroup_root(), "" for the root
+    int depth;
+    int in_use;
+    int dir_wd;                     // Watches child mkdir/rmdir
+    int events_wd;                  // Watches cgroup.events for populated changes
+    int populated;
+    int has_previous;
+    double sample_time;
+    double previous_time;
+    cgroup_stats_t current;
+    cgroup_stats_t previous;
+} cgroup_node_t;
+
+typedef struct {
+    cgroup_node_t *nodes;           // MAX_CGROUPS slots
+    int node_count;                 // Highest used slot + 1
+    int inotify_fd;
+    int order_dirty;
+    int order[MAX_CGROUPS];         // Display order (tree order)
+    int order_count;
+} cgroup_tree_t;
+
+static double monotonic_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void node_file(const cgroup_node_t *node, const char *file, char *out, size_t size) {
+    snprintf(out, size, "%s%s%s/%s", cgroup_root(), node->path[0] ? "/" : "", node->path, file);
+}
+
+static int read_populated(const cgroup_node_t *node) {
+    char path[PATH_MAX], buf[256];
+    node_file(node, "cgroup.events", path, sizeof(path));
+    if (read_small_file(path, buf, sizeof(buf)) < 0) return 0;
+    char *p = strstr(buf, "populated ");
+    return p ? atoi(p + 10) : 0;
+}
+
+// Reads "key value" lines and stores the values of the requested keys
+static void read_keyed_file(const cgroup_node_t *node, const char *file,
+                            const char **keys, unsigned long long **values, int key_count) {
+    char path[PATH_MAX], buf[8192];
+    node_file(node, file, path, sizeof(path));
+    if (read_small_file(path, buf, sizeof(buf)) < 0) return;
+
+    for (char *line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+        for (int k = 0; k < key_count; k++) {
+            size_t len = strlen(keys[k]);
+            if (strncmp(line, keys[k], len) == 0 && line[len] == ' ') {
+                *values[k] = strtoull(line + len + 1, NULL, 10);
+                break;
+            }
+        }
+    }
+}
+
+static void read_pressure(const cgroup_node_t *node, const char *file, float *some, float *full) {
+    char path[PATH_MAX], buf[512];
+    node_file(node, file, path, sizeof(path));
+    *some = 0;
+    if (full) *full = 0;
+    if (read_small_file(path, buf, sizeof(buf)) < 0) return;
+
+    char *p = strstr(buf, "some avg10=");
+    if (p) *some = strtof(p + 11, NULL);
+    p = strstr(buf, "full avg10=");
+    if (p && full) *full = strtof(p + 11, NULL);
+}
+
+// io.stat has one line per device: "8:0 rbytes=... wbytes=... rios=... wios=..."
+static void read_io_stat(const cgroup_node_t *node, cgroup_stats_t *stats) {
+    char path[PATH_MAX], buf[8192];
+    node_file(node, "io.stat", path, sizeof(path));
+    stats->io_rbytes = 0;
+    stats->io_wbytes = 0;
+    if (read_small_file(path, buf, sizeof(buf)) < 0) return;
+
+    for (char *p = buf; (p = strstr(p, "bytes=")) != NULL; p += 6) {
+        if (p > buf && p[-1] == 'r') stats->io_rbytes += strtoull(p + 6, NULL, 10);
+        else if (p > buf && p[-1] == 'w') stats->io_wbytes += strtoull(p + 6, NULL, 10);
+    }
+}
+
+static void read_node_stats(cgroup_node_t *node) {
+    cgroup_stats_t *s = &node->current;
+    char path[PATH_MAX], buf[64];
+
+    node->previous = node->current;
+    node->previous_time = node->sample_time;
+    node->has_previous = node->sample_time > 0;
+    node->sample_time = monotonic_now();
+
+    const char *cpu_keys[] = {"usage_usec", "user_usec", "system_usec", "throttled_usec"};
+    unsigned long long *cpu_values[] = {&s->cpu_usage_usec, &s->cpu_user_usec,
+                                        &s->cpu_system_usec, &s->throttled_usec};
+    read_keyed_file(node, "cpu.stat", cpu_keys, cpu_values, 4);
+
+    const char *mem_keys[] = {"anon", "file"};
+    unsigned long long *mem_values[] = {&s->memory_anon, &s->memory_file};
+    read_keyed_file(node, "memory.stat", mem_keys, mem_values, 2);
+
+    node_file(node, "memory.current", path, sizeof(path));
+    s->memory_current = read_small_file(path, buf, sizeof(buf)) > 0 ? strtoull(buf, NULL, 10) : 0;
+
+    read_io_stat(node, s);
+    read_pressure(node, "cpu.pressure", &s->cpu_some, NULL);
+    read_pressure(node, "memory.pressure", &s->memory_some, &s->memory_full);
+    read_pressure(node, "io.pressure", &s->io_some, &s->io_full);
+}
+
+static int find_node_by_path(cgroup_tree_t *tree, const char *path) {
+    for (int i = 0; i < tree->node_count; i++) {
+        if (tree->nodes[i].in_use && strcmp(tree->nodes[i].path, path) == 0) return i;
+    }
+    return -1;
+}
+
+// Joins a cgroup path and a child name; a path that does not fit is skipped rather than cut short
+static int child_path(char *child, size_t size, const char *path, const char *name) {
+    int n = snprintf(child, size, "%s%s%s", path, path[0] ? "/" : "", name);
+    return n >= 0 && (size_t)n < size;
+}
+
+// Adds a cgroup and, walking its directory once, all of its descendants.
+// Known cgroups are kept as they are, but their directories are still walked.
+static void add_cgroup(cgroup_tree_t *tree, const char *path, int depth) {
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s%s%s", cgroup_root(), path[0] ? "/" : "", path);
+
+    if (find_node_by_path(tree, path) < 0) {
+        int slot = -1;
+        for (int i = 0; i < MAX_CGROUPS; i++) {
+            if (!tree->nodes[i].in_use) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) return;
+
+        cgroup_node_t *node = &tree->nodes[slot];
+        memset(node, 0, sizeof(*node));
+        snprintf(node->path, sizeof(node->path), "%s", path);
+        node->depth = depth;
+        node->in_use = 1;
+        if (slot >= tree->node_count) tree->node_count = slot + 1;
+        tree->order_dirty = 1;
+
+        char events[PATH_MAX];
+        node_file(node, "cgroup.events", events, sizeof(events));
+        node->dir_wd = inotify_add_watch(tree->inotify_fd, dir, IN_CREATE | IN_DELETE | IN_ONLYDIR);
+        node->events_wd = inotify_add_watch(tree->inotify_fd, events, IN_MODIFY);
+        // The root cgroup has no cgroup.events and is always populated
+        node->populated = path[0] ? read_populated(node) : 1;
+    }
+
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+        char child[CGROUP_PATH_MAX];
+        if (child_path(child, sizeof(child), path, entry->d_name)) add_cgroup(tree, child, depth + 1);
+    }
+    closedir(d);
+}
+
+// Removes a cgroup and every node below it
+static void remove_cgroup(cgroup_tree_t *tree, const char *path) {
+    size_t len = strlen(path);
+    for (int i = 0; i < tree->node_count; i++) {
+        cgroup_node_t *node = &tree->nodes[i];
+        if (!node->in_use) continue;
+        if (strcmp(node->path, path) == 0 ||
+            (strncmp(node->path, path, len) == 0 && node->path[len] == '/')) {
+            if (node->dir_wd >= 0) inotify_rm_watch(tree->inotify_fd, node->dir_wd);
+            if (node->events_wd >= 0) inotify_rm_watch(tree->inotify_fd, node->events_wd);
+            node->in_use = 0;
+            tree->order_dirty = 1;
+        }
+    }
+}
+
+// The kernel dropped events; brings the watch set back in line with the hierarchy
+static void rescan_cgroups(cgroup_tree_t *tree) {
+    for (int i = 0; i < tree->node_count; i++) {
+        cgroup_node_t *node = &tree->nodes[i];
+        if (!node->in_use || !node->path[0]) continue;
+
+        char dir[PATH_MAX];
+        snprintf(dir, sizeof(dir), "%s/%s", cgroup_root(), node->path);
+        if (access(dir, F_OK) != 0) remove_cgroup(tree, node->path);
+        else node->populated = read_populated(node);
+    }
+    add_cgroup(tree, "", 0);
+}
+
+// Applies queued inotify events instead of rescanning the hierarchy
+static void process_cgroup_events(cgroup_tree_t *tree) {
+    char buf[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    int overflowed = 0;
+
+    while ((len = read(tree->inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                overflowed = 1;
+                continue;
+            }
+
+            for (int i = 0; i < tree->node_count; i++) {
+                cgroup_node_t *node = &tree->nodes[i];
+                if (!node->in_use) continue;
+
+                if (ev->wd == node->events_wd && (ev->mask & IN_MODIFY)) {
+                    node->populated = read_populated(node);
+                    break;
+                }
+                if (ev->wd == node->dir_wd && (ev->mask & IN_ISDIR) && ev->len > 0) {
+                    char child[CGROUP_PATH_MAX];
+                    if (!child_path(child, sizeof(child), node->path, ev->name)) break;
+                    if (ev->mask & IN_CREATE) add_cgroup(tree, child, node->depth + 1);
+                    if (ev->mask & IN_DELETE) remove_cgroup(tree, child);
+                    break;
+                }
+            }
+        }
+    }
+    if (overflowed) rescan_cgroups(tree);
+}
+
+// Orders paths so that every cgroup directly precedes its children
+static int compare_tree_paths(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    unsigned char ca = (*a == '/') ? 1 : (unsigned char)*a;
+    unsigned char cb = (*b == '/') ? 1 : (unsigned char)*b;
+    return (ca > cb) - (ca < cb);
+}
+
+static cgroup_tree_t *sort_tree;
+
+static int compare_order(const void *a, const void *b) {
+    return compare_tree_paths(sort_tree->nodes[*(const int *)a].path,
+                              sort_tree->nodes[*(const int *)b].path);
+}
+
+static void rebuild_order(cgroup_tree_t *tree) {
+    tree->order_count = 0;
+    for (int i = 0; i < tree->node_count; i++) {
+        if (tree->nodes[i].in_use) tree->order[tree->order_count++] = i;
+    }
+    sort_tree = tree;
+    qsort(tree->order, tree->order_count, sizeof(int), compare_order);
+    tree->order_dirty = 0;
+}
+
+static void format_bytes(double bytes, char *out, size_t size) {
+    const char *units[] = {"B", "K", "M", "G", "T"};
+    int unit = 0;
+    while (bytes >= 1024 && unit < 4) {
+        bytes /= 1024;
+        unit++;
+    }
+    snprintf(out, size, "%.1f%s", bytes, units[unit]);
+}
+
+static void render_cgroups(cgroup_tree_t *tree, int *row_map, int *row_count) {
+    int populated = 0;
+    for (int i = 0; i < tree->order_count; i++) {
+        if (tree->nodes[tree->order[i]].populated) populated++;
+    }
+
+    printf("\033[2J\033[H");
+    printf("===== cgroup v2 Overview (%d cgroups, %d populated) =====\n",
+           tree->order_count, populated);
+    printf("%-4s %-40s %7s %9s %9s %9s %9s %17s\n",
+           "#", "CGROUP", "CPU%", "MEMORY", "MEM/s", "READ/s", "WRITE/s", "PSI cpu/mem/io");
+    printf("--------------------------------------------------------------------------------------------------------------\n");
+
+    *row_count = 0;
+    int hidden = 0;
+    for (int i = 0; i < tree->order_count; i++) {
+        cgroup_node_t *node = &tree->nodes[tree->order[i]];
+        if (!node->populated) continue;
+        if (*row_count >= CGROUP_MAX_ROWS) {
+            hidden++;
+            continue;
+        }
+
+        double elapsed = node->sample_time - node->previous_time;
+        double cpu = 0, mem_rate = 0, read_rate = 0, write_rate = 0;
+        if (node->has_previous && elapsed > 0) {
+            cpu = (node->current.cpu_usage_usec - node->previous.cpu_usage_usec) / 1e4 / elapsed;
+            mem_rate = ((double)node->current.memory_current - node->previous.memory_current) / elapsed;
+            read_rate = (node->current.io_rbytes - node->previous.io_rbytes) / elapsed;
+            write_rate = (node->current.io_wbytes - node->previous.io_wbytes) / elapsed;
+        }
+
+        const char *name = strrchr(node->path, '/');
+        name = name ? name + 1 : (node->path[0] ? node->path : "/");
+        char label[64], mem[16], mem_s[16], rd[16], wr[16], psi[32];
+        // The column is 40 wide; deeper indents and longer names are cut there anyway
+        int indent = node->depth < 10 ? node->depth * 2 : 20;
+        snprintf(label, sizeof(label), "%*s%.40s", indent, "", name);
+        format_bytes(node->current.memory_current, mem, sizeof(mem));
+        format_bytes(mem_rate < 0 ? -mem_rate : mem_rate, mem_s + 1, sizeof(mem_s) - 1);
+        mem_s[0] = mem_rate < 0 ? '-' : '+';
+        format_bytes(read_rate, rd, sizeof(rd));
+        format_bytes(write_rate, wr, sizeof(wr));
+        snprintf(psi, sizeof(psi), "%.1f/%.1f/%.1f", node->current.cpu_some,
+                 node->current.memory_some, node->current.io_some);
+
+        row_map[*row_count] = tree->order[i];
+        printf("%-4d %-40.40s %7.1f %9s %9s %9s %9s %17s\n",
+               ++(*row_count), label, cpu, mem, mem_s, rd, wr, psi);
+    }
+    if (hidden > 0) {
+        printf("... %d more populated cgroups not shown\n", hidden);
+    }
+}
+
+// Lists the member processes of one cgroup using the process snapshot
+static void show_cgroup_members(const char *path) {
+    pid_t *pids = NULL;
+    int count = cgroup_collect_pids(path, 1, &pids);
+    if (count <= 0) {
+        printf("No processes in cgroup %s\n", path[0] ? path : "/");
+        free(pids);
+        return;
+    }
+
+    // Two snapshots half a second apart give CPU rates for the members
+    ProcessSnapshot first = {0}, second = {0};
+    snapshot_take(&first, NULL);
+    usleep(500000);
+    snapshot_take(&second, &first);
+
+    printf("\n===== Processes in %s (%d) =====\n", path[0] ? path : "/", count);
+    snapshot_print_header();
+    for (int i = 0; i < count; i++) {
+        const ProcessSample *s = snapshot_find(&second, pids[i]);
+        if (s) snapshot_print_row(s);
+    }
+
+    snapshot_free(&first);
+    snapshot_free(&second);
+    free(pids);
+}
+
+void show_cgroup_view(void) {
+    if (!cgroup_v2_available()) {
+        printf("No cgroup v2 hierarchy is mounted (pure cgroup v1 hosts are not supported)\n");
+        return;
+    }
+
+    cgroup_tree_t *tree = calloc(1, sizeof(cgroup_tree_t));
+    if (tree) tree->nodes = calloc(MAX_CGROUPS, sizeof(cgroup_node_t));
+    if (!tree || !tree->nodes) {
+        perror("Out of memory");
+        free(tree);
+        return;
+    }
+    tree->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (tree->inotify_fd < 0) {
+        perror("inotify_init1 failed");
+        free(tree->nodes);
+        free(tree);
+        return;
+    }
+
+    add_cgroup(tree, "", 0);
+    int row_map[CGROUP_MAX_ROWS];
+    int row_count = 0;
+
+    overhead_begin(CGROUP_REFRESH_MS);
+    while (1) {
+        double start = overhead_clock();
+        process_cgroup_events(tree);
+        if (tree->order_dirty) rebuild_order(tree);
+        overhead_record(PHASE_ENUMERATE, start);
+
+        start = overhead_clock();
+        for (int i = 0; i < tree->order_count; i++) {
+            cgroup_node_t *node = &tree->nodes[tree->order[i]];
+            if (node->populated) read_node_stats(node);
+        }
+        overhead_record(PHASE_READ, start);
+
+        start = overhead_clock();
+        render_cgroups(tree, row_map, &row_count);
+        overhead_record(PHASE_RENDER, start);
+        int interval = overhead_end_frame();
+        overhead_print_status();
+        printf("\nPress Enter to drill into a cgroup or leave.\n");
+        fflush(stdout);
+
+        if (!wait_for_refresh(interval)) continue;
+
+        char input[32];
+        printf("Cgroup # to list member processes (blank to leave): ");
+        if (fgets(input, sizeof(input), stdin) == NULL || atoi(input) <= 0) break;
+        int row = atoi(input);
+        if (row > row_count) {
+            printf("Invalid cgroup number\n");
+        } else {
+            show_cgroup_members(tree->nodes[row_map[row - 1]].path);
+        }
+        printf("\nPress Enter to return to the cgroup view...");
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF);
+        // The drill-down is not part of the refresh loop's own cost
+        overhead_begin(CGROUP_REFRESH_MS);
+    }
+
+    close(tree->inotify_fd);
+    free(tree->nodes);
+    free(tree);
+}
+
+#else
+
+void show_cgroup_view(void) {
+    printf("The cgroup view requires Linux cgroup v2\n");
+}
+
+#endif
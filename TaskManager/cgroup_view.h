@@ -0,0 +1,10 @@
+#ifndef CGROUP_VIEW_H
+#define CGROUP_VIEW_H
+
+/**
+ * Live view of every cgroup with CPU, memory, I/O and pressure rates.
+ * Pressing Enter offers a drill-down into the member processes.
+ */
+void show_cgroup_view(void);
+
+#endif
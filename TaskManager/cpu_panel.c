@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "cpu_panel.h"
+#include "overhead.h"
+
+#define STAT_BUFFER_INITIAL 16384
+#define HEAT_STRIP_WIDTH 64
+#define BAR_WIDTH 20
+
+// Structure of arrays: one contiguous array per counter so the delta loops
+// run over unit-stride data the compiler can vectorise across cores
+struct cpu_panel {
+    int capacity;                               // Cores the arrays can hold
+    int count;                                  // Highest CPU number seen + 1
+    int current;                                // Which tick buffer holds the newest sample
+    uint64_t *ticks[2][CPU_FIELDS];
+    float *percent[CPU_FIELDS];                 // Share of the last interval per core
+    float *busy;                                // 100 - idle - iowait
+    float *scale;                               // 100 / ticks elapsed, scratch
+    unsigned char *online;
+    uint64_t total_ticks[2][CPU_FIELDS];        // The aggregate "cpu" line
+    float total_percent[CPU_FIELDS];
+    double load[3];
+    int running;
+    int blocked;
+    int threads;
+    char *buf;
+    size_t buf_size;
+};
+
+static void *alloc_array(int capacity, size_t elem_size) {
+    void *array = NULL;
+    if (posix_memalign(&array, 64, capacity * elem_size) != 0) return NULL;
+    memset(array, 0, capacity * elem_size);
+    return array;
+}
+
+static void free_arrays(cpu_panel_t *panel) {
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        free(panel->ticks[0][f]);
+        free(panel->ticks[1][f]);
+        free(panel->percent[f]);
+    }
+    free(panel->busy);
+    free(panel->scale);
+    free(panel->online);
+}
+
+// Reallocates every array for a new capacity, keeping the counters read so far
+static int resize_panel(cpu_panel_t *panel, int capacity) {
+    cpu_panel_t grown = *panel;
+    int ok = 1;
+
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        grown.ticks[0][f] = alloc_array(capacity, sizeof(uint64_t));
+        grown.ticks[1][f] = alloc_array(capacity, sizeof(uint64_t));
+        grown.percent[f] = alloc_array(capacity, sizeof(float));
+        ok &= grown.ticks[0][f] && grown.ticks[1][f] && grown.percent[f];
+    }
+    grown.busy = alloc_array(capacity, sizeof(float));
+    grown.scale = alloc_array(capacity, sizeof(float));
+    grown.online = alloc_array(capacity, 1);
+    ok &= grown.busy && grown.scale && grown.online;
+
+    if (!ok) {
+        free_arrays(&grown);
+        return 0;
+    }
+
+    if (panel->capacity > 0) {
+        for (int f = 0; f < CPU_FIELDS; f++) {
+            memcpy(grown.ticks[0][f], panel->ticks[0][f], panel->capacity * sizeof(uint64_t));
+            memcpy(grown.ticks[1][f], panel->ticks[1][f], panel->capacity * sizeof(uint64_t));
+        }
+        memcpy(grown.online, panel->online, panel->capacity);
+        free_arrays(panel);
+    }
+    grown.capacity = capacity;
+    *panel = grown;
+    return 1;
+}
+
+cpu_panel_t *cpu_panel_create(void) {
+    cpu_panel_t *panel = calloc(1, sizeof(cpu_panel_t));
+    if (!panel) return NULL;
+
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    panel->buf_size = STAT_BUFFER_INITIAL;
+    panel->buf = malloc(panel->buf_size);
+    if (!panel->buf || !resize_panel(panel, configured > 0 ? (int)configured : 1)) {
+        cpu_panel_destroy(panel);
+        return NULL;
+    }
+    return panel;
+}
+
+void cpu_panel_destroy(cpu_panel_t *panel) {
+    if (!panel) return;
+    free_arrays(panel);
+    free(panel->buf);
+    free(panel);
+}
+
+// Reads a whole /proc file with plain read() calls, growing the buffer only when it fills up
+static ssize_t read_proc_file(cpu_panel_t *panel, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    size_t len = 0;
+    while (1) {
+        if (len + 1 >= panel->buf_size) {
+            char *grown = realloc(panel->buf, panel->buf_size * 2);
+            if (!grown) break;
+            panel->buf = grown;
+            panel->buf_size *= 2;
+        }
+        ssize_t n = read(fd, panel->buf + len, panel->buf_size - len - 1);
+        if (n <= 0) break;
+        len += n;
+    }
+    close(fd);
+    panel->buf[len] = '\0';
+    return len;
+}
+
+static char *parse_counters(char *p, uint64_t *const *fields, int index) {
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        fields[f][index] = strtoull(p, &p, 10);
+    }
+    return p;
+}
+
+static void parse_stat(cpu_panel_t *panel) {
+    uint64_t **ticks = panel->ticks[panel->current];
+    char *p = panel->buf;
+    memset(panel->online, 0, panel->capacity);
+    panel->count = 0;
+
+    while (*p) {
+        char *line_end = strchr(p, '\n');
+        if (strncmp(p, "cpu", 3) == 0) {
+            if (p[3] == ' ') {
+                uint64_t *aggregate[CPU_FIELDS];
+                for (int f = 0; f < CPU_FIELDS; f++) aggregate[f] = &panel->total_ticks[panel->current][f];
+                parse_counters(p + 4, aggregate, 0);
+            } else {
+                char *end;
+                int cpu = (int)strtol(p + 3, &end, 10);
+                if (cpu >= panel->capacity && !resize_panel(panel, cpu + 1 > panel->capacity * 2 ? cpu + 1 : panel->capacity * 2)) {
+                    break;
+                }
+                ticks = panel->ticks[panel->current];
+                parse_counters(end, ticks, cpu);
+                panel->online[cpu] = 1;
+                if (cpu + 1 > panel->count) panel->count = cpu + 1;
+            }
+        } else if (strncmp(p, "procs_running ", 14) == 0) {
+            panel->running = atoi(p + 14);
+        } else if (strncmp(p, "procs_blocked ", 14) == 0) {
+            panel->blocked = atoi(p + 14);
+        }
+        // The intr line can be tens of kilobytes; jump straight past it
+        if (!line_end) break;
+        p = line_end + 1;
+    }
+}
+
+static void compute_deltas(cpu_panel_t *panel) {
+    const int n = panel->count;
+    uint64_t *const *cur = panel->ticks[panel->current];
+    uint64_t *const *prev = panel->ticks[panel->current ^ 1];
+    float *restrict scale = panel->scale;
+
+    for (int i = 0; i < n; i++) scale[i] = 0;
+
+    // Counters can step backwards across CPU hotplug, clamp those deltas to zero
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        const uint64_t *restrict c = cur[f];
+        const uint64_t *restrict p = prev[f];
+        float *restrict out = panel->percent[f];
+        for (int i = 0; i < n; i++) {
+            out[i] = (float)(c[i] > p[i] ? c[i] - p[i] : 0);
+            scale[i] += out[i];
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        scale[i] = scale[i] > 0 ? 100.0f / scale[i] : 0;
+    }
+
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        float *restrict out = panel->percent[f];
+        for (int i = 0; i < n; i++) out[i] *= scale[i];
+    }
+
+    float *restrict busy = panel->busy;
+    const float *restrict idle = panel->percent[CPU_IDLE];
+    const float *restrict iowait = panel->percent[CPU_IOWAIT];
+    for (int i = 0; i < n; i++) {
+        busy[i] = scale[i] > 0 ? 100.0f - idle[i] - iowait[i] : 0;
+    }
+
+    uint64_t total = 0;
+    uint64_t deltas[CPU_FIELDS];
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        uint64_t c = panel->total_ticks[panel->current][f], p = panel->total_ticks[panel->current ^ 1][f];
+        deltas[f] = c > p ? c - p : 0;
+        total += deltas[f];
+    }
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        panel->total_percent[f] = total ? 100.0f * deltas[f] / total : 0;
+    }
+}
+
+int cpu_panel_sample(cpu_panel_t *panel) {
+    double start = overhead_clock();
+    panel->current ^= 1;
+    if (read_proc_file(panel, "/proc/stat") <= 0) return -1;
+    overhead_record(PHASE_READ, start);
+
+    start = overhead_clock();
+    parse_stat(panel);
+    compute_deltas(panel);
+    overhead_record(PHASE_PARSE, start);
+
+    start = overhead_clock();
+    if (read_proc_file(panel, "/proc/loadavg") > 0) {
+        sscanf(panel->buf, "%lf %lf %lf %*d/%d", &panel->load[0], &panel->load[1], &panel->load[2], &panel->threads);
+    }
+    overhead_record(PHASE_READ, start);
+    return panel->count;
+}
+
+int cpu_panel_cores(const cpu_panel_t *panel) {
+    return panel->count;
+}
+
+float cpu_panel_percent(const cpu_panel_t *panel, cpu_field_t field, int cpu) {
+    if (cpu < 0 || cpu >= panel->count || !panel->online[cpu]) return 0;
+    return panel->percent[field][cpu];
+}
+
+static void render_heat_strip(const cpu_panel_t *panel) {
+    static const char ramp[] = " .:-=+*#%@";
+    char line[HEAT_STRIP_WIDTH + 1];
+
+    for (int base = 0; base < panel->count; base += HEAT_STRIP_WIDTH) {
+        int width = panel->count - base < HEAT_STRIP_WIDTH ? panel->count - base : HEAT_STRIP_WIDTH;
+        for (int i = 0; i < width; i++) {
+            int core = base + i;
+            int level = (int)(panel->busy[core] / 10);
+            if (level > 9) level = 9;
+            if (level < 0) level = 0;
+            line[i] = panel->online[core] ? ramp[level] : '_';
+        }
+        line[width] = '\0';
+        printf("cpu%4d-%-4d |%s|\n", base, base + width - 1, line);
+    }
+    printf("Heat-strip: one column per core, ' ' idle to '@' busy, '_' offline\n");
+}
+
+void cpu_panel_render(const cpu_panel_t *panel, int max_rows) {
+    const float *t = panel->total_percent;
+    printf("Load: %.2f %.2f %.2f | Run queue: %d running, %d blocked | %d threads\n",
+           panel->load[0], panel->load[1], panel->load[2], panel->running, panel->blocked, panel->threads);
+    printf("CPU:  us %5.1f  sy %5.1f  wa %5.1f  hi %5.1f  si %5.1f  st %5.1f  (%d cores)\n",
+           t[CPU_USER] + t[CPU_NICE], t[CPU_SYSTEM], t[CPU_IOWAIT], t[CPU_IRQ],
+           t[CPU_SOFTIRQ], t[CPU_STEAL], panel->count);
+
+    if (panel->count > max_rows) {
+        render_heat_strip(panel);
+        return;
+    }
+
+    for (int i = 0; i < panel->count; i++) {
+        if (!panel->online[i]) {
+            printf("cpu%-4d offline\n", i);
+            continue;
+        }
+        char bar[BAR_WIDTH + 1];
+        int filled = (int)(panel->busy[i] * BAR_WIDTH / 100 + 0.5f);
+        for (int j = 0; j < BAR_WIDTH; j++) bar[j] = j < filled ? '#' : ' ';
+        bar[BAR_WIDTH] = '\0';
+        printf("cpu%-4d [%s] %5.1f%%  us %5.1f sy %5.1f wa %5.1f hi %5.1f si %5.1f st %5.1f\n",
+               i, bar, panel->busy[i],
+               panel->percent[CPU_USER][i] + panel->percent[CPU_NICE][i], panel->percent[CPU_SYSTEM][i],
+               panel->percent[CPU_IOWAIT][i], panel->percent[CPU_IRQ][i],
+               panel->percent[CPU_SOFTIRQ][i], panel->percent[CPU_STEAL][i]);
+    }
+}
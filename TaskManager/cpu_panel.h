@@ -0,0 +1,62 @@
+#ifndef CPU_PANEL_H
+#define CPU_PANEL_H
+
+// Per-core tick counters from /proc/stat, in the order the kernel prints them
+typedef enum {
+    CPU_USER,
+    CPU_NICE,
+    CPU_SYSTEM,
+    CPU_IDLE,
+    CPU_IOWAIT,
+    CPU_IRQ,
+    CPU_SOFTIRQ,
+    CPU_STEAL,
+    CPU_FIELDS
+} cpu_field_t;
+
+typedef struct cpu_panel cpu_panel_t;
+
+/**
+ * Creates a panel sized for the configured CPUs; it grows if more appear
+ * @return The panel, or NULL if out of memory
+ */
+cpu_panel_t *cpu_panel_create(void);
+
+/**
+ * Reads /proc/stat and /proc/loadavg and computes per-core utilisation
+ * since the previous sample
+ * @param panel The panel
+ * @return Number of cores, -1 if /proc/stat is unavailable
+ */
+int cpu_panel_sample(cpu_panel_t *panel);
+
+/**
+ * Returns the number of cores covered by the last sample
+ * @param panel The panel
+ */
+int cpu_panel_cores(const cpu_panel_t *panel);
+
+/**
+ * Returns a core's share of the last interval spent in one state
+ * @param panel The panel
+ * @param field The state, e.g. CPU_SOFTIRQ
+ * @param cpu The CPU number
+ * @return Percent of the interval, 0 for unknown or offline cores
+ */
+float cpu_panel_percent(const cpu_panel_t *panel, cpu_field_t field, int cpu);
+
+/**
+ * Prints the panel: one line per core, or a heat-strip when there are
+ * more cores than max_rows
+ * @param panel The panel
+ * @param max_rows Terminal rows the panel may use
+ */
+void cpu_panel_render(const cpu_panel_t *panel, int max_rows);
+
+/**
+ * Frees the panel
+ * @param panel The panel
+ */
+void cpu_panel_destroy(cpu_panel_t *panel);
+
+#endif
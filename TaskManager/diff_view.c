@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "diff_view.h"
+#include "history.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define DIFF_TOP 10
+#define DIFF_COMMANDS 8                     // Commands named in the started/exited summaries
+#define MOVER_EPSILON 0.05
+
+typedef enum {
+    MOVER_CPU,
+    MOVER_RSS,
+    MOVER_THREADS,
+    MOVER_FDS,
+    MOVERS
+} mover_metric_t;
+
+static const char *mover_names[MOVERS] = {"CPU", "RSS", "threads", "open fds"};
+
+typedef struct {
+    int row;
+    double delta;
+} mover_t;
+
+static void format_kb(double kb, char *out, size_t size) {
+    double magnitude = kb < 0 ? -kb : kb;
+    if (magnitude >= 1024.0 * 1024) snprintf(out, size, "%.1fG", kb / (1024.0 * 1024));
+    else if (magnitude >= 1024) snprintf(out, size, "%.1fM", kb / 1024);
+    else snprintf(out, size, "%.0fK", kb);
+}
+
+static int metric_available(const ProcessSample *s, mover_metric_t metric) {
+    return metric != MOVER_FDS || s->fds >= 0;
+}
+
+static double metric_value(const ProcessSample *s, mover_metric_t metric) {
+    switch (metric) {
+        case MOVER_CPU: return s->cpu_percent;
+        case MOVER_RSS: return s->rss_kb;
+        case MOVER_THREADS: return s->threads;
+        default: return s->fds;
+    }
+}
+
+static void format_metric(double value, mover_metric_t metric, int sign, char *out, size_t size) {
+    char number[31];                // Leaves room for the sign in a 32-byte column
+    if (metric == MOVER_RSS) format_kb(value, number, sizeof(number));
+    else if (metric == MOVER_CPU) snprintf(number, sizeof(number), "%.1f%%", value);
+    else snprintf(number, sizeof(number), "%.0f", value);
+    snprintf(out, size, "%s%s", sign && value > 0 ? "+" : "", number);
+}
+
+static int compare_movers(const void *a, const void *b) {
+    const mover_t *ma = a, *mb = b;
+    double da = ma->delta < 0 ? -ma->delta : ma->delta;
+    double db = mb->delta < 0 ? -mb->delta : mb->delta;
+    return da < db ? 1 : da > db ? -1 : ma->row - mb->row;
+}
+
+static const ProcessSnapshot *sort_snapshot;
+
+static int compare_index_command(const void *a, const void *b) {
+    const ProcessSample *sa = &sort_snapshot->samples[*(const int *)a];
+    const ProcessSample *sb = &sort_snapshot->samples[*(const int *)b];
+    int order = strcmp(sa->command, sb->command);
+    return order ? order : (sa->rss_kb < sb->rss_kb) - (sa->rss_kb > sb->rss_kb);
+}
+
+static int compare_index_rss(const void *a, const void *b) {
+    const ProcessSample *sa = &sort_snapshot->samples[*(const int *)a];
+    const ProcessSample *sb = &sort_snapshot->samples[*(const int *)b];
+    return (sa->rss_kb < sb->rss_kb) - (sa->rss_kb > sb->rss_kb);
+}
+
+typedef struct {
+    const char *command;
+    int count;
+} command_count_t;
+
+// Started or exited processes: a per-command tally, then the largest by RSS
+static void print_side(const ProcessSnapshot *snap, int *indices, int count, const char *title, int top) {
+    printf("\n%s: %d\n", title, count);
+    if (count == 0) return;
+
+    sort_snapshot = snap;
+    qsort(indices, count, sizeof(int), compare_index_command);
+    command_count_t commands[DIFF_COMMANDS];
+    int command_count = 0;
+    for (int i = 0; i < count; ) {
+        int run = 1;
+        while (i + run < count && strcmp(snap->samples[indices[i]].command, snap->samples[indices[i + run]].command) == 0) run++;
+
+        // Insertion into the largest DIFF_COMMANDS runs, kept in descending order
+        if (command_count == DIFF_COMMANDS && commands[DIFF_COMMANDS - 1].count >= run) {
+            i += run;
+            continue;
+        }
+        int slot = command_count < DIFF_COMMANDS ? command_count++ : DIFF_COMMANDS - 1;
+        while (slot > 0 && commands[slot - 1].count < run) {
+            commands[slot] = commands[slot - 1];
+            slot--;
+        }
+        commands[slot].command = snap->samples[indices[i]].command;
+        commands[slot].count = run;
+        i += run;
+    }
+    printf("  By command:");
+    for (int i = 0; i < command_count; i++) {
+        printf("%s %s x%d", i ? "," : "", commands[i].command, commands[i].count);
+    }
+    printf("\n");
+
+    qsort(indices, count, sizeof(int), compare_index_rss);
+    snapshot_print_header();
+    for (int i = 0; i < count && i < top; i++) {
+        snapshot_print_row(&snap->samples[indices[i]]);
+    }
+    if (count > top) printf("  ... and %d more\n", count - top);
+}
+
+static void print_movers(const ProcessSnapshot *before, const ProcessSnapshot *after, const SnapshotDiff *diff,
+                         mover_t *movers, mover_metric_t metric, int top) {
+    int count = 0, available = 0;
+    for (int r = 0; r < diff->count; r++) {
+        const diff_row_t *row = &diff->rows[r];
+        if (row->before < 0 || row->after < 0) continue;
+        const ProcessSample *b = &before->samples[row->before], *a = &after->samples[row->after];
+        if (!metric_available(b, metric) || !metric_available(a, metric)) continue;
+        available++;
+        // CPU percentages are floats; changes below the printed precision are noise
+        double delta = metric_value(a, metric) - metric_value(b, metric);
+        if (delta >= MOVER_EPSILON || delta <= -MOVER_EPSILON) {
+            movers[count].row = r;
+            movers[count].delta = delta;
+            count++;
+        }
+    }
+
+    printf("\nTop movers by %s", mover_names[metric]);
+    if (available == 0) {
+        printf(": not available for these snapshots\n");
+        return;
+    }
+    printf(" (%d of %d changed)\n", count, available);
+    if (count == 0) return;
+    qsort(movers, count, sizeof(mover_t), compare_movers);
+
+    printf("%8s %-12s %-20s %10s %10s %10s\n", "PID", "USER", "COMMAND", "BEFORE", "AFTER", "CHANGE");
+    for (int i = 0; i < count && i < top; i++) {
+        const diff_row_t *row = &diff->rows[movers[i].row];
+        const ProcessSample *b = &before->samples[row->before], *a = &after->samples[row->after];
+        char old_value[32], new_value[32], change[32];
+        format_metric(metric_value(b, metric), metric, 0, old_value, sizeof(old_value));
+        format_metric(metric_value(a, metric), metric, 0, new_value, sizeof(new_value));
+        format_metric(movers[i].delta, metric, 1, change, sizeof(change));
+        printf("%8d %-12.12s %-20.20s %10s %10s %10s\n", a->pid, a->username, a->command, old_value, new_value, change);
+    }
+}
+
+void snapshot_diff_print(const ProcessSnapshot *before, const ProcessSnapshot *after, const SnapshotDiff *diff,
+                         const char *before_label, const char *after_label, int top) {
+    double start = overhead_clock();
+    int *started = malloc((diff->started + 1) * sizeof(int));
+    int *exited = malloc((diff->exited + 1) * sizeof(int));
+    mover_t *movers = malloc((diff->common + 1) * sizeof(mover_t));
+    if (!started || !exited || !movers) {
+        perror("Out of memory");
+        free(started);
+        free(exited);
+        free(movers);
+        return;
+    }
+
+    int started_count = 0, exited_count = 0;
+    for (int r = 0; r < diff->count; r++) {
+        if (diff->rows[r].before < 0) started[started_count++] = diff->rows[r].after;
+        else if (diff->rows[r].after < 0) exited[exited_count++] = diff->rows[r].before;
+    }
+
+    printf("===== Snapshot diff: %s -> %s (%.0f s apart) =====\n",
+           before_label, after_label, after->timestamp - before->timestamp);
+    printf("Processes: %d -> %d (%d started, %d exited, %d in both)\n",
+           before->count, after->count, diff->started, diff->exited, diff->common);
+    print_side(after, started, started_count, "Started", top);
+    print_side(before, exited, exited_count, "Exited", top);
+    for (int m = 0; m < MOVERS; m++) {
+        print_movers(before, after, diff, movers, m, top);
+    }
+    overhead_record(PHASE_RENDER, start);
+
+    free(started);
+    free(exited);
+    free(movers);
+}
+
+void show_snapshot_diff(void) {
+    if (!snapshot_supported() || snapshot_replaying()) {
+        printf("Live diffs need /proc (Linux only); recordings have their own diff in the replay menu\n");
+        return;
+    }
+
+    char input[32];
+    int seconds = 10;
+    printf("Compare with the host how many seconds ago (default 10, Enter while waiting uses the oldest kept): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) {
+        return;
+    }
+    if (atoi(input) > 0) seconds = atoi(input);
+
+    // Views that record history (and this one) keep snapshots, so an old enough one is usually there already
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    const ProcessSnapshot *before = NULL;
+    int cur = 0;
+
+    overhead_begin(1000);
+    if (snapshot_take(&snaps[cur], NULL) < 0) return;
+    do {
+        ProcessSnapshot *snap = &snaps[cur];
+        history_record(snap);
+        // The first refresh has lifetime CPU averages, not rates, so it is not compared
+        if (snap->frame > 0 && (before = history_baseline(seconds)) != NULL) break;
+
+        printf("\033[2J\033[H");
+        printf("===== Snapshot diff =====\n");
+        double span = history_baseline_span();
+        if (span > 0) {
+            printf("Oldest kept snapshot is %.0f s old; %d s is reached in %.0f s (%d processes now)\n",
+                   span, seconds, seconds - span, snap->count);
+        } else {
+            printf("Keeping the first snapshot...\n");
+        }
+        int interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to compare now\n");
+        fflush(stdout);
+
+        if (wait_for_refresh(interval)) {
+            if (snap->frame > 0 && history_baseline_span() > 0) before = history_baseline(history_baseline_span());
+            break;
+        }
+        cur ^= 1;
+    } while (snapshot_take(&snaps[cur], &snaps[cur ^ 1]) >= 0);
+
+    if (before) {
+        ProcessSnapshot *after = &snaps[cur];
+        SnapshotDiff diff = {0};
+        char before_label[32], after_label[32];
+        time_t now = time(NULL);
+        time_t then = now - (time_t)(after->timestamp - before->timestamp + 0.5);
+        strftime(before_label, sizeof(before_label), "%H:%M:%S", localtime(&then));
+        strftime(after_label, sizeof(after_label), "%H:%M:%S", localtime(&now));
+        snapshot_count_fds(after);
+
+        printf("\033[2J\033[H");
+        if (snapshot_diff(before, after, &diff) >= 0) {
+            snapshot_diff_print(before, after, &diff, before_label, after_label, DIFF_TOP);
+        }
+        snapshot_diff_free(&diff);
+    } else {
+        printf("Nothing to compare yet\n");
+    }
+
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
@@ -0,0 +1,27 @@
+#ifndef DIFF_VIEW_H
+#define DIFF_VIEW_H
+
+#include "snapshot_diff.h"
+
+/**
+ * Prints started and exited processes (also grouped by command) and the
+ * processes whose CPU, RSS, thread count and open fds moved the most.
+ * fd movers need snapshot_count_fds() on both snapshots.
+ * @param before The older snapshot
+ * @param after The newer snapshot
+ * @param diff Result of snapshot_diff for the two
+ * @param before_label How to name the older side ("13:02:11", "baseline", ...)
+ * @param after_label How to name the newer side
+ * @param top Rows per section
+ */
+void snapshot_diff_print(const ProcessSnapshot *before, const ProcessSnapshot *after, const SnapshotDiff *diff,
+                         const char *before_label, const char *after_label, int top);
+
+/**
+ * Shows what changed on the host over the last few seconds, against a
+ * snapshot kept by history_record. Without one that old yet, it keeps
+ * sampling until there is one, or until Enter compares with the oldest.
+ */
+void show_snapshot_diff(void);
+
+#endif
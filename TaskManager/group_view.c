@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "group_view.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define GROUP_REFRESH_MS 1000
+#define GROUP_DEFAULT_ROWS 15
+#define GROUP_MEMBER_ROWS 10        // Member processes listed under an expanded group
+#define GROUP_MAX_EXPANDED 8
+
+static const char *sort_names[GROUP_SORTS] = {"CPU", "RSS", "process count", "I/O"};
+
+// Key of an expanded group; kept by key because group indices change every refresh
+typedef struct {
+    uid_t uid;
+    char name[64];
+} group_ref_t;
+
+static unsigned int hash_key(group_key_t key, uid_t uid, const char *name) {
+    if (key == GROUP_BY_USER) return (unsigned int)uid * 2654435761u;
+    unsigned int hash = 2166136261u;
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    return hash;
+}
+
+static int same_key(const GroupTable *table, const process_group_t *g, uid_t uid, const char *name) {
+    return table->key == GROUP_BY_USER ? g->uid == uid : strcmp(g->name, name) == 0;
+}
+
+static int grow_slots(GroupTable *table) {
+    unsigned int capacity = table->slot_mask ? (table->slot_mask + 1) * 2 : 256;
+    int *slots = malloc(capacity * sizeof(int));
+    if (!slots) return 0;
+    memset(slots, 0xff, capacity * sizeof(int));
+    for (int i = 0; i < table->count; i++) {
+        const process_group_t *g = &table->groups[i];
+        unsigned int slot = hash_key(table->key, g->uid, g->name) & (capacity - 1);
+        while (slots[slot] >= 0) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = i;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slot_mask = capacity - 1;
+    return 1;
+}
+
+int group_find(const GroupTable *table, uid_t uid, const char *name) {
+    if (!table->slots) return -1;
+    unsigned int slot = hash_key(table->key, uid, name) & table->slot_mask;
+    while (table->slots[slot] >= 0) {
+        if (same_key(table, &table->groups[table->slots[slot]], uid, name)) return table->slots[slot];
+        slot = (slot + 1) & table->slot_mask;
+    }
+    return -1;
+}
+
+// Finds the group of a process, opening a new one for an unseen key
+static int find_or_add_group(GroupTable *table, const ProcessSample *s) {
+    const char *name = table->key == GROUP_BY_USER ? s->username : s->command;
+    if ((unsigned int)table->count * 2 >= table->slot_mask && !grow_slots(table)) return -1;
+    unsigned int slot = hash_key(table->key, s->uid, name) & table->slot_mask;
+    while (table->slots[slot] >= 0) {
+        if (same_key(table, &table->groups[table->slots[slot]], s->uid, name)) return table->slots[slot];
+        slot = (slot + 1) & table->slot_mask;
+    }
+
+    if (table->count == table->capacity) {
+        int capacity = table->capacity ? table->capacity * 2 : 64;
+        process_group_t *grown = realloc(table->groups, capacity * sizeof(process_group_t));
+        if (!grown) return -1;
+        table->groups = grown;
+        table->capacity = capacity;
+    }
+    process_group_t *g = &table->groups[table->count];
+    memset(g, 0, sizeof(*g));
+    g->uid = s->uid;
+    snprintf(g->name, sizeof(g->name), "%s", name);
+    g->first = g->last = -1;
+    table->slots[slot] = table->count;
+    return table->count++;
+}
+
+int group_snapshot(GroupTable *table, group_key_t key, const ProcessSnapshot *snap,
+                   const ProcessSnapshot *previous, filter_t *filter) {
+    if (snap->count > table->next_capacity) {
+        int *grown = realloc(table->next, snap->count * sizeof(int));
+        if (!grown) return -1;
+        table->next = grown;
+        table->next_capacity = snap->count;
+    }
+    table->key = key;
+    table->count = 0;
+    if (table->slots) memset(table->slots, 0xff, (table->slot_mask + 1) * sizeof(int));
+
+    double dt = previous ? snap->timestamp - previous->timestamp : 0;
+    int p = 0;
+    filter_prepare(filter, snap);
+    for (int i = 0; i < snap->count; i++) {
+        const ProcessSample *s = &snap->samples[i];
+        table->next[i] = -1;
+        if (!filter_match(filter, snap, i)) continue;
+
+        int index = find_or_add_group(table, s);
+        if (index < 0) return -1;
+        process_group_t *g = &table->groups[index];
+        g->processes++;
+        g->threads += s->threads;
+        g->cpu_percent += s->cpu_percent;
+        g->rss_kb += s->rss_kb;
+        if (g->last >= 0) table->next[g->last] = i;
+        else g->first = i;
+        g->last = i;
+
+        // Both snapshots are in PID order, so the previous counters come from a merge walk
+        if (s->io_bytes == SNAPSHOT_IO_UNKNOWN || dt <= 0) continue;
+        while (p < previous->count && previous->samples[p].pid < s->pid) p++;
+        if (p < previous->count) {
+            const ProcessSample *old = &previous->samples[p];
+            if (old->pid == s->pid && old->starttime == s->starttime &&
+                old->io_bytes != SNAPSHOT_IO_UNKNOWN && s->io_bytes >= old->io_bytes) {
+                g->io_rate += (s->io_bytes - old->io_bytes) / dt;
+                g->io_members++;
+            }
+        }
+    }
+    return table->count;
+}
+
+static double group_metric(const process_group_t *g, group_sort_t sort) {
+    switch (sort) {
+        case GROUP_SORT_CPU: return g->cpu_percent;
+        case GROUP_SORT_RSS: return g->rss_kb;
+        case GROUP_SORT_PROCESSES: return g->processes;
+        default: return g->io_rate;
+    }
+}
+
+static double sample_metric(const ProcessSample *s, group_sort_t sort) {
+    switch (sort) {
+        case GROUP_SORT_RSS: return s->rss_kb;
+        case GROUP_SORT_PROCESSES: return s->threads;
+        default: return s->cpu_percent;
+    }
+}
+
+// Bounded insertion: each group costs one comparison unless it makes the top
+int group_top(const GroupTable *table, group_sort_t sort, int *order, int count) {
+    int shown = 0;
+    if (count <= 0) return 0;
+    for (int i = 0; i < table->count; i++) {
+        double value = group_metric(&table->groups[i], sort);
+        if (shown == count && value <= group_metric(&table->groups[order[shown - 1]], sort)) continue;
+        int j = shown < count ? shown++ : count - 1;
+        while (j > 0 && group_metric(&table->groups[order[j - 1]], sort) < value) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    return shown;
+}
+
+void group_table_free(GroupTable *table) {
+    free(table->groups);
+    free(table->slots);
+    free(table->next);
+    memset(table, 0, sizeof(*table));
+}
+
+static void format_kb(double kb, char *out, size_t size) {
+    if (kb >= 1024.0 * 1024) snprintf(out, size, "%.1fG", kb / (1024.0 * 1024));
+    else if (kb >= 1024) snprintf(out, size, "%.1fM", kb / 1024);
+    else snprintf(out, size, "%.0fK", kb);
+}
+
+static int find_expanded(const group_ref_t *expanded, int count, const GroupTable *table, const process_group_t *g) {
+    for (int i = 0; i < count; i++) {
+        if (same_key(table, g, expanded[i].uid, expanded[i].name)) return i;
+    }
+    return -1;
+}
+
+// Lists the largest members of a group; process count ranks them by threads, I/O by CPU
+static void print_members(const GroupTable *table, const process_group_t *g,
+                          ProcessSnapshot *snap, group_sort_t sort) {
+    int top[GROUP_MEMBER_ROWS];
+    int shown = 0;
+    for (int i = g->first; i >= 0; i = table->next[i]) {
+        double value = sample_metric(&snap->samples[i], sort);
+        if (shown == GROUP_MEMBER_ROWS && value <= sample_metric(&snap->samples[top[shown - 1]], sort)) continue;
+        int j = shown < GROUP_MEMBER_ROWS ? shown++ : GROUP_MEMBER_ROWS - 1;
+        while (j > 0 && sample_metric(&snap->samples[top[j - 1]], sort) < value) {
+            top[j] = top[j - 1];
+            j--;
+        }
+        top[j] = i;
+    }
+    for (int i = 0; i < shown; i++) {
+        printf("      ");
+        snapshot_print_row(&snap->samples[top[i]]);
+        // Expanded rows are being watched; keep them off the extrapolated tiers
+        snapshot_promote(snap, snap->samples[top[i]].pid);
+    }
+    if (g->processes > shown) printf("      ... %d more\n", g->processes - shown);
+}
+
+static void render_groups(const GroupTable *table, const int *order, int shown, ProcessSnapshot *snap,
+                          group_sort_t sort, const group_ref_t *expanded, int expanded_count, int have_io) {
+    int processes = 0, threads = 0;
+    float cpu = 0;
+    double rss = 0;
+    for (int i = 0; i < table->count; i++) {
+        processes += table->groups[i].processes;
+        threads += table->groups[i].threads;
+        cpu += table->groups[i].cpu_percent;
+        rss += table->groups[i].rss_kb;
+    }
+    char size[32];
+    format_kb(rss, size, sizeof(size));
+    printf("%d %s, %d processes, %d threads, %.1f%% CPU, %s RSS\n\n", table->count,
+           table->key == GROUP_BY_USER ? "users" : "commands", processes, threads, cpu, size);
+
+    printf("%4s   %-24s %7s %8s %8s %10s %11s\n", "#", table->key == GROUP_BY_USER ? "USER" : "COMMAND",
+           "PROCS", "THREADS", "CPU%", "RSS", "I/O");
+    for (int i = 0; i < shown; i++) {
+        const process_group_t *g = &table->groups[order[i]];
+        int open = find_expanded(expanded, expanded_count, table, g) >= 0;
+        char rate[48];
+        if (!have_io || g->io_members == 0) {
+            snprintf(rate, sizeof(rate), "-");
+        } else {
+            format_kb(g->io_rate / 1024, size, sizeof(size));
+            snprintf(rate, sizeof(rate), "%s/s", size);
+        }
+        format_kb(g->rss_kb, size, sizeof(size));
+        char name[80];
+        if (table->key == GROUP_BY_USER) snprintf(name, sizeof(name), "%s (%d)", g->name, (int)g->uid);
+        else snprintf(name, sizeof(name), "%s", g->name);
+        printf("%4d %c %-24.24s %7d %8d %8.1f %10s %11s\n", i + 1, open ? '-' : '+',
+               name, g->processes, g->threads, g->cpu_percent, size, rate);
+        if (open) print_members(table, g, snap, sort);
+    }
+    if (!have_io) {
+        printf("\nI/O rates need live /proc/<pid>/io counters and a previous refresh\n");
+    }
+}
+
+// Reads the expand/collapse and regroup command typed after Enter; returns 0 to leave
+static int handle_command(const GroupTable *table, const int *order, int shown, group_key_t *key,
+                          group_sort_t *sort, group_ref_t *expanded, int *expanded_count) {
+    char input[32];
+    printf("Group # to expand or collapse, u/c to group by user/command, s to change the sort, blank to leave: ");
+    if (fgets(input, sizeof(input), stdin) == NULL || input[0] == '\n') return 0;
+
+    if (input[0] == 'u' || input[0] == 'c') {
+        group_key_t chosen = input[0] == 'u' ? GROUP_BY_USER : GROUP_BY_COMMAND;
+        if (chosen != *key) *expanded_count = 0;
+        *key = chosen;
+        return 1;
+    }
+    if (input[0] == 's') {
+        *sort = (*sort + 1) % GROUP_SORTS;
+        return 1;
+    }
+
+    int row = atoi(input);
+    if (row < 1 || row > shown) {
+        printf("No group %d on screen\n", row);
+        return 1;
+    }
+    const process_group_t *g = &table->groups[order[row - 1]];
+    int found = find_expanded(expanded, *expanded_count, table, g);
+    if (found >= 0) {
+        expanded[found] = expanded[--*expanded_count];
+    } else if (*expanded_count < GROUP_MAX_EXPANDED) {
+        expanded[*expanded_count].uid = g->uid;
+        snprintf(expanded[*expanded_count].name, sizeof(expanded[0].name), "%s", g->name);
+        (*expanded_count)++;
+    } else {
+        printf("At most %d groups can be expanded at once\n", GROUP_MAX_EXPANDED);
+    }
+    return 1;
+}
+
+void show_group_view(void) {
+    char input[256];
+    group_key_t key = GROUP_BY_COMMAND;
+    group_sort_t sort = GROUP_SORT_CPU;
+    int rows = GROUP_DEFAULT_ROWS;
+
+    printf("Group by 1. user  2. command name (default 2): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    if (atoi(input) == 1) key = GROUP_BY_USER;
+    printf("Sort by 1. CPU  2. RSS  3. process count  4. I/O (default 1): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    if (atoi(input) >= 1 && atoi(input) <= GROUP_SORTS) sort = atoi(input) - 1;
+    printf("Number of groups to show (default %d): ", GROUP_DEFAULT_ROWS);
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    if (atoi(input) > 0) rows = atoi(input);
+    printf("Filter expression, e.g. rss > 100M && user != root (blank for all): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = '\0';
+
+    char error[128];
+    filter_t *filter = filter_compile(input, error, sizeof(error));
+    if (!filter && error[0]) {
+        printf("Bad filter: %s\n", error);
+        return;
+    }
+
+    int *order = malloc(rows * sizeof(int));
+    if (!order) {
+        filter_free(filter);
+        return;
+    }
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    GroupTable table = {0};
+    group_ref_t expanded[GROUP_MAX_EXPANDED];
+    int expanded_count = 0;
+    int cur = 0, live = !snapshot_replaying();
+
+    overhead_begin(GROUP_REFRESH_MS);
+    if (snapshot_take(&snaps[cur], NULL) < 0) {
+        free(order);
+        filter_free(filter);
+        return;
+    }
+
+    do {
+        ProcessSnapshot *snap = &snaps[cur];
+        if (live) snapshot_read_io(snap);
+        int have_io = live && snap->frame > 0;
+
+        double start = overhead_clock();
+        if (group_snapshot(&table, key, snap, have_io ? &snaps[cur ^ 1] : NULL, filter) < 0) break;
+        int shown = group_top(&table, sort, order, rows);
+        overhead_record(PHASE_SORT, start);
+
+        start = overhead_clock();
+        char scope[600];
+        snapshot_describe_scope(scope, sizeof(scope));
+        printf("\033[2J\033[H");
+        printf("===== Processes grouped by %s, top %d by %s =====\n",
+               key == GROUP_BY_USER ? "user" : "command name", rows, sort_names[sort]);
+        printf("Scope: %s\n", scope);
+        if (filter) printf("Filter: %s\n", filter_text(filter));
+        render_groups(&table, order, shown, snap, sort, expanded, expanded_count, have_io);
+        overhead_record(PHASE_RENDER, start);
+        int interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to expand, regroup or leave\n");
+        fflush(stdout);
+
+        if (wait_for_refresh(interval)) {
+            if (!handle_command(&table, order, shown, &key, &sort, expanded, &expanded_count)) break;
+            // Time spent at the prompt is not refresh cost
+            overhead_begin(GROUP_REFRESH_MS);
+        }
+        cur ^= 1;
+    } while (snapshot_take(&snaps[cur], &snaps[cur ^ 1]) >= 0);
+
+    free(order);
+    group_table_free(&table);
+    filter_free(filter);
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
@@ -0,0 +1,90 @@
+#ifndef GROUP_VIEW_H
+#define GROUP_VIEW_H
+
+#include <sys/types.h>
+#include "proc_snapshot.h"
+#include "proc_filter.h"
+
+typedef enum {
+    GROUP_BY_USER,
+    GROUP_BY_COMMAND
+} group_key_t;
+
+typedef enum {
+    GROUP_SORT_CPU,
+    GROUP_SORT_RSS,
+    GROUP_SORT_PROCESSES,
+    GROUP_SORT_IO,
+    GROUP_SORTS
+} group_sort_t;
+
+// Totals of one user or one command name over a snapshot
+typedef struct {
+    uid_t uid;                      // Key of GROUP_BY_USER groups
+    char name[64];                  // Command name, or the user name of GROUP_BY_USER groups
+    int processes;
+    int threads;
+    float cpu_percent;
+    unsigned long rss_kb;
+    double io_rate;                 // Bytes per second, summed over io_members
+    int io_members;                 // Members whose I/O counters were readable in both snapshots
+    int first;                      // First member as a snapshot index; members chain through next[]
+    int last;
+} process_group_t;
+
+typedef struct {
+    group_key_t key;
+    process_group_t *groups;        // In order of first appearance
+    int count;
+    int capacity;
+    int *slots;                     // Open addressing over groups, -1 when free
+    unsigned int slot_mask;
+    int *next;                      // Next member of the same group per snapshot index, -1 at the end
+    int next_capacity;
+} GroupTable;
+
+/**
+ * Aggregates a snapshot by user or command name in one pass. Buffers are
+ * reused, so regrouping every refresh stops allocating once they fit.
+ * @param table The table; zero-initialise before the first call
+ * @param key What to group by
+ * @param snap The snapshot, sorted by PID
+ * @param previous The snapshot before it for I/O rates, or NULL
+ * @param filter Only matching processes are counted; NULL for all
+ * @return Number of groups, -1 if out of memory
+ */
+int group_snapshot(GroupTable *table, group_key_t key, const ProcessSnapshot *snap,
+                   const ProcessSnapshot *previous, filter_t *filter);
+
+/**
+ * Selects the largest groups without sorting the whole table
+ * @param table A grouped table
+ * @param sort The metric to rank by
+ * @param order Receives up to count group indices, largest first
+ * @param count Size of order
+ * @return Number of indices written
+ */
+int group_top(const GroupTable *table, group_sort_t sort, int *order, int count);
+
+/**
+ * Looks up a group by its key
+ * @param table A grouped table
+ * @param uid The uid for GROUP_BY_USER tables
+ * @param name The command name for GROUP_BY_COMMAND tables
+ * @return Index of the group, -1 if absent
+ */
+int group_find(const GroupTable *table, uid_t uid, const char *name);
+
+/**
+ * Frees the buffers of a group table
+ * @param table The table
+ */
+void group_table_free(GroupTable *table);
+
+/**
+ * Live totals of CPU, RSS, threads, I/O and process count per user or per
+ * command name, with groups that expand to their member processes
+ */
+void show_group_view(void);
+
+#endif
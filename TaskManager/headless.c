@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "headless.h"
+#include "taskmgr.h"
+#include "overhead.h"
+
+static const char *column_names[COLUMN_COUNT] = {
+    "pid", "ppid", "uid", "user", "state", "cpu", "mem", "rss", "vsz",
+    "threads", "minflt", "majflt", "time", "start", "cmd"
+};
+
+// Rows are appended here and written out when the next field would not fit
+typedef struct {
+    char data[HEADLESS_BUFFER_SIZE];
+    size_t used;
+    int failed;                     // errno of the write that failed, 0 while the stream is fine
+} writer_t;
+
+static writer_t out;
+static volatile sig_atomic_t headless_stop;
+
+static void request_stop(int sig) {
+    (void)sig;
+    headless_stop = 1;
+}
+
+static void flush_output(writer_t *w) {
+    size_t done = 0;
+    while (done < w->used && !w->failed) {
+        ssize_t n = write(STDOUT_FILENO, w->data + done, w->used - done);
+        if (n > 0) done += n;
+        else if (n < 0 && errno != EINTR) w->failed = errno;
+    }
+    w->used = 0;
+}
+
+static void put(writer_t *w, const char *s, size_t len) {
+    if (len > sizeof(w->data) - w->used) flush_output(w);
+    // Fields are far smaller than the buffer
+    memcpy(w->data + w->used, s, len);
+    w->used += len;
+}
+
+static void put_str(writer_t *w, const char *s) {
+    put(w, s, strlen(s));
+}
+
+static void put_char(writer_t *w, char c) {
+    if (w->used == sizeof(w->data)) flush_output(w);
+    w->data[w->used++] = c;
+}
+
+static void put_uint(writer_t *w, unsigned long long value) {
+    char digits[24];
+    int i = sizeof(digits);
+    do {
+        digits[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    put(w, digits + i, sizeof(digits) - i);
+}
+
+// Fixed-point decimal without printf; only values beyond 2^64 / 10^decimals take the slow path
+static void put_fixed(writer_t *w, double value, int decimals) {
+    unsigned long long scale = 1;
+    for (int i = 0; i < decimals; i++) scale *= 10;
+    // JSON has no spelling for NaN or infinity, so they come out as 0 and the largest double
+    if (value != value) value = 0;
+    int negative = value < 0;
+    if (negative) value = -value;
+    if (value > DBL_MAX) value = DBL_MAX;
+    if (value * scale + 0.5 >= 18446744073709551616.0) {
+        char text[DBL_MAX_10_EXP + 16];
+        int n = snprintf(text, sizeof(text), "%s%.*f", negative ? "-" : "", decimals, value);
+        put(w, text, n);
+        return;
+    }
+
+    unsigned long long scaled = (unsigned long long)(value * scale + 0.5);
+    if (negative && scaled) put_char(w, '-');
+    put_uint(w, scaled / scale);
+    if (decimals == 0) return;
+
+    char fraction[8];
+    unsigned long long rest = scaled % scale;
+    for (int i = decimals - 1; i >= 0; i--) {
+        fraction[i] = '0' + rest % 10;
+        rest /= 10;
+    }
+    put_char(w, '.');
+    put(w, fraction, decimals);
+}
+
+static void put_json_string(writer_t *w, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    put_char(w, '"');
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            put_char(w, '\\');
+            put_char(w, c);
+        } else if (c < 0x20) {
+            char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            put(w, escape, sizeof(escape));
+        } else {
+            put_char(w, c);
+        }
+    }
+    put_char(w, '"');
+}
+
+static void put_csv_string(writer_t *w, const char *s) {
+    if (!strpbrk(s, ",\"\r\n")) {
+        put_str(w, s);
+        return;
+    }
+    put_char(w, '"');
+    for (; *s; s++) {
+        if (*s == '"') put_char(w, '"');
+        put_char(w, *s);
+    }
+    put_char(w, '"');
+}
+
+static void put_value(writer_t *w, headless_format_t format, headless_column_t column, const tm_process_t *p) {
+    const char *text = NULL;
+    char state[2] = { p->state, '\0' };
+    switch (column) {
+        case COLUMN_PID:     put_uint(w, p->pid); break;
+        case COLUMN_PPID:    put_uint(w, p->ppid); break;
+        case COLUMN_UID:     put_uint(w, p->uid); break;
+        case COLUMN_USER:    text = p->user; break;
+        case COLUMN_STATE:   text = state; break;
+        case COLUMN_CPU:     put_fixed(w, p->cpu_percent, 1); break;
+        case COLUMN_MEM:     put_fixed(w, p->mem_percent, 1); break;
+        case COLUMN_RSS:     put_uint(w, p->rss_kb); break;
+        case COLUMN_VSZ:     put_uint(w, p->vsize_kb); break;
+        case COLUMN_THREADS: put_uint(w, p->threads); break;
+        case COLUMN_MINFLT:  put_uint(w, p->minflt); break;
+        case COLUMN_MAJFLT:  put_uint(w, p->majflt); break;
+        case COLUMN_TIME:    put_fixed(w, p->cpu_seconds, 2); break;
+        case COLUMN_START:   put_fixed(w, p->start_seconds, 2); break;
+        case COLUMN_CMD:     text = p->command; break;
+        case COLUMN_COUNT:   break;
+    }
+    if (!text) return;
+    if (format == HEADLESS_CSV) put_csv_string(w, text);
+    else put_json_string(w, text);
+}
+
+static void put_object(writer_t *w, const headless_options_t *opts, double ts, const tm_process_t *p) {
+    put_char(w, '{');
+    if (opts->format == HEADLESS_NDJSON) {
+        put_str(w, "\"ts\":");
+        put_fixed(w, ts, 3);
+        put_char(w, ',');
+    }
+    for (int i = 0; i < opts->column_count; i++) {
+        if (i > 0) put_char(w, ',');
+        put_char(w, '"');
+        put_str(w, column_names[opts->columns[i]]);
+        put_str(w, "\":");
+        put_value(w, opts->format, opts->columns[i], p);
+    }
+    put_char(w, '}');
+}
+
+// One sample: a line per process, or one JSON document for all of them
+static void emit_sample(writer_t *w, const headless_options_t *opts, tm_snapshot_t *snap, tm_filter_t *filter) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    double ts = now.tv_sec + now.tv_nsec / 1e9;
+
+    if (opts->format == HEADLESS_JSON) {
+        put_str(w, "{\"ts\":");
+        put_fixed(w, ts, 3);
+        put_str(w, ",\"processes\":[");
+    }
+
+    tm_iter_t it;
+    tm_process_t p;
+    int rows = 0;
+    tm_snapshot_iter(&it, snap, filter);
+    while (tm_iter_next(&it, &p) && !w->failed) {
+        switch (opts->format) {
+            case HEADLESS_NDJSON:
+                put_object(w, opts, ts, &p);
+                put_char(w, '\n');
+                break;
+            case HEADLESS_JSON:
+                if (rows > 0) put_char(w, ',');
+                put_object(w, opts, ts, &p);
+                break;
+            case HEADLESS_CSV:
+                put_fixed(w, ts, 3);
+                for (int i = 0; i < opts->column_count; i++) {
+                    put_char(w, ',');
+                    put_value(w, opts->format, opts->columns[i], &p);
+                }
+                put_char(w, '\n');
+                break;
+        }
+        rows++;
+    }
+
+    if (opts->format == HEADLESS_JSON) put_str(w, "]}\n");
+    flush_output(w);
+}
+
+// Sleeps until a deadline on the monotonic clock; a stop request cuts it short
+static void sleep_until(double deadline) {
+    double remaining = deadline - overhead_clock();
+    if (remaining <= 0) return;
+    struct timespec ts = { (time_t)remaining, (long)((remaining - (time_t)remaining) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+void headless_options_init(headless_options_t *opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->format = HEADLESS_NDJSON;
+    opts->interval_ms = 1000;
+    headless_set_columns(opts, HEADLESS_DEFAULT_COLUMNS);
+}
+
+int headless_set_format(headless_options_t *opts, const char *name) {
+    if (strcmp(name, "ndjson") == 0) opts->format = HEADLESS_NDJSON;
+    else if (strcmp(name, "json") == 0) opts->format = HEADLESS_JSON;
+    else if (strcmp(name, "csv") == 0) opts->format = HEADLESS_CSV;
+    else {
+        fprintf(stderr, "Unknown format '%s'; use ndjson, json or csv\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+int headless_set_columns(headless_options_t *opts, const char *list) {
+    headless_column_t columns[HEADLESS_MAX_COLUMNS];
+    int count = 0;
+    const char *p = list;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        int found = -1;
+        for (int c = 0; c < COLUMN_COUNT && found < 0; c++) {
+            if (strlen(column_names[c]) == len && strncmp(p, column_names[c], len) == 0) found = c;
+        }
+        if (found < 0 || count == HEADLESS_MAX_COLUMNS) {
+            if (found < 0) fprintf(stderr, "Unknown column '%.*s'; choose from", (int)len, p);
+            else fprintf(stderr, "At most %d columns are supported; columns are", HEADLESS_MAX_COLUMNS);
+            for (int c = 0; c < COLUMN_COUNT; c++) fprintf(stderr, "%s%s", c ? "," : " ", column_names[c]);
+            fprintf(stderr, "\n");
+            return 0;
+        }
+        columns[count++] = found;
+        p += len;
+        if (*p == ',') p++;
+    }
+    if (count == 0) {
+        fprintf(stderr, "No columns selected\n");
+        return 0;
+    }
+    memcpy(opts->columns, columns, count * sizeof(columns[0]));
+    opts->column_count = count;
+    return 1;
+}
+
+int run_headless(const headless_options_t *opts) {
+    char error[256];
+    tm_filter_t *filter = NULL;
+    if (opts->filter && !(filter = tm_filter_compile(opts->filter, error, sizeof(error))) && error[0]) {
+        fprintf(stderr, "Invalid filter: %s\n", error);
+        return EXIT_FAILURE;
+    }
+
+    // A reader that goes away is the normal end of a pipeline, not a crash
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = request_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // CPU percentages need two samples, so even --once waits one interval
+    tm_snapshot_t *snaps[2] = { tm_snapshot_take(NULL), NULL };
+    int cur = 0, status = EXIT_SUCCESS;
+    if (!snaps[0]) status = EXIT_FAILURE;
+
+    if (opts->format == HEADLESS_CSV && status == EXIT_SUCCESS) {
+        put_str(&out, "ts");
+        for (int i = 0; i < opts->column_count; i++) {
+            put_char(&out, ',');
+            put_str(&out, column_names[opts->columns[i]]);
+        }
+        put_char(&out, '\n');
+    }
+
+    double deadline = overhead_clock();
+    while (status == EXIT_SUCCESS && !headless_stop && !out.failed) {
+        // A sample that overran its slot shifts the schedule instead of bunching the next ones
+        deadline += opts->interval_ms / 1000.0;
+        if (deadline < overhead_clock()) deadline = overhead_clock();
+        sleep_until(deadline);
+        if (headless_stop) break;
+
+        // The older buffer is refilled in place; only the first round allocates it
+        int next = cur ^ 1;
+        if (snaps[next] ? tm_snapshot_refresh(snaps[next], snaps[cur]) < 0
+                        : !(snaps[next] = tm_snapshot_take(snaps[cur]))) {
+            status = EXIT_FAILURE;
+            break;
+        }
+        cur = next;
+
+        emit_sample(&out, opts, snaps[cur], filter);
+        if (opts->once) break;
+    }
+    flush_output(&out);
+
+    if (status != EXIT_SUCCESS) fprintf(stderr, "Cannot read the process list\n");
+    if (out.failed && out.failed != EPIPE) {
+        fprintf(stderr, "Writing output failed: %s\n", strerror(out.failed));
+        status = EXIT_FAILURE;
+    }
+    tm_snapshot_free(snaps[0]);
+    tm_snapshot_free(snaps[1]);
+    tm_filter_free(filter);
+    return status;
+}
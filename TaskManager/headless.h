@@ -0,0 +1,75 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#define HEADLESS_MAX_COLUMNS 32
+#define HEADLESS_BUFFER_SIZE 65536      // Output is written in chunks of this size, never a whole table
+#define HEADLESS_DEFAULT_COLUMNS "pid,user,cpu,mem,rss,cmd"
+
+typedef enum {
+    HEADLESS_NDJSON,                    // One object per process and line
+    HEADLESS_JSON,                      // One document per sample and line
+    HEADLESS_CSV                        // Header once, then one row per process
+} headless_format_t;
+
+typedef enum {
+    COLUMN_PID,
+    COLUMN_PPID,
+    COLUMN_UID,
+    COLUMN_USER,
+    COLUMN_STATE,
+    COLUMN_CPU,                         // Percent of one core over the interval
+    COLUMN_MEM,                         // Percent
+    COLUMN_RSS,                         // KB
+    COLUMN_VSZ,                         // KB
+    COLUMN_THREADS,
+    COLUMN_MINFLT,
+    COLUMN_MAJFLT,
+    COLUMN_TIME,                        // CPU seconds consumed so far
+    COLUMN_START,                       // Seconds after boot
+    COLUMN_CMD,
+    COLUMN_COUNT
+} headless_column_t;
+
+// What process_manager --once / --format prints instead of the menu
+typedef struct {
+    headless_format_t format;
+    headless_column_t columns[HEADLESS_MAX_COLUMNS];
+    int column_count;
+    const char *filter;                 // Filter expression, or NULL for every process
+    int interval_ms;                    // CPU measuring window and time between samples
+    int once;                           // Emit a single sample and exit
+} headless_options_t;
+
+/**
+ * Fills in the defaults: NDJSON, HEADLESS_DEFAULT_COLUMNS, no filter,
+ * one sample per second until interrupted
+ * @param opts The options
+ */
+void headless_options_init(headless_options_t *opts);
+
+/**
+ * Selects the output format
+ * @param opts The options
+ * @param name "ndjson", "json" or "csv"
+ * @return 1 on success, 0 for an unknown format (reported on stderr)
+ */
+int headless_set_format(headless_options_t *opts, const char *name);
+
+/**
+ * Selects the columns from a comma-separated list such as "pid,cpu,rss,cmd"
+ * @param opts The options
+ * @param list The column names
+ * @return 1 on success, 0 for an unknown or empty list (reported on stderr)
+ */
+int headless_set_columns(headless_options_t *opts, const char *list);
+
+/**
+ * Samples processes and streams them to stdout without the menu. Every
+ * record carries "ts", the wall-clock time of its sample in seconds. A
+ * closed pipe (e.g. | head) ends the stream quietly.
+ * @param opts The options
+ * @return Exit status for main
+ */
+int run_headless(const headless_options_t *opts);
+
+#endif
@@ -0,0 +1,579 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "history.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define HISTORY_TREND_TAU 900.0             // Seconds; older RSS samples fade out of the regression
+#define LEAK_MIN_SPAN 120.0                 // Seconds of history before a process can be flagged
+#define LEAK_MIN_R2 0.8
+#define LEAK_MIN_KB_PER_HOUR 16384.0
+#define LEAK_MIN_FRACTION_PER_HOUR 0.1      // Growth relative to the current RSS
+#define SPARKLINE_WIDTH 30
+#define LEAK_ROWS 10
+
+static const double tier_width[HISTORY_TIERS] = {1, 10, 60};
+static const char *tier_names[HISTORY_TIERS] = {"1s", "10s", "1min"};
+static const char *metric_names[HISTORY_METRICS] = {"CPU %", "RSS KB", "IO KB/s", "Faults/s"};
+static const float metric_floor[HISTORY_METRICS] = {10, 0, 64, 100};
+
+// Fixed-size ring per tier; values are metric-major so one series is contiguous
+typedef struct {
+    float values[HISTORY_METRICS][HISTORY_POINTS];
+    int head;                               // Next slot to write
+    int count;
+    long bucket;                            // Time bucket being accumulated
+    double sum[HISTORY_METRICS];
+    int samples;
+} history_ring_t;
+
+typedef struct {
+    pid_t pid;
+    unsigned long long starttime;
+    double first_seen;
+    double last_seen;                       // Timestamp of the last snapshot that had the process
+    double last_read;                       // sampled_at of the last non-extrapolated sample
+    unsigned long long last_faults;
+    unsigned long long last_io;
+    int have_io;
+    float fault_rate;
+    float io_rate;
+    double trend_time;
+    double sw, st, sy, stt, sty, syy;       // Weighted sums of 1, t, rss, t^2, t*rss, rss^2
+    history_ring_t tiers[HISTORY_TIERS];
+} history_slab_t;
+
+// Slabs are addressed by index, so the pool can move when it grows; exited
+// processes return their slab to the free list
+static history_slab_t *slabs;
+static int pool_size;
+static int *free_slabs;
+static int free_count;
+static int *active;                         // Slab indices sorted by PID
+static int active_count;
+static int *merged;                         // The next active list while a snapshot is recorded
+static int *arrivals;                       // Rows of that snapshot without a slab, then their slabs
+static int arrivals_capacity;
+static int untracked;
+static double last_timestamp;
+static ProcessSnapshot baselines[HISTORY_BASELINES];   // Oldest first
+static int baseline_count;
+static SampleScope baseline_scope;          // Scope the kept snapshots were taken in
+
+// Doubles the pool, up to HISTORY_MAX_PROCESSES slabs
+static int grow_pool(void) {
+    if (pool_size >= HISTORY_MAX_PROCESSES) return 0;
+    int size = pool_size ? pool_size * 2 : HISTORY_INITIAL_PROCESSES;
+    if (size > HISTORY_MAX_PROCESSES) size = HISTORY_MAX_PROCESSES;
+
+    history_slab_t *grown = realloc(slabs, size * sizeof(history_slab_t));
+    if (grown) slabs = grown;
+    int *grown_free = realloc(free_slabs, size * sizeof(int));
+    if (grown_free) free_slabs = grown_free;
+    int *grown_active = realloc(active, size * sizeof(int));
+    if (grown_active) active = grown_active;
+    int *grown_merged = realloc(merged, size * sizeof(int));
+    if (grown_merged) merged = grown_merged;
+    if (!grown || !grown_free || !grown_active || !grown_merged) return 0;
+
+    // Pushed high to low so the lowest new index is handed out first
+    for (int i = size - 1; i >= pool_size; i--) free_slabs[free_count++] = i;
+    pool_size = size;
+    return 1;
+}
+
+static int compare_last_seen(const void *a, const void *b) {
+    double sa = slabs[merged[*(const int *)a]].last_seen, sb = slabs[merged[*(const int *)b]].last_seen;
+    return (sa > sb) - (sa < sb);
+}
+
+// Frees up to needed slabs of processes the snapshot did not have, least recently seen first
+static void evict_unseen(int merged_count, double now, int needed) {
+    int *positions = malloc(merged_count * sizeof(int));
+    if (!positions) return;
+    int count = 0;
+    for (int i = 0; i < merged_count; i++) {
+        if (slabs[merged[i]].last_seen < now) positions[count++] = i;
+    }
+    qsort(positions, count, sizeof(int), compare_last_seen);
+    for (int i = 0; i < count && i < needed; i++) {
+        free_slabs[free_count++] = merged[positions[i]];
+        merged[positions[i]] = -1;
+    }
+    free(positions);
+}
+
+static void release_slab(int slot) {
+    free_slabs[free_count++] = slot;
+}
+
+// Storage I/O counters; only readable for our own processes unless running as root
+static int read_io_bytes(pid_t pid, unsigned long long *bytes) {
+    char path[64], buf[512];
+    snprintf(path, sizeof(path), "/proc/%d/io", pid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return 0;
+    buf[len] = '\0';
+
+    char *read_bytes = strstr(buf, "read_bytes:");
+    char *write_bytes = strstr(buf, "\nwrite_bytes:");
+    if (!read_bytes || !write_bytes) return 0;
+    *bytes = strtoull(read_bytes + 11, NULL, 10) + strtoull(write_bytes + 13, NULL, 10);
+    return 1;
+}
+
+static void ring_add(history_ring_t *ring, double now, double width, const float *point) {
+    long bucket = (long)(now / width);
+    if (ring->samples > 0 && bucket != ring->bucket) {
+        for (int m = 0; m < HISTORY_METRICS; m++) {
+            ring->values[m][ring->head] = (float)(ring->sum[m] / ring->samples);
+            ring->sum[m] = 0;
+        }
+        ring->head = (ring->head + 1) % HISTORY_POINTS;
+        if (ring->count < HISTORY_POINTS) ring->count++;
+        ring->samples = 0;
+    }
+    ring->bucket = bucket;
+    for (int m = 0; m < HISTORY_METRICS; m++) ring->sum[m] += point[m];
+    ring->samples++;
+}
+
+// Exponentially weighted least squares: each sum decays with the time since the last sample
+static void trend_add(history_slab_t *slab, double now, double rss_kb) {
+    double dt = slab->trend_time > 0 ? now - slab->trend_time : 0;
+    double decay = HISTORY_TREND_TAU / (HISTORY_TREND_TAU + dt);
+    double t = now - slab->first_seen;
+
+    slab->sw = slab->sw * decay + 1;
+    slab->st = slab->st * decay + t;
+    slab->sy = slab->sy * decay + rss_kb;
+    slab->stt = slab->stt * decay + t * t;
+    slab->sty = slab->sty * decay + t * rss_kb;
+    slab->syy = slab->syy * decay + rss_kb * rss_kb;
+    slab->trend_time = now;
+}
+
+static void update_slab(history_slab_t *slab, const ProcessSample *s, double now) {
+    // Extrapolated samples carry stale counters; keep the last measured rates for them
+    if (!s->extrapolated) {
+        double dt = s->sampled_at - slab->last_read;
+        unsigned long long faults = s->minflt + s->majflt;
+        if (slab->last_read > 0 && dt > 0) slab->fault_rate = (float)((faults - slab->last_faults) / dt);
+        slab->last_faults = faults;
+
+        unsigned long long io;
+        if (read_io_bytes(s->pid, &io)) {
+            if (slab->have_io && dt > 0 && io >= slab->last_io) slab->io_rate = (float)((io - slab->last_io) / 1024.0 / dt);
+            slab->last_io = io;
+            slab->have_io = 1;
+        }
+        slab->last_read = s->sampled_at;
+    }
+    slab->last_seen = now;
+
+    float point[HISTORY_METRICS];
+    point[HISTORY_CPU] = s->cpu_percent;
+    point[HISTORY_RSS] = (float)s->rss_kb;
+    point[HISTORY_IO] = slab->io_rate;
+    point[HISTORY_FAULTS] = slab->fault_rate;
+    for (int t = 0; t < HISTORY_TIERS; t++) ring_add(&slab->tiers[t], now, tier_width[t], point);
+    trend_add(slab, now, (double)s->rss_kb);
+}
+
+// Index of the kept snapshot whose removal leaves the smallest gap for its age;
+// never the oldest or the newest
+static int thinnest_baseline(double now) {
+    int best = 1;
+    double best_score = 0;
+    for (int i = 1; i < baseline_count - 1; i++) {
+        double gap = baselines[i + 1].timestamp - baselines[i - 1].timestamp;
+        double score = gap / (now - baselines[i].timestamp);
+        if (i == 1 || score < best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+// First refreshes have lifetime CPU averages rather than rates, so they are not kept
+static void keep_baseline(const ProcessSnapshot *snap) {
+    if (snap->frame == 0) return;
+    // Snapshots of another scope would diff as processes starting and exiting
+    if (memcmp(&baseline_scope, snapshot_get_scope(), sizeof(baseline_scope)) != 0) {
+        baseline_scope = *snapshot_get_scope();
+        baseline_count = 0;
+    }
+    if (baseline_count > 0 && snap->timestamp - baselines[baseline_count - 1].timestamp < HISTORY_BASELINE_SPACING) {
+        return;
+    }
+
+    if (baseline_count == HISTORY_BASELINES) {
+        // The dropped copy's buffer moves to the end and takes the new one
+        int drop = thinnest_baseline(snap->timestamp);
+        ProcessSnapshot reused = baselines[drop];
+        memmove(&baselines[drop], &baselines[drop + 1], (baseline_count - drop - 1) * sizeof(ProcessSnapshot));
+        baselines[--baseline_count] = reused;
+    }
+    ProcessSnapshot *kept = &baselines[baseline_count];
+    if (!snapshot_copy(kept, snap)) return;
+    // Open fds cannot be counted after the fact
+    snapshot_count_fds(kept);
+    baseline_count++;
+}
+
+const ProcessSnapshot *history_baseline(double age) {
+    for (int i = baseline_count - 1; i >= 0; i--) {
+        if (last_timestamp - baselines[i].timestamp >= age) return &baselines[i];
+    }
+    return NULL;
+}
+
+double history_baseline_span(void) {
+    return baseline_count ? last_timestamp - baselines[0].timestamp : 0;
+}
+
+// A process missing from a full snapshot has exited; from a scoped one it may just be outside the scope
+static void drop_or_keep(int slot, int complete, int *merged_count) {
+    if (complete) release_slab(slot);
+    else merged[(*merged_count)++] = slot;
+}
+
+void history_record(const ProcessSnapshot *snap) {
+    // Recorded frames carry another boot's clock and would poison the live rings
+    if (snap->timestamp <= last_timestamp || snapshot_replaying()) return;
+    if (!slabs && !grow_pool()) return;
+    if (snap->count > arrivals_capacity) {
+        int *grown = realloc(arrivals, snap->count * sizeof(int));
+        if (!grown) return;
+        arrivals = grown;
+        arrivals_capacity = snap->count;
+    }
+    last_timestamp = snap->timestamp;
+
+    double start = overhead_clock();
+    int complete = snapshot_get_scope()->type == SCOPE_ALL;
+    int merged_count = 0, arrival_count = 0, a = 0;
+
+    // Merge the PID-sorted snapshot with the PID-sorted active list
+    for (int i = 0; i < snap->count; i++) {
+        const ProcessSample *s = &snap->samples[i];
+        while (a < active_count && slabs[active[a]].pid < s->pid) drop_or_keep(active[a++], complete, &merged_count);
+
+        if (a < active_count && slabs[active[a]].pid == s->pid) {
+            int slot = active[a++];
+            if (slabs[slot].starttime == s->starttime) {
+                update_slab(&slabs[slot], s, snap->timestamp);
+                merged[merged_count++] = slot;
+                continue;
+            }
+            release_slab(slot);     // PID reused by a new process
+        }
+        arrivals[arrival_count++] = i;
+    }
+    while (a < active_count) drop_or_keep(active[a++], complete, &merged_count);
+
+    // New processes take free slabs, then a bigger pool, then the slabs seen least recently
+    while (free_count < arrival_count && grow_pool());
+    if (free_count < arrival_count) evict_unseen(merged_count, snap->timestamp, arrival_count - free_count);
+    untracked = 0;
+    for (int n = 0; n < arrival_count; n++) {
+        const ProcessSample *s = &snap->samples[arrivals[n]];
+        if (free_count == 0) {
+            untracked++;
+            arrivals[n] = -1;
+            continue;
+        }
+        int slot = free_slabs[--free_count];
+        memset(&slabs[slot], 0, sizeof(history_slab_t));
+        slabs[slot].pid = s->pid;
+        slabs[slot].starttime = s->starttime;
+        slabs[slot].first_seen = snap->timestamp;
+        update_slab(&slabs[slot], s, snap->timestamp);
+        arrivals[n] = slot;
+    }
+
+    // Both lists are in PID order and never share a PID
+    int m = 0, n = 0;
+    active_count = 0;
+    while (m < merged_count || n < arrival_count) {
+        if (m < merged_count && merged[m] < 0) m++;
+        else if (n < arrival_count && arrivals[n] < 0) n++;
+        else if (n == arrival_count || (m < merged_count && slabs[merged[m]].pid < slabs[arrivals[n]].pid)) {
+            active[active_count++] = merged[m++];
+        } else {
+            active[active_count++] = arrivals[n++];
+        }
+    }
+    overhead_record(PHASE_PARSE, start);
+    keep_baseline(snap);
+}
+
+static history_slab_t *find_slab(pid_t pid) {
+    int lo = 0, hi = active_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        pid_t found = slabs[active[mid]].pid;
+        if (found == pid) return &slabs[active[mid]];
+        if (found < pid) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+int history_series(pid_t pid, history_tier_t tier, history_metric_t metric, float *out) {
+    const history_slab_t *slab = slabs ? find_slab(pid) : NULL;
+    if (!slab) return 0;
+    const history_ring_t *ring = &slab->tiers[tier];
+
+    // The bucket still being filled is the newest point; the oldest full one drops to make room
+    int partial = ring->samples > 0;
+    int count = ring->count + partial > HISTORY_POINTS ? HISTORY_POINTS - partial : ring->count;
+    for (int i = 0; i < count; i++) {
+        int index = (ring->head - count + i + HISTORY_POINTS) % HISTORY_POINTS;
+        out[i] = ring->values[metric][index];
+    }
+    if (partial) out[count++] = (float)(ring->sum[metric] / ring->samples);
+    return count;
+}
+
+int history_trend(pid_t pid, history_trend_t *trend) {
+    const history_slab_t *slab = slabs ? find_slab(pid) : NULL;
+    memset(trend, 0, sizeof(*trend));
+    if (!slab) return 0;
+
+    trend->span = slab->trend_time - slab->first_seen;
+    double den = slab->sw * slab->stt - slab->st * slab->st;
+    double num = slab->sw * slab->sty - slab->st * slab->sy;
+    double var_y = slab->sw * slab->syy - slab->sy * slab->sy;
+    if (slab->sw < 3 || den <= 0) return 1;
+
+    trend->slope_kb_per_hour = num / den * 3600;
+    trend->r2 = var_y > 0 ? num * num / (den * var_y) : 0;
+
+    double rss = slab->tiers[HISTORY_1S].samples
+        ? slab->tiers[HISTORY_1S].sum[HISTORY_RSS] / slab->tiers[HISTORY_1S].samples : 0;
+    trend->leaking = trend->span >= LEAK_MIN_SPAN && trend->r2 >= LEAK_MIN_R2 &&
+                     trend->slope_kb_per_hour >= LEAK_MIN_KB_PER_HOUR &&
+                     trend->slope_kb_per_hour >= LEAK_MIN_FRACTION_PER_HOUR * rss;
+    return 1;
+}
+
+void history_sparkline(const float *values, int count, float scale_floor, char *out, size_t size) {
+    static const char ramp[] = " .:-=+*#%@";
+    int width = count < (int)size - 1 ? count : (int)size - 1;
+    const float *shown = values + count - width;
+    float min = 0, max = 0;
+    for (int i = 0; i < width; i++) {
+        if (i == 0 || shown[i] < min) min = shown[i];
+        if (i == 0 || shown[i] > max) max = shown[i];
+    }
+
+    // Large flat values like RSS read better relative to their own range
+    float base = min > 0 && (max - min) < max * 0.5f ? min : 0;
+    float range = max - base > scale_floor ? max - base : scale_floor > 0 ? scale_floor : 1;
+    for (int i = 0; i < width; i++) {
+        int level = (int)((shown[i] - base) * 9 / range + 0.5f);
+        out[i] = ramp[level < 0 ? 0 : level > 9 ? 9 : level];
+    }
+    out[width] = '\0';
+}
+
+static unsigned long read_mem_available_kb(void) {
+    char buf[2048];
+    int fd = open("/proc/meminfo", O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return 0;
+    buf[len] = '\0';
+    char *line = strstr(buf, "MemAvailable:");
+    return line ? strtoul(line + 13, NULL, 10) : 0;
+}
+
+typedef struct {
+    const ProcessSample *sample;
+    history_trend_t trend;
+} leak_row_t;
+
+static int compare_leaks(const void *a, const void *b) {
+    double sa = ((const leak_row_t *)a)->trend.slope_kb_per_hour, sb = ((const leak_row_t *)b)->trend.slope_kb_per_hour;
+    return (sa < sb) - (sa > sb);
+}
+
+static int compare_cpu(const void *a, const void *b) {
+    float ca = (*(const ProcessSample *const *)a)->cpu_percent, cb = (*(const ProcessSample *const *)b)->cpu_percent;
+    return (ca < cb) - (ca > cb);
+}
+
+static void render_history(const ProcessSnapshot *snap, history_tier_t tier, leak_row_t *leaks,
+                           const ProcessSample **order) {
+    int leak_count = 0;
+    for (int i = 0; i < snap->count; i++) {
+        order[i] = &snap->samples[i];
+        history_trend_t trend;
+        if (history_trend(snap->samples[i].pid, &trend) && trend.leaking) {
+            leaks[leak_count].sample = &snap->samples[i];
+            leaks[leak_count++].trend = trend;
+        }
+    }
+    qsort(leaks, leak_count, sizeof(leak_row_t), compare_leaks);
+    qsort(order, snap->count, sizeof(*order), compare_cpu);
+
+    printf("\033[2J\033[H");
+    printf("===== Process History (%s resolution) =====\n", tier_names[tier]);
+    char scope[600];
+    snapshot_describe_scope(scope, sizeof(scope));
+    printf("Scope: %s | %d tracked, %d untracked | %zu KB history pool\n", scope, active_count,
+           untracked, pool_size * sizeof(history_slab_t) / 1024);
+
+    float series[HISTORY_POINTS];
+    char spark[SPARKLINE_WIDTH + 1];
+    unsigned long available = read_mem_available_kb();
+    printf("\nLIKELY LEAKING (steady RSS growth, R2 >= %.1f over %.0f+ s)\n", LEAK_MIN_R2, LEAK_MIN_SPAN);
+    printf("%8s %-16s %10s %10s %5s %6s %9s  %s\n", "PID", "COMMAND", "RSS(KB)", "KB/HOUR", "R2", "SPAN", "EXHAUSTS",
+           "RSS HISTORY");
+    for (int i = 0; i < leak_count && i < LEAK_ROWS; i++) {
+        const leak_row_t *row = &leaks[i];
+        int points = history_series(row->sample->pid, tier, HISTORY_RSS, series);
+        history_sparkline(series, points, 0, spark, sizeof(spark));
+        char exhausts[16] = "-";
+        if (available > 0) snprintf(exhausts, sizeof(exhausts), "%.1fh", available / row->trend.slope_kb_per_hour);
+        printf("%8d %-16.16s %10lu %10.0f %5.2f %5.0fs %9s  [%s]\n", row->sample->pid, row->sample->command,
+               row->sample->rss_kb, row->trend.slope_kb_per_hour, row->trend.r2, row->trend.span, exhausts, spark);
+    }
+    if (leak_count == 0) printf("  none\n");
+
+    int rows = terminal_rows() - (leak_count < LEAK_ROWS ? (leak_count ? leak_count : 1) : LEAK_ROWS) - 14;
+    if (rows < 5) rows = 5;
+    printf("\n%8s %-16s %6s  %-*s %10s %8s %9s\n", "PID", "COMMAND", "CPU%", SPARKLINE_WIDTH + 2, "CPU HISTORY",
+           "RSS(KB)", "IO KB/s", "FAULTS/s");
+    for (int i = 0; i < snap->count && i < rows; i++) {
+        const ProcessSample *s = order[i];
+        float io[HISTORY_POINTS], faults[HISTORY_POINTS];
+        int points = history_series(s->pid, tier, HISTORY_CPU, series);
+        history_series(s->pid, tier, HISTORY_IO, io);
+        history_series(s->pid, tier, HISTORY_FAULTS, faults);
+        history_sparkline(series, points, metric_floor[HISTORY_CPU], spark, sizeof(spark));
+        printf("%8d %-16.16s %6.1f%c [%-*s] %10lu %8.1f %9.1f\n", s->pid, s->command, s->cpu_percent,
+               s->extrapolated ? '~' : ' ',
+               SPARKLINE_WIDTH, spark, s->rss_kb, points ? io[points - 1] : 0, points ? faults[points - 1] : 0);
+    }
+}
+
+static history_tier_t ask_tier(void) {
+    char input[16];
+    printf("Resolution: 1) 1 s  2) 10 s  3) 1 min (default 1): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return HISTORY_1S;
+    int choice = atoi(input);
+    return choice >= 1 && choice <= HISTORY_TIERS ? (history_tier_t)(choice - 1) : HISTORY_1S;
+}
+
+void show_history_view(void) {
+    if (!snapshot_supported()) {
+        printf("Process history needs /proc (Linux only)\n");
+        return;
+    }
+    history_tier_t tier = ask_tier();
+
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    leak_row_t *leaks = NULL;
+    const ProcessSample **order = NULL;
+    int capacity = 0, cur = 0;
+
+    overhead_begin(1000);
+    if (snapshot_take(&snaps[cur], NULL) < 0) return;
+    do {
+        ProcessSnapshot *snap = &snaps[cur];
+        history_record(snap);
+        if (snap->count > capacity) {
+            leak_row_t *grown_leaks = realloc(leaks, snap->count * sizeof(leak_row_t));
+            if (grown_leaks) leaks = grown_leaks;
+            const ProcessSample **grown_order = realloc(order, snap->count * sizeof(*order));
+            if (grown_order) order = grown_order;
+            if (!grown_leaks || !grown_order) break;
+            capacity = snap->count;
+        }
+
+        double start = overhead_clock();
+        render_history(snap, tier, leaks, order);
+        overhead_record(PHASE_RENDER, start);
+        int interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to return\n");
+        fflush(stdout);
+
+        if (wait_for_refresh(interval)) break;
+        cur ^= 1;
+    } while (snapshot_take(&snaps[cur], &snaps[cur ^ 1]) >= 0);
+
+    free(leaks);
+    free(order);
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
+
+void show_process_history(pid_t pid) {
+    if (!snapshot_supported()) {
+        printf("Process history needs /proc (Linux only)\n");
+        return;
+    }
+
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    int cur = 0;
+    overhead_begin(1000);
+    if (snapshot_take(&snaps[cur], NULL) < 0) return;
+    do {
+        history_record(&snaps[cur]);
+        snapshot_promote(&snaps[cur], pid);
+        const ProcessSample *s = snapshot_find(&snaps[cur], pid);
+
+        printf("\033[2J\033[H");
+        if (!s) {
+            printf("PID %d is not running or outside the monitoring scope\n", pid);
+            break;
+        }
+        printf("===== History of PID %d (%s) =====\n", pid, s->command);
+
+        float series[HISTORY_POINTS];
+        char spark[HISTORY_POINTS + 1];
+        for (int m = 0; m < HISTORY_METRICS; m++) {
+            printf("\n%s\n", metric_names[m]);
+            for (int t = 0; t < HISTORY_TIERS; t++) {
+                int points = history_series(pid, t, m, series);
+                float min = 0, max = 0;
+                for (int i = 0; i < points; i++) {
+                    if (i == 0 || series[i] < min) min = series[i];
+                    if (i == 0 || series[i] > max) max = series[i];
+                }
+                history_sparkline(series, points, metric_floor[m], spark, sizeof(spark));
+                printf("  %-4s [%-*s] min %.1f max %.1f now %.1f\n", tier_names[t], HISTORY_POINTS, spark,
+                       min, max, points ? series[points - 1] : 0);
+            }
+        }
+
+        history_trend_t trend;
+        if (history_trend(pid, &trend)) {
+            printf("\nRSS trend: %+.0f KB/hour (R2 %.2f over %.0f s)%s\n", trend.slope_kb_per_hour, trend.r2,
+                   trend.span, trend.leaking ? " - likely leaking" : "");
+        }
+        int interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to return\n");
+        fflush(stdout);
+
+        if (wait_for_refresh(interval)) break;
+        cur ^= 1;
+    } while (snapshot_take(&snaps[cur], &snaps[cur ^ 1]) >= 0);
+
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
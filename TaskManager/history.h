@@ -0,0 +1,102 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <sys/types.h>
+#include <stddef.h>
+#include "proc_snapshot.h"
+
+#define HISTORY_POINTS 60           // Points kept per tier and metric
+#define HISTORY_INITIAL_PROCESSES 1024  // Slabs allocated by the first recording; the pool doubles from there
+#define HISTORY_MAX_PROCESSES 16384     // Largest pool; then the least recently seen slabs are reused
+#define HISTORY_BASELINES 12            // Whole snapshots kept for diffs against the past
+#define HISTORY_BASELINE_SPACING 5.0    // Seconds between kept snapshots before older ones are thinned out
+
+typedef enum {
+    HISTORY_CPU,                    // Percent
+    HISTORY_RSS,                    // KB
+    HISTORY_IO,                     // Storage read + write KB/s
+    HISTORY_FAULTS,                 // Minor + major faults per second
+    HISTORY_METRICS
+} history_metric_t;
+
+typedef enum {
+    HISTORY_1S,
+    HISTORY_10S,
+    HISTORY_1MIN,
+    HISTORY_TIERS
+} history_tier_t;
+
+// RSS trend from an exponentially weighted streaming linear regression
+typedef struct {
+    double slope_kb_per_hour;
+    double r2;                      // Fit quality, 1 for a perfectly straight line
+    double span;                    // Seconds of history behind the fit
+    int leaking;
+} history_trend_t;
+
+/**
+ * Appends one snapshot to the per-process histories. Exited processes
+ * hand their slab back to the pool. A scoped snapshot leaves the histories
+ * of processes outside the scope alone; they are reused last, once the
+ * pool is full. Recording the same snapshot twice is a no-op, so several
+ * views can feed the store.
+ * @param snap The snapshot, sorted by PID as snapshot_take leaves it
+ */
+void history_record(const ProcessSnapshot *snap);
+
+/**
+ * Finds a kept snapshot for comparing against the host as it was a while
+ * ago. history_record keeps up to HISTORY_BASELINES copies with their fd
+ * counts, and thins them so that older ones lie further apart.
+ * @param age Seconds before the last recorded snapshot
+ * @return The youngest copy at least that old, valid until the next
+ *         history_record, or NULL if none is
+ */
+const ProcessSnapshot *history_baseline(double age);
+
+/**
+ * Age of the oldest kept snapshot relative to the last recorded one
+ * @return Seconds, 0 if none is kept
+ */
+double history_baseline_span(void);
+
+/**
+ * Copies one metric of a tracked process, oldest point first
+ * @param pid The process ID
+ * @param tier Resolution of the series
+ * @param metric The metric
+ * @param out Receives up to HISTORY_POINTS values
+ * @return Number of points, 0 if the process is not tracked
+ */
+int history_series(pid_t pid, history_tier_t tier, history_metric_t metric, float *out);
+
+/**
+ * Current RSS trend of a tracked process
+ * @param pid The process ID
+ * @param trend Receives the trend
+ * @return 1 if the process is tracked, 0 otherwise
+ */
+int history_trend(pid_t pid, history_trend_t *trend);
+
+/**
+ * Draws values as a one-line ASCII sparkline scaled to the largest value
+ * @param values Series, oldest first
+ * @param count Number of values
+ * @param scale_floor Smallest full-scale value, so idle noise stays flat
+ * @param out Receives count characters and a terminator
+ * @param size Size of out
+ */
+void history_sparkline(const float *values, int count, float scale_floor, char *out, size_t size);
+
+/**
+ * Live view of leak suspects and the busiest processes with sparklines
+ */
+void show_history_view(void);
+
+/**
+ * Every metric and tier of one process as sparklines
+ * @param pid The process ID
+ */
+void show_process_history(pid_t pid);
+
+#endif
@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "io_panel.h"
+#include "cpu_panel.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define IO_BUFFER_SIZE 65536        // Holds /proc/net/dev or /proc/diskstats for IO_MAX_DEVICES entries
+#define IO_COUNTERS 8
+#define IO_REFRESH_MS 1000
+#define SECTOR_BYTES 512
+
+// Counter slots of a disk
+enum { DISK_READS, DISK_READ_SECTORS, DISK_READ_MS, DISK_WRITES, DISK_WRITE_SECTORS, DISK_WRITE_MS, DISK_IO_MS };
+
+// Counter slots of a network interface
+enum { NET_RX_BYTES, NET_RX_PACKETS, NET_RX_DROP, NET_TX_BYTES, NET_TX_PACKETS, NET_TX_DROP };
+
+typedef struct {
+    char name[32];
+    int used;
+    int skip;                       // Partitions are tracked but not shown
+    unsigned long seen;             // Refresh number of the last read that listed the device
+    int has_previous;
+    double sampled_at;
+    double previous_at;
+    unsigned long long current[IO_COUNTERS];
+    unsigned long long previous[IO_COUNTERS];
+} io_device_t;
+
+typedef struct {
+    io_device_t devices[IO_MAX_DEVICES];
+    int hint;                       // Slot after the last match; /proc lists devices in a stable order
+    int dropped;                    // Devices ignored because the table was full
+} device_table_t;
+
+struct io_panel {
+    device_table_t disks;
+    device_table_t interfaces;
+    unsigned long refresh;
+    int sysfs_block;                // /sys/block exists, so partitions can be told apart
+    char buf[IO_BUFFER_SIZE];
+};
+
+io_panel_t *io_panel_create(void) {
+    io_panel_t *panel = calloc(1, sizeof(io_panel_t));
+    if (!panel) return NULL;
+    panel->sysfs_block = access("/sys/block", F_OK) == 0;
+    return panel;
+}
+
+void io_panel_destroy(io_panel_t *panel) {
+    free(panel);
+}
+
+static ssize_t read_into_buffer(io_panel_t *panel, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(panel->buf) - 1 &&
+           (n = read(fd, panel->buf + len, sizeof(panel->buf) - 1 - len)) > 0) {
+        len += n;
+    }
+    close(fd);
+    panel->buf[len] = '\0';
+    return len;
+}
+
+// Finds the slot of a device, claiming a free one for newcomers
+static io_device_t *find_or_add_device(device_table_t *table, const char *name, unsigned long refresh) {
+    io_device_t *hinted = &table->devices[table->hint];
+    if (hinted->used && strcmp(hinted->name, name) == 0) {
+        table->hint = (table->hint + 1) % IO_MAX_DEVICES;
+        hinted->seen = refresh;
+        return hinted;
+    }
+
+    int free_slot = -1;
+    for (int i = 0; i < IO_MAX_DEVICES; i++) {
+        io_device_t *device = &table->devices[i];
+        if (!device->used) {
+            if (free_slot < 0) free_slot = i;
+            continue;
+        }
+        if (strcmp(device->name, name) == 0) {
+            table->hint = (i + 1) % IO_MAX_DEVICES;
+            device->seen = refresh;
+            return device;
+        }
+    }
+
+    if (free_slot < 0) {
+        table->dropped++;
+        return NULL;
+    }
+    io_device_t *device = &table->devices[free_slot];
+    memset(device, 0, sizeof(*device));
+    snprintf(device->name, sizeof(device->name), "%s", name);
+    device->used = 1;
+    device->seen = refresh;
+    table->hint = (free_slot + 1) % IO_MAX_DEVICES;
+    return device;
+}
+
+static void store_counters(io_device_t *device, const unsigned long long *counters, double now) {
+    if (device->sampled_at > 0) {
+        memcpy(device->previous, device->current, sizeof(device->previous));
+        device->previous_at = device->sampled_at;
+        device->has_previous = 1;
+    }
+    memcpy(device->current, counters, sizeof(device->current));
+    device->sampled_at = now;
+}
+
+// Slots of devices that vanished (unplugged disks, deleted veth pairs) are reused
+static void release_missing(device_table_t *table, unsigned long refresh) {
+    for (int i = 0; i < IO_MAX_DEVICES; i++) {
+        if (table->devices[i].used && table->devices[i].seen != refresh) {
+            table->devices[i].used = 0;
+        }
+    }
+}
+
+static int sample_disks(io_panel_t *panel, double now) {
+    double start = overhead_clock();
+    ssize_t len = read_into_buffer(panel, "/proc/diskstats");
+    overhead_record(PHASE_READ, start);
+    if (len <= 0) return -1;
+
+    start = overhead_clock();
+    char *line = panel->buf;
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        char name[32];
+        unsigned long long c[IO_COUNTERS] = {0};
+        if (sscanf(line, "%*u %*u %31s %llu %*u %llu %llu %llu %*u %llu %llu %*u %llu",
+                   name, &c[DISK_READS], &c[DISK_READ_SECTORS], &c[DISK_READ_MS],
+                   &c[DISK_WRITES], &c[DISK_WRITE_SECTORS], &c[DISK_WRITE_MS], &c[DISK_IO_MS]) == 8) {
+            io_device_t *device = find_or_add_device(&panel->disks, name, panel->refresh);
+            if (device) {
+                if (device->sampled_at == 0 && panel->sysfs_block) {
+                    // Only whole disks have an entry in /sys/block; checked once per device
+                    char path[64];
+                    snprintf(path, sizeof(path), "/sys/block/%s", name);
+                    device->skip = access(path, F_OK) != 0;
+                }
+                store_counters(device, c, now);
+            }
+        }
+        line = next;
+    }
+    release_missing(&panel->disks, panel->refresh);
+    overhead_record(PHASE_PARSE, start);
+    return 0;
+}
+
+static int sample_interfaces(io_panel_t *panel, double now) {
+    double start = overhead_clock();
+    ssize_t len = read_into_buffer(panel, "/proc/net/dev");
+    overhead_record(PHASE_READ, start);
+    if (len <= 0) return -1;
+
+    start = overhead_clock();
+    char *line = panel->buf;
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        // The two header lines have no colon after the interface name
+        char *colon = strchr(line, ':');
+        if (colon) {
+            *colon = '\0';
+            while (*line == ' ') line++;
+
+            unsigned long long c[IO_COUNTERS] = {0};
+            if (sscanf(colon + 1, "%llu %llu %*u %llu %*u %*u %*u %*u %llu %llu %*u %llu",
+                       &c[NET_RX_BYTES], &c[NET_RX_PACKETS], &c[NET_RX_DROP],
+                       &c[NET_TX_BYTES], &c[NET_TX_PACKETS], &c[NET_TX_DROP]) == 6) {
+                io_device_t *device = find_or_add_device(&panel->interfaces, line, panel->refresh);
+                if (device) store_counters(device, c, now);
+            }
+        }
+        line = next;
+    }
+    release_missing(&panel->interfaces, panel->refresh);
+    overhead_record(PHASE_PARSE, start);
+    return 0;
+}
+
+int io_panel_sample(io_panel_t *panel) {
+    double now = overhead_clock();
+    panel->refresh++;
+    // Counted afresh by this pass and kept for the render that follows it
+    panel->disks.dropped = 0;
+    panel->interfaces.dropped = 0;
+    int disks = sample_disks(panel, now);
+    int interfaces = sample_interfaces(panel, now);
+    return disks < 0 && interfaces < 0 ? -1 : 0;
+}
+
+static double counter_rate(const io_device_t *device, int counter) {
+    double elapsed = device->sampled_at - device->previous_at;
+    if (!device->has_previous || elapsed <= 0 || device->current[counter] < device->previous[counter]) {
+        return 0;
+    }
+    return (device->current[counter] - device->previous[counter]) / elapsed;
+}
+
+static void render_disks(const device_table_t *table, int show_idle) {
+    printf("%-16s %9s %9s %10s %10s %10s %6s\n",
+           "DISK", "READ/s", "WRITE/s", "RD MB/s", "WR MB/s", "AWAIT(ms)", "UTIL%");
+
+    int hidden = 0;
+    for (int i = 0; i < IO_MAX_DEVICES; i++) {
+        const io_device_t *d = &table->devices[i];
+        if (!d->used || d->skip) continue;
+
+        double reads = counter_rate(d, DISK_READS), writes = counter_rate(d, DISK_WRITES);
+        double io_ms = counter_rate(d, DISK_IO_MS);
+        if (!show_idle && reads + writes == 0 && io_ms == 0) {
+            hidden++;
+            continue;
+        }
+
+        // Average time per completed request, queueing included
+        double ops = reads + writes;
+        double await = ops > 0 ? (counter_rate(d, DISK_READ_MS) + counter_rate(d, DISK_WRITE_MS)) / ops : 0;
+        double util = io_ms / 10.0; // ms busy per second -> percent
+        printf("%-16.16s %9.1f %9.1f %10.2f %10.2f %10.2f %6.1f\n",
+               d->name, reads, writes,
+               counter_rate(d, DISK_READ_SECTORS) * SECTOR_BYTES / (1024.0 * 1024.0),
+               counter_rate(d, DISK_WRITE_SECTORS) * SECTOR_BYTES / (1024.0 * 1024.0),
+               await, util > 100 ? 100 : util);
+    }
+    if (hidden > 0) printf("(%d idle disks hidden)\n", hidden);
+    if (table->dropped > 0) printf("(%d disks not tracked, table full)\n", table->dropped);
+}
+
+static void render_interfaces(const device_table_t *table, int show_idle) {
+    printf("%-16s %10s %10s %10s %10s %9s %9s\n",
+           "INTERFACE", "RX KB/s", "TX KB/s", "RX pkt/s", "TX pkt/s", "RX drop/s", "TX drop/s");
+
+    int hidden = 0;
+    for (int i = 0; i < IO_MAX_DEVICES; i++) {
+        const io_device_t *d = &table->devices[i];
+        if (!d->used) continue;
+
+        double rx_packets = counter_rate(d, NET_RX_PACKETS), tx_packets = counter_rate(d, NET_TX_PACKETS);
+        double rx_drop = counter_rate(d, NET_RX_DROP), tx_drop = counter_rate(d, NET_TX_DROP);
+        if (!show_idle && rx_packets + tx_packets + rx_drop + tx_drop == 0) {
+            hidden++;
+            continue;
+        }
+        printf("%-16.16s %10.1f %10.1f %10.1f %10.1f %9.1f %9.1f\n",
+               d->name, counter_rate(d, NET_RX_BYTES) / 1024.0, counter_rate(d, NET_TX_BYTES) / 1024.0,
+               rx_packets, tx_packets, rx_drop, tx_drop);
+    }
+    if (hidden > 0) printf("(%d idle interfaces hidden)\n", hidden);
+    if (table->dropped > 0) printf("(%d interfaces not tracked, table full)\n", table->dropped);
+}
+
+void io_panel_render(const io_panel_t *panel, int show_idle) {
+    render_disks(&panel->disks, show_idle);
+    printf("\n");
+    render_interfaces(&panel->interfaces, show_idle);
+}
+
+void show_system_overview(void) {
+    cpu_panel_t *cpu = cpu_panel_create();
+    io_panel_t *io = io_panel_create();
+    if (!cpu || !io) {
+        perror("Out of memory");
+        cpu_panel_destroy(cpu);
+        io_panel_destroy(io);
+        return;
+    }
+
+    overhead_begin(IO_REFRESH_MS);
+    int interval = IO_REFRESH_MS;
+    do {
+        int have_cpu = cpu_panel_sample(cpu) > 0;
+        int have_io = io_panel_sample(io) == 0;
+        if (!have_cpu && !have_io) {
+            printf("The system overview requires /proc\n");
+            break;
+        }
+
+        double start = overhead_clock();
+        printf("\033[2J\033[H");
+        printf("===== System Overview =====\n");
+        if (have_cpu) {
+            cpu_panel_render(cpu, terminal_rows() / 2);
+            printf("\n");
+        }
+        if (have_io) {
+            io_panel_render(io, 0);
+        }
+        overhead_record(PHASE_RENDER, start);
+        interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to return\n");
+        fflush(stdout);
+    } while (!wait_for_refresh(interval));
+
+    cpu_panel_destroy(cpu);
+    io_panel_destroy(io);
+}
@@ -0,0 +1,42 @@
+#ifndef IO_PANEL_H
+#define IO_PANEL_H
+
+#define IO_MAX_DEVICES 256          // Fixed table size for disks and for interfaces
+
+typedef struct io_panel io_panel_t;
+
+/**
+ * Creates the disk and network panel. Every table and read buffer is
+ * allocated here once; refreshing never allocates.
+ * @return The panel, or NULL if out of memory
+ */
+io_panel_t *io_panel_create(void);
+
+/**
+ * Reads /proc/diskstats and /proc/net/dev and computes per-device rates.
+ * Devices missing from a read free their slot for newcomers (veth pairs etc.)
+ * @param panel The panel
+ * @return 0 on success, -1 if neither file could be read
+ */
+int io_panel_sample(io_panel_t *panel);
+
+/**
+ * Prints the disk table (IOPS, throughput, await, utilisation) and the
+ * interface table (bytes, packets and drops per second)
+ * @param panel The panel
+ * @param show_idle 1 to include devices without traffic in the last interval
+ */
+void io_panel_render(const io_panel_t *panel, int show_idle);
+
+/**
+ * Frees the panel
+ * @param panel The panel
+ */
+void io_panel_destroy(io_panel_t *panel);
+
+/**
+ * Live system overview: per-core CPU, disks and network interfaces
+ */
+void show_system_overview(void);
+
+#endif
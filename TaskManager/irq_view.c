@@ -0,0 +1,377 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <stdint.h>
+#include "irq_view.h"
+#include "cpu_panel.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define IRQ_MAX_ROWS 2048
+#define IRQ_MAX_CPUS 1024
+#define IRQ_LABEL_LEN 16
+#define IRQ_DESC_LEN 40
+#define IRQ_CHUNK 4096              // Streaming read size; lines are never buffered whole
+#define IRQ_REFRESH_MS 1000
+#define IRQ_SHOWN_ROWS 20
+#define IMBALANCE_MIN_RATE 100.0    // Interrupts/s below which balance does not matter
+#define IMBALANCE_SHARE 0.9         // Flag lines where one core takes this share
+#define SOFTIRQ_SATURATED 25.0      // Softirq CPU percent that counts as saturated
+
+typedef enum {
+    PARSE_HEADER,                   // "CPU0 CPU1 ..." column list
+    PARSE_LABEL,                    // Text up to the first ':'
+    PARSE_COUNTS,                   // One counter per CPU column
+    PARSE_DESC                      // Chip, hwirq and device names
+} parse_state_t;
+
+// One of /proc/interrupts or /proc/softirqs; both share the same layout
+typedef struct {
+    const char *path;
+    int ncpu;                       // Columns in the header
+    int cpu_ids[IRQ_MAX_CPUS];      // CPU number of each column, offline CPUs are skipped
+    int rows[2];
+    int current;
+    double sampled_at[2];
+    char labels[2][IRQ_MAX_ROWS][IRQ_LABEL_LEN];
+    char descs[IRQ_MAX_ROWS][IRQ_DESC_LEN];
+    uint64_t *counts[2];            // rows x ncpu matrices
+    int matrix_cpus;                // ncpu the matrices were sized for
+    double *rates;                  // rows x ncpu, per second
+    double row_rate[IRQ_MAX_ROWS];
+
+    // Parser state, carried across read() chunks
+    parse_state_t state;
+    int col;
+    int label_len;
+    int desc_len;
+    uint64_t number;
+    int in_number;
+    char last[3];                   // Trailing header characters, to spot "CPU"
+} irq_table_t;
+
+static int ensure_matrices(irq_table_t *t) {
+    if (t->matrix_cpus == t->ncpu && t->counts[0]) return 1;
+    free(t->counts[0]);
+    free(t->counts[1]);
+    free(t->rates);
+    size_t cells = (size_t)IRQ_MAX_ROWS * (t->ncpu ? t->ncpu : 1);
+    t->counts[0] = calloc(cells, sizeof(uint64_t));
+    t->counts[1] = calloc(cells, sizeof(uint64_t));
+    t->rates = calloc(cells, sizeof(double));
+    t->matrix_cpus = t->ncpu;
+    // New geometry: the previous sample can no longer be compared against
+    t->rows[0] = t->rows[1] = 0;
+    return t->counts[0] && t->counts[1] && t->rates;
+}
+
+static void end_row(irq_table_t *t) {
+    int cur = t->current;
+    if (t->in_number && t->state == PARSE_COUNTS && t->col < t->ncpu) {
+        t->counts[cur][(size_t)t->rows[cur] * t->ncpu + t->col++] = t->number;
+    }
+    if (t->state != PARSE_HEADER && t->label_len > 0 && t->rows[cur] < IRQ_MAX_ROWS) {
+        // Lines with fewer columns (ERR, MIS) leave the rest at zero
+        for (int c = t->col; c < t->ncpu; c++) {
+            t->counts[cur][(size_t)t->rows[cur] * t->ncpu + c] = 0;
+        }
+        t->labels[cur][t->rows[cur]][t->label_len] = '\0';
+        t->descs[t->rows[cur]][t->desc_len] = '\0';
+        t->rows[cur]++;
+    }
+    t->state = PARSE_LABEL;
+    t->col = 0;
+    t->label_len = 0;
+    t->desc_len = 0;
+    t->in_number = 0;
+}
+
+// Consumes one character; the whole file passes through here exactly once
+static void feed(irq_table_t *t, char c) {
+    int cur = t->current;
+    int row = t->rows[cur] < IRQ_MAX_ROWS ? t->rows[cur] : IRQ_MAX_ROWS - 1;
+
+    switch (t->state) {
+        case PARSE_HEADER:
+            if (c == '\n') {
+                if (t->in_number && t->ncpu < IRQ_MAX_CPUS) t->cpu_ids[t->ncpu++] = (int)t->number;
+                t->in_number = 0;
+                if (!ensure_matrices(t)) t->ncpu = 0;
+                t->state = PARSE_LABEL;
+            } else if (isdigit((unsigned char)c) && (t->in_number || memcmp(t->last, "CPU", 3) == 0)) {
+                t->number = t->in_number ? t->number * 10 + (c - '0') : (uint64_t)(c - '0');
+                t->in_number = 1;
+            } else {
+                if (t->in_number && t->ncpu < IRQ_MAX_CPUS) t->cpu_ids[t->ncpu++] = (int)t->number;
+                t->in_number = 0;
+            }
+            t->last[0] = t->last[1];
+            t->last[1] = t->last[2];
+            t->last[2] = c;
+            break;
+
+        case PARSE_LABEL:
+            if (c == '\n') {
+                end_row(t);
+            } else if (c == ':') {
+                t->state = PARSE_COUNTS;
+            } else if (c != ' ' && t->label_len < IRQ_LABEL_LEN - 1) {
+                t->labels[cur][row][t->label_len++] = c;
+            }
+            break;
+
+        case PARSE_COUNTS:
+            if (isdigit((unsigned char)c)) {
+                t->number = t->in_number ? t->number * 10 + (c - '0') : (uint64_t)(c - '0');
+                t->in_number = 1;
+            } else if (c == '\n') {
+                end_row(t);
+            } else if (c == ' ') {
+                if (t->in_number) {
+                    if (t->col < t->ncpu) t->counts[cur][(size_t)row * t->ncpu + t->col] = t->number;
+                    t->col++;
+                    t->in_number = 0;
+                    if (t->col >= t->ncpu) t->state = PARSE_DESC;
+                }
+            } else {
+                // Text before all columns were filled: the description started early
+                t->state = PARSE_DESC;
+                if (t->desc_len < IRQ_DESC_LEN - 1) t->descs[row][t->desc_len++] = c;
+            }
+            break;
+
+        case PARSE_DESC:
+            if (c == '\n') {
+                end_row(t);
+            } else if ((c != ' ' || (t->desc_len > 0 && t->descs[row][t->desc_len - 1] != ' ')) &&
+                       t->desc_len < IRQ_DESC_LEN - 1) {
+                t->descs[row][t->desc_len++] = c; // Runs of spaces collapse to one
+            }
+            break;
+    }
+}
+
+static int sample_table(irq_table_t *t) {
+    double start = overhead_clock();
+    int fd = open(t->path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    t->current ^= 1;
+    t->rows[t->current] = 0;
+    t->ncpu = 0;
+    t->state = PARSE_HEADER;
+    t->in_number = 0;
+    t->col = t->label_len = t->desc_len = 0;
+    memset(t->last, 0, sizeof(t->last));
+
+    char chunk[IRQ_CHUNK];
+    ssize_t n;
+    double read_time = 0;
+    while (1) {
+        double read_start = overhead_clock();
+        n = read(fd, chunk, sizeof(chunk));
+        read_time += overhead_clock() - read_start;
+        if (n <= 0) break;
+        for (ssize_t i = 0; i < n; i++) feed(t, chunk[i]);
+    }
+    if (t->state != PARSE_LABEL || t->label_len > 0) end_row(t);
+    close(fd);
+    t->sampled_at[t->current] = overhead_clock();
+
+    // read() and parsing interleave per chunk, so split the elapsed time by what was spent in read()
+    overhead_record(PHASE_READ, overhead_clock() - read_time);
+    overhead_record(PHASE_PARSE, start + read_time);
+    return t->ncpu > 0 ? 0 : -1;
+}
+
+// Rows are matched by label; the order is usually unchanged, so try the same index first
+static void compute_rates(irq_table_t *t) {
+    int cur = t->current, prev = cur ^ 1;
+    double elapsed = t->sampled_at[cur] - t->sampled_at[prev];
+    int have_previous = t->rows[prev] > 0 && elapsed > 0;
+
+    for (int r = 0; r < t->rows[cur]; r++) {
+        double *rates = &t->rates[(size_t)r * t->ncpu];
+        t->row_rate[r] = 0;
+        memset(rates, 0, t->ncpu * sizeof(double));
+
+        int p = -1;
+        if (have_previous) {
+            if (r < t->rows[prev] && strcmp(t->labels[prev][r], t->labels[cur][r]) == 0) {
+                p = r;
+            } else {
+                for (int i = 0; i < t->rows[prev]; i++) {
+                    if (strcmp(t->labels[prev][i], t->labels[cur][r]) == 0) {
+                        p = i;
+                        break;
+                    }
+                }
+            }
+        }
+        if (p < 0) continue;
+
+        const uint64_t *now = &t->counts[cur][(size_t)r * t->ncpu];
+        const uint64_t *before = &t->counts[prev][(size_t)p * t->ncpu];
+        for (int c = 0; c < t->ncpu; c++) {
+            rates[c] = now[c] > before[c] ? (now[c] - before[c]) / elapsed : 0;
+            t->row_rate[r] += rates[c];
+        }
+    }
+}
+
+static int find_row(const irq_table_t *t, const char *label) {
+    for (int r = 0; r < t->rows[t->current]; r++) {
+        if (strcmp(t->labels[t->current][r], label) == 0) return r;
+    }
+    return -1;
+}
+
+// One character per CPU; neighbouring CPUs share a cell when there are more CPUs than columns
+static void render_heat_cells(const double *rates, int ncpu, double max_rate, int width) {
+    static const char ramp[] = " .:-=+*#%@";
+    int cells = ncpu < width ? ncpu : width;
+    for (int cell = 0; cell < cells; cell++) {
+        int first = cell * ncpu / cells, last = (cell + 1) * ncpu / cells;
+        double peak = 0;
+        for (int c = first; c < last; c++) {
+            if (rates[c] > peak) peak = rates[c];
+        }
+        int level = max_rate > 0 ? (int)(peak * 9 / max_rate + 0.999) : 0;
+        putchar(ramp[level > 9 ? 9 : level]);
+    }
+}
+
+static irq_table_t *sort_table;
+
+static int compare_row_rate(const void *a, const void *b) {
+    double ra = sort_table->row_rate[*(const int *)a], rb = sort_table->row_rate[*(const int *)b];
+    return (ra < rb) - (ra > rb);
+}
+
+static void render_interrupts(irq_table_t *t, int heat_width) {
+    static int order[IRQ_MAX_ROWS];
+    int rows = t->rows[t->current];
+    for (int r = 0; r < rows; r++) order[r] = r;
+    sort_table = t;
+    qsort(order, rows, sizeof(int), compare_row_rate);
+
+    printf("%-8s %10s %-*s  %s\n", "IRQ", "TOTAL/s", heat_width, "PER-CPU HEAT", "DEVICE / NOTE");
+    for (int i = 0; i < rows && i < IRQ_SHOWN_ROWS; i++) {
+        int r = order[i];
+        if (t->row_rate[r] <= 0) break;
+        const double *rates = &t->rates[(size_t)r * t->ncpu];
+
+        int top = 0;
+        for (int c = 1; c < t->ncpu; c++) {
+            if (rates[c] > rates[top]) top = c;
+        }
+        printf("%-8.8s %10.0f ", t->labels[t->current][r], t->row_rate[r]);
+        render_heat_cells(rates, t->ncpu, rates[top], heat_width);
+        int cells = t->ncpu < heat_width ? t->ncpu : heat_width;
+        printf("%*s  %-24.24s", heat_width - cells, "", t->descs[r]);
+
+        double share = rates[top] / t->row_rate[r];
+        if (t->ncpu > 1 && t->row_rate[r] >= IMBALANCE_MIN_RATE && share >= IMBALANCE_SHARE) {
+            printf(" \033[1;31mIMBALANCED %.0f%% on CPU%d\033[0m", share * 100, t->cpu_ids[top]);
+        }
+        printf("\n");
+    }
+}
+
+static void render_softirqs(irq_table_t *t, const cpu_panel_t *cpu, int heat_width) {
+    printf("%-8s %10s %-*s\n", "SOFTIRQ", "TOTAL/s", heat_width, "PER-CPU HEAT");
+    for (int r = 0; r < t->rows[t->current]; r++) {
+        const double *rates = &t->rates[(size_t)r * t->ncpu];
+        double peak = 0;
+        for (int c = 0; c < t->ncpu; c++) {
+            if (rates[c] > peak) peak = rates[c];
+        }
+        printf("%-8.8s %10.0f ", t->labels[t->current][r], t->row_rate[r]);
+        render_heat_cells(rates, t->ncpu, peak, heat_width);
+        printf("\n");
+    }
+
+    int net_rx = find_row(t, "NET_RX"), net_tx = find_row(t, "NET_TX");
+    if (net_rx < 0 && net_tx < 0) return;
+
+    // A core is saturated when softirq time is high and network work dominates its softirqs
+    printf("\nNetwork softirq load per core (softirq CPU >= %.0f%% flagged):\n", SOFTIRQ_SATURATED);
+    int flagged = 0;
+    for (int c = 0; c < t->ncpu; c++) {
+        double rx = net_rx >= 0 ? t->rates[(size_t)net_rx * t->ncpu + c] : 0;
+        double tx = net_tx >= 0 ? t->rates[(size_t)net_tx * t->ncpu + c] : 0;
+        double all = 0;
+        for (int r = 0; r < t->rows[t->current]; r++) all += t->rates[(size_t)r * t->ncpu + c];
+        float si = cpu ? cpu_panel_percent(cpu, CPU_SOFTIRQ, t->cpu_ids[c]) : 0;
+
+        if (si >= SOFTIRQ_SATURATED && all > 0 && (rx + tx) / all >= 0.5) {
+            printf("  \033[1;31mCPU%-4d si %5.1f%%  NET_RX %10.0f/s  NET_TX %10.0f/s  SATURATED\033[0m\n",
+                   t->cpu_ids[c], si, rx, tx);
+            flagged++;
+        }
+    }
+    if (flagged == 0) printf("  No core is saturated by NET_RX/NET_TX\n");
+}
+
+static void free_table(irq_table_t *t) {
+    if (!t) return;
+    free(t->counts[0]);
+    free(t->counts[1]);
+    free(t->rates);
+    free(t);
+}
+
+void show_interrupt_view(void) {
+    irq_table_t *irqs = calloc(1, sizeof(irq_table_t));
+    irq_table_t *softirqs = calloc(1, sizeof(irq_table_t));
+    cpu_panel_t *cpu = cpu_panel_create();
+    if (!irqs || !softirqs) {
+        perror("Out of memory");
+        free_table(irqs);
+        free_table(softirqs);
+        cpu_panel_destroy(cpu);
+        return;
+    }
+    irqs->path = "/proc/interrupts";
+    softirqs->path = "/proc/softirqs";
+
+    overhead_begin(IRQ_REFRESH_MS);
+    int interval = IRQ_REFRESH_MS;
+    do {
+        if (sample_table(irqs) < 0) {
+            printf("Cannot read /proc/interrupts\n");
+            break;
+        }
+        int have_softirqs = sample_table(softirqs) == 0;
+        if (cpu) cpu_panel_sample(cpu);
+
+        double start = overhead_clock();
+        compute_rates(irqs);
+        if (have_softirqs) compute_rates(softirqs);
+        overhead_record(PHASE_SORT, start);
+
+        start = overhead_clock();
+        int heat_width = irqs->ncpu < 64 ? (irqs->ncpu > 12 ? irqs->ncpu : 12) : 64;
+        printf("\033[2J\033[H");
+        printf("===== Interrupts and Softirqs (%d CPUs, %d IRQ lines) =====\n",
+               irqs->ncpu, irqs->rows[irqs->current]);
+        render_interrupts(irqs, heat_width);
+        if (have_softirqs) {
+            printf("\n");
+            render_softirqs(softirqs, cpu, heat_width);
+        }
+        overhead_record(PHASE_RENDER, start);
+        interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Heat: ' ' none to '@' the busiest CPU of the line. Press Enter to return\n");
+        fflush(stdout);
+    } while (!wait_for_refresh(interval));
+
+    free_table(irqs);
+    free_table(softirqs);
+    cpu_panel_destroy(cpu);
+}
@@ -0,0 +1,11 @@
+#ifndef IRQ_VIEW_H
+#define IRQ_VIEW_H
+
+/**
+ * Live heatmap of /proc/interrupts and /proc/softirqs rates per CPU.
+ * Flags IRQ lines served almost entirely by one core and cores whose
+ * softirq time is dominated by NET_RX/NET_TX work.
+ */
+void show_interrupt_view(void);
+
+#endif
@@ -8,13 +8,35 @@
 #include <string.h>
 #include <termios.h>
 #include <time.h>
+#include <pwd.h>
 #include "process_manager.h"
+#include "taskstats.h"
+#include "perf_counters.h"
+#include "cgroup.h"
+#include "cgroup_view.h"
+#include "proc_snapshot.h"
+#include "overhead.h"
+#include "io_panel.h"
+#include "irq_view.h"
+#include "psi_view.h"
+#include "blocked_view.h"
+#include "socket_view.h"
+#include "maps_view.h"
+#include "numa_view.h"
+#include "history.h"
+#include "recording_view.h"
+#include "diff_view.h"
+#include "group_view.h"
+#include "snapshot_shm.h"
+#include "snapshot_daemon.h"
+#include "taskmgr.h"
+#include "headless.h"
 
 #define DEFAULT_PORT 8990
 #define KEY_UP 65
 #define KEY_DOWN 66
 #define KEY_ENTER 13
-#define MENU_ITEMS 15
+#define MENU_ITEMS 29
 
 // Function to handle terminal settings for interactive mode
 struct termios orig_termios;
@@ -101,7 +123,21 @@ void print_menu_with_selection(int selected) {
         "Add demo task",
         "Filter tasks by name",
         "Start chat server",
-        "Connect to chat"
+        "Connect to chat",
+        "cgroup overview",
+        "Sampling settings",
+        "System overview",
+        "Interrupts and softirqs",
+        "Pressure stall dashboard",
+        "Blocked task analyser",
+        "Sockets by process",
+        "NUMA placement",
+        "Process history and leak detection",
+        "Record snapshots to file",
+        "Replay a recording",
+        "Snapshot diff",
+        "Totals by user or command",
+        "Attach to or detach from the monitoring daemon"
     };
     
     clear_screen();
@@ -109,7 +145,13 @@ void print_menu_with_selection(int selected) {
     // Print header with padding
     printf("\n╔════════════════════════════════════════╗\n");
     printf("║          Process Manager Menu          ║\n");
-    printf("╚════════════════════════════════════════╝\n\n");
+    printf("╚════════════════════════════════════════╝\n");
+    if (snapshot_get_scope()->type != SCOPE_ALL || snapshot_daemon_attached()) {
+        char scope[600];
+        snapshot_describe_scope(scope, sizeof(scope));
+        printf("%s: %s\n", snapshot_daemon_attached() ? "Snapshots" : "Scope", scope);
+    }
+    printf("\n");
     
     for (int i = 0; i < MENU_ITEMS; i++) {
         if (i == selected) {
@@ -159,6 +201,191 @@ int get_menu_choice(void) {
     }
 }
 
+// Detail views for a single process, opened from "Find process by PID"
+void show_process_detail_menu(pid_t pid) {
+    char input[16];
+    
+    while (1) {
+        printf("\nProcess %d details:\n", pid);
+        printf("1. Delay accounting (taskstats)\n");
+        printf("2. Hardware counters (process)\n");
+        printf("3. Hardware counters (process and descendants)\n");
+        printf("4. CPU profile to folded stacks\n");
+        printf("5. Memory map by backing file\n");
+        printf("6. NUMA placement of threads\n");
+        printf("7. History and RSS trend\n");
+        printf("0. Back\n");
+        printf("Enter choice: ");
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            return;
+        }
+        
+        switch (atoi(input)) {
+            case 1:
+                show_process_delay_accounting(pid);
+                break;
+            case 2:
+                show_hardware_counter_panel(pid, 0);
+                break;
+            case 3:
+                show_hardware_counter_panel(pid, 1);
+                break;
+            case 4: {
+                int seconds = 10;
+                char output_path[256];
+                printf("Seconds to profile (default 10): ");
+                if (fgets(input, sizeof(input), stdin) != NULL && atoi(input) > 0) {
+                    seconds = atoi(input);
+                }
+                printf("Output file (default profile_%d.folded): ", pid);
+                if (fgets(output_path, sizeof(output_path), stdin) == NULL) {
+                    return;
+                }
+                output_path[strcspn(output_path, "\n")] = 0;
+                if (strlen(output_path) == 0) {
+                    snprintf(output_path, sizeof(output_path), "profile_%d.folded", pid);
+                }
+                profile_process(pid, seconds, output_path);
+                break;
+            }
+            case 5:
+                printf("Read RSS/PSS/swap from smaps (slower)? (Y/n): ");
+                if (fgets(input, sizeof(input), stdin) == NULL) {
+                    return;
+                }
+                show_memory_maps(pid, input[0] != 'n' && input[0] != 'N');
+                break;
+            case 6:
+                show_numa_threads(pid);
+                break;
+            case 7:
+                show_process_history(pid);
+                break;
+            case 0:
+                return;
+            default:
+                printf("Invalid choice\n");
+        }
+    }
+}
+
+void set_monitoring_scope(void) {
+    char input[512];
+    SampleScope scope;
+    memset(&scope, 0, sizeof(scope));
+
+    printf("\nMonitoring scope:\n");
+    printf("1. All processes\n");
+    printf("2. Processes of one user\n");
+    printf("3. cgroup (including child cgroups)\n");
+    printf("4. Process subtree\n");
+    printf("Enter choice: ");
+    if (fgets(input, sizeof(input), stdin) == NULL) {
+        return;
+    }
+
+    switch (atoi(input)) {
+        case 1:
+            scope.type = SCOPE_ALL;
+            break;
+        case 2: {
+            printf("Enter user name or UID: ");
+            if (fgets(input, sizeof(input), stdin) == NULL) {
+                return;
+            }
+            input[strcspn(input, "\n")] = 0;
+            struct passwd *pw = getpwnam(input);
+            if (pw) {
+                scope.uid = pw->pw_uid;
+            } else if (isdigit((unsigned char)input[0])) {
+                scope.uid = (uid_t)atoi(input);
+            } else {
+                printf("Unknown user: %s\n", input);
+                return;
+            }
+            scope.type = SCOPE_USER;
+            break;
+        }
+        case 3:
+            if (!cgroup_v2_available()) {
+                printf("cgroup v2 is not available on this system\n");
+                return;
+            }
+            printf("Enter cgroup path relative to %s: ", cgroup_root());
+            if (fgets(input, sizeof(input), stdin) == NULL) {
+                return;
+            }
+            input[strcspn(input, "\n")] = 0;
+            {
+                pid_t *pids;
+                int count = cgroup_collect_pids(input, 1, &pids);
+                if (count < 0) {
+                    printf("cgroup %s does not exist\n", input);
+                    return;
+                }
+                free(pids);
+            }
+            scope.type = SCOPE_CGROUP;
+            snprintf(scope.cgroup_path, sizeof(scope.cgroup_path), "%s", input);
+            break;
+        case 4:
+            printf("Enter root PID: ");
+            if (fgets(input, sizeof(input), stdin) == NULL) {
+                return;
+            }
+            scope.root_pid = atoi(input);
+            if (scope.root_pid <= 0 || kill(scope.root_pid, 0) < 0) {
+                printf("Process %d not found\n", scope.root_pid);
+                return;
+            }
+            scope.type = SCOPE_SUBTREE;
+            break;
+        default:
+            printf("Invalid choice\n");
+            return;
+    }
+
+    snapshot_set_scope(&scope);
+    snapshot_describe_scope(input, sizeof(input));
+    printf("Scope set to %s\n", input);
+}
+
+void show_sampling_settings(void) {
+    char input[64];
+    char scope[600];
+    snapshot_describe_scope(scope, sizeof(scope));
+
+    printf("\nSampling settings:\n");
+    printf("1. Monitoring scope (%s)\n", scope);
+    printf("2. CPU budget (%.2f%% of one core)\n", overhead_get_budget());
+    printf("3. Tiered sampling (%s)\n", snapshot_tiering_enabled() ? "always" : "automatic");
+    printf("Enter choice: ");
+    if (fgets(input, sizeof(input), stdin) == NULL) {
+        return;
+    }
+
+    switch (atoi(input)) {
+        case 1:
+            set_monitoring_scope();
+            break;
+        case 2:
+            printf("CPU budget in percent of one core: ");
+            if (fgets(input, sizeof(input), stdin) != NULL && atof(input) > 0) {
+                overhead_set_budget(atof(input));
+                printf("CPU budget set to %.2f%%\n", overhead_get_budget());
+            } else {
+                printf("Invalid budget\n");
+            }
+            break;
+        case 3:
+            snapshot_set_tiering(!snapshot_tiering_enabled());
+            printf("Tiered sampling: %s\n", snapshot_tiering_enabled() ? "always" : "automatic");
+            break;
+        default:
+            printf("Invalid choice\n");
+    }
+}
+
 void start_chat_server(void) {
     char port_str[10];
     printf("Enter port number (default: %d): ", DEFAULT_PORT);
@@ -272,10 +499,60 @@ void connect_to_chat(void) {
     }
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
+    int run_daemon = 0, attach = 0, headless = 0, interval_ms = 1000;
+    headless_options_t batch;
+    headless_options_init(&batch);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--daemon") == 0) {
+            run_daemon = 1;
+        } else if (strcmp(argv[i], "--attach") == 0) {
+            attach = 1;
+        } else if (strncmp(argv[i], "--interval=", 11) == 0 && atoi(argv[i] + 11) > 0) {
+            // Sets the daemon's period with --daemon, otherwise asks for the loop mode
+            interval_ms = atoi(argv[i] + 11);
+            headless = 1;
+        } else if (strcmp(argv[i], "--once") == 0) {
+            batch.once = headless = 1;
+        } else if (strncmp(argv[i], "--format=", 9) == 0 && headless_set_format(&batch, argv[i] + 9)) {
+            headless = 1;
+        } else if (strncmp(argv[i], "--columns=", 10) == 0 && headless_set_columns(&batch, argv[i] + 10)) {
+            headless = 1;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            batch.filter = argv[i] + 9;
+            headless = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--attach]                 interactive menu\n", argv[0]);
+            fprintf(stderr, "       %s --daemon [--interval=MS]   shared snapshot daemon\n", argv[0]);
+            fprintf(stderr, "       %s [--once] [--format=ndjson|json|csv] [--columns=LIST] [--filter=EXPR]\n"
+                            "          [--interval=MS] [--attach]\n"
+                            "Any of --once, --format, --columns, --filter or --interval streams to stdout\n"
+                            "instead of opening the menu.\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // One sampler for every viewer on the host; no menu, no welcome
+    if (run_daemon) {
+        return run_snapshot_daemon(interval_ms);
+    }
+
+    // Batch output for scripts and collectors; no menu, no welcome, no sound
+    if (headless) {
+        batch.interval_ms = interval_ms;
+        if (attach) snapshot_daemon_attach();
+        int status = run_headless(&batch);
+        if (snapshot_daemon_attached()) snapshot_daemon_detach();
+        return status;
+    }
+
     //Welcome music
     system("afplay welcome.wav");
-    init_task_scheduler();
+    
+    if (attach && !snapshot_daemon_attach()) {
+        printf("No monitoring daemon is running; sampling /proc in this process instead.\n");
+        wait_for_enter();
+    }
     
     // Check if running with elevated privileges
     uid_t euid = geteuid();
@@ -296,6 +573,8 @@ int main(void) {
     char command[256];
     
     while (1) {
+        // Back from a live view; it keeps no budget-forced tiering
+        overhead_end();
         choice = get_menu_choice();
         
         // Reset terminal mode for regular input
@@ -325,6 +604,8 @@ int main(void) {
                     pid = atoi(input);
                     if (!find_process_by_pid(pid)) {
                         printf("Process not found\n");
+                    } else {
+                        show_process_detail_menu(pid);
                     }
                 }
                 break;
@@ -365,13 +646,24 @@ int main(void) {
                 printf("Sort by:\n");
                 printf("1. CPU Usage\n");
                 printf("2. Memory Usage\n");
+                printf("3. CPU Run-Queue Delay\n");
+                printf("4. Block I/O Delay\n");
+                printf("5. Swap-in Delay\n");
+                printf("6. Memory Reclaim Delay\n");
                 printf("Enter choice: ");
                 if (fgets(input, sizeof(input), stdin) != NULL) {
                     int sort_by = atoi(input);
                     printf("Enter number of processes to show: ");
                     if (fgets(input, sizeof(input), stdin) != NULL) {
                         int count = atoi(input);
-                        show_top_resource_usage(sort_by, count);
+                        name[0] = '\0';
+                        if (sort_by == 1 || sort_by == 2) {
+                            printf("Filter by command name or expression, e.g. rss > 1G && user == root (Enter for none): ");
+                            if (fgets(name, sizeof(name), stdin) != NULL) {
+                                name[strcspn(name, "\n")] = 0;
+                            }
+                        }
+                        show_top_resource_usage(sort_by, count, name);
                     }
                 }
                 break;
@@ -391,6 +683,7 @@ int main(void) {
                         int type = atoi(input);
                         time_t execution_time = 0;
                         int interval = 0;
+                        int task_id = 0;
                         
                         switch (type) {
                             case 1: {
@@ -406,7 +699,7 @@ int main(void) {
                                         tm.tm_year -= 1900;
                                         tm.tm_mon -= 1;
                                         execution_time = mktime(&tm);
-                                        add_scheduled_task(command, ONCE, execution_time, 0);
+                                        task_id = tm_sched_add(command, TM_SCHED_ONCE, execution_time, 0);
                                     }
                                 }
                                 break;
@@ -417,7 +710,7 @@ int main(void) {
                                 if (fgets(input, sizeof(input), stdin) != NULL) {
                                     interval = atoi(input);
                                     execution_time = time(NULL) + interval;
-                                    add_scheduled_task(command, INTERVAL, execution_time, interval);
+                                    task_id = tm_sched_add(command, TM_SCHED_INTERVAL, execution_time, interval);
                                 }
                                 break;
                                 
@@ -440,12 +733,18 @@ int main(void) {
                                             execution_time += 24 * 60 * 60;
                                         }
                                         
-                                        add_scheduled_task(command, DAILY, execution_time, 24 * 60 * 60);
+                                        task_id = tm_sched_add(command, TM_SCHED_DAILY, execution_time, 0);
                                     }
                                 }
                                 break;
                             }
                         }
+
+                        if (task_id > 0) {
+                            printf("Task %d scheduled.\n", task_id);
+                        } else if (task_id < 0) {
+                            printf("Maximum task limit reached!\n");
+                        }
                     }
                 }
                 break;
@@ -457,8 +756,9 @@ int main(void) {
             case 11:
                 printf("Enter task ID to remove: ");
                 if (fgets(input, sizeof(input), stdin) != NULL) {
-                    int task_id = atoi(input) - 1;
-                    remove_scheduled_task(task_id);
+                    if (!tm_sched_remove(atoi(input))) {
+                        printf("No task with that ID!\n");
+                    }
                 }
                 break;
                 
@@ -486,9 +786,65 @@ int main(void) {
                 connect_to_chat();
                 break;
                 
+            case 16:
+                show_cgroup_view();
+                break;
+                
+            case 17:
+                show_sampling_settings();
+                break;
+                
+            case 18:
+                show_system_overview();
+                break;
+                
+            case 19:
+                show_interrupt_view();
+                break;
+                
+            case 20:
+                show_pressure_dashboard();
+                break;
+                
+            case 21:
+                show_blocked_tasks();
+                break;
+                
+            case 22:
+                show_socket_view();
+                break;
+                
+            case 23:
+                show_numa_view();
+                break;
+                
+            case 24:
+                show_history_view();
+                break;
+                
+            case 25:
+                show_recorder();
+                break;
+                
+            case 26:
+                show_replay();
+                break;
+                
+            case 27:
+                show_snapshot_diff();
+                break;
+                
+            case 28:
+                show_group_view();
+                break;
+                
+            case 29:
+                show_daemon_attach();
+                break;
+                
             case 0:
                 printf("Exiting...\n");
-                stop_task_scheduler();
+                tm_sched_stop();
                 return EXIT_SUCCESS;
                 
             default:
@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include "maps_view.h"
+#include "overhead.h"
+
+#define MAPS_CHUNK (256 * 1024)     // Read size; lines are parsed in place inside the buffer
+#define GROUP_ROWS 25
+#define MAPPING_ROWS 15
+
+// One line of /proc/<pid>/maps plus the smaps counters that follow it
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    char perms[5];
+    int group;
+    unsigned long rss_kb;
+    unsigned long pss_kb;
+    unsigned long swap_kb;
+} mapping_t;
+
+typedef struct {
+    char *name;
+    size_t name_len;
+    int mappings;
+    uint64_t size;
+    unsigned long rss_kb;
+    unsigned long pss_kb;
+    unsigned long swap_kb;
+} map_group_t;
+
+typedef struct {
+    mapping_t *mappings;
+    int count;
+    int capacity;
+    map_group_t *groups;
+    int group_count;
+    int group_capacity;
+    int *slots;                     // Open addressing index into groups, -1 when empty
+    unsigned int slot_mask;
+    int last_group;                 // Consecutive mappings usually share a file
+} maps_report_t;
+
+// Chunked reader handing out lines as pointers into its own buffer
+typedef struct {
+    int fd;
+    char *buf;
+    size_t size;
+    size_t len;
+    size_t pos;
+    int eof;
+} line_stream_t;
+
+static char *stream_next_line(line_stream_t *s) {
+    while (1) {
+        char *line = s->buf + s->pos;
+        char *newline = memchr(line, '\n', s->len - s->pos);
+        if (newline) {
+            *newline = '\0';
+            s->pos = newline - s->buf + 1;
+            return line;
+        }
+        if (s->eof) {
+            if (s->pos == s->len) return NULL;
+            s->buf[s->len] = '\0';
+            s->pos = s->len;
+            return line;
+        }
+
+        // Only the unfinished tail moves; a line longer than the buffer grows it
+        size_t tail = s->len - s->pos;
+        memmove(s->buf, line, tail);
+        s->len = tail;
+        s->pos = 0;
+        if (tail + 1 >= s->size) {
+            char *grown = realloc(s->buf, s->size * 2);
+            if (!grown) return NULL;
+            s->buf = grown;
+            s->size *= 2;
+        }
+        ssize_t n = read(s->fd, s->buf + s->len, s->size - s->len - 1);
+        if (n <= 0) {
+            s->eof = 1;
+        } else {
+            s->len += n;
+        }
+    }
+}
+
+static uint64_t parse_hex(char **p) {
+    uint64_t value = 0;
+    char *c = *p;
+    while (1) {
+        unsigned int digit;
+        if (*c >= '0' && *c <= '9') {
+            digit = *c - '0';
+        } else if (*c >= 'a' && *c <= 'f') {
+            digit = *c - 'a' + 10;
+        } else {
+            break;
+        }
+        value = value << 4 | digit;
+        c++;
+    }
+    *p = c;
+    return value;
+}
+
+static unsigned long parse_kb(const char *p) {
+    while (*p == ' ') p++;
+    unsigned long value = 0;
+    while (*p >= '0' && *p <= '9') value = value * 10 + (*p++ - '0');
+    return value;
+}
+
+static unsigned int hash_name(const char *name, size_t len) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int grow_slots(maps_report_t *report) {
+    unsigned int capacity = report->slot_mask ? (report->slot_mask + 1) * 2 : 256;
+    int *slots = malloc(capacity * sizeof(int));
+    if (!slots) return 0;
+    memset(slots, 0xff, capacity * sizeof(int));
+    for (int i = 0; i < report->group_count; i++) {
+        unsigned int slot = hash_name(report->groups[i].name, report->groups[i].name_len) & (capacity - 1);
+        while (slots[slot] >= 0) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = i;
+    }
+    free(report->slots);
+    report->slots = slots;
+    report->slot_mask = capacity - 1;
+    return 1;
+}
+
+static int find_group(maps_report_t *report, const char *name, size_t len) {
+    const map_group_t *last = report->last_group >= 0 ? &report->groups[report->last_group] : NULL;
+    if (last && last->name_len == len && memcmp(last->name, name, len) == 0) return report->last_group;
+
+    if ((unsigned int)report->group_count * 2 >= report->slot_mask && !grow_slots(report)) return -1;
+    unsigned int slot = hash_name(name, len) & report->slot_mask;
+    while (report->slots[slot] >= 0) {
+        const map_group_t *g = &report->groups[report->slots[slot]];
+        if (g->name_len == len && memcmp(g->name, name, len) == 0) return report->last_group = report->slots[slot];
+        slot = (slot + 1) & report->slot_mask;
+    }
+
+    if (report->group_count == report->group_capacity) {
+        int capacity = report->group_capacity ? report->group_capacity * 2 : 64;
+        map_group_t *grown = realloc(report->groups, capacity * sizeof(map_group_t));
+        if (!grown) return -1;
+        report->groups = grown;
+        report->group_capacity = capacity;
+    }
+    map_group_t *g = &report->groups[report->group_count];
+    memset(g, 0, sizeof(*g));
+    g->name = malloc(len + 1);
+    if (!g->name) return -1;
+    memcpy(g->name, name, len);
+    g->name[len] = '\0';
+    g->name_len = len;
+    report->slots[slot] = report->group_count;
+    return report->last_group = report->group_count++;
+}
+
+// "start-end perms offset dev inode   path"; anonymous mappings have no path
+static mapping_t *parse_mapping_line(maps_report_t *report, char *line) {
+    if (report->count == report->capacity) {
+        int capacity = report->capacity ? report->capacity * 2 : 1024;
+        mapping_t *grown = realloc(report->mappings, capacity * sizeof(mapping_t));
+        if (!grown) return NULL;
+        report->mappings = grown;
+        report->capacity = capacity;
+    }
+    mapping_t *m = &report->mappings[report->count];
+    memset(m, 0, sizeof(*m));
+
+    char *p = line;
+    m->start = parse_hex(&p);
+    if (*p++ != '-') return NULL;
+    m->end = parse_hex(&p);
+    if (*p++ != ' ') return NULL;
+    memcpy(m->perms, p, 4);
+    p += 4;
+
+    // Skip offset, device and inode to reach the path column
+    for (int field = 0; field < 3; field++) {
+        while (*p == ' ') p++;
+        while (*p && *p != ' ') p++;
+    }
+    while (*p == ' ') p++;
+
+    const char *name = p;
+    size_t len = strlen(p);
+    if (len == 0) {
+        name = "[anon]";
+        len = 6;
+    } else if (strncmp(name, "[stack:", 7) == 0) {
+        // Older kernels label thread stacks per TID
+        name = "[stack]";
+        len = 7;
+    }
+    m->group = find_group(report, name, len);
+    if (m->group < 0) return NULL;
+
+    map_group_t *g = &report->groups[m->group];
+    g->mappings++;
+    g->size += m->end - m->start;
+    report->count++;
+    return m;
+}
+
+static void apply_smaps_field(maps_report_t *report, mapping_t *m, const char *line) {
+    unsigned long *field = NULL;
+    unsigned long *total = NULL;
+    map_group_t *g = &report->groups[m->group];
+
+    if (strncmp(line, "Rss:", 4) == 0) {
+        field = &m->rss_kb;
+        total = &g->rss_kb;
+    } else if (strncmp(line, "Pss:", 4) == 0) {
+        field = &m->pss_kb;
+        total = &g->pss_kb;
+    } else if (strncmp(line, "Swap:", 5) == 0) {
+        field = &m->swap_kb;
+        total = &g->swap_kb;
+    } else {
+        return;
+    }
+    *field = parse_kb(strchr(line, ':') + 1);
+    *total += *field;
+}
+
+static int parse_maps(pid_t pid, int with_smaps, maps_report_t *report) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", pid, with_smaps ? "smaps" : "maps");
+
+    line_stream_t stream = {0};
+    stream.fd = open(path, O_RDONLY);
+    if (stream.fd < 0) return -1;
+    stream.size = MAPS_CHUNK;
+    stream.buf = malloc(stream.size);
+    if (!stream.buf) {
+        close(stream.fd);
+        return -1;
+    }
+
+    mapping_t *current = NULL;
+    char *line;
+    int failed = 0;
+    while ((line = stream_next_line(&stream)) != NULL) {
+        // smaps field names start with a capital letter; mapping lines start with a hex address
+        if (line[0] >= 'A' && line[0] <= 'Z') {
+            if (current) apply_smaps_field(report, current, line);
+            continue;
+        }
+        if (!line[0]) continue;
+        current = parse_mapping_line(report, line);
+        if (!current) {
+            failed = 1;
+            break;
+        }
+    }
+
+    int saved = errno;
+    close(stream.fd);
+    free(stream.buf);
+    errno = saved;
+    return failed || (report->count == 0 && errno == EACCES) ? -1 : report->count;
+}
+
+static void format_kb(double kb, char *out, size_t size) {
+    const char *units[] = {"K", "M", "G", "T"};
+    int unit = 0;
+    while (kb >= 1024 && unit < 3) {
+        kb /= 1024;
+        unit++;
+    }
+    snprintf(out, size, "%.1f%s", kb, units[unit]);
+}
+
+static int sort_by_rss;
+
+static int compare_groups(const void *a, const void *b) {
+    const map_group_t *ga = a, *gb = b;
+    if (sort_by_rss && ga->rss_kb != gb->rss_kb) return (ga->rss_kb < gb->rss_kb) - (ga->rss_kb > gb->rss_kb);
+    return (ga->size < gb->size) - (ga->size > gb->size);
+}
+
+static int compare_mappings(const void *a, const void *b) {
+    const mapping_t *ma = *(mapping_t *const *)a, *mb = *(mapping_t *const *)b;
+    if (sort_by_rss && ma->rss_kb != mb->rss_kb) return (ma->rss_kb < mb->rss_kb) - (ma->rss_kb > mb->rss_kb);
+    uint64_t sa = ma->end - ma->start, sb = mb->end - mb->start;
+    return (sa < sb) - (sa > sb);
+}
+
+static void print_group_row(const map_group_t *g, int with_smaps) {
+    char vsz[16], rss[16] = "-", pss[16] = "-", swap[16] = "-";
+    format_kb(g->size / 1024.0, vsz, sizeof(vsz));
+    if (with_smaps) {
+        format_kb(g->rss_kb, rss, sizeof(rss));
+        format_kb(g->pss_kb, pss, sizeof(pss));
+        format_kb(g->swap_kb, swap, sizeof(swap));
+    }
+    printf("%7d %9s %9s %9s %9s  %s\n", g->mappings, vsz, rss, pss, swap, g->name);
+}
+
+static void render_report(pid_t pid, maps_report_t *report, int with_smaps, double elapsed) {
+    map_group_t total = {0};
+    for (int i = 0; i < report->group_count; i++) {
+        total.mappings += report->groups[i].mappings;
+        total.size += report->groups[i].size;
+        total.rss_kb += report->groups[i].rss_kb;
+        total.pss_kb += report->groups[i].pss_kb;
+        total.swap_kb += report->groups[i].swap_kb;
+    }
+
+    // Sort pointers first: qsort on the groups below moves them
+    mapping_t **order = malloc(report->count * sizeof(mapping_t *));
+    sort_by_rss = with_smaps;
+    if (order) {
+        for (int i = 0; i < report->count; i++) order[i] = &report->mappings[i];
+        qsort(order, report->count, sizeof(mapping_t *), compare_mappings);
+    }
+
+    char mapping_names[MAPPING_ROWS][64];
+    for (int i = 0; order && i < report->count && i < MAPPING_ROWS; i++) {
+        snprintf(mapping_names[i], sizeof(mapping_names[i]), "%s", report->groups[order[i]->group].name);
+    }
+    qsort(report->groups, report->group_count, sizeof(map_group_t), compare_groups);
+
+    printf("\n===== Memory map of PID %d =====\n", pid);
+    printf("%d mappings in %d backing files, parsed from %s in %.1f ms\n", report->count, report->group_count,
+           with_smaps ? "smaps" : "maps", elapsed * 1000);
+    printf("\n%7s %9s %9s %9s %9s  %s\n", "MAPS", "VSZ", "RSS", "PSS", "SWAP", "BACKING");
+    for (int i = 0; i < report->group_count && i < GROUP_ROWS; i++) {
+        print_group_row(&report->groups[i], with_smaps);
+    }
+    if (report->group_count > GROUP_ROWS) printf("  ... %d more\n", report->group_count - GROUP_ROWS);
+    total.name = "TOTAL";
+    print_group_row(&total, with_smaps);
+
+    if (!order) return;
+    printf("\n%-33s %-5s %9s %9s %9s %9s  %s\n", "ADDRESS", "PERMS", "VSZ", "RSS", "PSS", "SWAP", "BACKING");
+    for (int i = 0; i < report->count && i < MAPPING_ROWS; i++) {
+        const mapping_t *m = order[i];
+        char vsz[16], rss[16] = "-", pss[16] = "-", swap[16] = "-";
+        format_kb((m->end - m->start) / 1024.0, vsz, sizeof(vsz));
+        if (with_smaps) {
+            format_kb(m->rss_kb, rss, sizeof(rss));
+            format_kb(m->pss_kb, pss, sizeof(pss));
+            format_kb(m->swap_kb, swap, sizeof(swap));
+        }
+        printf("%016llx-%016llx %-5s %9s %9s %9s %9s  %s\n", (unsigned long long)m->start,
+               (unsigned long long)m->end, m->perms, vsz, rss, pss, swap, mapping_names[i]);
+    }
+    free(order);
+}
+
+void show_memory_maps(pid_t pid, int with_smaps) {
+    maps_report_t report;
+    memset(&report, 0, sizeof(report));
+    report.last_group = -1;
+
+    double start = overhead_clock();
+    int count = parse_maps(pid, with_smaps, &report);
+    double elapsed = overhead_clock() - start;
+
+    if (count < 0) {
+        printf("Cannot read the memory map of PID %d: %s\n", pid, strerror(errno));
+    } else {
+        render_report(pid, &report, with_smaps, elapsed);
+    }
+
+    for (int i = 0; i < report.group_count; i++) free(report.groups[i].name);
+    free(report.groups);
+    free(report.mappings);
+    free(report.slots);
+}
@@ -0,0 +1,15 @@
+#ifndef MAPS_VIEW_H
+#define MAPS_VIEW_H
+
+#include <sys/types.h>
+
+/**
+ * Prints the memory mappings of a process aggregated by backing file
+ * (each library, heap, stack, anonymous memory) and its largest mappings.
+ * @param pid The process ID
+ * @param with_smaps Read /proc/<pid>/smaps for RSS/PSS/swap instead of
+ *        the cheaper /proc/<pid>/maps, which only gives sizes
+ */
+void show_memory_maps(pid_t pid, int with_smaps);
+
+#endif
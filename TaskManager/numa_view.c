@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include "numa_view.h"
+#include "proc_snapshot.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define NUMA_MAX_NODES 64
+#define NUMA_PROCESS_ROWS 20
+#define NUMA_READ_BUFFER (256 * 1024)
+
+// numa_maps totals of one process, kept until the user asks for a re-read
+typedef struct {
+    pid_t pid;
+    unsigned long long starttime;
+    unsigned long node_kb[NUMA_MAX_NODES];
+    double parsed_at;
+    int readable;
+} numa_cache_entry_t;
+
+typedef struct {
+    int threads[NUMA_MAX_NODES];
+    int thread_count;
+} thread_placement_t;
+
+static numa_cache_entry_t *numa_cache;
+static int numa_cache_count;
+static int numa_cache_capacity;
+
+static int *cpu_to_node;
+static int cpu_capacity;
+static int node_count;
+static char node_cpus[NUMA_MAX_NODES][64];
+
+// Maps CPUs to nodes from /sys; without the node directory everything is node 0
+static void load_topology(void) {
+    node_count = 0;
+    DIR *dir = opendir("/sys/devices/system/node");
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        int node;
+        if (sscanf(entry->d_name, "node%d", &node) != 1 || node < 0 || node >= NUMA_MAX_NODES) continue;
+
+        char path[64 + sizeof(entry->d_name)];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+        FILE *fp = fopen(path, "r");
+        if (!fp) continue;
+        if (fgets(node_cpus[node], sizeof(node_cpus[node]), fp) == NULL) node_cpus[node][0] = '\0';
+        fclose(fp);
+        node_cpus[node][strcspn(node_cpus[node], "\n")] = '\0';
+        if (node + 1 > node_count) node_count = node + 1;
+
+        // cpulist is a comma-separated list of ranges like "0-15,32-47"
+        char *p = node_cpus[node];
+        while (*p) {
+            int first = (int)strtol(p, &p, 10), last = first;
+            if (*p == '-') last = (int)strtol(p + 1, &p, 10);
+            if (last >= cpu_capacity) {
+                int capacity = last + 64;
+                int *grown = realloc(cpu_to_node, capacity * sizeof(int));
+                if (!grown) break;
+                for (int i = cpu_capacity; i < capacity; i++) grown[i] = 0;
+                cpu_to_node = grown;
+                cpu_capacity = capacity;
+            }
+            for (int cpu = first; cpu <= last; cpu++) cpu_to_node[cpu] = node;
+            if (*p == ',') p++;
+            else break;
+        }
+    }
+    if (dir) closedir(dir);
+    if (node_count == 0) {
+        node_count = 1;
+        snprintf(node_cpus[0], sizeof(node_cpus[0]), "all");
+    }
+}
+
+static int node_of_cpu(int cpu) {
+    return cpu >= 0 && cpu < cpu_capacity ? cpu_to_node[cpu] : 0;
+}
+
+// Sums the N<node>=<pages> tokens of every mapping, scaled by that mapping's page size
+static int parse_numa_maps(pid_t pid, unsigned long *node_kb) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/numa_maps", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    setvbuf(fp, NULL, _IOFBF, NUMA_READ_BUFFER);
+
+    memset(node_kb, 0, NUMA_MAX_NODES * sizeof(unsigned long));
+    char line[4096];
+    int lines = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long pages[NUMA_MAX_NODES];
+        unsigned long page_kb = 4;
+        int touched = 0;
+        lines++;
+
+        for (char *token = strtok(line, " \n"); token; token = strtok(NULL, " \n")) {
+            if (token[0] == 'N' && token[1] >= '0' && token[1] <= '9') {
+                char *eq;
+                int node = (int)strtol(token + 1, &eq, 10);
+                if (*eq != '=' || node >= NUMA_MAX_NODES) continue;
+                if (!touched) memset(pages, 0, sizeof(pages));
+                touched = 1;
+                pages[node] += strtoul(eq + 1, NULL, 10);
+            } else if (strncmp(token, "kernelpagesize_kB=", 18) == 0) {
+                page_kb = strtoul(token + 18, NULL, 10);
+            }
+        }
+        for (int n = 0; touched && n < NUMA_MAX_NODES; n++) node_kb[n] += pages[n] * page_kb;
+    }
+    fclose(fp);
+    // Kernel threads have an empty numa_maps; other users' processes fail to read
+    return lines > 0;
+}
+
+static numa_cache_entry_t *cache_lookup(pid_t pid, unsigned long long starttime, int reread) {
+    numa_cache_entry_t *entry = NULL;
+    for (int i = 0; i < numa_cache_count; i++) {
+        if (numa_cache[i].pid == pid) {
+            entry = &numa_cache[i];
+            break;
+        }
+    }
+    if (entry && entry->starttime == starttime && !reread) return entry;
+
+    if (!entry) {
+        if (numa_cache_count == numa_cache_capacity) {
+            int capacity = numa_cache_capacity ? numa_cache_capacity * 2 : 64;
+            numa_cache_entry_t *grown = realloc(numa_cache, capacity * sizeof(numa_cache_entry_t));
+            if (!grown) return NULL;
+            numa_cache = grown;
+            numa_cache_capacity = capacity;
+        }
+        entry = &numa_cache[numa_cache_count++];
+    }
+
+    double start = overhead_clock();
+    entry->pid = pid;
+    entry->starttime = starttime;
+    entry->readable = parse_numa_maps(pid, entry->node_kb);
+    entry->parsed_at = overhead_clock();
+    overhead_record(PHASE_READ, start);
+    return entry;
+}
+
+// Drops cached processes that exited or were replaced by a new process with the same PID
+static void cache_prune(const ProcessSnapshot *snap) {
+    int kept = 0;
+    for (int i = 0; i < numa_cache_count; i++) {
+        const ProcessSample *s = snapshot_find(snap, numa_cache[i].pid);
+        if (s && s->starttime == numa_cache[i].starttime) numa_cache[kept++] = numa_cache[i];
+    }
+    numa_cache_count = kept;
+}
+
+// Field 39 of the stat line is the CPU the task last ran on
+static int thread_cpu(pid_t pid, pid_t tid, char *state, char *comm, size_t comm_size) {
+    char path[96], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, tid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return -1;
+    buf[len] = '\0';
+
+    char *open_paren = strchr(buf, '(');
+    char *close_paren = strrchr(buf, ')');
+    if (!open_paren || !close_paren) return -1;
+    if (comm) snprintf(comm, comm_size, "%.*s", (int)(close_paren - open_paren - 1), open_paren + 1);
+    if (state) *state = close_paren[2];
+
+    char *p = close_paren + 2;
+    for (int field = 3; field < 39 && p; field++) {
+        p = strchr(p, ' ');
+        if (p) p++;
+    }
+    return p ? atoi(p) : -1;
+}
+
+static void count_thread_nodes(pid_t pid, thread_placement_t *placement) {
+    memset(placement, 0, sizeof(*placement));
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *dir = opendir(path);
+    if (!dir) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        int cpu = thread_cpu(pid, atoi(entry->d_name), NULL, NULL, 0);
+        if (cpu < 0) continue;
+        placement->threads[node_of_cpu(cpu)]++;
+        placement->thread_count++;
+    }
+    closedir(dir);
+}
+
+static int busiest_node(const unsigned long *values, int count) {
+    int best = 0;
+    for (int n = 1; n < count; n++) {
+        if (values[n] > values[best]) best = n;
+    }
+    return best;
+}
+
+static void format_node_memory(const unsigned long *node_kb, char *out, size_t size) {
+    size_t used = 0;
+    out[0] = '\0';
+    for (int n = 0; n < node_count && used < size; n++) {
+        if (!node_kb[n] && node_count > 1) continue;
+        double value = node_kb[n];
+        const char *unit = "K";
+        if (value >= 1024 * 1024) {
+            value /= 1024 * 1024;
+            unit = "G";
+        } else if (value >= 1024) {
+            value /= 1024;
+            unit = "M";
+        }
+        used += snprintf(out + used, size - used, "%s%d:%.1f%s", used ? " " : "", n, value, unit);
+    }
+}
+
+/**
+ * A process is flagged when most of its threads sit on one node while
+ * less than half of its resident memory does.
+ */
+static int crosses_nodes(const numa_cache_entry_t *entry, const thread_placement_t *placement) {
+    if (node_count < 2 || !entry->readable || placement->thread_count == 0) return 0;
+    unsigned long threads[NUMA_MAX_NODES], total = 0;
+    for (int n = 0; n < node_count; n++) {
+        threads[n] = placement->threads[n];
+        total += entry->node_kb[n];
+    }
+    int thread_node = busiest_node(threads, node_count);
+    return total > 0 && entry->node_kb[thread_node] * 2 < total;
+}
+
+static void print_topology(void) {
+    printf("%d NUMA node%s:", node_count, node_count == 1 ? "" : "s");
+    for (int n = 0; n < node_count; n++) {
+        if (node_cpus[n][0]) printf(" node%d cpus %s", n, node_cpus[n]);
+    }
+    printf("\n");
+    if (node_count == 1) printf("Single node: all memory is local, placement is shown for reference\n");
+}
+
+static int compare_rss(const void *a, const void *b) {
+    const ProcessSample *sa = *(const ProcessSample *const *)a, *sb = *(const ProcessSample *const *)b;
+    return (sa->rss_kb < sb->rss_kb) - (sa->rss_kb > sb->rss_kb);
+}
+
+static void render_processes(ProcessSnapshot *snap, int reread) {
+    ProcessSample **order = malloc((snap->count ? snap->count : 1) * sizeof(ProcessSample *));
+    if (!order) return;
+    for (int i = 0; i < snap->count; i++) order[i] = &snap->samples[i];
+    qsort(order, snap->count, sizeof(ProcessSample *), compare_rss);
+
+    printf("\n===== NUMA placement =====\n");
+    print_topology();
+    printf("\n%8s %-16s %9s %5s %-28s %-20s %s\n", "PID", "COMMAND", "RSS(KB)", "AGE", "MEMORY BY NODE",
+           "THREADS BY NODE", "FLAG");
+
+    int shown = 0, flagged = 0;
+    for (int i = 0; i < snap->count && shown < NUMA_PROCESS_ROWS; i++) {
+        const ProcessSample *s = order[i];
+        if (s->rss_kb == 0) break;
+        numa_cache_entry_t *entry = cache_lookup(s->pid, s->starttime, reread);
+        if (!entry) continue;
+
+        thread_placement_t placement;
+        count_thread_nodes(s->pid, &placement);
+
+        char memory[64] = "unreadable", threads[64] = "";
+        if (entry->readable) format_node_memory(entry->node_kb, memory, sizeof(memory));
+        size_t used = 0;
+        for (int n = 0; n < node_count && used < sizeof(threads); n++) {
+            if (!placement.threads[n] && node_count > 1) continue;
+            used += snprintf(threads + used, sizeof(threads) - used, "%s%d:%d", used ? " " : "", n, placement.threads[n]);
+        }
+
+        int cross = crosses_nodes(entry, &placement);
+        flagged += cross;
+        printf("%8d %-16.16s %9lu %4.0fs %-28.28s %-20.20s %s\n", s->pid, s->command, s->rss_kb,
+               overhead_clock() - entry->parsed_at, memory, threads, cross ? "REMOTE" : "");
+        shown++;
+    }
+    if (flagged) printf("\n%d process%s run most threads away from most of their memory\n",
+                        flagged, flagged == 1 ? "" : "es");
+    printf("AGE is the time since numa_maps was read; memory columns only change on a re-read\n");
+    free(order);
+}
+
+void show_numa_view(void) {
+    if (!snapshot_supported()) {
+        printf("The NUMA view needs /proc (Linux only)\n");
+        return;
+    }
+    load_topology();
+
+    char input[32];
+    int reread = 0;
+    while (1) {
+        ProcessSnapshot snap = {0};
+        if (snapshot_take(&snap, NULL) < 0) {
+            printf("Failed to read processes\n");
+            return;
+        }
+        cache_prune(&snap);
+        render_processes(&snap, reread);
+        snapshot_free(&snap);
+
+        printf("\nr = re-read numa_maps, t = thread placement of a PID, Enter = refresh threads, 0 = back: ");
+        if (fgets(input, sizeof(input), stdin) == NULL || input[0] == '0') return;
+        reread = input[0] == 'r';
+        if (input[0] == 't') {
+            printf("Enter PID: ");
+            if (fgets(input, sizeof(input), stdin) == NULL) return;
+            show_numa_threads(atoi(input));
+        }
+    }
+}
+
+void show_numa_threads(pid_t pid) {
+    if (!snapshot_supported()) {
+        printf("The NUMA view needs /proc (Linux only)\n");
+        return;
+    }
+    load_topology();
+
+    unsigned long node_kb[NUMA_MAX_NODES];
+    if (!parse_numa_maps(pid, node_kb)) {
+        printf("Cannot read /proc/%d/numa_maps\n", pid);
+        return;
+    }
+    int memory_node = busiest_node(node_kb, node_count);
+    char memory[64];
+    format_node_memory(node_kb, memory, sizeof(memory));
+
+    printf("\n===== NUMA placement of PID %d =====\n", pid);
+    print_topology();
+    printf("Memory by node: %s (most on node %d)\n", memory, memory_node);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        printf("Cannot list threads of PID %d\n", pid);
+        return;
+    }
+
+    printf("\n%8s %-16s %5s %5s %5s %s\n", "TID", "COMMAND", "STATE", "CPU", "NODE", "FLAG");
+    int rows = terminal_rows() - 10, shown = 0, remote = 0, total = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        char comm[32], state = '?';
+        pid_t tid = atoi(entry->d_name);
+        int cpu = thread_cpu(pid, tid, &state, comm, sizeof(comm));
+        if (cpu < 0) continue;
+        int node = node_of_cpu(cpu);
+        int away = node_count > 1 && node != memory_node;
+        remote += away;
+        total++;
+        if (shown++ < rows) {
+            printf("%8d %-16.16s %5c %5d %5d %s\n", tid, comm, state, cpu, node, away ? "REMOTE" : "");
+        }
+    }
+    closedir(dir);
+    if (shown > rows) printf("  ... %d more threads\n", shown - rows);
+    printf("\n%d of %d threads last ran on a node other than node %d\n", remote, total, memory_node);
+}
@@ -0,0 +1,20 @@
+#ifndef NUMA_VIEW_H
+#define NUMA_VIEW_H
+
+#include <sys/types.h>
+
+/**
+ * NUMA placement of the largest processes in scope: resident memory per
+ * node from /proc/<pid>/numa_maps and the node each thread last ran on.
+ * Flags processes whose threads run away from their memory. numa_maps
+ * results are cached per process and only re-read on request.
+ */
+void show_numa_view(void);
+
+/**
+ * Per-thread CPU and node of one process next to where its memory lives
+ * @param pid The process ID
+ */
+void show_numa_threads(pid_t pid);
+
+#endif
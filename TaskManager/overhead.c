@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include "overhead.h"
+#include "proc_snapshot.h"
+
+#define INTERVAL_STRETCH 1.5
+#define MAX_STRETCH 10              // Never refresh slower than 10x the requested interval
+#define CPU_SMOOTHING 0.3           // Weight of the newest frame in the moving average
+
+static double budget_percent = OVERHEAD_DEFAULT_BUDGET;
+static uint64_t phase_current[PHASE_COUNT];   // Nanoseconds; a sampler thread adds to these too
+static double phase_last[PHASE_COUNT];
+static int base_interval;
+static int current_interval;
+static double last_wall;
+static double last_cpu;
+static double cpu_percent;          // Smoothed, percent of one core
+static int frames;                  // Frames closed since overhead_begin
+static int tiering_forced;          // Set when the budget switched tiering on
+static unsigned long allocs_mark;   // Allocation count when the current frame began
+static unsigned long allocs_last;   // Allocations during the last frame, both threads included
+
+// Counting happens in alloc_count.o, which only process_manager links; in programs
+// that embed libtaskmgr the weak reference stays unresolved
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define OVERHEAD_COUNTS_ALLOCS 1
+extern unsigned long overhead_alloc_calls __attribute__((weak));
+#endif
+
+static int counting_allocs(void) {
+#ifdef OVERHEAD_COUNTS_ALLOCS
+    return &overhead_alloc_calls != NULL;
+#else
+    return 0;
+#endif
+}
+
+unsigned long overhead_allocations(void) {
+#ifdef OVERHEAD_COUNTS_ALLOCS
+    if (counting_allocs()) return __atomic_load_n(&overhead_alloc_calls, __ATOMIC_RELAXED);
+#endif
+    return 0;
+}
+
+static double process_cpu_seconds(void) {
+    // /proc/self/stat counts in clock ticks; 10 ms is already 1% of a one-second frame
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double overhead_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void overhead_record(overhead_phase_t phase, double start) {
+    __atomic_fetch_add(&phase_current[phase], (uint64_t)((overhead_clock() - start) * 1e9), __ATOMIC_RELAXED);
+}
+
+void overhead_set_budget(double percent) {
+    if (percent > 0) budget_percent = percent;
+}
+
+double overhead_get_budget(void) {
+    return budget_percent;
+}
+
+// Hands tiering back to the automatic setting it had before the budget forced it on
+static void release_tiering(void) {
+    if (!tiering_forced) return;
+    snapshot_set_tiering(0);
+    tiering_forced = 0;
+}
+
+void overhead_begin(int base_interval_ms) {
+    release_tiering();
+    base_interval = base_interval_ms;
+    current_interval = base_interval_ms;
+    cpu_percent = 0;
+    frames = 0;
+    last_wall = overhead_clock();
+    last_cpu = process_cpu_seconds();
+    allocs_mark = overhead_allocations();
+    allocs_last = 0;
+    for (int i = 0; i < PHASE_COUNT; i++) __atomic_store_n(&phase_current[i], 0, __ATOMIC_RELAXED);
+    memset(phase_last, 0, sizeof(phase_last));
+}
+
+int overhead_end_frame(void) {
+    double wall = overhead_clock();
+    double cpu = process_cpu_seconds();
+    // The first frame has no idle wait in it and would read as a full core
+    if (frames > 0 && wall > last_wall) {
+        double frame_percent = 100.0 * (cpu - last_cpu) / (wall - last_wall);
+        cpu_percent = frames == 1 ? frame_percent
+                                  : CPU_SMOOTHING * frame_percent + (1 - CPU_SMOOTHING) * cpu_percent;
+    }
+    last_wall = wall;
+    last_cpu = cpu;
+    frames++;
+
+    unsigned long allocs = overhead_allocations();
+    allocs_last = allocs - allocs_mark;
+    allocs_mark = allocs;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        phase_last[i] = __atomic_exchange_n(&phase_current[i], 0, __ATOMIC_RELAXED) / 1e9;
+    }
+    if (frames == 1) return current_interval;
+
+    if (cpu_percent > budget_percent) {
+        // Tiering loses the least information, so try it before slowing down
+        if (!snapshot_tiering_enabled()) {
+            snapshot_set_tiering(1);
+            tiering_forced = 1;
+        } else if (current_interval < base_interval * MAX_STRETCH) {
+            current_interval = (int)(current_interval * INTERVAL_STRETCH);
+            if (current_interval > base_interval * MAX_STRETCH) current_interval = base_interval * MAX_STRETCH;
+        }
+    } else if (cpu_percent < budget_percent / 2) {
+        // Undone in the reverse order: the interval first, then tiering
+        if (current_interval > base_interval) {
+            current_interval = (int)(current_interval / INTERVAL_STRETCH);
+            if (current_interval < base_interval) current_interval = base_interval;
+        } else {
+            release_tiering();
+        }
+    }
+    return current_interval;
+}
+
+void overhead_end(void) {
+    release_tiering();
+}
+
+// Total CPU time and resident size of this process from /proc/self/stat
+static void read_self_stat(double *cpu_seconds, unsigned long *rss_kb) {
+    *cpu_seconds = 0;
+    *rss_kb = 0;
+
+    // open/read rather than stdio, which would allocate on every status line
+    char buf[1024];
+    int fd = open("/proc/self/stat", O_RDONLY);
+    if (fd < 0) return;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return;
+    buf[len] = '\0';
+
+    char *p = strrchr(buf, ')');
+    if (!p) return;
+    unsigned long long utime, stime;
+    long rss_pages;
+    // Fields 3-24 per proc(5): state ... utime(14) stime(15) ... rss(24)
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %*d %*d %*d %*d %*d %*d %*u %*u %ld",
+               &utime, &stime, &rss_pages) == 3) {
+        *cpu_seconds = (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+        *rss_kb = rss_pages * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+}
+
+void overhead_status(overhead_status_t *status) {
+    read_self_stat(&status->total_cpu_seconds, &status->rss_kb);
+    status->cpu_percent = cpu_percent;
+    status->budget_percent = budget_percent;
+    for (int i = 0; i < PHASE_COUNT; i++) status->phase_ms[i] = phase_last[i] * 1000;
+    status->counting_allocs = counting_allocs();
+    status->allocations = allocs_last;
+    status->interval_ms = current_interval;
+    status->tiered = snapshot_tiering_enabled();
+    status->tiering_forced = tiering_forced;
+}
@@ -0,0 +1,89 @@
+#ifndef OVERHEAD_H
+#define OVERHEAD_H
+
+// Phases of one refresh, timed separately for the status line
+typedef enum {
+    PHASE_ENUMERATE,                // Listing the PIDs or cgroups to sample
+    PHASE_READ,                     // open/read/close of /proc and cgroupfs files
+    PHASE_PARSE,                    // Turning file contents into samples
+    PHASE_SORT,                     // Ordering, merging and rate computation
+    PHASE_RENDER,                   // Printing the frame
+    PHASE_COUNT
+} overhead_phase_t;
+
+#define OVERHEAD_DEFAULT_BUDGET 0.5 // Percent of one core
+
+/**
+ * Returns CLOCK_MONOTONIC seconds, used as the start mark for overhead_record
+ */
+double overhead_clock(void);
+
+/**
+ * Adds the time since start to a phase of the current frame; safe to
+ * call from a sampler thread while the UI thread renders
+ * @param phase The phase
+ * @param start Value of overhead_clock() when the phase began
+ */
+void overhead_record(overhead_phase_t phase, double start);
+
+/**
+ * Sets the CPU budget of the monitoring loops
+ * @param percent Percent of one core, e.g. 0.5
+ */
+void overhead_set_budget(double percent);
+
+/**
+ * Returns the CPU budget in percent of one core
+ */
+double overhead_get_budget(void);
+
+/**
+ * Starts measuring a live view; clears the history of the previous one
+ * @param base_interval_ms The refresh interval the view asks for
+ */
+void overhead_begin(int base_interval_ms);
+
+/**
+ * Closes a frame: measures our own CPU use and, when it exceeds the budget,
+ * first switches to tiered sampling and then stretches the interval.
+ * Once usage falls well below the budget the interval shrinks back, and
+ * then tiering that the budget switched on is switched off again.
+ * @return The interval in milliseconds to wait before the next frame
+ */
+int overhead_end_frame(void);
+
+/**
+ * Ends a live view. Tiering that the budget switched on goes back to the
+ * automatic setting, so it does not outlive the view that needed it.
+ */
+void overhead_end(void);
+
+/**
+ * Counts calls into malloc, calloc and realloc by the whole process so far.
+ * Counting needs alloc_count.o, which only process_manager links, on a
+ * glibc build without sanitizers; elsewhere this is 0.
+ */
+unsigned long overhead_allocations(void);
+
+// Self-instrumentation of the last frame, for the status line of a view
+typedef struct {
+    double cpu_percent;             // Smoothed, percent of one core
+    double budget_percent;
+    double total_cpu_seconds;       // Since the process started
+    unsigned long rss_kb;
+    double phase_ms[PHASE_COUNT];
+    int counting_allocs;            // 0 when allocations cannot be counted
+    unsigned long allocations;      // During the last frame
+    int interval_ms;                // Current refresh interval
+    int tiered;
+    int tiering_forced;             // Tiering was switched on by the budget
+} overhead_status_t;
+
+/**
+ * Describes the last frame: CPU use against the budget, time per phase,
+ * allocations and the refresh interval
+ * @param status Receives the figures
+ */
+void overhead_status(overhead_status_t *status);
+
+#endif
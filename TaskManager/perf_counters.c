@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <time.h>
+#include "perf_counters.h"
+#include "process_manager.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+
+#define MAX_COUNTER_GROUPS 128          // Up to MAX_GROUP_MEMBERS fds each; further threads are reported, not counted
+#define MAX_GROUP_MEMBERS 6
+
+typedef enum {
+    CTR_CYCLES,
+    CTR_INSTRUCTIONS,
+    CTR_CACHE_MISSES,
+    CTR_BRANCH_MISSES,
+    CTR_CONTEXT_SWITCHES,
+    CTR_TASK_CLOCK,
+    CTR_CPU_MIGRATIONS,
+    CTR_PAGE_FAULTS,
+    CTR_COUNT
+} counter_slot_t;
+
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+    counter_slot_t slot;
+} counter_def_t;
+
+// The first entry of each set is the group leader
+static const counter_def_t hardware_set[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, CTR_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, CTR_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, CTR_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, CTR_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, CTR_CONTEXT_SWITCHES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, CTR_TASK_CLOCK},
+};
+
+static const counter_def_t software_set[] = {
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, CTR_TASK_CLOCK},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, CTR_CONTEXT_SWITCHES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, CTR_CPU_MIGRATIONS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, CTR_PAGE_FAULTS},
+};
+
+// One perf group per thread; every member is read with a single read() on the leader
+typedef struct {
+    int fds[MAX_GROUP_MEMBERS];
+    counter_slot_t slots[MAX_GROUP_MEMBERS];
+    int members;
+} counter_group_t;
+
+typedef struct {
+    counter_group_t groups[MAX_COUNTER_GROUPS];
+    int group_count;
+    int skipped;         // Threads left out: over MAX_COUNTER_GROUPS or their group failed to open
+    int hardware;        // 1 if the hardware set was opened
+    int inherit;         // 1 if counters follow threads created later
+    int user_only;       // 1 if kernel-side events are excluded (paranoid >= 2)
+} counter_panel_t;
+
+static long sys_perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu,
+                                int group_fd, unsigned long flags) {
+    return syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+static int read_paranoid_level(void) {
+    FILE *fp = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    int level = 2;
+    if (fp) {
+        if (fscanf(fp, "%d", &level) != 1) level = 2;
+        fclose(fp);
+    }
+    return level;
+}
+
+int perf_counters_available(char *reason, size_t size) {
+    int level = read_paranoid_level();
+
+    // Above 2 (Debian/Ubuntu patch) unprivileged users get no events at all
+    if (level > 2 && geteuid() != 0) {
+        snprintf(reason, size,
+                 "perf_event_paranoid is %d; run with sudo or lower it to 2", level);
+        return 0;
+    }
+    return 1;
+}
+
+static void close_group(counter_group_t *group) {
+    for (int i = 0; i < group->members; i++) {
+        close(group->fds[i]);
+    }
+    group->members = 0;
+}
+
+// Opens one counter group on a thread, returns 1 if at least the leader opened
+static int open_group(counter_panel_t *panel, counter_group_t *group, pid_t tid,
+                      const counter_def_t *set, int set_size) {
+    group->members = 0;
+
+    for (int i = 0; i < set_size && i < MAX_GROUP_MEMBERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = set[i].type;
+        attr.config = set[i].config;
+        attr.inherit = panel->inherit;
+        attr.exclude_kernel = panel->user_only;
+        attr.exclude_hv = panel->user_only;
+        attr.read_format = PERF_FORMAT_GROUP |
+                           PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = (i == 0);
+
+        int group_fd = (i == 0) ? -1 : group->fds[0];
+        int fd = sys_perf_event_open(&attr, tid, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+        if (fd < 0) {
+            if (i == 0) return 0;
+            continue; // Skip members this PMU does not implement
+        }
+        group->fds[group->members] = fd;
+        group->slots[group->members] = set[i].slot;
+        group->members++;
+    }
+
+    ioctl(group->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return 1;
+}
+
+// Chooses hardware or software events and inheritance on the first thread
+static int probe_counter_mode(counter_panel_t *panel, pid_t tid, int *open_errno) {
+    static const int inherit_modes[] = {1, 0};
+
+    for (int hw = 1; hw >= 0; hw--) {
+        for (int m = 0; m < 2; m++) {
+            panel->hardware = hw;
+            panel->inherit = inherit_modes[m];
+
+            const counter_def_t *set = hw ? hardware_set : software_set;
+            int size = hw ? (int)(sizeof(hardware_set) / sizeof(hardware_set[0]))
+                          : (int)(sizeof(software_set) / sizeof(software_set[0]));
+            if (open_group(panel, &panel->groups[0], tid, set, size)) {
+                panel->group_count = 1;
+                return 1;
+            }
+            *open_errno = errno;
+
+            // Permission problems will not go away with another event set
+            if (errno == EACCES || errno == EPERM || errno == ESRCH) return 0;
+        }
+    }
+    return 0;
+}
+
+// Collects the threads of pid (and optionally of all its descendants); *skipped
+// counts the ones that did not fit in max
+static int collect_threads(pid_t root, int include_subtree, pid_t *tids, int max, int *skipped) {
+    int proc_capacity = 16;
+    pid_t *procs = malloc(proc_capacity * sizeof(pid_t));
+    int proc_count = 0;
+    *skipped = 0;
+    if (!procs) return 0;
+    procs[proc_count++] = root;
+
+    if (include_subtree) {
+        // Repeat the /proc scan until no new descendant shows up
+        int added = 1;
+        while (added) {
+            added = 0;
+            DIR *dir = opendir("/proc");
+            if (!dir) break;
+            struct dirent *entry;
+            while ((entry = readdir(dir)) != NULL) {
+                if (!isdigit((unsigned char)entry->d_name[0])) continue;
+                pid_t pid = atoi(entry->d_name);
+
+                int known = 0;
+                for (int i = 0; i < proc_count; i++) {
+                    if (procs[i] == pid) { known = 1; break; }
+                }
+                if (known) continue;
+
+                char path[64], buf[512];
+                snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+                FILE *fp = fopen(path, "r");
+                if (!fp) continue;
+                size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+                fclose(fp);
+                buf[len] = '\0';
+
+                char *close_paren = strrchr(buf, ')');
+                pid_t ppid = 0;
+                if (close_paren && sscanf(close_paren + 2, "%*c %d", &ppid) == 1) {
+                    for (int i = 0; i < proc_count; i++) {
+                        if (procs[i] == ppid) {
+                            if (proc_count == proc_capacity) {
+                                pid_t *grown = realloc(procs, 2 * proc_capacity * sizeof(pid_t));
+                                if (!grown) break;
+                                procs = grown;
+                                proc_capacity *= 2;
+                            }
+                            procs[proc_count++] = pid;
+                            added = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+            closedir(dir);
+        }
+    }
+
+    int tid_count = 0;
+    for (int p = 0; p < proc_count; p++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/task", procs[p]);
+        DIR *dir = opendir(path);
+        if (!dir) continue;
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (!isdigit((unsigned char)entry->d_name[0])) continue;
+            if (tid_count < max) tids[tid_count++] = atoi(entry->d_name);
+            else (*skipped)++;
+        }
+        closedir(dir);
+    }
+    free(procs);
+    return tid_count;
+}
+
+// Sums every group into totals[], scaling for multiplexed PMU time
+static void read_panel(counter_panel_t *panel, double totals[CTR_COUNT]) {
+    for (int s = 0; s < CTR_COUNT; s++) totals[s] = 0;
+
+    for (int g = 0; g < panel->group_count; g++) {
+        counter_group_t *group = &panel->groups[g];
+        uint64_t buf[3 + MAX_GROUP_MEMBERS];
+
+        ssize_t len = read(group->fds[0], buf, sizeof(buf));
+        if (len < (ssize_t)(3 * sizeof(uint64_t))) continue;
+
+        uint64_t nr = buf[0];
+        uint64_t enabled = buf[1];
+        uint64_t running = buf[2];
+        double scale = (running > 0 && running < enabled) ? (double)enabled / running : 1.0;
+
+        for (uint64_t i = 0; i < nr && i < (uint64_t)group->members; i++) {
+            totals[group->slots[i]] += buf[3 + i] * scale;
+        }
+    }
+}
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_panel(pid_t pid, int include_subtree, counter_panel_t *panel,
+                        const double delta[CTR_COUNT], double elapsed) {
+    printf("\033[2J\033[H");
+    printf("===== %s Counters for PID %d%s =====\n",
+           panel->hardware ? "Hardware" : "Software", pid,
+           include_subtree ? " and descendants" : "");
+    printf("Threads: %d   Inherit: %s   Scope: %s   Interval: %.2f s\n",
+           panel->group_count, panel->inherit ? "yes" : "no",
+           panel->user_only ? "user space" : "user+kernel", elapsed);
+    if (panel->skipped > 0) {
+        printf("(%d threads not counted: at most %d, or their counters failed to open)\n",
+               panel->skipped, MAX_COUNTER_GROUPS);
+    }
+    printf("-------------------------------------------------------------\n");
+
+    if (panel->hardware) {
+        double ipc = delta[CTR_CYCLES] > 0 ? delta[CTR_INSTRUCTIONS] / delta[CTR_CYCLES] : 0;
+        double per_k = delta[CTR_INSTRUCTIONS] > 0 ? 1000.0 / delta[CTR_INSTRUCTIONS] : 0;
+        printf("%-18s %16.0f /s\n", "cycles", delta[CTR_CYCLES] / elapsed);
+        printf("%-18s %16.0f /s\n", "instructions", delta[CTR_INSTRUCTIONS] / elapsed);
+        printf("%-18s %16.2f\n", "IPC", ipc);
+        printf("%-18s %16.0f /s  (%.2f per 1k instr)\n", "cache-misses",
+               delta[CTR_CACHE_MISSES] / elapsed, delta[CTR_CACHE_MISSES] * per_k);
+        printf("%-18s %16.0f /s  (%.2f per 1k instr)\n", "branch-misses",
+               delta[CTR_BRANCH_MISSES] / elapsed, delta[CTR_BRANCH_MISSES] * per_k);
+    } else {
+        printf("(No hardware PMU available, e.g. inside a VM: showing software events)\n");
+        printf("%-18s %16.0f /s\n", "cpu-migrations", delta[CTR_CPU_MIGRATIONS] / elapsed);
+        printf("%-18s %16.0f /s\n", "page-faults", delta[CTR_PAGE_FAULTS] / elapsed);
+    }
+    printf("%-18s %16.0f /s\n", "context-switches", delta[CTR_CONTEXT_SWITCHES] / elapsed);
+    printf("%-18s %16.2f CPUs\n", "task-clock", delta[CTR_TASK_CLOCK] / 1e9 / elapsed);
+    printf("-------------------------------------------------------------\n");
+    printf("Press Enter to stop\n");
+    fflush(stdout);
+}
+
+void show_hardware_counter_panel(pid_t pid, int include_subtree) {
+    char reason[128];
+    if (!perf_counters_available(reason, sizeof(reason))) {
+        printf("Hardware counters unavailable: %s\n", reason);
+        return;
+    }
+
+    pid_t tids[MAX_COUNTER_GROUPS];
+    int skipped;
+    int tid_count = collect_threads(pid, include_subtree, tids, MAX_COUNTER_GROUPS, &skipped);
+    if (tid_count == 0) {
+        printf("Process with PID %d not found\n", pid);
+        return;
+    }
+
+    counter_panel_t *panel = calloc(1, sizeof(counter_panel_t));
+    if (!panel) {
+        perror("Out of memory");
+        return;
+    }
+    panel->user_only = (read_paranoid_level() >= 2 && geteuid() != 0);
+    panel->skipped = skipped;
+
+    int open_errno = 0;
+    if (!probe_counter_mode(panel, tids[0], &open_errno)) {
+        if (open_errno == EACCES || open_errno == EPERM) {
+            printf("Permission denied opening counters for PID %d (need CAP_PERFMON or same user)\n", pid);
+        } else {
+            printf("perf_event_open failed: %s\n", strerror(open_errno));
+        }
+        free(panel);
+        return;
+    }
+
+    const counter_def_t *set = panel->hardware ? hardware_set : software_set;
+    int set_size = panel->hardware ? (int)(sizeof(hardware_set) / sizeof(hardware_set[0]))
+                                   : (int)(sizeof(software_set) / sizeof(software_set[0]));
+    for (int i = 1; i < tid_count; i++) {
+        if (open_group(panel, &panel->groups[panel->group_count], tids[i], set, set_size)) {
+            panel->group_count++;
+        } else if (errno != ESRCH) {
+            panel->skipped++;       // A thread that already exited is simply gone
+        }
+    }
+
+    double previous[CTR_COUNT], current[CTR_COUNT], delta[CTR_COUNT];
+    read_panel(panel, previous);
+    double last_time = monotonic_seconds();
+
+    while (!wait_for_refresh(1000)) {
+        read_panel(panel, current);
+        double now = monotonic_seconds();
+        for (int s = 0; s < CTR_COUNT; s++) {
+            delta[s] = current[s] - previous[s];
+            previous[s] = current[s];
+        }
+        print_panel(pid, include_subtree, panel, delta, now - last_time);
+        last_time = now;
+
+        if (kill(pid, 0) != 0 && errno == ESRCH) {
+            printf("Process %d has exited\n", pid);
+            break;
+        }
+    }
+
+    for (int g = 0; g < panel->group_count; g++) {
+        close_group(&panel->groups[g]);
+    }
+    free(panel);
+}
+
+#else
+
+int perf_counters_available(char *reason, size_t size) {
+    snprintf(reason, size, "perf_event_open is only available on Linux");
+    return 0;
+}
+
+void show_hardware_counter_panel(pid_t pid, int include_subtree) {
+    (void)pid;
+    (void)include_subtree;
+    printf("Hardware counters unavailable: perf_event_open is only available on Linux\n");
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <sys/types.h>
+
+/**
+ * Checks whether perf_event_open may be used for other processes' counters
+ * @param reason Buffer receiving an explanation when counters are unavailable
+ * @param size Size of the reason buffer
+ * @return 1 if counters can be opened, 0 otherwise
+ */
+int perf_counters_available(char *reason, size_t size);
+
+/**
+ * Shows a live panel with IPC, cache misses, branch misses and context
+ * switches for a process, refreshed every second until Enter is pressed.
+ * Hardware events are used where the PMU allows it, software events otherwise.
+ * @param pid The process ID
+ * @param include_subtree 1 to also count every descendant of the process
+ */
+void show_hardware_counter_panel(pid_t pid, int include_subtree);
+
+#endif
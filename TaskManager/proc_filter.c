@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "proc_filter.h"
+
+#define FILTER_MAX_NODES 64
+#define FILTER_MAX_TEXT 64
+
+typedef enum {
+    NODE_AND,
+    NODE_OR,
+    NODE_NOT,
+    NODE_COMPARE,
+    NODE_SUBTREE
+} node_type_t;
+
+typedef enum {
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_CONTAINS,
+    OP_EXCLUDES
+} filter_op_t;
+
+typedef struct {
+    node_type_t type;
+    int left, right;                        // Children of AND, OR and NOT
+    filter_field_t field;
+    filter_op_t op;
+    double number;
+    char text[FILTER_MAX_TEXT];
+    pid_t root;                             // subtree()
+    unsigned char *members;                 // subtree() membership per row of the prepared snapshot
+    int member_capacity;
+} filter_node_t;
+
+struct filter {
+    filter_node_t nodes[FILTER_MAX_NODES];
+    int count;
+    int root;
+    int has_subtree;
+    char source[256];
+};
+
+typedef struct {
+    const char *pos;
+    filter_t *filter;
+    char *error;
+    size_t error_size;
+} parser_t;
+
+static const struct {
+    const char *name;
+    filter_field_t field;
+} field_names[] = {
+    {"pid", FILTER_PID}, {"ppid", FILTER_PPID}, {"uid", FILTER_UID},
+    {"cpu", FILTER_CPU}, {"mem", FILTER_MEM}, {"rss", FILTER_RSS},
+    {"vsize", FILTER_VSIZE}, {"vsz", FILTER_VSIZE}, {"threads", FILTER_THREADS},
+    {"minflt", FILTER_MINFLT}, {"majflt", FILTER_MAJFLT}, {"state", FILTER_STATE},
+    {"user", FILTER_USER}, {"comm", FILTER_COMMAND}, {"command", FILTER_COMMAND},
+    {"name", FILTER_COMMAND}
+};
+
+// Characters that end a bare word
+#define WORD_STOP " \t\n()!=<>~&|,\""
+
+static int fail(parser_t *p, const char *message, const char *detail) {
+    if (p->error[0] == '\0') snprintf(p->error, p->error_size, "%s%s", message, detail ? detail : "");
+    return -1;
+}
+
+static void skip_spaces(parser_t *p) {
+    while (isspace((unsigned char)*p->pos)) p->pos++;
+}
+
+static int accept(parser_t *p, const char *token) {
+    skip_spaces(p);
+    size_t len = strlen(token);
+    if (strncmp(p->pos, token, len) != 0) return 0;
+    // A lone '!' must not swallow the start of != or !~
+    if (strcmp(token, "!") == 0 && (p->pos[1] == '=' || p->pos[1] == '~')) return 0;
+    p->pos += len;
+    return 1;
+}
+
+static int accept_keyword(parser_t *p, const char *keyword) {
+    skip_spaces(p);
+    size_t len = strlen(keyword);
+    if (strncasecmp(p->pos, keyword, len) != 0 || (p->pos[len] && !strchr(WORD_STOP, p->pos[len]))) return 0;
+    p->pos += len;
+    return 1;
+}
+
+// Reads a bare word or a double-quoted string; one that does not fit is an error, not cut short
+static int read_word(parser_t *p, char *out, size_t size) {
+    skip_spaces(p);
+    const char *start = p->pos;
+    size_t len = 0;
+    if (*p->pos == '"') {
+        p->pos++;
+        while (*p->pos && *p->pos != '"') {
+            if (len + 1 < size) out[len] = *p->pos;
+            len++;
+            p->pos++;
+        }
+        if (*p->pos != '"') return 0;
+        p->pos++;
+    } else {
+        while (*p->pos && !strchr(WORD_STOP, *p->pos)) {
+            if (len + 1 < size) out[len] = *p->pos;
+            len++;
+            p->pos++;
+        }
+        if (len == 0) return 0;
+    }
+    if (len + 1 > size) {
+        char limit[48];
+        snprintf(limit, sizeof(limit), "word longer than %d characters: ", (int)size - 1);
+        fail(p, limit, start);
+        return 0;
+    }
+    out[len] = '\0';
+    return 1;
+}
+
+static int new_node(parser_t *p, node_type_t type) {
+    if (p->filter->count == FILTER_MAX_NODES) return fail(p, "expression too complex", NULL);
+    filter_node_t *node = &p->filter->nodes[p->filter->count];
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+    node->left = node->right = -1;
+    return p->filter->count++;
+}
+
+// Numbers with an optional K/M/G/T suffix; sizes are in KB, so a plain number is KB
+static int parse_number(const char *text, filter_field_t field, double *out) {
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text) return 0;
+    if (field == FILTER_RSS || field == FILTER_VSIZE) {
+        switch (toupper((unsigned char)*end)) {
+            case 'K': end++; break;
+            case 'M': value *= 1024; end++; break;
+            case 'G': value *= 1024.0 * 1024; end++; break;
+            case 'T': value *= 1024.0 * 1024 * 1024; end++; break;
+        }
+        if (toupper((unsigned char)*end) == 'B') end++;
+    } else if ((field == FILTER_CPU || field == FILTER_MEM) && *end == '%') {
+        end++;
+    }
+    *out = value;
+    return *end == '\0';
+}
+
+static int parse_or(parser_t *p);
+
+static int parse_comparison(parser_t *p) {
+    char name[FILTER_MAX_TEXT], value[FILTER_MAX_TEXT];
+    if (!read_word(p, name, sizeof(name))) {
+        return fail(p, *p->pos ? "unexpected " : "expression ends too early", *p->pos ? p->pos : NULL);
+    }
+
+    if (strcasecmp(name, "subtree") == 0) {
+        int parens = accept(p, "(");
+        if (!read_word(p, value, sizeof(value)) || atoi(value) <= 0) return fail(p, "subtree needs a PID", NULL);
+        if (parens && !accept(p, ")")) return fail(p, "missing ')' after subtree PID", NULL);
+        int n = new_node(p, NODE_SUBTREE);
+        if (n < 0) return n;
+        p->filter->nodes[n].root = atoi(value);
+        p->filter->has_subtree = 1;
+        return n;
+    }
+
+    int field = -1;
+    for (size_t i = 0; i < sizeof(field_names) / sizeof(field_names[0]); i++) {
+        if (strcasecmp(name, field_names[i].name) == 0) field = field_names[i].field;
+    }
+    if (field < 0) return fail(p, "unknown field ", name);
+
+    filter_op_t op;
+    if (accept(p, "==") || accept(p, "=")) op = OP_EQ;
+    else if (accept(p, "!=")) op = OP_NE;
+    else if (accept(p, "!~")) op = OP_EXCLUDES;
+    else if (accept(p, "~")) op = OP_CONTAINS;
+    else if (accept(p, "<=")) op = OP_LE;
+    else if (accept(p, ">=")) op = OP_GE;
+    else if (accept(p, "<")) op = OP_LT;
+    else if (accept(p, ">")) op = OP_GT;
+    else return fail(p, "expected a comparison after ", name);
+
+    if (!read_word(p, value, sizeof(value))) return fail(p, "expected a value after ", name);
+
+    int n = new_node(p, NODE_COMPARE);
+    if (n < 0) return n;
+    filter_node_t *node = &p->filter->nodes[n];
+    node->field = field;
+    node->op = op;
+    snprintf(node->text, sizeof(node->text), "%s", value);
+
+    if (field == FILTER_USER || field == FILTER_COMMAND) {
+        if (op != OP_EQ && op != OP_NE && op != OP_CONTAINS && op != OP_EXCLUDES) {
+            return fail(p, "only ==, !=, ~ and !~ apply to ", name);
+        }
+    } else if (field == FILTER_STATE) {
+        if ((op != OP_EQ && op != OP_NE) || strlen(value) != 1) return fail(p, "state takes == or != and one letter", NULL);
+    } else {
+        if (op == OP_CONTAINS || op == OP_EXCLUDES) return fail(p, "~ only applies to user and comm", NULL);
+        if (!parse_number(value, field, &node->number)) return fail(p, "bad number ", value);
+    }
+    return n;
+}
+
+static int parse_primary(parser_t *p) {
+    if (accept(p, "(")) {
+        int n = parse_or(p);
+        if (n < 0) return n;
+        if (!accept(p, ")")) return fail(p, "missing ')'", NULL);
+        return n;
+    }
+    return parse_comparison(p);
+}
+
+static int parse_not(parser_t *p) {
+    if (accept(p, "!") || accept_keyword(p, "not")) {
+        int child = parse_not(p);
+        if (child < 0) return child;
+        int n = new_node(p, NODE_NOT);
+        if (n < 0) return n;
+        p->filter->nodes[n].left = child;
+        return n;
+    }
+    return parse_primary(p);
+}
+
+static int parse_binary(parser_t *p, node_type_t type) {
+    int left = type == NODE_OR ? parse_binary(p, NODE_AND) : parse_not(p);
+    while (left >= 0 && (type == NODE_OR ? accept(p, "||") || accept_keyword(p, "or")
+                                         : accept(p, "&&") || accept_keyword(p, "and"))) {
+        int right = type == NODE_OR ? parse_binary(p, NODE_AND) : parse_not(p);
+        if (right < 0) return right;
+        int n = new_node(p, type);
+        if (n < 0) return n;
+        p->filter->nodes[n].left = left;
+        p->filter->nodes[n].right = right;
+        left = n;
+    }
+    return left;
+}
+
+static int parse_or(parser_t *p) {
+    return parse_binary(p, NODE_OR);
+}
+
+filter_t *filter_compile(const char *text, char *error, size_t error_size) {
+    error[0] = '\0';
+    while (isspace((unsigned char)*text)) text++;
+    if (*text == '\0') return NULL;
+
+    filter_t *filter = calloc(1, sizeof(filter_t));
+    if (!filter) {
+        snprintf(error, error_size, "out of memory");
+        return NULL;
+    }
+    size_t len = strcspn(text, "\n");
+    if (len >= sizeof(filter->source)) {
+        snprintf(error, error_size, "expression longer than %d characters", (int)sizeof(filter->source) - 1);
+        filter_free(filter);
+        return NULL;
+    }
+    memcpy(filter->source, text, len);
+    filter->source[len] = '\0';
+    parser_t p = { filter->source, filter, error, error_size };
+
+    // A plain name keeps working the way the old command filter did
+    if (!strpbrk(filter->source, "=<>~!&|()\"") && strncasecmp(filter->source, "subtree", 7) != 0) {
+        while (len > 0 && isspace((unsigned char)filter->source[len - 1])) len--;
+        filter->source[len] = '\0';
+        if (len >= sizeof(filter->nodes[0].text)) {
+            // Command names are shorter than this, so a longer name could never match
+            snprintf(error, error_size, "name longer than %d characters", (int)sizeof(filter->nodes[0].text) - 1);
+            filter_free(filter);
+            return NULL;
+        }
+        filter->root = new_node(&p, NODE_COMPARE);
+        filter->nodes[0].field = FILTER_COMMAND;
+        filter->nodes[0].op = OP_CONTAINS;
+        memcpy(filter->nodes[0].text, filter->source, len + 1);
+        return filter;
+    }
+
+    filter->root = parse_or(&p);
+    skip_spaces(&p);
+    if (filter->root >= 0 && *p.pos) fail(&p, "unexpected ", p.pos);
+    if (error[0]) {
+        filter_free(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+void filter_prepare(filter_t *filter, const ProcessSnapshot *snap) {
+    if (filter == NULL || !filter->has_subtree) return;
+
+    for (int n = 0; n < filter->count; n++) {
+        filter_node_t *node = &filter->nodes[n];
+        if (node->type != NODE_SUBTREE) continue;
+        if (snap->count > node->member_capacity) {
+            unsigned char *grown = realloc(node->members, snap->count);
+            if (!grown) continue;
+            node->members = grown;
+            node->member_capacity = snap->count;
+        }
+
+        // 0 unknown, 1 inside, 2 outside; each row is resolved once by walking up to a known ancestor
+        memset(node->members, 0, snap->count);
+        for (int i = 0; i < snap->count; i++) {
+            int path[64], depth = 0, j = i, verdict = 2;
+            while (j >= 0 && node->members[j] == 0 && depth < 64) {
+                if (snap->samples[j].pid == node->root) {
+                    verdict = 1;
+                    break;
+                }
+                path[depth++] = j;
+                const ProcessSample *parent = snapshot_find(snap, snap->samples[j].ppid);
+                j = parent && parent->pid != snap->samples[j].pid ? (int)(parent - snap->samples) : -1;
+            }
+            if (j >= 0 && node->members[j]) verdict = node->members[j];
+            if (j >= 0 && snap->samples[j].pid == node->root) node->members[j] = 1;
+            while (depth > 0) node->members[path[--depth]] = verdict;
+        }
+    }
+}
+
+static double numeric_value(const ProcessSample *s, filter_field_t field) {
+    switch (field) {
+        case FILTER_PID: return s->pid;
+        case FILTER_PPID: return s->ppid;
+        case FILTER_UID: return s->uid;
+        case FILTER_CPU: return s->cpu_percent;
+        case FILTER_MEM: return s->mem_percent;
+        case FILTER_RSS: return s->rss_kb;
+        case FILTER_VSIZE: return s->vsize_kb;
+        case FILTER_THREADS: return s->threads;
+        case FILTER_MINFLT: return s->minflt;
+        case FILTER_MAJFLT: return s->majflt;
+        default: return 0;
+    }
+}
+
+static int contains_nocase(const char *haystack, const char *needle) {
+    size_t len = strlen(needle);
+    for (const char *p = haystack; *p; p++) {
+        if (strncasecmp(p, needle, len) == 0) return 1;
+    }
+    return len == 0;
+}
+
+static int compare(const filter_node_t *node, const ProcessSample *s) {
+    if (node->field == FILTER_USER || node->field == FILTER_COMMAND) {
+        const char *value = node->field == FILTER_USER ? s->username : s->command;
+        switch (node->op) {
+            case OP_EQ: return strcmp(value, node->text) == 0;
+            case OP_NE: return strcmp(value, node->text) != 0;
+            case OP_CONTAINS: return contains_nocase(value, node->text);
+            default: return !contains_nocase(value, node->text);
+        }
+    }
+    if (node->field == FILTER_STATE) {
+        return (s->state == node->text[0]) == (node->op == OP_EQ);
+    }
+
+    double value = numeric_value(s, node->field);
+    switch (node->op) {
+        case OP_EQ: return value == node->number;
+        case OP_NE: return value != node->number;
+        case OP_LT: return value < node->number;
+        case OP_LE: return value <= node->number;
+        case OP_GT: return value > node->number;
+        default: return value >= node->number;
+    }
+}
+
+static int evaluate(const filter_t *filter, int n, const ProcessSnapshot *snap, int index) {
+    const filter_node_t *node = &filter->nodes[n];
+    switch (node->type) {
+        case NODE_AND:
+            return evaluate(filter, node->left, snap, index) && evaluate(filter, node->right, snap, index);
+        case NODE_OR:
+            return evaluate(filter, node->left, snap, index) || evaluate(filter, node->right, snap, index);
+        case NODE_NOT:
+            return !evaluate(filter, node->left, snap, index);
+        case NODE_SUBTREE:
+            return node->members && index < node->member_capacity && node->members[index] == 1;
+        default:
+            return compare(node, &snap->samples[index]);
+    }
+}
+
+int filter_match(const filter_t *filter, const ProcessSnapshot *snap, int index) {
+    if (filter == NULL) return 1;
+    return evaluate(filter, filter->root, snap, index);
+}
+
+static int zone_may_match(const filter_t *filter, int n, const filter_zone_t *zone) {
+    const filter_node_t *node = &filter->nodes[n];
+    switch (node->type) {
+        case NODE_AND:
+            return zone_may_match(filter, node->left, zone) && zone_may_match(filter, node->right, zone);
+        case NODE_OR:
+            return zone_may_match(filter, node->left, zone) || zone_may_match(filter, node->right, zone);
+        case NODE_COMPARE:
+            if (node->field < FILTER_NUMERIC_FIELDS) {
+                double lo = zone->min[node->field], hi = zone->max[node->field], v = node->number;
+                switch (node->op) {
+                    case OP_EQ: return lo <= v && v <= hi;
+                    case OP_NE: return !(lo == v && hi == v);
+                    case OP_LT: return lo < v;
+                    case OP_LE: return lo <= v;
+                    case OP_GT: return hi > v;
+                    default: return hi >= v;
+                }
+            }
+            return 1;
+        default:
+            // Negations and subtrees cannot be decided from bounds
+            return 1;
+    }
+}
+
+int filter_may_match(const filter_t *filter, const filter_zone_t *zone) {
+    if (filter == NULL) return 1;
+    return zone_may_match(filter, filter->root, zone);
+}
+
+const char *filter_text(const filter_t *filter) {
+    return filter ? filter->source : "";
+}
+
+void filter_free(filter_t *filter) {
+    if (filter == NULL) return;
+    for (int n = 0; n < filter->count; n++) free(filter->nodes[n].members);
+    free(filter);
+}
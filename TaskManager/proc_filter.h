@@ -0,0 +1,87 @@
+#ifndef PROC_FILTER_H
+#define PROC_FILTER_H
+
+#include <stddef.h>
+#include "proc_snapshot.h"
+
+// Fields a filter can test; the numeric ones also have zone map bounds
+typedef enum {
+    FILTER_PID,
+    FILTER_PPID,
+    FILTER_UID,
+    FILTER_CPU,                     // Percent
+    FILTER_MEM,                     // Percent
+    FILTER_RSS,                     // KB
+    FILTER_VSIZE,                   // KB
+    FILTER_THREADS,
+    FILTER_MINFLT,
+    FILTER_MAJFLT,
+    FILTER_NUMERIC_FIELDS,
+    FILTER_STATE = FILTER_NUMERIC_FIELDS,
+    FILTER_USER,
+    FILTER_COMMAND,
+    FILTER_FIELDS
+} filter_field_t;
+
+// Smallest and largest value of each numeric field over a group of rows
+typedef struct {
+    double min[FILTER_NUMERIC_FIELDS];
+    double max[FILTER_NUMERIC_FIELDS];
+} filter_zone_t;
+
+typedef struct filter filter_t;
+
+/**
+ * Compiles a filter expression such as
+ *   rss > 2G && user == root
+ *   (cpu >= 50 || majflt > 1000) and not comm ~ kworker
+ *   subtree(1234) && threads > 100
+ * Comparisons are ==, !=, <, <=, >, >= and ~ / !~ (case-insensitive
+ * substring, user and comm only). Sizes take K, M, G and T suffixes and
+ * default to KB. A bare word without operators matches command names,
+ * like the old name filter did.
+ * @param text The expression
+ * @param error Receives a message when compilation fails
+ * @param error_size Size of error
+ * @return The filter, or NULL for an empty expression (error is "") or on failure
+ */
+filter_t *filter_compile(const char *text, char *error, size_t error_size);
+
+/**
+ * Resolves subtree() terms against a snapshot. Call once per snapshot
+ * before filter_match; filters without subtree() terms skip the work.
+ * @param filter The filter, or NULL
+ * @param snap The snapshot about to be matched
+ */
+void filter_prepare(filter_t *filter, const ProcessSnapshot *snap);
+
+/**
+ * Tests one process of a prepared snapshot
+ * @param filter The filter; NULL matches everything
+ * @param snap The snapshot passed to filter_prepare
+ * @param index Index of the process in snap->samples
+ * @return 1 if the process matches, 0 otherwise
+ */
+int filter_match(const filter_t *filter, const ProcessSnapshot *snap, int index);
+
+/**
+ * Checks whether any row inside the zone could match. Only numeric
+ * comparisons can rule a zone out; everything else is assumed to match.
+ * @param filter The filter; NULL matches everything
+ * @param zone Bounds of the rows
+ * @return 0 if no row can match, 1 otherwise
+ */
+int filter_may_match(const filter_t *filter, const filter_zone_t *zone);
+
+/**
+ * The expression a filter was compiled from
+ */
+const char *filter_text(const filter_t *filter);
+
+/**
+ * Frees a compiled filter
+ * @param filter The filter, or NULL
+ */
+void filter_free(filter_t *filter);
+
+#endif
@@ -0,0 +1,765 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <pthread.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "proc_snapshot.h"
+#include "cgroup.h"
+#include "overhead.h"
+
+#define USER_CACHE_SIZE 64
+
+#define TIER_HOT_CPU_PERCENT 1.0f
+#define TIER_HOT_FAULT_RATE 100.0   // Page faults per second
+#define TIER_SPIKE_PERCENT 20.0     // Host CPU, in percent of one core, that the rows must account for
+
+static SampleScope current_scope = { .type = SCOPE_ALL };
+static int tiering_enabled = 0;
+static SnapshotSource current_source;
+static int source_set = 0;
+
+typedef struct {
+    uid_t uid;
+    char name[32];
+    int used;
+} user_cache_entry_t;
+
+static user_cache_entry_t user_cache[USER_CACHE_SIZE];
+static pthread_mutex_t user_cache_lock = PTHREAD_MUTEX_INITIALIZER;   // A sampler thread and the UI both look up names
+
+// getpwuid_r() reads /etc/passwd, so remember the answer per uid; the name is
+// copied out because another thread may overwrite the cache slot
+static void lookup_username(uid_t uid, char *out, size_t size) {
+    pthread_mutex_lock(&user_cache_lock);
+    user_cache_entry_t *entry = &user_cache[uid % USER_CACHE_SIZE];
+    if (!entry->used || entry->uid != uid) {
+        struct passwd pw, *found = NULL;
+        char buf[1024];
+        if (getpwuid_r(uid, &pw, buf, sizeof(buf), &found) == 0 && found) {
+            snprintf(entry->name, sizeof(entry->name), "%s", found->pw_name);
+        } else {
+            snprintf(entry->name, sizeof(entry->name), "%u", (unsigned)uid);
+        }
+        entry->uid = uid;
+        entry->used = 1;
+    }
+    snprintf(out, size, "%s", entry->name);
+    pthread_mutex_unlock(&user_cache_lock);
+}
+
+static double monotonic_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Plain open/read: stdio would allocate a FILE and its buffer on every refresh
+static int read_proc_file(const char *path, char *buf, size_t size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t len = read(fd, buf, size - 1);
+    close(fd);
+    if (len <= 0) return 0;
+    buf[len] = '\0';
+    return 1;
+}
+
+static double read_uptime(void) {
+    char buf[64];
+    return read_proc_file("/proc/uptime", buf, sizeof(buf)) ? strtod(buf, NULL) : 0;
+}
+
+// User, nice and system time of all CPUs, the part processes can be charged with
+static unsigned long long read_busy_ticks(void) {
+    char buf[256];
+    unsigned long long user, nice, system;
+    if (!read_proc_file("/proc/stat", buf, sizeof(buf)) ||
+        sscanf(buf, "cpu %llu %llu %llu", &user, &nice, &system) != 3) {
+        return 0;
+    }
+    return user + nice + system;
+}
+
+static unsigned long read_mem_total_kb(void) {
+    char buf[128];
+    unsigned long total = 0;
+    if (!read_proc_file("/proc/meminfo", buf, sizeof(buf)) || sscanf(buf, "MemTotal: %lu kB", &total) != 1) {
+        total = 0;
+    }
+    return total;
+}
+
+// Parses /proc/<pid>/stat; fields after the command are space separated
+static int parse_stat_line(char *buf, ProcessSample *s, long page_kb) {
+    char *open_paren = strchr(buf, '(');
+    char *close_paren = strrchr(buf, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) return 0;
+
+    size_t len = close_paren - open_paren - 1;
+    if (len >= sizeof(s->command)) len = sizeof(s->command) - 1;
+    memcpy(s->command, open_paren + 1, len);
+    s->command[len] = '\0';
+
+    char *p = close_paren + 2;
+    s->state = *p;
+    p += 2;
+
+    // Field numbers follow proc(5), starting at ppid (4)
+    unsigned long long fields[25];
+    for (int field = 4; field <= 24; field++) {
+        char *end;
+        fields[field] = strtoull(p, &end, 10);
+        if (end == p) return 0;
+        p = end;
+    }
+
+    s->ppid = (pid_t)fields[4];
+    s->minflt = fields[10];
+    s->majflt = fields[12];
+    s->utime = fields[14];
+    s->stime = fields[15];
+    s->threads = (int)fields[20];
+    s->starttime = fields[22];
+    s->vsize_kb = fields[23] / 1024;
+    s->rss_kb = fields[24] * page_kb;
+    return 1;
+}
+
+static int read_process_sample(pid_t pid, ProcessSample *s, long page_kb) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+
+    double start = overhead_clock();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    // The stat file is owned by the effective uid of the process
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return 0;
+    }
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    overhead_record(PHASE_READ, start);
+    if (len <= 0) return 0;
+    buf[len] = '\0';
+
+    start = overhead_clock();
+    memset(s, 0, sizeof(*s));
+    s->pid = pid;
+    s->uid = st.st_uid;
+    s->fds = -1;
+    s->io_bytes = SNAPSHOT_IO_UNKNOWN;
+    int parsed = parse_stat_line(buf, s, page_kb);
+    if (parsed) lookup_username(s->uid, s->username, sizeof(s->username));
+    overhead_record(PHASE_PARSE, start);
+    return parsed;
+}
+
+static int compare_pid(const void *a, const void *b) {
+    const ProcessSample *sa = a, *sb = b;
+    return (sa->pid > sb->pid) - (sa->pid < sb->pid);
+}
+
+// Hot processes burn CPU or fault pages, warm ones moved at all since their last read
+static unsigned char classify_tier(const ProcessSample *s, const ProcessSample *old, double elapsed) {
+    unsigned long faults = (s->minflt + s->majflt) - (old->minflt + old->majflt);
+    if (s->cpu_percent >= TIER_HOT_CPU_PERCENT || faults / elapsed >= TIER_HOT_FAULT_RATE) {
+        return TIER_HOT;
+    }
+    if (s->utime + s->stime != old->utime + old->stime || faults > 0 || s->state == 'R') {
+        return TIER_WARM;
+    }
+    return TIER_COLD;
+}
+
+// Both snapshots are sorted by PID, so rates come from a single merge pass
+static void compute_rates(ProcessSnapshot *snap, const ProcessSnapshot *previous) {
+    long ticks = sysconf(_SC_CLK_TCK);
+    int j = 0;
+
+    for (int i = 0; i < snap->count; i++) {
+        ProcessSample *s = &snap->samples[i];
+        s->mem_percent = snap->mem_total_kb ? 100.0f * s->rss_kb / snap->mem_total_kb : 0;
+        if (s->extrapolated) continue; // Rates and tier carry over with the sample
+
+        s->cpu_percent = 0;
+        s->tier = TIER_HOT;
+        if (!previous) {
+            // Without a previous sample fall back to the lifetime average, like ps
+            double alive = snap->uptime - (double)s->starttime / ticks;
+            if (alive > 0) {
+                s->cpu_percent = (float)(100.0 * (s->utime + s->stime) / ticks / alive);
+            }
+            continue;
+        }
+
+        while (j < previous->count && previous->samples[j].pid < s->pid) j++;
+        if (j < previous->count && previous->samples[j].pid == s->pid &&
+            previous->samples[j].starttime == s->starttime) {
+            // The previous counters may be several frames old for tiered processes
+            const ProcessSample *old = &previous->samples[j];
+            double elapsed = s->sampled_at - old->sampled_at;
+            if (elapsed <= 0) continue;
+            unsigned long long used = (s->utime + s->stime) - (old->utime + old->stime);
+            s->cpu_percent = (float)(100.0 * used / ticks / elapsed);
+            s->tier = classify_tier(s, old, elapsed);
+        }
+    }
+}
+
+// A carried-over row cannot show a spike, but the host total does: true when
+// the host used clearly more CPU than the rows of a full-host snapshot add up to
+static int spike_unaccounted(const ProcessSnapshot *snap, const ProcessSnapshot *previous) {
+    double elapsed = snap->timestamp - previous->timestamp;
+    if (!snap->busy_ticks || !previous->busy_ticks || snap->busy_ticks < previous->busy_ticks || elapsed <= 0) {
+        return 0;
+    }
+
+    double rows = 0;
+    int carried = 0;
+    for (int i = 0; i < snap->count; i++) {
+        rows += snap->samples[i].cpu_percent;
+        carried |= snap->samples[i].extrapolated;
+    }
+    double host = 100.0 * (snap->busy_ticks - previous->busy_ticks) / sysconf(_SC_CLK_TCK) / elapsed;
+    return carried && host - rows >= TIER_SPIKE_PERCENT;
+}
+
+// Reads every carried-over row now instead of when its tier comes due
+static void reread_extrapolated(ProcessSnapshot *snap, long page_kb) {
+    for (int i = 0; i < snap->count; i++) {
+        ProcessSample *s = &snap->samples[i];
+        if (!s->extrapolated) continue;
+        ProcessSample fresh;
+        snap->reads++;
+        if (!read_process_sample(s->pid, &fresh, page_kb)) continue; // Exited; gone at the next refresh
+        fresh.sampled_at = snap->timestamp;
+        *s = fresh;
+    }
+}
+
+// Staggered by PID so the cold re-reads spread evenly over the frames
+static int tier_due(const ProcessSample *old, unsigned long frame) {
+    switch (old->tier) {
+        case TIER_WARM: return (frame + old->pid) % TIER_WARM_INTERVAL == 0;
+        case TIER_COLD: return (frame + old->pid) % TIER_COLD_INTERVAL == 0;
+        default: return 1;
+    }
+}
+
+void snapshot_set_tiering(int enabled) {
+    // The overhead controller flips this from the UI while a sampler thread reads it
+    __atomic_store_n(&tiering_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+int snapshot_tiering_enabled(void) {
+    return __atomic_load_n(&tiering_enabled, __ATOMIC_RELAXED);
+}
+
+void snapshot_promote(ProcessSnapshot *snap, pid_t pid) {
+    ProcessSample *s = (ProcessSample *)snapshot_find(snap, pid);
+    if (s) s->tier = TIER_HOT;
+}
+
+void snapshot_set_scope(const SampleScope *scope) {
+    if (scope) {
+        current_scope = *scope;
+    } else {
+        memset(&current_scope, 0, sizeof(current_scope));
+        current_scope.type = SCOPE_ALL;
+    }
+}
+
+const SampleScope *snapshot_get_scope(void) {
+    return &current_scope;
+}
+
+void snapshot_describe_scope(char *buf, size_t size) {
+    if (source_set) {
+        current_source.describe(buf, size, current_source.ctx);
+        return;
+    }
+    switch (current_scope.type) {
+        case SCOPE_USER: {
+            char name[sizeof(user_cache[0].name)];
+            lookup_username(current_scope.uid, name, sizeof(name));
+            snprintf(buf, size, "user %s", name);
+            break;
+        }
+        case SCOPE_CGROUP:
+            snprintf(buf, size, "cgroup %s", current_scope.cgroup_path);
+            break;
+        case SCOPE_SUBTREE:
+            snprintf(buf, size, "subtree of PID %d", current_scope.root_pid);
+            break;
+        default:
+            snprintf(buf, size, "all processes");
+            break;
+    }
+}
+
+void snapshot_set_source(const SnapshotSource *source) {
+    source_set = source != NULL;
+    if (source) current_source = *source;
+}
+
+int snapshot_replaying(void) {
+    return source_set;
+}
+
+int snapshot_supported(void) {
+    if (source_set) return 1;
+    return access("/proc/self/stat", R_OK) == 0;
+}
+
+#define SCOPE_READ_SIZE 4096       // Stack buffer for listing a task directory and reading a children file
+
+// PIDs gathered for one refresh; they grow in the snapshot's arena when there is one
+typedef struct {
+    pid_t *pids;
+    int count;
+    int capacity;
+    arena_t *arena;
+} pid_list_t;
+
+static int append_pid(pid_list_t *list, pid_t pid) {
+    if (list->count == list->capacity) {
+        int grown_capacity = list->capacity ? list->capacity * 2 : 256;
+        pid_t *grown = list->arena ? arena_extend(list->arena, list->pids, list->capacity * sizeof(pid_t),
+                                                  grown_capacity * sizeof(pid_t))
+                                   : realloc(list->pids, grown_capacity * sizeof(pid_t));
+        if (!grown) return 0;
+        list->pids = grown;
+        list->capacity = grown_capacity;
+    }
+    list->pids[list->count++] = pid;
+    return 1;
+}
+
+// What getdents64 fills a directory buffer with
+typedef struct {
+    uint64_t ino;
+    int64_t off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[];
+} proc_dirent_t;
+
+// Appends every PID in a whitespace-separated file; a PID can straddle two reads
+static int append_pid_file(int fd, pid_list_t *list) {
+    char buf[SCOPE_READ_SIZE];
+    pid_t pid = 0;
+    int digits = 0;
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < len; i++) {
+            if (isdigit((unsigned char)buf[i])) {
+                pid = pid * 10 + (buf[i] - '0');
+                digits = 1;
+            } else if (digits) {
+                if (!append_pid(list, pid)) return 0;
+                pid = 0;
+                digits = 0;
+            }
+        }
+    }
+    return !digits || append_pid(list, pid);
+}
+
+// Appends the children of every thread of pid, read from /proc/<pid>/task/<tid>/children.
+// getdents64 and read avoid the buffers opendir and fopen would allocate per process.
+static void append_children(pid_t pid, pid_list_t *list) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    int dir = open(path, O_RDONLY | O_DIRECTORY);
+    if (dir < 0) return;
+
+    uint64_t entries[SCOPE_READ_SIZE / sizeof(uint64_t)];      // Keeps the entries aligned
+    int more = 1;
+    long len;
+    while (more && (len = syscall(SYS_getdents64, dir, entries, sizeof(entries))) > 0) {
+        for (long offset = 0; offset < len && more;) {
+            const proc_dirent_t *entry = (const proc_dirent_t *)((const char *)entries + offset);
+            offset += entry->reclen;
+            if (!isdigit((unsigned char)entry->name[0])) continue;
+
+            char children[32];
+            snprintf(children, sizeof(children), "%d/children", atoi(entry->name));
+            int fd = openat(dir, children, O_RDONLY);
+            if (fd < 0) continue;
+            more = append_pid_file(fd, list);
+            close(fd);
+        }
+    }
+    close(dir);
+}
+
+// Breadth-first walk from the root; returns -1 on kernels without CONFIG_PROC_CHILDREN
+static int collect_subtree_pids(pid_t root, pid_list_t *list) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/children", getpid());
+    if (access(path, R_OK) != 0) return -1;
+
+    snprintf(path, sizeof(path), "/proc/%d", root);
+    if (access(path, F_OK) != 0 || !append_pid(list, root)) {
+        return 0;
+    }
+
+    for (int next = 0; next < list->count; next++) {
+        append_children(list->pids[next], list);
+    }
+    return list->count;
+}
+
+// Parent of a process from its stat file, -1 if it is gone
+static pid_t read_ppid(pid_t pid) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return -1;
+    buf[len] = '\0';
+
+    // The command may contain spaces and parentheses; the fields resume after the last ')'
+    char state;
+    pid_t ppid;
+    const char *end = strrchr(buf, ')');
+    if (!end || sscanf(end + 1, " %c %d", &state, &ppid) != 2) return -1;
+    return ppid;
+}
+
+// Index of pid in the listed PIDs, which /proc usually hands out in ascending order
+static int find_listed_pid(const pid_t *pids, int count, int sorted, pid_t pid) {
+    if (!sorted) {
+        for (int i = 0; i < count; i++) if (pids[i] == pid) return i;
+        return -1;
+    }
+    int lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (pids[mid] == pid) return mid;
+        if (pids[mid] < pid) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+// Kept open across refreshes: rewinding costs a seek, opendir a buffer allocation each time
+static DIR *proc_dir;
+
+static int list_all_pids(pid_list_t *list) {
+    if (proc_dir) {
+        rewinddir(proc_dir);
+    } else if ((proc_dir = opendir("/proc")) == NULL) {
+        perror("Failed to open /proc");
+        return -1;
+    }
+    DIR *dir = proc_dir;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)entry->d_name[0])) continue;
+
+        // A directory stat is one syscall, far cheaper than reading the stat file
+        if (current_scope.type == SCOPE_USER) {
+            struct stat st;
+            if (fstatat(dirfd(dir), entry->d_name, &st, 0) < 0 || st.st_uid != current_scope.uid) {
+                continue;
+            }
+        }
+        if (!append_pid(list, atoi(entry->d_name))) break;
+    }
+    return list->count;
+}
+
+// Without the children files: lists every PID, reads each parent and keeps the descendants
+// of root. The parent table and keep-mask come from the scratch arena.
+static int filter_subtree_pids(pid_t root, pid_list_t *list, arena_t *scratch) {
+    if (list_all_pids(list) < 0) return -1;
+    int count = list->count;
+    pid_t *pids = list->pids;
+    pid_t *ppids = arena_alloc(scratch, count * sizeof(pid_t));
+    char *keep = arena_alloc(scratch, count);
+    if (!ppids || !keep) return -1;
+
+    int sorted = 1;
+    for (int i = 0; i < count; i++) {
+        ppids[i] = read_ppid(pids[i]);
+        keep[i] = pids[i] == root && ppids[i] >= 0;
+        if (i > 0 && pids[i] < pids[i - 1]) sorted = 0;
+    }
+
+    // Repeat until no new descendant is found
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < count; i++) {
+            if (keep[i] || ppids[i] < 0) continue;
+            int parent = find_listed_pid(pids, count, sorted, ppids[i]);
+            if (parent >= 0 && keep[parent]) {
+                keep[i] = 1;
+                changed = 1;
+            }
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (keep[i]) pids[kept++] = pids[i];
+    }
+    return list->count = kept;
+}
+
+// Cgroup members and subtree walks come out of PID order. Sorting the PIDs before the
+// samples are read lets snapshot_take skip qsort, whose merge buffer is a malloc;
+// this merge sort takes its buffer from the arena instead.
+static void sort_listed_pids(pid_list_t *list) {
+    int n = list->count, sorted = 1;
+    for (int i = 1; i < n && sorted; i++) sorted = list->pids[i - 1] <= list->pids[i];
+    if (sorted) return;
+    pid_t *src = list->pids, *dst = arena_alloc(list->arena, n * sizeof(pid_t));
+    if (!dst) return;
+
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = n - lo > width ? lo + width : n;
+            int hi = n - mid > width ? mid + width : n;
+            int i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) dst[k++] = src[i] <= src[j] ? src[i++] : src[j++];
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi) dst[k++] = src[j++];
+        }
+        pid_t *merged = dst;
+        dst = src;
+        src = merged;
+    }
+    if (src != list->pids) memcpy(list->pids, src, n * sizeof(pid_t));
+}
+
+static int append_cgroup_pid(pid_t pid, void *ctx) {
+    return append_pid(ctx, pid);
+}
+
+static int collect_scope_pids(pid_list_t *list) {
+    switch (current_scope.type) {
+        case SCOPE_CGROUP:
+            if (cgroup_for_each_pid(current_scope.cgroup_path, 1, append_cgroup_pid, list) < 0) return -1;
+            if (list->arena) sort_listed_pids(list);
+            return list->count;
+        case SCOPE_SUBTREE: {
+            int count = collect_subtree_pids(current_scope.root_pid, list);
+            if (count >= 0) {
+                if (list->arena) sort_listed_pids(list);
+                return count;
+            }
+            if (list->arena) return filter_subtree_pids(current_scope.root_pid, list, list->arena);
+
+            arena_t scratch = {0};
+            count = filter_subtree_pids(current_scope.root_pid, list, &scratch);
+            arena_free(&scratch);
+            return count;
+        }
+        default:
+            return list_all_pids(list);
+    }
+}
+
+int snapshot_scope_pids(pid_t **pids) {
+    pid_list_t list = {0};
+    int count = collect_scope_pids(&list);
+    if (count < 0) {
+        free(list.pids);
+        list.pids = NULL;
+    }
+    *pids = list.pids;
+    return count;
+}
+
+static int sorted_by_pid(const ProcessSnapshot *snap) {
+    for (int i = 1; i < snap->count; i++) {
+        if (snap->samples[i].pid < snap->samples[i - 1].pid) return 0;
+    }
+    return 1;
+}
+
+int snapshot_take(ProcessSnapshot *snap, const ProcessSnapshot *previous) {
+    if (source_set) return current_source.take(snap, current_source.ctx);
+
+    // The previous refresh of this snapshot is being recycled, and its PID list with it
+    arena_reset(&snap->arena);
+    pid_list_t list = { NULL, 0, 0, &snap->arena };
+    double start = overhead_clock();
+    int pid_count = collect_scope_pids(&list);
+    pid_t *pids = list.pids;
+    overhead_record(PHASE_ENUMERATE, start);
+    if (pid_count < 0) return -1;
+
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    int tiered = previous && (snapshot_tiering_enabled() || previous->count >= TIER_AUTO_PROCESSES);
+    snap->count = 0;
+    snap->reads = 0;
+    snap->frame = previous ? previous->frame + 1 : 0;
+    snap->timestamp = monotonic_now();
+    snap->uptime = read_uptime();
+    snap->mem_total_kb = read_mem_total_kb();
+    snap->busy_ticks = tiered ? read_busy_ticks() : 0;
+
+    if (pid_count > snap->capacity) {
+        ProcessSample *grown = realloc(snap->samples, pid_count * sizeof(ProcessSample));
+        if (grown) {
+            snap->samples = grown;
+            snap->capacity = pid_count;
+        }
+    }
+
+    for (int i = 0; i < pid_count && snap->count < snap->capacity; i++) {
+        ProcessSample *s = &snap->samples[snap->count];
+
+        // Quiet processes keep their last values until their tier comes due
+        const ProcessSample *old = tiered ? snapshot_find(previous, pids[i]) : NULL;
+        if (old && !tier_due(old, snap->frame)) {
+            *s = *old;
+            s->extrapolated = 1;
+            snap->count++;
+            continue;
+        }
+
+        snap->reads++;
+        if (read_process_sample(pids[i], s, page_kb)) {
+            // The stat file may belong to another uid after a setuid since enumeration
+            if (current_scope.type == SCOPE_USER && s->uid != current_scope.uid) {
+                continue;
+            }
+            s->sampled_at = snap->timestamp;
+            snap->count++;
+        }
+    }
+
+    // /proc lists PIDs in ascending order, so this usually skips qsort and its merge buffer
+    start = overhead_clock();
+    if (!sorted_by_pid(snap)) qsort(snap->samples, snap->count, sizeof(ProcessSample), compare_pid);
+    compute_rates(snap, previous);
+    overhead_record(PHASE_SORT, start);
+
+    // Other scopes leave out processes that use the host's CPU too, so only a full snapshot can tell
+    if (tiered && current_scope.type == SCOPE_ALL && spike_unaccounted(snap, previous)) {
+        reread_extrapolated(snap, page_kb);
+        start = overhead_clock();
+        compute_rates(snap, previous);
+        overhead_record(PHASE_SORT, start);
+    }
+    return snap->count;
+}
+
+// Since Linux 6.2 the size of /proc/<pid>/fd is the number of open descriptors
+static int count_fds(pid_t pid) {
+    char path[64];
+    struct stat st;
+    snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+    if (stat(path, &st) < 0) return -1;
+    if (st.st_size > 0) return st.st_size;
+
+    DIR *dir = opendir(path);
+    if (!dir) return -1;
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+int snapshot_count_fds(ProcessSnapshot *snap) {
+    double start = overhead_clock();
+    int counted = 0;
+    for (int i = 0; i < snap->count; i++) {
+        snap->samples[i].fds = count_fds(snap->samples[i].pid);
+        if (snap->samples[i].fds >= 0) counted++;
+    }
+    overhead_record(PHASE_READ, start);
+    return counted;
+}
+
+static unsigned long long read_io_bytes(pid_t pid) {
+    char path[64], buf[512];
+    snprintf(path, sizeof(path), "/proc/%d/io", pid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return SNAPSHOT_IO_UNKNOWN;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return SNAPSHOT_IO_UNKNOWN;
+    buf[len] = '\0';
+
+    char *read_bytes = strstr(buf, "read_bytes:");
+    char *write_bytes = strstr(buf, "\nwrite_bytes:");
+    if (!read_bytes || !write_bytes) return SNAPSHOT_IO_UNKNOWN;
+    return strtoull(read_bytes + 11, NULL, 10) + strtoull(write_bytes + 13, NULL, 10);
+}
+
+int snapshot_read_io(ProcessSnapshot *snap) {
+    double start = overhead_clock();
+    int counted = 0;
+    for (int i = 0; i < snap->count; i++) {
+        snap->samples[i].io_bytes = read_io_bytes(snap->samples[i].pid);
+        if (snap->samples[i].io_bytes != SNAPSHOT_IO_UNKNOWN) counted++;
+    }
+    overhead_record(PHASE_READ, start);
+    return counted;
+}
+
+int snapshot_copy(ProcessSnapshot *dst, const ProcessSnapshot *src) {
+    if (src->count > dst->capacity) {
+        ProcessSample *grown = realloc(dst->samples, src->count * sizeof(ProcessSample));
+        if (!grown) return 0;
+        dst->samples = grown;
+        dst->capacity = src->count;
+    }
+    memcpy(dst->samples, src->samples, src->count * sizeof(ProcessSample));
+    dst->count = src->count;
+    dst->timestamp = src->timestamp;
+    dst->uptime = src->uptime;
+    dst->mem_total_kb = src->mem_total_kb;
+    dst->frame = src->frame;
+    dst->reads = src->reads;
+    dst->busy_ticks = src->busy_ticks;
+    return 1;
+}
+
+void snapshot_free(ProcessSnapshot *snap) {
+    if (snap == NULL) return;
+    free(snap->samples);
+    arena_free(&snap->arena);
+    snap->samples = NULL;
+    snap->count = 0;
+    snap->capacity = 0;
+}
+
+const ProcessSample *snapshot_find(const ProcessSnapshot *snap, pid_t pid) {
+    int lo = 0, hi = snap->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (snap->samples[mid].pid == pid) return &snap->samples[mid];
+        if (snap->samples[mid].pid < pid) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+int snapshot_still_running(const ProcessSample *sample) {
+    ProcessSample now;
+    // A PID reused since the sample shows up as a different start time
+    return read_process_sample(sample->pid, &now, 1) && now.starttime == sample->starttime;
+}
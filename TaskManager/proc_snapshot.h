@@ -0,0 +1,203 @@
+#ifndef PROC_SNAPSHOT_H
+#define PROC_SNAPSHOT_H
+
+#include <sys/types.h>
+#include "arena.h"
+
+// How often a process is re-read; quiet processes are carried over between reads
+typedef enum {
+    TIER_HOT,                       // Re-read every frame
+    TIER_WARM,                      // Re-read every TIER_WARM_INTERVAL frames
+    TIER_COLD                       // Re-read every TIER_COLD_INTERVAL frames
+} sample_tier_t;
+
+#define TIER_WARM_INTERVAL 4
+#define TIER_COLD_INTERVAL 16
+#define TIER_AUTO_PROCESSES 1000    // Tiering switches on by itself above this many processes
+#define SNAPSHOT_IO_UNKNOWN (~0ULL)  // io_bytes before snapshot_read_io() or when /proc/<pid>/io is unreadable
+
+// One process as read from /proc/<pid>/stat during a refresh
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    uid_t uid;
+    char state;
+    char command[64];
+    char username[32];
+    unsigned long long utime;       // Clock ticks
+    unsigned long long stime;       // Clock ticks
+    unsigned long long starttime;   // Clock ticks after boot
+    unsigned long minflt;
+    unsigned long majflt;
+    unsigned long vsize_kb;
+    unsigned long rss_kb;
+    int threads;
+    int fds;                        // Open file descriptors, -1 until snapshot_count_fds() ran
+    unsigned long long io_bytes;    // Storage bytes read + written, SNAPSHOT_IO_UNKNOWN until snapshot_read_io() ran
+    float cpu_percent;              // Relative to the previous snapshot, lifetime average without one
+    float mem_percent;
+    double sampled_at;              // CLOCK_MONOTONIC seconds when the counters were last read
+    unsigned char tier;             // sample_tier_t
+    unsigned char extrapolated;     // Carried over from an earlier frame instead of re-read
+} ProcessSample;
+
+// All sampled processes of one refresh, sorted by PID
+typedef struct {
+    ProcessSample *samples;
+    int count;
+    int capacity;
+    double timestamp;               // CLOCK_MONOTONIC seconds
+    double uptime;                  // Seconds since boot when the snapshot was taken
+    unsigned long mem_total_kb;
+    unsigned long frame;            // Refresh number, drives the tier schedule
+    int reads;                      // Stat files actually read for this snapshot
+    unsigned long long busy_ticks;  // Host user+nice+system clock ticks from /proc/stat, 0 if unread
+    arena_t arena;                  // Variable-length data of one refresh, reset when the snapshot is retaken
+} ProcessSnapshot;
+
+typedef enum {
+    SCOPE_ALL,                      // Every process on the host
+    SCOPE_USER,                     // Processes owned by one uid
+    SCOPE_CGROUP,                   // Members of a cgroup and its descendants
+    SCOPE_SUBTREE                   // A process and all of its descendants
+} scope_type_t;
+
+// Replaces /proc as the origin of snapshots, e.g. to replay a recording
+typedef struct {
+    int (*take)(ProcessSnapshot *snap, void *ctx);              // Same contract as snapshot_take
+    void (*describe)(char *buf, size_t size, void *ctx);        // Status line text instead of the scope
+    void *ctx;
+} SnapshotSource;
+
+// Restricts which processes the sampler enumerates
+typedef struct {
+    scope_type_t type;
+    uid_t uid;
+    char cgroup_path[512];
+    pid_t root_pid;
+} SampleScope;
+
+/**
+ * Sets the scope honoured by every following snapshot_take
+ * @param scope The new scope, or NULL to sample all processes
+ */
+void snapshot_set_scope(const SampleScope *scope);
+
+/**
+ * Returns the scope currently applied to snapshots
+ */
+const SampleScope *snapshot_get_scope(void);
+
+/**
+ * Describes the current scope for status lines ("all processes", "user root", ...)
+ * @param buf Buffer receiving the description
+ * @param size Size of the buffer
+ */
+void snapshot_describe_scope(char *buf, size_t size);
+
+/**
+ * Returns the PIDs inside the current scope without reading their stats.
+ * Cgroup scopes read cgroup.procs and subtree scopes follow
+ * /proc/<pid>/task/<tid>/children, so neither walks all of /proc.
+ * @param pids Receives a malloc'ed array the caller must free; NULL on failure
+ * @return Number of PIDs, -1 on failure
+ */
+int snapshot_scope_pids(pid_t **pids);
+
+/**
+ * Forces tiered sampling on or off. When off, tiering still engages once a
+ * refresh covers TIER_AUTO_PROCESSES processes.
+ * @param enabled 1 to always tier, 0 for automatic
+ */
+void snapshot_set_tiering(int enabled);
+
+/**
+ * Checks whether tiered sampling is forced on
+ */
+int snapshot_tiering_enabled(void);
+
+/**
+ * Moves a process to the hot tier so the next refresh re-reads it.
+ * Views call this for rows in their top-N or matching their filter.
+ * @param snap The snapshot that will be passed as previous to the next refresh
+ * @param pid The process ID
+ */
+void snapshot_promote(ProcessSnapshot *snap, pid_t pid);
+
+/**
+ * Routes every following snapshot_take to another source. Scope and
+ * tiering do not apply while a source is set.
+ * @param source The source, copied; NULL goes back to reading /proc
+ */
+void snapshot_set_source(const SnapshotSource *source);
+
+/**
+ * Checks whether snapshots come from a source other than the live /proc
+ * @return 1 while a source is set, 0 otherwise
+ */
+int snapshot_replaying(void);
+
+/**
+ * Checks whether process snapshots can be taken on this system (/proc exists)
+ * @return 1 if supported, 0 otherwise
+ */
+int snapshot_supported(void);
+
+/**
+ * Reads every process inside the current scope from /proc into a snapshot
+ * @param snap Snapshot to fill; its buffer is reused across calls
+ * @param previous Previous snapshot used for CPU rates and the tier schedule,
+ *                 or NULL for lifetime averages (like ps); must not be snap
+ * @return Number of processes sampled, -1 on failure
+ */
+int snapshot_take(ProcessSnapshot *snap, const ProcessSnapshot *previous);
+
+/**
+ * Fills in the open file descriptor count of every process. Kept out of
+ * snapshot_take because it costs a stat (a directory walk before Linux
+ * 6.2) per process; processes we may not inspect stay at -1.
+ * @param snap The snapshot
+ * @return Number of processes whose count could be read
+ */
+int snapshot_count_fds(ProcessSnapshot *snap);
+
+/**
+ * Fills in the storage I/O counters (read_bytes + write_bytes) of every
+ * process. Like the fd count it costs one more file per process, so only
+ * views that show I/O call it. Other users' processes need root.
+ * @param snap The snapshot
+ * @return Number of processes whose counters could be read
+ */
+int snapshot_read_io(ProcessSnapshot *snap);
+
+/**
+ * Copies the rows and header of a snapshot, e.g. to keep it past the next
+ * refresh
+ * @param dst Receives the copy; its buffer is reused and grown as needed
+ * @param src The snapshot
+ * @return 1 on success, 0 if out of memory
+ */
+int snapshot_copy(ProcessSnapshot *dst, const ProcessSnapshot *src);
+
+/**
+ * Frees the buffers of a snapshot
+ * @param snap The snapshot
+ */
+void snapshot_free(ProcessSnapshot *snap);
+
+/**
+ * Finds a process in a snapshot
+ * @param snap The snapshot
+ * @param pid The process ID
+ * @return The sample, or NULL if the PID was not sampled
+ */
+const ProcessSample *snapshot_find(const ProcessSnapshot *snap, pid_t pid);
+
+/**
+ * Checks that a sampled process still runs under its PID
+ * @param sample A sample from an earlier snapshot
+ * @return 1 if it does, 0 if it exited or its PID now names another process
+ */
+int snapshot_still_running(const ProcessSample *sample);
+
+#endif
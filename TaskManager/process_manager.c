@@ -2,14 +2,25 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <errno.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <time.h>
 #include <pthread.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
 #include "process_manager.h"
+#include "taskstats.h"
+#include "proc_snapshot.h"
+#include "overhead.h"
+#include "cpu_panel.h"
+#include "proc_filter.h"
+#include "sampler.h"
+#include "taskmgr.h"
 
 static const ProcessState process_states[] = {
     {'R', "Running - Process is running or runnable (on run queue)"},
@@ -23,265 +34,89 @@ static const ProcessState process_states[] = {
     {'\0', NULL} // End of array marker
 };
 
-#define MAX_SCHEDULED_TASKS 100
-
-static scheduled_task_t tasks[MAX_SCHEDULED_TASKS];
-static int task_count = 0;
-static int scheduler_running = 0;
-static pthread_t scheduler_thread;
-static pthread_mutex_t task_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-void* scheduler_thread_function(void* arg) {
-    (void)arg;  // Suppress unused parameter warning
-    
-    while (scheduler_running) {
-        time_t current_time = time(NULL);
-        
-        pthread_mutex_lock(&task_mutex);
-        for (int i = 0; i < task_count; i++) {
-            if (!tasks[i].is_active) continue;
-            
-            int should_run = 0;
-            switch (tasks[i].type) {
-                case ONCE:
-                    if (current_time >= tasks[i].execution_time) {
-                        should_run = 1;
-                        tasks[i].is_active = 0;  // Bir kerelik görev tamamlandı
-                    }
-                    break;
-                    
-                case INTERVAL:
-                    if (current_time >= tasks[i].execution_time) {
-                        should_run = 1;
-                        tasks[i].execution_time = current_time + tasks[i].interval_seconds;
-                    }
-                    break;
-                    
-                case DAILY: {
-                    struct tm* tm_current = localtime(&current_time);
-                    struct tm* tm_scheduled = localtime(&tasks[i].execution_time);
-                    if (tm_current->tm_hour == tm_scheduled->tm_hour &&
-                        tm_current->tm_min == tm_scheduled->tm_min) {
-                        should_run = 1;
-                        //Schedule for tomorrow same time 
-                        tasks[i].execution_time += 24 * 60 * 60;
-                    }
-                    break;
-                }
-            }
-            
-            if (should_run) {
-                // Create a modified command with task identifier
-                char task_cmd[512];
-                
-                // For better identification in process listings
-                snprintf(task_cmd, sizeof(task_cmd), 
-                        "echo \"Running Task %d: %s\"; %s", 
-                        i + 1, tasks[i].command, tasks[i].command);
-                
-                pid_t pid = fork();
-                if (pid == 0) {
-                    // Create identifiable process name using Task-ID prefix
-                    char process_name[256];
-                    snprintf(process_name, sizeof(process_name), "Task-%d", i + 1);
-                    
-                    // Write the name to /proc/self/comm if available (Linux)
-                    FILE *comm_file = fopen("/proc/self/comm", "w");
-                    if (comm_file) {
-                        fputs(process_name, comm_file);
-                        fclose(comm_file);
-                    }
-                    
-                    // Execute the task
-                    execl("/bin/sh", "sh", "-c", task_cmd, NULL);
-                    exit(1);
-                } else if (pid > 0) {
-                    tasks[i].last_pid = pid;
-                }
-            }
-        }
-        pthread_mutex_unlock(&task_mutex);
-        
-        sleep(1); 
+static const char *task_type_name(tm_sched_type_t type) {
+    switch (type) {
+        case TM_SCHED_ONCE: return "Once";
+        case TM_SCHED_INTERVAL: return "Interval";
+        case TM_SCHED_DAILY: return "Daily";
     }
-    return NULL;
-}
-
-void init_task_scheduler(void) {
-    task_count = 0;
-    scheduler_running = 0;
-    memset(tasks, 0, sizeof(tasks));
-}
-
-void add_scheduled_task(const char* command, schedule_type_t type, time_t execution_time, int interval_seconds) {
-    pthread_mutex_lock(&task_mutex);
-    
-    if (task_count >= MAX_SCHEDULED_TASKS) {
-        printf("Maximum task limit reached!\n");
-        pthread_mutex_unlock(&task_mutex);
-        return;
-    }
-    
-    scheduled_task_t* task = &tasks[task_count];
-    strncpy(task->command, command, sizeof(task->command) - 1);
-    task->type = type;
-    task->execution_time = execution_time;
-    task->interval_seconds = interval_seconds;
-    task->is_active = 1;
-    task->last_pid = 0;
-    
-    task_count++;
-    pthread_mutex_unlock(&task_mutex);
-}
-
-void add_demo_task(const char* name) {
-    pthread_mutex_lock(&task_mutex);
-    
-    if (task_count >= MAX_SCHEDULED_TASKS) {
-        printf("Maximum task limit reached!\n");
-        pthread_mutex_unlock(&task_mutex);
-        return;
-    }
-    
-    // Mevcut demo görevlerini kontrol et
-    for (int i = 0; i < task_count; i++) {
-        if (tasks[i].is_demo_task) {
-            printf("Zaten bir demo görevi mevcut (Task ID: %d, PID: %d)\n", i+1, tasks[i].last_pid);
-            pthread_mutex_unlock(&task_mutex);
-            return;
-        }
-    }
-    
-    scheduled_task_t* task = &tasks[task_count];
-    
-    // Demo görevi adı
-    char task_name[256];
-    snprintf(task_name, sizeof(task_name), "Demo görev: %s", name);
-    strncpy(task->command, task_name, sizeof(task->command) - 1);
-    
-    task->type = INTERVAL;
-    task->execution_time = time(NULL); // Hemen başlat
-    task->interval_seconds = 3600; // 1 saat (aslında sürekli çalışacak)
-    task->is_active = 1;
-    task->last_pid = 0;
-    task->is_demo_task = 1; // Bu bir demo görevi
-    
-    int task_index = task_count; // Görev indeksi için kopyala
-    task_count++;
-    
-    printf("Demo görevi eklendi. Scheduler'ı başlattığınızda, sabit bir PID ile uzun süre çalışacak.\n");
-    
-    // Eğer scheduler zaten çalışıyorsa, hemen bu görev için bir PID ata
-    if (scheduler_running) {
-        // Demo görev kontrolcüsünü oluştur
-        char task_id[64];
-        snprintf(task_id, sizeof(task_id), "Demo-%d-Task", task_index + 1);
-        
-        // Demo görevi için uzun süre çalışan bir komut
-        char command[512];
-        
-        // Demo görev kontrolcüsü için komut
-        snprintf(command, sizeof(command), 
-               "export PS1=\"Demo-%d> \"; echo \"[%s] DEMO TASK RUNNING ($(date))\" > /dev/stderr; "
-               "echo \"Bu bir demo görevidir. PID:$$. 'Ctrl+C' ile durdurmayın.\"; "
-               "echo \"Bu süreç, öncelik değiştirme demosu için kullanılmaktadır.\"; "
-               "while true; do echo -n .; sleep 10; done", 
-               task_index + 1, task_id);
-        
-        // Süreci fork() ile oluştur
-        pid_t pid = fork();
-        if (pid == 0) {
-            // Çocuk süreç - demo süreci
-            setsid(); // Kendi süreç grubunu oluştur
-            
-            // Komutun çalıştırılması
-            execl("/bin/sh", task_id, "-c", command, NULL);
-            exit(0);
-        } else if (pid > 0) {
-            // Ebeveyn süreç - PID'yi kaydet
-            task->last_pid = pid;
-            char timestamp[32];
-            time_t now = time(NULL);
-            strftime(timestamp, sizeof(timestamp), "%H:%M:%S", localtime(&now));
-            printf("Demo task started with PID: %d at %s\n", pid, timestamp);
-            printf("Bu PID'yi öncelik değiştirme demosu için kullanabilirsiniz.\n");
-        }
-    } else {
-        printf("Bu görev, öncelik değiştirme işlemleri için idealdir.\n");
-    }
-    
-    pthread_mutex_unlock(&task_mutex);
+    return "?";
 }
 
 void list_scheduled_tasks(void) {
-    pthread_mutex_lock(&task_mutex);
+    tm_task_t tasks[TM_SCHED_MAX_TASKS];
+    int task_count = tm_sched_list(tasks, TM_SCHED_MAX_TASKS);
     printf("\nScheduled Tasks:\n");
     printf("%-4s %-40s %-10s %-20s %-10s %-10s %-10s\n", 
            "ID", "Command", "Type", "Next Run", "Interval", "Status", "Last PID");
     printf("------------------------------------------------------------------------------------------\n");
     
-    for (int i = 0; i < task_count; i++) {
-        char type_str[10];
-        switch (tasks[i].type) {
-            case ONCE: strcpy(type_str, "Once"); break;
-            case INTERVAL: strcpy(type_str, "Interval"); break;
-            case DAILY: strcpy(type_str, "Daily"); break;
-        }
-        
+    for (int i = 0; i < task_count && i < TM_SCHED_MAX_TASKS; i++) {
         char time_str[20];
+        struct tm next_run;
         strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", 
-                localtime(&tasks[i].execution_time));
+                localtime_r(&tasks[i].next_run, &next_run));
         
-        char pid_str[10] = "N/A";
+        char pid_str[12] = "N/A";
         if (tasks[i].last_pid > 0) {
             snprintf(pid_str, sizeof(pid_str), "%d", tasks[i].last_pid);
         }
         
         printf("%-4d %-40s %-10s %-20s %-10d %-10s %-10s\n", 
-               i + 1,
+               tasks[i].id,
                tasks[i].command,
-               type_str,
+               task_type_name(tasks[i].type),
                time_str,
                tasks[i].interval_seconds,
-               tasks[i].is_active ? "Active" : "Inactive",
+               tasks[i].active ? "Active" : "Inactive",
                pid_str);
     }
-    pthread_mutex_unlock(&task_mutex);
 }
 
-void remove_scheduled_task(int task_index) {
-    pthread_mutex_lock(&task_mutex);
-    
-    if (task_index < 0 || task_index >= task_count) {
-        printf("Invalid task index!\n");
-        pthread_mutex_unlock(&task_mutex);
+static int find_task(int id, tm_task_t *out) {
+    tm_task_t tasks[TM_SCHED_MAX_TASKS];
+    int task_count = tm_sched_list(tasks, TM_SCHED_MAX_TASKS);
+    for (int i = 0; i < task_count && i < TM_SCHED_MAX_TASKS; i++) {
+        if (tasks[i].id == id) {
+            *out = tasks[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The demo task is an ordinary task whose command never exits, so its PID stays put
+void add_demo_task(const char* name) {
+    static int demo_task_id;
+    tm_task_t task;
+    if (demo_task_id > 0 && find_task(demo_task_id, &task)) {
+        printf("Zaten bir demo görevi mevcut (Task ID: %d, PID: %d)\n", task.id, task.last_pid);
         return;
     }
     
-    // Son task'ı silinen yere taşı
-    if (task_index < task_count - 1) {
-        memcpy(&tasks[task_index], &tasks[task_count - 1], sizeof(scheduled_task_t));
+    // Everything after '#' is a shell comment, so the name is shown but never run
+    char command[TM_TASK_COMMAND_MAX];
+    snprintf(command, sizeof(command), "while true; do sleep 10; done # Demo görev: %s", name);
+    int id = tm_sched_add(command, TM_SCHED_ONCE, time(NULL), 0);
+    if (id < 0) {
+        printf("Maximum task limit reached!\n");
+        return;
     }
-    task_count--;
+    demo_task_id = id;
+    printf("Demo görevi eklendi (Task ID: %d).\n", id);
     
-    pthread_mutex_unlock(&task_mutex);
-}
-
-void run_task_scheduler(void) {
-    if (!scheduler_running) {
-        scheduler_running = 1;
-        pthread_create(&scheduler_thread, NULL, scheduler_thread_function, NULL);
-        printf("Task scheduler started.\n");
+    // The scheduler thread checks its table once a second
+    for (int tries = 0; tries < 30; tries++) {
+        if (find_task(id, &task) && task.last_pid > 0) {
+            printf("Demo task started with PID: %d\n", task.last_pid);
+            printf("Bu PID'yi öncelik değiştirme demosu için kullanabilirsiniz.\n");
+            return;
+        }
+        usleep(100000);
     }
+    printf("Bu görev, öncelik değiştirme işlemleri için idealdir; PID'si görev listesinde görünecek.\n");
 }
 
-void stop_task_scheduler(void) {
-    if (scheduler_running) {
-        scheduler_running = 0;
-        pthread_join(scheduler_thread, NULL);
-        printf("Task scheduler stopped.\n");
-    }
-}
 //Threads adding v1.2.0
 //for adding thread instead of usin ps now using top to similar output like ps aux
 void list_all_processes(void) {
@@ -531,6 +366,24 @@ int change_process_priority(pid_t target_pid, int priority) {
     }
 }
 
+int wait_for_refresh(int interval_ms) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+    
+    struct timeval tv;
+    tv.tv_sec = interval_ms / 1000;
+    tv.tv_usec = (interval_ms % 1000) * 1000;
+    
+    if (select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) > 0) {
+        // Consume the rest of the line so it does not leak into the menu
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF);
+        return 1;
+    }
+    return 0;
+}
+
 void show_process_states_info(void) {
     printf("\n===== Process State Codes and Descriptions PROUDLY DESIGNED BY KAPPASUTRA =====\n");
     printf("%-6s %-70s\n", "CODE", "DESCRIPTION");
@@ -563,7 +416,217 @@ void explain_process_state(char state) {
     printf("Unknown process state code: %c\n", state);
 }
 
+static void print_scope_line(const ProcessSnapshot *snap) {
+    char scope[600];
+    snapshot_describe_scope(scope, sizeof(scope));
+    printf("Scope: %s (%d processes sampled, %d read", scope, snap->count, snap->reads);
+    printf(snap->reads < snap->count ? ", ~ marks extrapolated values)\n" : ")\n");
+}
+
+// Prints the children of parent_index in pstree style; first_child/next_sibling index the snapshot
+static void print_tree_children(const ProcessSnapshot *snap, const int *first_child,
+                                const int *next_sibling, int parent_index, char *prefix, size_t prefix_len) {
+    for (int i = first_child[parent_index]; i >= 0; i = next_sibling[i]) {
+        int last = next_sibling[i] < 0;
+        printf("%s%s%s(%d)\n", prefix, last ? "└─" : "├─", snap->samples[i].command, snap->samples[i].pid);
+
+        // Each level adds at most 4 bytes ("│ " in UTF-8)
+        if (prefix_len + 5 < 1024) {
+            strcpy(prefix + prefix_len, last ? "  " : "│ ");
+            print_tree_children(snap, first_child, next_sibling, i, prefix, strlen(prefix));
+            prefix[prefix_len] = '\0';
+        }
+    }
+}
+
+// Builds the tree from the ppid links of a snapshot, so it honours the monitoring scope
+static void display_snapshot_tree(pid_t root_pid) {
+    ProcessSnapshot snap = {0};
+    if (snapshot_take(&snap, NULL) < 0) {
+        printf("Failed to sample processes\n");
+        return;
+    }
+
+    int *first_child = malloc((snap.count + 1) * sizeof(int));
+    int *next_sibling = malloc((snap.count + 1) * sizeof(int));
+    if (!first_child || !next_sibling) {
+        perror("Out of memory");
+        free(first_child);
+        free(next_sibling);
+        snapshot_free(&snap);
+        return;
+    }
+    for (int i = 0; i < snap.count; i++) {
+        first_child[i] = -1;
+        next_sibling[i] = -1;
+    }
+
+    // Walk backwards so siblings end up in ascending PID order
+    for (int i = snap.count - 1; i >= 0; i--) {
+        const ProcessSample *parent = snapshot_find(&snap, snap.samples[i].ppid);
+        if (parent && parent->pid != snap.samples[i].pid) {
+            int p = parent - snap.samples;
+            next_sibling[i] = first_child[p];
+            first_child[p] = i;
+        }
+    }
+
+    print_scope_line(&snap);
+    char prefix[1024] = "";
+    int shown = 0;
+    for (int i = 0; i < snap.count; i++) {
+        const ProcessSample *s = &snap.samples[i];
+        int is_root = root_pid > 0 ? s->pid == root_pid
+                                   : snapshot_find(&snap, s->ppid) == NULL || s->ppid == s->pid;
+        if (!is_root) continue;
+
+        printf("%s(%d)\n", s->command, s->pid);
+        print_tree_children(&snap, first_child, next_sibling, i, prefix, 0);
+        shown++;
+    }
+    if (shown == 0) {
+        printf("Process %d is not running or outside the monitoring scope\n", root_pid);
+    }
+
+    free(first_child);
+    free(next_sibling);
+    snapshot_free(&snap);
+}
+
+static int compare_sample_cpu_desc(const void *a, const void *b) {
+    const ProcessSample *sa = *(const ProcessSample * const *)a, *sb = *(const ProcessSample * const *)b;
+    return (sa->cpu_percent < sb->cpu_percent) - (sa->cpu_percent > sb->cpu_percent);
+}
+
+static int compare_sample_rss_desc(const void *a, const void *b) {
+    const ProcessSample *sa = *(const ProcessSample * const *)a, *sb = *(const ProcessSample * const *)b;
+    return (sa->rss_kb < sb->rss_kb) - (sa->rss_kb > sb->rss_kb);
+}
+
+void overhead_print_status(void) {
+    overhead_status_t st;
+    overhead_status(&st);
+
+    char allocs[32] = "mallocs n/a";
+    if (st.counting_allocs) snprintf(allocs, sizeof(allocs), "%lu malloc%s", st.allocations, st.allocations == 1 ? "" : "s");
+
+    printf("Self: %.2f%% CPU (budget %.2f%%), %.1fs total, %lu KB RSS | "
+           "enum %.1f read %.1f parse %.1f sort %.1f render %.1f ms | %s | interval %d ms%s\n",
+           st.cpu_percent, st.budget_percent, st.total_cpu_seconds, st.rss_kb,
+           st.phase_ms[PHASE_ENUMERATE], st.phase_ms[PHASE_READ], st.phase_ms[PHASE_PARSE],
+           st.phase_ms[PHASE_SORT], st.phase_ms[PHASE_RENDER], allocs, st.interval_ms,
+           st.tiered ? (st.tiering_forced ? ", tiered (budget)" : ", tiered") : "");
+}
+
+int terminal_rows(void) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0) {
+        return ws.ws_row;
+    }
+    return 24;
+}
+
+void snapshot_print_header(void) {
+    printf("%-12s %8s %8s %6s %6s %10s %5s %4s %-20s\n",
+           "USER", "PID", "PPID", "CPU", "MEM", "RSS(KB)", "STATE", "#TH", "COMMAND");
+}
+
+void snapshot_print_row(const ProcessSample *s) {
+    printf("%-12.12s %8d %8d %5.1f%c %6.1f %10lu %5c %4d %-20s\n",
+           s->username, s->pid, s->ppid, s->cpu_percent, s->extrapolated ? '~' : ' ',
+           s->mem_percent, s->rss_kb, s->state, s->threads, s->command);
+}
+
+// Live top-N; a sampler thread refreshes into the buffer this loop is not rendering
+static void show_top_snapshot_usage(int sort_by, int count, const char *filter) {
+    const ProcessSample **order = NULL;
+    int order_capacity = 0;
+    char error[128];
+    filter_t *compiled = filter ? filter_compile(filter, error, sizeof(error)) : NULL;
+    if (filter && !compiled && error[0]) {
+        printf("Bad filter: %s\n", error);
+        return;
+    }
+    cpu_panel_t *cpu = cpu_panel_create();
+
+    overhead_begin(1000);
+    sampler_t *sampler = sampler_start(1000);
+    if (!sampler) {
+        cpu_panel_destroy(cpu);
+        filter_free(compiled);
+        return;
+    }
+
+    const ProcessSnapshot *snap;
+    while ((snap = sampler_acquire(sampler)) != NULL) {
+        if (snap->count > order_capacity) {
+            const ProcessSample **grown = realloc(order, snap->count * sizeof(*order));
+            if (!grown) {
+                sampler_release(sampler, snap);
+                break;
+            }
+            order = grown;
+            order_capacity = snap->count;
+        }
+
+        // Sort pointers so the snapshot itself stays in PID order for the next refresh
+        double start = overhead_clock();
+        int matched = 0;
+        filter_prepare(compiled, snap);
+        for (int i = 0; i < snap->count; i++) {
+            if (filter_match(compiled, snap, i)) {
+                order[matched++] = &snap->samples[i];
+            }
+        }
+        qsort(order, matched, sizeof(*order), sort_by == 1 ? compare_sample_cpu_desc : compare_sample_rss_desc);
+        overhead_record(PHASE_SORT, start);
+
+        // The CPU panel reads the live /proc/stat, which says nothing about a replayed frame
+        int have_cpu = cpu && !snapshot_replaying() && cpu_panel_sample(cpu) > 0;
+
+        start = overhead_clock();
+        printf("\033[2J\033[H");
+        if (have_cpu) {
+            // Whatever the process table and status lines leave over goes to the per-core lines
+            int shown = matched < count ? matched : count;
+            cpu_panel_render(cpu, terminal_rows() - shown - 12);
+            printf("\n");
+        }
+        printf("===== Top %d Processes by %s Usage =====\n", count, sort_by == 1 ? "CPU" : "Memory");
+        print_scope_line(snap);
+        if (compiled) printf("Filter: %s (%d matching)\n", filter_text(compiled), matched);
+        snapshot_print_header();
+        for (int i = 0; i < matched && i < count; i++) {
+            snapshot_print_row(order[i]);
+        }
+        overhead_record(PHASE_RENDER, start);
+        int interval = overhead_end_frame();
+        overhead_print_status();
+        printf("\nPress Enter to return\n");
+        fflush(stdout);
+
+        // Shown rows and filter matches must never lag behind
+        for (int i = 0; i < matched; i++) {
+            if (i < count || compiled) sampler_promote(sampler, order[i]->pid);
+        }
+        sampler_release(sampler, snap);
+
+        sampler_set_interval(sampler, interval);
+        if (sampler_wait(sampler)) break;
+    }
+
+    free(order);
+    sampler_stop(sampler);
+    cpu_panel_destroy(cpu);
+    filter_free(compiled);
+}
+
 void display_process_tree(pid_t root_pid) {
+    if (snapshot_supported()) {
+        display_snapshot_tree(root_pid);
+        return;
+    }
+
     pid_t pid = fork();
     
     if (pid < 0) {
@@ -624,7 +687,18 @@ void display_process_tree(pid_t root_pid) {
     }
 }
 
-void show_top_resource_usage(int sort_by, int count) {
+void show_top_resource_usage(int sort_by, int count, const char *filter) {
+    // Delay accounting comes from the kernel, not from ps
+    if (sort_by >= 3 && sort_by <= 6) {
+        show_top_delay_usage((delay_sort_t)(sort_by - 3), count);
+        return;
+    }
+
+    if (snapshot_supported()) {
+        show_top_snapshot_usage(sort_by, count > 0 ? count : 10, filter);
+        return;
+    }
+
     count = count +1;
     if (count <= 0) {
         count = 10; // Default to top 10 if you want you can change it but believe me after 10 in terminal you will see a lot of processes. So hard to see.
@@ -977,16 +1051,17 @@ void filter_tasks_by_name(const char *name) {
         return;
     }
     
-    pthread_mutex_lock(&task_mutex);
+    tm_task_t tasks[TM_SCHED_MAX_TASKS];
+    int task_count = tm_sched_list(tasks, TM_SCHED_MAX_TASKS);
     printf("\nTasks matching '%s':\n", name);
     printf("%-4s %-40s %-10s %-10s\n", 
            "ID", "Command", "Status", "PID");
     printf("-------------------------------------------------------------\n");
     
     int found = 0;
-    for (int i = 0; i < task_count; i++) {
+    for (int i = 0; i < task_count && i < TM_SCHED_MAX_TASKS; i++) {
         if (strstr(tasks[i].command, name) != NULL) {
-            char pid_str[10] = "N/A";
+            char pid_str[12] = "N/A";
             if (tasks[i].last_pid > 0) {
                 // Check if process is still running
                 char check_cmd[64];
@@ -1000,9 +1075,9 @@ void filter_tasks_by_name(const char *name) {
             }
             
             printf("%-4d %-40s %-10s %-10s\n", 
-                   i + 1,
+                   tasks[i].id,
                    tasks[i].command,
-                   tasks[i].is_active ? "Active" : "Inactive",
+                   tasks[i].active ? "Active" : "Inactive",
                    pid_str);
             found++;
         }
@@ -1011,10 +1086,47 @@ void filter_tasks_by_name(const char *name) {
     if (!found) {
         printf("No tasks found matching '%s'\n", name);
     }
-    pthread_mutex_unlock(&task_mutex);
 }
 
 void list_all_processes_with_threads(void) {
+    ProcessSnapshot snap = {0};
+    if (snapshot_supported() && snapshot_take(&snap, NULL) >= 0) {
+        print_scope_line(&snap);
+        printf("╔═══════════════════╦════════════╦═════════╦═════════╦═════════════╦═════════════╦═════════╦═════════════╦══════════════════════════════════════════╦═══════╦═══════════════════════════════════════════════════╗\n");
+        printf("║      USER         ║    PID     ║   CPU   ║   MEM   ║    VSIZE   ║     RSS    ║  STATE  ║    TIME     ║                 COMMAND                   ║  #TH  ║                THREAD DETAILS                    ║\n");
+        printf("╠═══════════════════╬════════════╬═════════╬═════════╬═════════════╬═════════════╬═════════╬═════════════╬══════════════════════════════════════════╬═══════╬═══════════════════════════════════════════════════╣\n");
+
+        // One listing buffer for every row; uint64_t keeps the directory entries aligned
+        uint64_t scratch[THREAD_SCRATCH_SIZE / sizeof(uint64_t)];
+        long ticks = sysconf(_SC_CLK_TCK);
+        for (int i = 0; i < snap.count; i++) {
+            const ProcessSample *s = &snap.samples[i];
+            unsigned long long centis = (s->utime + s->stime) * 100 / ticks;
+            char time_str[32];             // Room for a 20-digit minute count
+            snprintf(time_str, sizeof(time_str), "%llu:%02llu.%02llu",
+                     centis / 6000, centis / 100 % 60, centis % 100);
+
+            int thread_count = 0;
+            char thread_summary[256] = {0};
+            if (snapshot_replaying()) {
+                // Recordings keep the thread count but not the threads themselves
+                thread_count = s->threads;
+                snprintf(thread_summary, sizeof(thread_summary), "(recorded)");
+            } else {
+                get_thread_summary_for_table(s->pid, (char *)scratch, sizeof(scratch), &thread_count,
+                                             thread_summary, sizeof(thread_summary));
+            }
+
+            printf("║ %-17.17s ║ %-10d ║ %7.1f ║ %7.1f ║ %11lu ║ %11lu ║ %-7c ║ %-11s ║ %-40.40s ║ %5d ║ %-47.47s ║\n",
+                   s->username, s->pid, s->cpu_percent, s->mem_percent, s->vsize_kb, s->rss_kb,
+                   s->state, time_str, s->command, thread_count, thread_summary);
+        }
+
+        printf("╚═══════════════════╩════════════╩═════════╩═════════╩═════════════╩═════════════╩═════════╩═════════════╩══════════════════════════════════════════╩═══════╩═══════════════════════════════════════════════════╝\n");
+        snapshot_free(&snap);
+        return;
+    }
+
     FILE *fp = popen("ps -axo user,pid,%cpu,%mem,vsz,rss,state,time,comm", "r");
     if (!fp) {
         perror("Failed to run ps command");
@@ -1027,6 +1139,7 @@ void list_all_processes_with_threads(void) {
     printf("╠═══════════════════╬════════════╬═════════╬═════════╬═════════════╬═════════════╬═════════╬═════════════╬══════════════════════════════════════════╬═══════╬═══════════════════════════════════════════════════╣\n");
 
     char line[1024];
+    uint64_t scratch[THREAD_SCRATCH_SIZE / sizeof(uint64_t)];
     // Skip the header line from ps output
     fgets(line, sizeof(line), fp);
 
@@ -1043,7 +1156,8 @@ void list_all_processes_with_threads(void) {
             // Get thread information
             int thread_count = 0;
             char thread_summary[256] = {0};
-            get_thread_summary_for_table(pid, &thread_count, thread_summary, sizeof(thread_summary));
+            get_thread_summary_for_table(pid, (char *)scratch, sizeof(scratch), &thread_count,
+                                         thread_summary, sizeof(thread_summary));
 
             // Print process information with thread details
             printf("║ %-17s ║ %-10d ║ %7.1f ║ %7.1f ║ %11lu ║ %11lu ║ %-7s ║ %-11s ║ %-40.40s ║ %5d ║ %-47.47s ║\n",
@@ -2,6 +2,7 @@
 #define PROCESS_MANAGER_H
 
 #include <sys/types.h>
+#include "proc_snapshot.h"
 
 typedef struct {
     char code;
@@ -60,6 +61,35 @@ int change_process_priority(pid_t pid, int priority);
 
 void show_process_states_info(void);
 
+/**
+ * Waits for the next refresh of a live view
+ * @param interval_ms Refresh interval in milliseconds
+ * @return 1 if the user pressed Enter to leave the view, 0 on timeout
+ */
+int wait_for_refresh(int interval_ms);
+
+/**
+ * Returns the height of the terminal, 24 when stdout is not a terminal
+ */
+int terminal_rows(void);
+
+/**
+ * Prints the self-instrumentation status line for the last frame,
+ * including how many allocations it made
+ */
+void overhead_print_status(void);
+
+/**
+ * Prints the column header used by snapshot_print_row
+ */
+void snapshot_print_header(void);
+
+/**
+ * Prints one process as a table row; extrapolated values are marked with '~'
+ * @param sample The process
+ */
+void snapshot_print_row(const ProcessSample *sample);
+
 /**
  * Displays a process tree showing parent-child relationships
  * @param root_pid The PID to use as the root of the tree (0 for all processes)
@@ -67,11 +97,15 @@ void show_process_states_info(void);
 void display_process_tree(pid_t root_pid);
 
 /**
- * Shows processes sorted by resource usage (CPU or memory)
- * @param sort_by 1 for CPU, 2 for memory
+ * Shows processes sorted by resource usage (CPU, memory or kernel delays).
+ * With /proc available CPU and memory are a live view refreshed every second.
+ * @param sort_by 1 for CPU, 2 for memory, 3-6 for CPU run-queue, block I/O,
+ *                swap-in or memory reclaim delay
  * @param count Number of processes to show (top N)
+ * @param filter Filter expression for the live view (see filter_compile), or NULL;
+ *               a bare word matches command names
  */
-void show_top_resource_usage(int sort_by, int count);
+void show_top_resource_usage(int sort_by, int count, const char *filter);
 
 /**
  * Gets process info for a specific PID
@@ -103,35 +137,37 @@ void explain_process_state(char state);
  */
 void free_process_info(ProcessInfo *info);
 
-// Task Scheduler yapıları
-typedef enum {
-    ONCE,           // Bir kere çalıştır
-    INTERVAL,       // Belirli aralıklarla çalıştır
-    DAILY          // Her gün belirli saatte çalıştır
-} schedule_type_t;
-
-typedef struct {
-    char command[256];           // Çalıştırılacak komut
-    schedule_type_t type;        // Zamanlama tipi
-    time_t execution_time;       // Çalıştırma zamanı
-    int interval_seconds;        // INTERVAL tipi için aralık
-    int is_active;              // Task aktif mi?
-    pid_t last_pid;             // Son çalıştırılan process'in PID'i
-    int is_demo_task;           // Demo görevi mi?
-} scheduled_task_t;
-
-// Task Scheduler fonksiyonları
-void init_task_scheduler(void);
-void add_scheduled_task(const char* command, schedule_type_t type, time_t execution_time, int interval_seconds);
+// Task Scheduler screens; they reach the scheduler in libtaskmgr through tm_sched_*
 void add_demo_task(const char* name);
 void list_scheduled_tasks(void);
-void remove_scheduled_task(int task_index);
-void run_task_scheduler(void);
-void stop_task_scheduler(void);
 void filter_tasks_by_name(const char* name);
 
 void list_threads_of_process(pid_t pid);
 
-void get_thread_summary_for_table(pid_t pid, int *thread_count, char *summary, size_t summary_size);
+#define THREAD_SCRATCH_SIZE 8192   // Directory listing buffer for get_thread_summary_for_table
+
+/**
+ * Counts the threads of a process and summarises them as "tid:STATE, ..."
+ * @param pid The process ID
+ * @param scratch THREAD_SCRATCH_SIZE bytes for reading the task directory,
+ *                8-byte aligned, e.g. a uint64_t array on the stack; only Linux uses it
+ * @param scratch_size Size of scratch
+ * @param thread_count Receives the number of threads
+ * @param summary Receives the summary
+ * @param summary_size Size of summary
+ */
+void get_thread_summary_for_table(pid_t pid, char *scratch, size_t scratch_size,
+                                  int *thread_count, char *summary, size_t summary_size);
+
+/**
+ * Samples the call stacks of a process with perf_event_open and writes them
+ * in folded-stack format ("comm;root;...;leaf count"), ready for flame graphs.
+ * Threads started after profiling begins are not sampled.
+ * @param pid The process ID
+ * @param seconds How long to sample
+ * @param output_path File receiving the folded stacks
+ * @return 1 if a profile was written, 0 otherwise
+ */
+int profile_process(pid_t pid, int seconds, const char *output_path);
 
 #endif 
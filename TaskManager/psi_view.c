@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <time.h>
+#include <poll.h>
+#include "psi_view.h"
+#include "proc_snapshot.h"
+#include "cgroup.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define PSI_RESOURCES 3
+#define PSI_HISTORY 60              // Samples kept per series, one per refresh
+#define PSI_REFRESH_MS 1000
+#define PSI_MAX_CGROUPS 10
+#define PSI_OFFENDERS 10
+#define PSI_TRIGGER_WINDOW_US 1000000
+#define PSI_PATH_MAX sizeof(((SampleScope *)0)->cgroup_path)  // A scoped cgroup path must fit whole
+
+static const char *resource_names[PSI_RESOURCES] = {"cpu", "memory", "io"};
+
+// One "some" or "full" line of a pressure file
+typedef struct {
+    float avg10, avg60, avg300;
+    unsigned long long total;       // Microseconds stalled since boot
+    float now;                      // Percent stalled over the last refresh
+    float history[PSI_HISTORY];
+} psi_series_t;
+
+typedef struct {
+    psi_series_t some;
+    psi_series_t full;
+    int trigger_fd;
+} psi_resource_t;
+
+typedef struct {
+    char path[PSI_PATH_MAX];
+    float some[PSI_RESOURCES];
+    float full[PSI_RESOURCES];
+} psi_cgroup_t;
+
+// What the top offenders looked like when a trigger fired
+typedef struct {
+    int fired;
+    int resource;
+    time_t when;
+    float stall;
+    int count;
+    ProcessSample rows[PSI_OFFENDERS];
+} psi_event_t;
+
+int psi_available(void) {
+    return access("/proc/pressure/memory", R_OK) == 0;
+}
+
+static void parse_series(const char *line, psi_series_t *series) {
+    sscanf(line, "%*s avg10=%f avg60=%f avg300=%f total=%llu",
+           &series->avg10, &series->avg60, &series->avg300, &series->total);
+}
+
+static int read_pressure_file(const char *path, psi_series_t *some, psi_series_t *full) {
+    char buf[512];
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return -1;
+    buf[len] = '\0';
+
+    char *full_line = strstr(buf, "full ");
+    if (strncmp(buf, "some ", 5) == 0) parse_series(buf, some);
+    if (full_line && full) parse_series(full_line, full);
+    return 0;
+}
+
+static void update_series(psi_series_t *series, unsigned long long previous_total, double elapsed, int first) {
+    series->now = first || elapsed <= 0 ? series->avg10
+                                        : (float)((series->total - previous_total) / (elapsed * 1e4));
+    if (series->now > 100) series->now = 100;
+    memmove(series->history, series->history + 1, (PSI_HISTORY - 1) * sizeof(float));
+    series->history[PSI_HISTORY - 1] = series->now;
+}
+
+static void sample_system(psi_resource_t *resources, double elapsed, int first) {
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/pressure/%s", resource_names[r]);
+        unsigned long long some_before = resources[r].some.total, full_before = resources[r].full.total;
+        if (read_pressure_file(path, &resources[r].some, &resources[r].full) < 0) continue;
+        update_series(&resources[r].some, some_before, elapsed, first);
+        update_series(&resources[r].full, full_before, elapsed, first);
+    }
+}
+
+// Top-level cgroups plus the scoped cgroup, ranked by memory pressure
+static int sample_cgroups(psi_cgroup_t *cgroups) {
+    if (!cgroup_v2_available()) return 0;
+
+    char paths[64][PSI_PATH_MAX];
+    int path_count = 0;
+    const SampleScope *scope = snapshot_get_scope();
+    if (scope->type == SCOPE_CGROUP) {
+        snprintf(paths[path_count++], sizeof(paths[0]), "%s", scope->cgroup_path);
+    }
+
+    DIR *dir = opendir(cgroup_root());
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL && path_count < 64) {
+            if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+            snprintf(paths[path_count++], sizeof(paths[0]), "%s", entry->d_name);
+        }
+        closedir(dir);
+    }
+
+    int count = 0;
+    for (int i = 0; i < path_count; i++) {
+        psi_cgroup_t cg;
+        memset(&cg, 0, sizeof(cg));
+        snprintf(cg.path, sizeof(cg.path), "%.*s", (int)sizeof(cg.path) - 1, paths[i]);
+
+        int readable = 0;
+        for (int r = 0; r < PSI_RESOURCES; r++) {
+            char path[PATH_MAX];
+            psi_series_t some = {0}, full = {0};
+            snprintf(path, sizeof(path), "%s/%.*s/%s.pressure", cgroup_root(), (int)sizeof(paths[i]) - 1, paths[i],
+                     resource_names[r]);
+            if (read_pressure_file(path, &some, &full) == 0) readable = 1;
+            cg.some[r] = some.avg10;
+            cg.full[r] = full.avg10;
+        }
+        if (!readable) continue;
+
+        // Insertion into a short list ordered by memory some
+        int pos = count < PSI_MAX_CGROUPS ? count : PSI_MAX_CGROUPS;
+        while (pos > 0 && cgroups[pos - 1].some[1] < cg.some[1]) {
+            if (pos < PSI_MAX_CGROUPS) cgroups[pos] = cgroups[pos - 1];
+            pos--;
+        }
+        if (pos < PSI_MAX_CGROUPS) {
+            cgroups[pos] = cg;
+            if (count < PSI_MAX_CGROUPS) count++;
+        }
+    }
+    return count;
+}
+
+// Writes "some <stall us> <window us>" so the kernel wakes us with POLLPRI
+static int register_trigger(const char *resource, float percent, char *error, size_t error_size) {
+    char path[64], trigger[64];
+    snprintf(path, sizeof(path), "/proc/pressure/%s", resource);
+    int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        snprintf(error, error_size, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    int len = snprintf(trigger, sizeof(trigger), "some %d %d",
+                       (int)(percent / 100 * PSI_TRIGGER_WINDOW_US), PSI_TRIGGER_WINDOW_US);
+    if (write(fd, trigger, len + 1) < 0) {
+        snprintf(error, error_size, "trigger on %s: %s", resource, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static const ProcessSnapshot *rank_previous;
+static int rank_resource;
+
+static double offender_score(const ProcessSample *s) {
+    if (rank_resource == 0) return s->cpu_percent;
+
+    // Memory and I/O stalls show up as major faults; blocked tasks add to I/O stalls
+    const ProcessSample *old = rank_previous ? snapshot_find(rank_previous, s->pid) : NULL;
+    double majflt = old && old->starttime == s->starttime ? (double)(s->majflt - old->majflt) : 0;
+    if (rank_resource == 1) return majflt * 1e6 + s->rss_kb;
+    return (s->state == 'D' ? 1e12 : 0) + majflt * 1e6 + s->cpu_percent;
+}
+
+static int compare_offenders(const void *a, const void *b) {
+    double sa = offender_score(a), sb = offender_score(b);
+    return (sa < sb) - (sa > sb);
+}
+
+static void capture_offenders(psi_event_t *event, int resource, float stall,
+                              ProcessSnapshot *snap, const ProcessSnapshot *previous) {
+    event->fired = 1;
+    event->resource = resource;
+    event->when = time(NULL);
+    event->stall = stall;
+
+    rank_previous = previous;
+    rank_resource = resource;
+    // Rank a copy: the snapshot must stay sorted by PID for the next refresh
+    ProcessSample *ranked = malloc(snap->count * sizeof(ProcessSample));
+    if (!ranked) {
+        event->count = 0;
+        return;
+    }
+    memcpy(ranked, snap->samples, snap->count * sizeof(ProcessSample));
+    qsort(ranked, snap->count, sizeof(ProcessSample), compare_offenders);
+    event->count = snap->count < PSI_OFFENDERS ? snap->count : PSI_OFFENDERS;
+    memcpy(event->rows, ranked, event->count * sizeof(ProcessSample));
+    free(ranked);
+}
+
+static void render_sparkline(const float *history) {
+    static const char ramp[] = " .:-=+*#%@";
+    float max = 10; // Scale to at least 10% so quiet noise stays flat
+    for (int i = 0; i < PSI_HISTORY; i++) {
+        if (history[i] > max) max = history[i];
+    }
+    putchar('[');
+    for (int i = 0; i < PSI_HISTORY; i++) {
+        int level = (int)(history[i] * 9 / max + 0.5f);
+        putchar(ramp[level > 9 ? 9 : level]);
+    }
+    printf("] max %.0f%%", max);
+}
+
+static void render_dashboard(const psi_resource_t *resources, const psi_cgroup_t *cgroups, int cgroup_count,
+                             float threshold, const char *trigger_error, const psi_event_t *event) {
+    printf("\033[2J\033[H");
+    printf("===== Pressure Stall Information =====\n");
+    printf("%-8s %-4s %6s %6s %6s %6s  HISTORY (%d s)\n", "RESOURCE", "KIND", "NOW%", "AVG10", "AVG60", "AVG300", PSI_HISTORY);
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        for (int kind = 0; kind < 2; kind++) {
+            const psi_series_t *s = kind ? &resources[r].full : &resources[r].some;
+            // The system-wide cpu "full" line is always zero before 5.13
+            printf("%-8s %-4s %6.2f %6.2f %6.2f %6.2f  ", kind ? "" : resource_names[r],
+                   kind ? "full" : "some", s->now, s->avg10, s->avg60, s->avg300);
+            render_sparkline(s->history);
+            printf("\n");
+        }
+    }
+
+    if (cgroup_count > 0) {
+        printf("\n%-32s %13s %13s %13s\n", "CGROUP (avg10 some/full)", "CPU", "MEMORY", "IO");
+        for (int i = 0; i < cgroup_count; i++) {
+            char cells[PSI_RESOURCES][16];
+            for (int r = 0; r < PSI_RESOURCES; r++) {
+                snprintf(cells[r], sizeof(cells[r]), "%.1f/%.1f", cgroups[i].some[r], cgroups[i].full[r]);
+            }
+            printf("%-32.32s %13s %13s %13s\n", cgroups[i].path, cells[0], cells[1], cells[2]);
+        }
+    }
+
+    printf("\n");
+    if (trigger_error[0]) {
+        printf("Triggers unavailable (%s), falling back to polling\n", trigger_error);
+    } else {
+        printf("Triggers: some >= %.0f%% stalled within %d s on cpu, memory and io\n",
+               threshold, PSI_TRIGGER_WINDOW_US / 1000000);
+    }
+
+    if (event->fired) {
+        char when[16];
+        strftime(when, sizeof(when), "%H:%M:%S", localtime(&event->when));
+        printf("\nLast trigger: %s pressure at %s (some %.1f%%), top offenders:\n",
+               resource_names[event->resource], when, event->stall);
+        snapshot_print_header();
+        for (int i = 0; i < event->count; i++) {
+            snapshot_print_row(&event->rows[i]);
+        }
+    }
+}
+
+// Waits for the refresh interval, a PSI trigger or Enter; returns 1 to leave the view
+static int wait_for_pressure(psi_resource_t *resources, int interval_ms, int *fired) {
+    struct pollfd fds[PSI_RESOURCES + 1];
+    int owners[PSI_RESOURCES + 1];
+    int nfds = 0;
+
+    fds[nfds].fd = STDIN_FILENO;
+    fds[nfds].events = POLLIN;
+    owners[nfds++] = -1;
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        if (resources[r].trigger_fd < 0) continue;
+        fds[nfds].fd = resources[r].trigger_fd;
+        fds[nfds].events = POLLPRI;
+        owners[nfds++] = r;
+    }
+
+    *fired = -1;
+    if (poll(fds, nfds, interval_ms) <= 0) return 0;
+
+    for (int i = 1; i < nfds; i++) {
+        if (fds[i].revents & POLLERR) {
+            // The pressure file went away; stop polling it
+            close(resources[owners[i]].trigger_fd);
+            resources[owners[i]].trigger_fd = -1;
+        } else if (fds[i].revents & POLLPRI) {
+            *fired = owners[i];
+        }
+    }
+    if (fds[0].revents & POLLIN) {
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF);
+        return 1;
+    }
+    return 0;
+}
+
+void show_pressure_dashboard(void) {
+    if (!psi_available()) {
+        printf("Pressure Stall Information is unavailable (needs Linux 4.20+ with CONFIG_PSI, psi=1)\n");
+        return;
+    }
+
+    char input[32];
+    float threshold = 10;
+    printf("Trigger when some stall exceeds %% over 1 s (default 10, 0 to disable): ");
+    if (fgets(input, sizeof(input), stdin) != NULL && input[0] != '\n') {
+        threshold = atof(input);
+    }
+
+    psi_resource_t resources[PSI_RESOURCES];
+    memset(resources, 0, sizeof(resources));
+    char trigger_error[128] = "";
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        resources[r].trigger_fd = -1;
+        if (threshold > 0 && !trigger_error[0]) {
+            resources[r].trigger_fd = register_trigger(resource_names[r], threshold,
+                                                       trigger_error, sizeof(trigger_error));
+        }
+    }
+    if (threshold <= 0) snprintf(trigger_error, sizeof(trigger_error), "disabled");
+
+    // A rolling process snapshot gives the offender ranking its rates when a trigger fires
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    int cur = 0;
+    snapshot_take(&snaps[cur], NULL);
+
+    psi_cgroup_t cgroups[PSI_MAX_CGROUPS];
+    psi_event_t event;
+    memset(&event, 0, sizeof(event));
+
+    overhead_begin(PSI_REFRESH_MS);
+    double last = overhead_clock();
+    int first = 1;
+    int fired = -1;
+    int interval = PSI_REFRESH_MS;
+    do {
+        double now = overhead_clock();
+        double start = now;
+        sample_system(resources, now - last, first);
+        int cgroup_count = sample_cgroups(cgroups);
+        overhead_record(PHASE_READ, start);
+
+        cur ^= 1;
+        snapshot_take(&snaps[cur], &snaps[cur ^ 1]);
+        // Without kernel triggers, the measured stall crossing the threshold stands in for one
+        for (int r = 0; r < PSI_RESOURCES && fired < 0 && !first && threshold > 0; r++) {
+            if (resources[r].trigger_fd < 0 && resources[r].some.now >= threshold) fired = r;
+        }
+        if (fired >= 0) {
+            capture_offenders(&event, fired, resources[fired].some.now, &snaps[cur], &snaps[cur ^ 1]);
+        }
+        last = now;
+        first = 0;
+
+        start = overhead_clock();
+        render_dashboard(resources, cgroups, cgroup_count, threshold, trigger_error, &event);
+        overhead_record(PHASE_RENDER, start);
+        interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to return\n");
+        fflush(stdout);
+    } while (!wait_for_pressure(resources, interval, &fired));
+
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        if (resources[r].trigger_fd >= 0) close(resources[r].trigger_fd);
+    }
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
@@ -0,0 +1,17 @@
+#ifndef PSI_VIEW_H
+#define PSI_VIEW_H
+
+/**
+ * Checks whether Pressure Stall Information is exposed in /proc/pressure
+ * @return 1 if available, 0 otherwise
+ */
+int psi_available(void);
+
+/**
+ * Live dashboard of system and per-cgroup pressure with a short history.
+ * Registers PSI triggers on the system pressure files; when one fires the
+ * top offenders are captured with the process listing columns.
+ */
+void show_pressure_dashboard(void);
+
+#endif
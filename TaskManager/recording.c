@@ -0,0 +1,1016 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include "recording.h"
+#include "overhead.h"
+
+/*
+ * File layout (host byte order, recordings are replayed where they were made):
+ *
+ *   file_header_t
+ *   frame_header_t + payload, repeated
+ *
+ * A payload holds, in order:
+ *   - strings first used by this frame: count, then length + bytes + NUL each.
+ *     IDs are global and assigned in file order, so the reader builds the
+ *     whole dictionary while indexing and points straight into the mapping.
+ *   - the PID set: a keyframe lists every PID, a delta frame lists the PIDs
+ *     that exited and the PIDs that appeared since the previous frame.
+ *     PID lists are ascending and stored as varint gaps.
+ *   - REC_COLUMNS columns over the frame's rows in PID order. Each value is
+ *     the difference to the same PID in the previous frame (to 0 for new PIDs
+ *     and in keyframes), zigzag varint coded, with runs of zero differences
+ *     collapsed into a single count. A quiet process costs nothing.
+ *
+ * Frames are grouped into blocks that start at a keyframe. After the last
+ * frame of a block comes a summary record with the block's time span and
+ * the minimum and maximum of every column, so queries can skip blocks
+ * without decoding them. Blocks without a summary (the one still being
+ * written) are always decoded.
+ */
+
+#define RECORDING_MAGIC "TMREC\0\0\1"
+#define RECORDING_VERSION 1
+#define FRAME_MAGIC 0x52464d54u             // "TMFR"
+#define FRAME_KEY 1
+#define FRAME_DELTA 2
+#define FRAME_SUMMARY 3
+#define MAX_STRING_LENGTH 255
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t keyframe_interval;
+    int64_t created;                        // Epoch seconds
+    int64_t clock_ticks;                    // sysconf(_SC_CLK_TCK) of the recording host
+} file_header_t;
+
+typedef struct {
+    uint32_t magic;
+    uint8_t type;                           // FRAME_KEY, FRAME_DELTA or FRAME_SUMMARY; others are skipped
+    uint8_t reserved[3];
+    uint32_t payload_length;
+    uint32_t rows;
+    double timestamp;                       // CLOCK_MONOTONIC seconds on the recording host
+    double wall;                            // Epoch seconds
+    double uptime;
+    uint64_t mem_total_kb;
+} frame_header_t;
+
+// Payload of a FRAME_SUMMARY record: time span and zone map of the block before it
+typedef struct {
+    uint32_t frames;
+    uint32_t reserved;
+    double first_wall;
+    double last_wall;
+    uint64_t min_mem_total_kb;
+    uint64_t max_mem_total_kb;
+    int64_t min_pid;
+    int64_t max_pid;
+    int64_t min[REC_COLUMNS];
+    int64_t max[REC_COLUMNS];
+} block_summary_t;
+
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} byte_buffer_t;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t id;
+    char *text;                             // NULL marks an empty slot
+} dict_entry_t;
+
+struct recorder {
+    FILE *fp;
+    int keyframe_interval;
+    unsigned long frames;
+    unsigned long long bytes;
+    // Rows of the previous and current frame, REC_COLUMNS values per row
+    pid_t *prev_pids, *cur_pids;
+    int64_t *prev_values, *cur_values;
+    int *prev_index;                        // Row of each current PID in the previous frame, -1 if new
+    unsigned char *kept;                    // Previous rows still present
+    int prev_count;
+    int capacity;
+    byte_buffer_t strings, body;
+    uint32_t new_strings;
+    dict_entry_t *dict;
+    uint32_t dict_size;                     // Slots, a power of two
+    uint32_t dict_count;
+    block_summary_t block;                  // Block being written
+};
+
+typedef struct {
+    size_t offset;
+    double wall;
+    uint32_t rows;
+    int block;
+} frame_ref_t;
+
+typedef struct {
+    int first_frame;                        // The keyframe
+    int frame_count;
+    int has_zone;                           // A summary record was found
+    filter_zone_t zone;
+} block_ref_t;
+
+struct replay {
+    int fd;
+    const unsigned char *base;
+    size_t size;
+    char path[256];
+    long clock_ticks;
+    frame_ref_t *frames;
+    int frame_count;
+    block_ref_t *blocks;                    // The sparse time index
+    int block_count;
+    const char **strings;
+    uint16_t *string_lengths;
+    uint32_t string_count;
+    uint32_t string_capacity;
+    // Decoded state of frame `decoded`, plus the buffers the next frame is decoded into
+    pid_t *pids, *next_pids;
+    int64_t *values, *next_values;
+    int rows;
+    int capacity;
+    int decoded;
+};
+
+static double wall_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int buffer_reserve(byte_buffer_t *buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) return 1;
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->length + extra) capacity *= 2;
+    unsigned char *grown = realloc(buffer->data, capacity);
+    if (!grown) return 0;
+    buffer->data = grown;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+static int put_varint(byte_buffer_t *buffer, uint64_t value) {
+    if (!buffer_reserve(buffer, 10)) return 0;
+    while (value >= 0x80) {
+        buffer->data[buffer->length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    buffer->data[buffer->length++] = (unsigned char)value;
+    return 1;
+}
+
+// Small differences of either sign become small unsigned numbers
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static int get_varint(const unsigned char **p, const unsigned char *end, uint64_t *out) {
+    uint64_t value = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        unsigned char byte = *(*p)++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *out = value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint32_t hash_string(const char *text) {
+    uint32_t hash = 2166136261u;
+    while (*text) {
+        hash ^= (unsigned char)*text++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int dict_grow(recorder_t *rec) {
+    uint32_t size = rec->dict_size ? rec->dict_size * 2 : 1024;
+    dict_entry_t *table = calloc(size, sizeof(dict_entry_t));
+    if (!table) return 0;
+    for (uint32_t i = 0; i < rec->dict_size; i++) {
+        if (!rec->dict[i].text) continue;
+        uint32_t slot = rec->dict[i].hash & (size - 1);
+        while (table[slot].text) slot = (slot + 1) & (size - 1);
+        table[slot] = rec->dict[i];
+    }
+    free(rec->dict);
+    rec->dict = table;
+    rec->dict_size = size;
+    return 1;
+}
+
+// ID of a command or user name; strings seen for the first time go out with the current frame
+static int64_t dict_id(recorder_t *rec, const char *text) {
+    if ((rec->dict_count + 1) * 4 > rec->dict_size * 3 && !dict_grow(rec)) return -1;
+
+    uint32_t hash = hash_string(text);
+    uint32_t slot = hash & (rec->dict_size - 1);
+    while (rec->dict[slot].text) {
+        if (rec->dict[slot].hash == hash && strcmp(rec->dict[slot].text, text) == 0) {
+            return rec->dict[slot].id;
+        }
+        slot = (slot + 1) & (rec->dict_size - 1);
+    }
+
+    size_t length = strnlen(text, MAX_STRING_LENGTH);
+    char *copy = malloc(length + 1);
+    if (!copy || !put_varint(&rec->strings, length) || !buffer_reserve(&rec->strings, length + 1)) {
+        free(copy);
+        return -1;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    memcpy(rec->strings.data + rec->strings.length, copy, length + 1);
+    rec->strings.length += length + 1;
+
+    rec->dict[slot].hash = hash;
+    rec->dict[slot].id = rec->dict_count++;
+    rec->dict[slot].text = copy;
+    rec->new_strings++;
+    return rec->dict[slot].id;
+}
+
+static int recorder_reserve(recorder_t *rec, int rows) {
+    if (rows <= rec->capacity) return 1;
+    int capacity = rec->capacity ? rec->capacity : 256;
+    while (capacity < rows) capacity *= 2;
+
+    pid_t *prev_pids = realloc(rec->prev_pids, capacity * sizeof(pid_t));
+    if (prev_pids) rec->prev_pids = prev_pids;
+    pid_t *cur_pids = realloc(rec->cur_pids, capacity * sizeof(pid_t));
+    if (cur_pids) rec->cur_pids = cur_pids;
+    int64_t *prev_values = realloc(rec->prev_values, capacity * REC_COLUMNS * sizeof(int64_t));
+    if (prev_values) rec->prev_values = prev_values;
+    int64_t *cur_values = realloc(rec->cur_values, capacity * REC_COLUMNS * sizeof(int64_t));
+    if (cur_values) rec->cur_values = cur_values;
+    int *prev_index = realloc(rec->prev_index, capacity * sizeof(int));
+    if (prev_index) rec->prev_index = prev_index;
+    unsigned char *kept = realloc(rec->kept, capacity);
+    if (kept) rec->kept = kept;
+    if (!prev_pids || !cur_pids || !prev_values || !cur_values || !prev_index || !kept) return 0;
+
+    rec->capacity = capacity;
+    return 1;
+}
+
+recorder_t *recorder_open(const char *path, int keyframe_interval) {
+    recorder_t *rec = calloc(1, sizeof(recorder_t));
+    if (!rec) return NULL;
+    rec->fp = fopen(path, "wb");
+    if (!rec->fp) {
+        free(rec);
+        return NULL;
+    }
+    rec->keyframe_interval = keyframe_interval > 0 ? keyframe_interval : RECORDING_KEYFRAME_INTERVAL;
+
+    file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.keyframe_interval = rec->keyframe_interval;
+    header.created = time(NULL);
+    header.clock_ticks = sysconf(_SC_CLK_TCK);
+    if (fwrite(&header, sizeof(header), 1, rec->fp) != 1) {
+        recorder_close(rec);
+        return NULL;
+    }
+    rec->bytes = sizeof(header);
+    return rec;
+}
+
+static int sample_columns(recorder_t *rec, const ProcessSample *s, int64_t *values) {
+    values[REC_PPID] = s->ppid;
+    values[REC_UID] = s->uid;
+    values[REC_STATE] = (unsigned char)s->state;
+    values[REC_COMMAND] = dict_id(rec, s->command);
+    values[REC_USERNAME] = dict_id(rec, s->username);
+    values[REC_UTIME] = s->utime;
+    values[REC_STIME] = s->stime;
+    values[REC_STARTTIME] = s->starttime;
+    values[REC_MINFLT] = s->minflt;
+    values[REC_MAJFLT] = s->majflt;
+    values[REC_VSIZE] = s->vsize_kb;
+    values[REC_RSS] = s->rss_kb;
+    values[REC_THREADS] = s->threads;
+    values[REC_CPU] = (int64_t)(s->cpu_percent * 10 + 0.5f);
+    return values[REC_COMMAND] >= 0 && values[REC_USERNAME] >= 0;
+}
+
+// Writes the PID set of a frame: every PID for keyframes, otherwise what left and what arrived
+static int encode_pids(recorder_t *rec, int count, int keyframe) {
+    byte_buffer_t *body = &rec->body;
+    if (keyframe) {
+        pid_t last = 0;
+        if (!put_varint(body, count)) return 0;
+        for (int i = 0; i < count; i++) {
+            if (!put_varint(body, rec->cur_pids[i] - last)) return 0;
+            last = rec->cur_pids[i];
+            rec->prev_index[i] = -1;
+        }
+        return 1;
+    }
+
+    int a = 0, added = 0, removed = 0;
+    memset(rec->kept, 0, rec->prev_count);
+    for (int i = 0; i < count; i++) {
+        while (a < rec->prev_count && rec->prev_pids[a] < rec->cur_pids[i]) a++;
+        if (a < rec->prev_count && rec->prev_pids[a] == rec->cur_pids[i]) {
+            rec->kept[a] = 1;
+            rec->prev_index[i] = a++;
+        } else {
+            rec->prev_index[i] = -1;
+            added++;
+        }
+    }
+    removed = rec->prev_count - (count - added);
+
+    pid_t last = 0;
+    if (!put_varint(body, removed)) return 0;
+    for (int i = 0; i < rec->prev_count; i++) {
+        if (rec->kept[i]) continue;
+        if (!put_varint(body, rec->prev_pids[i] - last)) return 0;
+        last = rec->prev_pids[i];
+    }
+    last = 0;
+    if (!put_varint(body, added)) return 0;
+    for (int i = 0; i < count; i++) {
+        if (rec->prev_index[i] >= 0) continue;
+        if (!put_varint(body, rec->cur_pids[i] - last)) return 0;
+        last = rec->cur_pids[i];
+    }
+    return 1;
+}
+
+// Closes the block being written with its time span and column bounds
+static int write_summary(recorder_t *rec) {
+    frame_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FRAME_MAGIC;
+    header.type = FRAME_SUMMARY;
+    header.payload_length = sizeof(block_summary_t);
+    header.wall = rec->block.last_wall;
+
+    int ok = fwrite(&header, sizeof(header), 1, rec->fp) == 1 &&
+             fwrite(&rec->block, sizeof(block_summary_t), 1, rec->fp) == 1;
+    rec->bytes += sizeof(header) + sizeof(block_summary_t);
+    rec->block.frames = 0;
+    return ok;
+}
+
+static void update_block(recorder_t *rec, int count, double wall, uint64_t mem_total_kb) {
+    block_summary_t *block = &rec->block;
+    if (block->frames == 0) {
+        memset(block, 0, sizeof(*block));
+        block->first_wall = wall;
+        block->min_mem_total_kb = block->max_mem_total_kb = mem_total_kb;
+        block->min_pid = INT64_MAX;
+        block->max_pid = INT64_MIN;
+        for (int c = 0; c < REC_COLUMNS; c++) {
+            block->min[c] = INT64_MAX;
+            block->max[c] = INT64_MIN;
+        }
+    }
+    block->frames++;
+    block->last_wall = wall;
+    if (mem_total_kb < block->min_mem_total_kb) block->min_mem_total_kb = mem_total_kb;
+    if (mem_total_kb > block->max_mem_total_kb) block->max_mem_total_kb = mem_total_kb;
+
+    for (int i = 0; i < count; i++) {
+        const int64_t *v = &rec->cur_values[i * REC_COLUMNS];
+        if (rec->cur_pids[i] < block->min_pid) block->min_pid = rec->cur_pids[i];
+        if (rec->cur_pids[i] > block->max_pid) block->max_pid = rec->cur_pids[i];
+        for (int c = 0; c < REC_COLUMNS; c++) {
+            if (v[c] < block->min[c]) block->min[c] = v[c];
+            if (v[c] > block->max[c]) block->max[c] = v[c];
+        }
+    }
+}
+
+long recorder_append(recorder_t *rec, const ProcessSnapshot *snap) {
+    int count = snap->count;
+    if (!recorder_reserve(rec, count)) return -1;
+    rec->strings.length = 0;
+    rec->body.length = 0;
+    rec->new_strings = 0;
+
+    for (int i = 0; i < count; i++) {
+        rec->cur_pids[i] = snap->samples[i].pid;
+        if (!sample_columns(rec, &snap->samples[i], &rec->cur_values[i * REC_COLUMNS])) return -1;
+    }
+
+    int keyframe = rec->frames % rec->keyframe_interval == 0;
+    if (keyframe && rec->block.frames > 0 && !write_summary(rec)) return -1;
+    if (!encode_pids(rec, count, keyframe)) return -1;
+
+    for (int c = 0; c < REC_COLUMNS; c++) {
+        uint64_t run = 0;
+        for (int i = 0; i < count; i++) {
+            int p = rec->prev_index[i];
+            int64_t base = p >= 0 ? rec->prev_values[p * REC_COLUMNS + c] : 0;
+            // Unsigned so that counters near the ends of their range wrap instead of overflowing
+            int64_t delta = (int64_t)((uint64_t)rec->cur_values[i * REC_COLUMNS + c] - (uint64_t)base);
+            if (delta == 0) {
+                run++;
+                continue;
+            }
+            if (!put_varint(&rec->body, run) || !put_varint(&rec->body, zigzag(delta))) return -1;
+            run = 0;
+        }
+        if (run > 0 && !put_varint(&rec->body, run)) return -1;
+    }
+
+    byte_buffer_t string_count = {0};
+    if (!put_varint(&string_count, rec->new_strings)) return -1;
+
+    frame_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FRAME_MAGIC;
+    header.type = keyframe ? FRAME_KEY : FRAME_DELTA;
+    header.payload_length = string_count.length + rec->strings.length + rec->body.length;
+    header.rows = count;
+    header.timestamp = snap->timestamp;
+    header.wall = wall_now();
+    header.uptime = snap->uptime;
+    header.mem_total_kb = snap->mem_total_kb;
+
+    // One flush per frame keeps the file replayable while it is still being written
+    int ok = fwrite(&header, sizeof(header), 1, rec->fp) == 1 &&
+             fwrite(string_count.data, string_count.length, 1, rec->fp) == 1 &&
+             (rec->strings.length == 0 || fwrite(rec->strings.data, rec->strings.length, 1, rec->fp) == 1) &&
+             (rec->body.length == 0 || fwrite(rec->body.data, rec->body.length, 1, rec->fp) == 1) &&
+             fflush(rec->fp) == 0;
+    free(string_count.data);
+    if (!ok) return -1;
+    update_block(rec, count, header.wall, header.mem_total_kb);
+
+    // The current frame becomes the base of the next one
+    pid_t *pids = rec->prev_pids;
+    rec->prev_pids = rec->cur_pids;
+    rec->cur_pids = pids;
+    int64_t *values = rec->prev_values;
+    rec->prev_values = rec->cur_values;
+    rec->cur_values = values;
+    rec->prev_count = count;
+    rec->frames++;
+
+    long written = sizeof(header) + header.payload_length;
+    rec->bytes += written;
+    return written;
+}
+
+unsigned long long recorder_bytes(const recorder_t *rec) {
+    return rec->bytes;
+}
+
+void recorder_close(recorder_t *rec) {
+    if (rec == NULL) return;
+    if (rec->fp) {
+        if (rec->block.frames > 0) write_summary(rec);
+        fclose(rec->fp);
+    }
+    for (uint32_t i = 0; i < rec->dict_size; i++) free(rec->dict[i].text);
+    free(rec->dict);
+    free(rec->strings.data);
+    free(rec->body.data);
+    free(rec->prev_pids);
+    free(rec->cur_pids);
+    free(rec->prev_values);
+    free(rec->cur_values);
+    free(rec->prev_index);
+    free(rec->kept);
+    free(rec);
+}
+
+// Collects the strings introduced by one frame; they are NUL-terminated inside the mapping
+static int index_strings(replay_t *replay, const unsigned char **p, const unsigned char *end) {
+    uint64_t count, length;
+    if (!get_varint(p, end, &count)) return 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!get_varint(p, end, &length) || length >= (uint64_t)(end - *p) || (*p)[length] != '\0') return 0;
+        if (replay->string_count == replay->string_capacity) {
+            uint32_t capacity = replay->string_capacity ? replay->string_capacity * 2 : 1024;
+            const char **grown = realloc(replay->strings, capacity * sizeof(char *));
+            if (grown) replay->strings = grown;
+            uint16_t *grown_lengths = realloc(replay->string_lengths, capacity * sizeof(uint16_t));
+            if (grown_lengths) replay->string_lengths = grown_lengths;
+            if (!grown || !grown_lengths) return 0;
+            replay->string_capacity = capacity;
+        }
+        replay->string_lengths[replay->string_count] = length;
+        replay->strings[replay->string_count++] = (const char *)*p;
+        *p += length + 1;
+    }
+    return 1;
+}
+
+// Converts stored column bounds into the filter's fields
+static void summary_zone(const block_summary_t *summary, filter_zone_t *zone) {
+    zone->min[FILTER_PID] = summary->min_pid;
+    zone->max[FILTER_PID] = summary->max_pid;
+    static const struct { filter_field_t field; recording_column_t column; } direct[] = {
+        {FILTER_PPID, REC_PPID}, {FILTER_UID, REC_UID}, {FILTER_RSS, REC_RSS}, {FILTER_VSIZE, REC_VSIZE},
+        {FILTER_THREADS, REC_THREADS}, {FILTER_MINFLT, REC_MINFLT}, {FILTER_MAJFLT, REC_MAJFLT}
+    };
+    for (size_t i = 0; i < sizeof(direct) / sizeof(direct[0]); i++) {
+        zone->min[direct[i].field] = summary->min[direct[i].column];
+        zone->max[direct[i].field] = summary->max[direct[i].column];
+    }
+
+    // Replayed percentages are floats, so leave a little slack around the exact bounds
+    zone->min[FILTER_CPU] = summary->min[REC_CPU] / 10.0 - 0.01;
+    zone->max[FILTER_CPU] = summary->max[REC_CPU] / 10.0 + 0.01;
+    zone->min[FILTER_MEM] = summary->max_mem_total_kb ?
+                            summary->min[REC_RSS] * 100.0 / summary->max_mem_total_kb - 0.01 : 0;
+    zone->max[FILTER_MEM] = summary->min_mem_total_kb ?
+                            summary->max[REC_RSS] * 100.0 / summary->min_mem_total_kb + 0.01 : 0;
+}
+
+static int index_frames(replay_t *replay) {
+    size_t offset = sizeof(file_header_t);
+    int capacity = 0, block_capacity = 0;
+    frame_header_t header;
+
+    while (offset + sizeof(header) <= replay->size) {
+        memcpy(&header, replay->base + offset, sizeof(header));
+        if (header.magic != FRAME_MAGIC) break;
+        if (header.payload_length > replay->size - offset - sizeof(header)) break;
+        const unsigned char *payload = replay->base + offset + sizeof(header);
+
+        if (header.type == FRAME_KEY || header.type == FRAME_DELTA) {
+            const unsigned char *p = payload;
+            if (!index_strings(replay, &p, p + header.payload_length)) break;
+            if (header.type == FRAME_KEY) {
+                if (replay->block_count == block_capacity) {
+                    block_capacity = block_capacity ? block_capacity * 2 : 64;
+                    block_ref_t *grown = realloc(replay->blocks, block_capacity * sizeof(block_ref_t));
+                    if (!grown) return 0;
+                    replay->blocks = grown;
+                }
+                block_ref_t *block = &replay->blocks[replay->block_count++];
+                memset(block, 0, sizeof(*block));
+                block->first_frame = replay->frame_count;
+            }
+            // Delta frames before the first keyframe have nothing to apply to
+            if (replay->block_count > 0) {
+                if (replay->frame_count == capacity) {
+                    capacity = capacity ? capacity * 2 : 1024;
+                    frame_ref_t *grown = realloc(replay->frames, capacity * sizeof(frame_ref_t));
+                    if (!grown) return 0;
+                    replay->frames = grown;
+                }
+                frame_ref_t *ref = &replay->frames[replay->frame_count++];
+                ref->offset = offset;
+                ref->wall = header.wall;
+                ref->rows = header.rows;
+                ref->block = replay->block_count - 1;
+                replay->blocks[ref->block].frame_count++;
+            }
+        } else if (header.type == FRAME_SUMMARY && header.payload_length == sizeof(block_summary_t) &&
+                   replay->block_count > 0) {
+            block_summary_t summary;
+            block_ref_t *block = &replay->blocks[replay->block_count - 1];
+            memcpy(&summary, payload, sizeof(summary));
+            if (summary.frames == (uint32_t)block->frame_count) {
+                summary_zone(&summary, &block->zone);
+                block->has_zone = 1;
+            }
+        }
+        offset += sizeof(header) + header.payload_length;
+    }
+    return 1;
+}
+
+replay_t *replay_open(const char *path) {
+    replay_t *replay = calloc(1, sizeof(replay_t));
+    if (!replay) return NULL;
+    replay->fd = -1;
+    replay->decoded = -1;
+    snprintf(replay->path, sizeof(replay->path), "%s", path);
+
+    struct stat st;
+    file_header_t header;
+    replay->fd = open(path, O_RDONLY);
+    if (replay->fd < 0 || fstat(replay->fd, &st) < 0 || (size_t)st.st_size < sizeof(header)) {
+        replay_close(replay);
+        return NULL;
+    }
+    replay->size = st.st_size;
+    void *base = mmap(NULL, replay->size, PROT_READ, MAP_SHARED, replay->fd, 0);
+    if (base == MAP_FAILED) {
+        replay_close(replay);
+        return NULL;
+    }
+    replay->base = base;
+
+    memcpy(&header, replay->base, sizeof(header));
+    replay->clock_ticks = header.clock_ticks > 0 ? header.clock_ticks : sysconf(_SC_CLK_TCK);
+    if (memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != RECORDING_VERSION || !index_frames(replay) || replay->frame_count == 0) {
+        replay_close(replay);
+        return NULL;
+    }
+    return replay;
+}
+
+int replay_frame_count(const replay_t *replay) {
+    return replay->frame_count;
+}
+
+double replay_frame_time(const replay_t *replay, int frame) {
+    return replay->frames[frame].wall;
+}
+
+int replay_find_time(const replay_t *replay, double when) {
+    int lo = 0, hi = replay->frame_count - 1, found = 0;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (replay->frames[mid].wall <= when) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return found;
+}
+
+void replay_info(const replay_t *replay, replay_info_t *info) {
+    info->path = replay->path;
+    info->bytes = replay->size;
+    info->clock_ticks = replay->clock_ticks;
+    info->blocks = replay->block_count;
+    info->zoned_blocks = 0;
+    for (int i = 0; i < replay->block_count; i++) {
+        if (replay->blocks[i].has_zone) info->zoned_blocks++;
+    }
+    info->strings = replay->string_count;
+    info->last_rows = replay->frame_count ? replay->frames[replay->frame_count - 1].rows : 0;
+}
+
+// Always allocates on first use, so an empty frame still has buffers to swap
+static int replay_reserve(replay_t *replay, int rows) {
+    if (rows <= replay->capacity && replay->capacity > 0) return 1;
+    int capacity = replay->capacity ? replay->capacity : 256;
+    while (capacity < rows) capacity *= 2;
+
+    pid_t *pids = realloc(replay->pids, capacity * sizeof(pid_t));
+    if (pids) replay->pids = pids;
+    pid_t *next_pids = realloc(replay->next_pids, capacity * sizeof(pid_t));
+    if (next_pids) replay->next_pids = next_pids;
+    int64_t *values = realloc(replay->values, capacity * REC_COLUMNS * sizeof(int64_t));
+    if (values) replay->values = values;
+    int64_t *next_values = realloc(replay->next_values, capacity * REC_COLUMNS * sizeof(int64_t));
+    if (next_values) replay->next_values = next_values;
+    if (!pids || !next_pids || !values || !next_values) return 0;
+
+    replay->capacity = capacity;
+    return 1;
+}
+
+static int skip_pid_list(const unsigned char **p, const unsigned char *end, uint64_t count) {
+    uint64_t gap;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!get_varint(p, end, &gap)) return 0;
+    }
+    return 1;
+}
+
+// Rebuilds the PID set of a delta frame by merging the decoded rows with what left and arrived.
+// Returns 2 when the set is unchanged, so the columns can be applied in place.
+static int merge_pid_set(replay_t *replay, const unsigned char **p, const unsigned char *end, int rows) {
+    uint64_t removed_left, added_left, gap;
+    if (!get_varint(p, end, &removed_left)) return 0;
+    const unsigned char *removed = *p;
+    if (!skip_pid_list(p, end, removed_left) || !get_varint(p, end, &added_left)) return 0;
+    const unsigned char *added = *p;
+    if (!skip_pid_list(p, end, added_left)) return 0;
+    if (removed_left == 0 && added_left == 0 && rows == replay->rows) return 2;
+
+    pid_t next_removed = 0, next_added = 0;
+    int have_removed = 0, have_added = 0;
+    if (removed_left && get_varint(&removed, end, &gap)) {
+        next_removed = gap;
+        have_removed = 1;
+        removed_left--;
+    }
+    if (added_left && get_varint(&added, end, &gap)) {
+        next_added = gap;
+        have_added = 1;
+        added_left--;
+    }
+
+    int o = 0, n = 0;
+    while (o < replay->rows || have_added) {
+        if (have_removed && (o >= replay->rows || next_removed <= replay->pids[o])) {
+            if (o < replay->rows && next_removed == replay->pids[o]) o++;
+            have_removed = removed_left && get_varint(&removed, end, &gap);
+            if (have_removed) {
+                next_removed += gap;
+                removed_left--;
+            }
+            continue;
+        }
+        if (n >= rows) return 0;
+
+        if (o < replay->rows && (!have_added || replay->pids[o] < next_added)) {
+            replay->next_pids[n] = replay->pids[o];
+            memcpy(&replay->next_values[n * REC_COLUMNS], &replay->values[o * REC_COLUMNS],
+                   REC_COLUMNS * sizeof(int64_t));
+            o++;
+        } else {
+            replay->next_pids[n] = next_added;
+            memset(&replay->next_values[n * REC_COLUMNS], 0, REC_COLUMNS * sizeof(int64_t));
+            have_added = added_left && get_varint(&added, end, &gap);
+            if (have_added) {
+                next_added += gap;
+                added_left--;
+            }
+        }
+        n++;
+    }
+    return n == rows;
+}
+
+static int apply_frame(replay_t *replay, int frame) {
+    frame_header_t header;
+    memcpy(&header, replay->base + replay->frames[frame].offset, sizeof(header));
+    const unsigned char *p = replay->base + replay->frames[frame].offset + sizeof(header);
+    const unsigned char *end = p + header.payload_length;
+    int rows = header.rows;
+    if (!replay_reserve(replay, rows)) return 0;
+
+    // The dictionary was collected while indexing
+    uint64_t count, value;
+    if (!get_varint(&p, end, &count)) return 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!get_varint(&p, end, &value) || value >= (uint64_t)(end - p)) return 0;
+        p += value + 1;
+    }
+
+    int in_place = 0;
+    if (header.type == FRAME_KEY) {
+        pid_t last = 0;
+        if (!get_varint(&p, end, &count) || count != (uint64_t)rows) return 0;
+        for (int i = 0; i < rows; i++) {
+            if (!get_varint(&p, end, &value)) return 0;
+            last += value;
+            replay->next_pids[i] = last;
+        }
+        memset(replay->next_values, 0, (size_t)rows * REC_COLUMNS * sizeof(int64_t));
+    } else {
+        int merged = merge_pid_set(replay, &p, end, rows);
+        if (!merged) return 0;
+        in_place = merged == 2;
+    }
+
+    int64_t *target = in_place ? replay->values : replay->next_values;
+    for (int c = 0; c < REC_COLUMNS; c++) {
+        int row = 0;
+        while (row < rows) {
+            if (!get_varint(&p, end, &value)) return 0;
+            if (value >= (uint64_t)(rows - row)) break;
+            row += value;
+            if (!get_varint(&p, end, &value)) return 0;
+            target[row * REC_COLUMNS + c] = (int64_t)((uint64_t)target[row * REC_COLUMNS + c] + (uint64_t)unzigzag(value));
+            row++;
+        }
+    }
+    if (in_place) return 1;
+
+    pid_t *pids = replay->pids;
+    replay->pids = replay->next_pids;
+    replay->next_pids = pids;
+    int64_t *values = replay->values;
+    replay->values = replay->next_values;
+    replay->next_values = values;
+    replay->rows = rows;
+    return 1;
+}
+
+static void copy_string(const replay_t *replay, int64_t id, char *out, size_t size) {
+    if (id < 0 || id >= replay->string_count) {
+        snprintf(out, size, "?");
+        return;
+    }
+    size_t length = replay->string_lengths[id] < size - 1 ? replay->string_lengths[id] : size - 1;
+    memcpy(out, replay->strings[id], length);
+    out[length] = '\0';
+}
+
+int replay_read(replay_t *replay, int frame, ProcessSnapshot *snap) {
+    if (frame < 0 || frame >= replay->frame_count) return -1;
+
+    // Play forward from what is decoded when that is on the way, otherwise restart at the keyframe
+    int key = replay->blocks[replay->frames[frame].block].first_frame;
+    int first = replay->decoded >= key && replay->decoded <= frame ? replay->decoded + 1 : key;
+    double start = overhead_clock();
+    for (int f = first; f <= frame; f++) {
+        if (!apply_frame(replay, f)) {
+            replay->decoded = -1;
+            replay->rows = 0;
+            return -1;
+        }
+        replay->decoded = f;
+    }
+    overhead_record(PHASE_PARSE, start);
+
+    if (replay->rows > snap->capacity) {
+        ProcessSample *grown = realloc(snap->samples, replay->rows * sizeof(ProcessSample));
+        if (!grown) return -1;
+        snap->samples = grown;
+        snap->capacity = replay->rows;
+    }
+
+    frame_header_t header;
+    memcpy(&header, replay->base + replay->frames[frame].offset, sizeof(header));
+    snap->count = replay->rows;
+    snap->reads = replay->rows;
+    snap->frame = frame;
+    snap->timestamp = header.timestamp;
+    snap->uptime = header.uptime;
+    snap->mem_total_kb = header.mem_total_kb;
+
+    for (int i = 0; i < replay->rows; i++) {
+        ProcessSample *s = &snap->samples[i];
+        const int64_t *v = &replay->values[i * REC_COLUMNS];
+        s->pid = replay->pids[i];
+        s->ppid = v[REC_PPID];
+        s->uid = v[REC_UID];
+        s->state = (char)v[REC_STATE];
+        copy_string(replay, v[REC_COMMAND], s->command, sizeof(s->command));
+        copy_string(replay, v[REC_USERNAME], s->username, sizeof(s->username));
+        s->utime = v[REC_UTIME];
+        s->stime = v[REC_STIME];
+        s->starttime = v[REC_STARTTIME];
+        s->minflt = v[REC_MINFLT];
+        s->majflt = v[REC_MAJFLT];
+        s->vsize_kb = v[REC_VSIZE];
+        s->rss_kb = v[REC_RSS];
+        s->threads = v[REC_THREADS];
+        s->fds = -1;
+        s->io_bytes = SNAPSHOT_IO_UNKNOWN;
+        s->cpu_percent = v[REC_CPU] / 10.0f;
+        s->mem_percent = header.mem_total_kb ? s->rss_kb * 100.0f / header.mem_total_kb : 0;
+        s->sampled_at = header.timestamp;
+        s->tier = TIER_HOT;
+        s->extrapolated = 0;
+    }
+    return snap->count;
+}
+
+typedef struct {
+    replay_match_t *matches;
+    int count;
+    int capacity;
+    int *slots;                             // Open addressing over matches, -1 when empty
+    int slot_count;                         // A power of two
+} match_table_t;
+
+static int match_slot(const match_table_t *table, pid_t pid, unsigned long long starttime) {
+    uint64_t key = ((uint64_t)pid << 32) ^ starttime;
+    return (int)((key * 0x9E3779B97F4A7C15ull) >> 40) & (table->slot_count - 1);
+}
+
+static int match_table_grow(match_table_t *table) {
+    int slot_count = table->slot_count ? table->slot_count * 2 : 1024;
+    int *slots = malloc(slot_count * sizeof(int));
+    replay_match_t *matches = realloc(table->matches, slot_count / 2 * sizeof(replay_match_t));
+    if (matches) table->matches = matches;
+    if (!slots || !matches) {
+        free(slots);
+        return 0;
+    }
+    memset(slots, 0xff, slot_count * sizeof(int));
+    free(table->slots);
+    table->slots = slots;
+    table->slot_count = slot_count;
+    table->capacity = slot_count / 2;
+    for (int i = 0; i < table->count; i++) {
+        int slot = match_slot(table, table->matches[i].pid, table->matches[i].starttime);
+        while (table->slots[slot] >= 0) slot = (slot + 1) & (slot_count - 1);
+        table->slots[slot] = i;
+    }
+    return 1;
+}
+
+// Finds or adds the entry of one process; a reused PID with a new start time is a new process
+static replay_match_t *match_entry(match_table_t *table, const ProcessSample *s) {
+    if (table->count == table->capacity && !match_table_grow(table)) return NULL;
+    int slot = match_slot(table, s->pid, s->starttime);
+    while (table->slots[slot] >= 0) {
+        replay_match_t *match = &table->matches[table->slots[slot]];
+        if (match->pid == s->pid && match->starttime == s->starttime) return match;
+        slot = (slot + 1) & (table->slot_count - 1);
+    }
+    table->slots[slot] = table->count;
+    replay_match_t *match = &table->matches[table->count++];
+    memset(match, 0, sizeof(*match));
+    match->pid = s->pid;
+    match->starttime = s->starttime;
+    return match;
+}
+
+int replay_query(replay_t *replay, double from, double to, filter_t *filter,
+                 replay_match_t **matches, replay_query_stats_t *stats) {
+    match_table_t table = {0};
+    ProcessSnapshot snap = {0};
+    int failed = 0;
+    double started = overhead_clock();
+    memset(stats, 0, sizeof(*stats));
+
+    // The sparse index finds the first block; zone maps decide which blocks need decoding
+    int first = replay_find_time(replay, from);
+    for (int b = replay->frames[first].block; b < replay->block_count && !failed; b++) {
+        const block_ref_t *block = &replay->blocks[b];
+        if (replay->frames[block->first_frame].wall > to) break;
+        if (replay->frames[block->first_frame + block->frame_count - 1].wall < from) continue;
+        stats->blocks++;
+        if (block->has_zone && !filter_may_match(filter, &block->zone)) {
+            stats->blocks_skipped++;
+            continue;
+        }
+
+        for (int f = block->first_frame; f < block->first_frame + block->frame_count; f++) {
+            double wall = replay->frames[f].wall;
+            if (wall < from) continue;
+            if (wall > to) break;
+            if (replay_read(replay, f, &snap) < 0) {
+                failed = 1;
+                break;
+            }
+            filter_prepare(filter, &snap);
+            stats->frames++;
+            stats->rows += snap.count;
+
+            for (int i = 0; i < snap.count; i++) {
+                if (!filter_match(filter, &snap, i)) continue;
+                const ProcessSample *s = &snap.samples[i];
+                replay_match_t *match = match_entry(&table, s);
+                if (!match) {
+                    failed = 1;
+                    break;
+                }
+                unsigned long long ticks = s->utime + s->stime;
+                if (match->frames++ == 0) {
+                    snprintf(match->command, sizeof(match->command), "%s", s->command);
+                    snprintf(match->username, sizeof(match->username), "%s", s->username);
+                    match->first_seen = wall;
+                    match->first_ticks = ticks;
+                }
+                match->last_seen = wall;
+                match->last_ticks = ticks;
+                match->cpu_sum += s->cpu_percent;
+                if (s->cpu_percent > match->peak_cpu) match->peak_cpu = s->cpu_percent;
+                if (s->rss_kb > match->peak_rss_kb) match->peak_rss_kb = s->rss_kb;
+            }
+        }
+    }
+
+    snapshot_free(&snap);
+    free(table.slots);
+    stats->seconds = overhead_clock() - started;
+    if (failed) {
+        free(table.matches);
+        *matches = NULL;
+        return -1;
+    }
+    *matches = table.matches;
+    return table.count;
+}
+
+void replay_close(replay_t *replay) {
+    if (replay == NULL) return;
+    if (replay->base) munmap((void *)replay->base, replay->size);
+    if (replay->fd >= 0) close(replay->fd);
+    free(replay->frames);
+    free(replay->strings);
+    free(replay->string_lengths);
+    free(replay->blocks);
+    free(replay->pids);
+    free(replay->next_pids);
+    free(replay->values);
+    free(replay->next_values);
+    free(replay);
+}
@@ -0,0 +1,162 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <stddef.h>
+#include <time.h>
+#include "proc_snapshot.h"
+#include "proc_filter.h"
+
+#define RECORDING_KEYFRAME_INTERVAL 300     // Frames between full frames; replay seeks land on these
+
+// Columns stored per process row; every column is delta-encoded against the same PID's previous frame
+typedef enum {
+    REC_PPID,
+    REC_UID,
+    REC_STATE,
+    REC_COMMAND,                    // String dictionary ID
+    REC_USERNAME,                   // String dictionary ID
+    REC_UTIME,
+    REC_STIME,
+    REC_STARTTIME,
+    REC_MINFLT,
+    REC_MAJFLT,
+    REC_VSIZE,
+    REC_RSS,
+    REC_THREADS,
+    REC_CPU,                        // Tenths of a percent
+    REC_COLUMNS
+} recording_column_t;
+
+typedef struct recorder recorder_t;
+typedef struct replay replay_t;
+
+// One process that matched a query, summarised over the frames it matched in
+typedef struct {
+    pid_t pid;
+    unsigned long long starttime;
+    char command[64];
+    char username[32];
+    double first_seen;              // Epoch seconds of the first matching frame
+    double last_seen;
+    int frames;                     // Frames the process matched in
+    double cpu_sum;                 // Over matching frames, for the average
+    float peak_cpu;
+    unsigned long peak_rss_kb;
+    unsigned long long first_ticks; // utime + stime at the first and the last match
+    unsigned long long last_ticks;
+} replay_match_t;
+
+typedef struct {
+    int blocks;                     // Blocks overlapping the time range
+    int blocks_skipped;             // Ruled out by their zone map without decoding
+    int frames;                     // Frames decoded and matched
+    long rows;                      // Rows tested against the filter
+    double seconds;
+} replay_query_stats_t;
+
+// What a recording holds, for describing it
+typedef struct {
+    const char *path;
+    size_t bytes;                   // File size
+    long clock_ticks;               // Ticks per second of the recording host
+    int blocks;                     // Keyframe-led blocks, the sparse time index
+    int zoned_blocks;               // Blocks with a zone map
+    unsigned int strings;           // Distinct commands and user names
+    int last_rows;                  // Processes in the last frame
+} replay_info_t;
+
+/**
+ * Creates a recording file, replacing any existing file
+ * @param path Output path
+ * @param keyframe_interval Frames between keyframes, 0 for RECORDING_KEYFRAME_INTERVAL
+ * @return The recorder, or NULL on failure (errno is set)
+ */
+recorder_t *recorder_open(const char *path, int keyframe_interval);
+
+/**
+ * Appends one snapshot as a frame. Rows are stored against the previous
+ * frame, so consecutive snapshots should come from consecutive refreshes.
+ * @param rec The recorder
+ * @param snap The snapshot, sorted by PID as snapshot_take leaves it
+ * @return Bytes written for the frame, -1 on failure
+ */
+long recorder_append(recorder_t *rec, const ProcessSnapshot *snap);
+
+/**
+ * Total bytes written so far, including the file header
+ */
+unsigned long long recorder_bytes(const recorder_t *rec);
+
+/**
+ * Flushes and closes a recording
+ * @param rec The recorder
+ */
+void recorder_close(recorder_t *rec);
+
+/**
+ * Maps a recording and indexes its frames and string dictionary.
+ * A frame cut short by a killed recorder is ignored.
+ * @param path The recording
+ * @return The replay, or NULL if the file cannot be read or is not a recording
+ */
+replay_t *replay_open(const char *path);
+
+/**
+ * Number of complete frames in a recording
+ */
+int replay_frame_count(const replay_t *replay);
+
+/**
+ * Wall clock time a frame was recorded at
+ * @param replay The replay
+ * @param frame Frame index
+ * @return Seconds since the epoch
+ */
+double replay_frame_time(const replay_t *replay, int frame);
+
+/**
+ * Finds the last frame recorded at or before a time
+ * @param replay The replay
+ * @param when Seconds since the epoch
+ * @return Frame index, 0 if the time lies before the recording
+ */
+int replay_find_time(const replay_t *replay, double when);
+
+/**
+ * Decodes one frame into a snapshot. Reading the next frame applies one
+ * delta; any other jump restarts from the nearest keyframe at or before it.
+ * @param replay The replay
+ * @param frame Frame index
+ * @param snap Snapshot to fill; its buffer is reused across calls
+ * @return Number of processes, -1 on a bad frame
+ */
+int replay_read(replay_t *replay, int frame, ProcessSnapshot *snap);
+
+/**
+ * Finds every process matching a filter between two times. Blocks of
+ * frames whose zone map rules the filter out are skipped undecoded.
+ * @param replay The replay
+ * @param from Start of the range, seconds since the epoch
+ * @param to End of the range, inclusive
+ * @param filter Compiled filter, or NULL for every process
+ * @param matches Receives a malloc'ed array, one entry per (PID, start time)
+ * @param stats Receives what the scan touched
+ * @return Number of matching processes, -1 on a bad frame
+ */
+int replay_query(replay_t *replay, double from, double to, filter_t *filter,
+                 replay_match_t **matches, replay_query_stats_t *stats);
+
+/**
+ * Describes a recording
+ * @param replay The replay
+ * @param info Receives the description; path points into the replay
+ */
+void replay_info(const replay_t *replay, replay_info_t *info);
+
+/**
+ * Unmaps a recording
+ * @param replay The replay
+ */
+void replay_close(replay_t *replay);
+
+#endif
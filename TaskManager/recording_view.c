@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include "recording_view.h"
+#include "recording.h"
+#include "diff_view.h"
+#include "group_view.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+// What the views are shown of a recording: the replay plus the frame they are at
+typedef struct {
+    replay_t *replay;
+    int cursor;                             // Frame the views see
+    int primed;                             // Cursor frame already shown, later requests play forward
+} replay_view_t;
+
+static void format_size(unsigned long long bytes, char *out, size_t size) {
+    if (bytes >= 1ULL << 30) snprintf(out, size, "%.1f GB", bytes / (double)(1ULL << 30));
+    else if (bytes >= 1ULL << 20) snprintf(out, size, "%.1f MB", bytes / (double)(1ULL << 20));
+    else if (bytes >= 1ULL << 10) snprintf(out, size, "%.1f KB", bytes / 1024.0);
+    else snprintf(out, size, "%llu B", bytes);
+}
+
+static void format_wall(double wall, char *out, size_t size) {
+    time_t when = (time_t)wall;
+    struct tm tm;
+    localtime_r(&when, &tm);
+    strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+void show_recorder(void) {
+    if (!snapshot_supported() || snapshot_replaying()) {
+        printf("Recording needs the live /proc (Linux only)\n");
+        return;
+    }
+
+    char path[256], scope[600];
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    char default_path[64];
+    strftime(default_path, sizeof(default_path), "taskmanager-%Y%m%d-%H%M%S.tmrec", &tm);
+    printf("Output file (default %s): ", default_path);
+    if (fgets(path, sizeof(path), stdin) == NULL) {
+        return;
+    }
+    path[strcspn(path, "\n")] = 0;
+    if (strlen(path) == 0) {
+        snprintf(path, sizeof(path), "%s", default_path);
+    }
+
+    recorder_t *rec = recorder_open(path, 0);
+    if (!rec) {
+        printf("Cannot create %s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    int cur = 0;
+    unsigned long frames = 0;
+    double first = 0;
+    long last_frame = 0;
+    snapshot_describe_scope(scope, sizeof(scope));
+
+    overhead_begin(1000);
+    if (snapshot_take(&snaps[cur], NULL) < 0) {
+        recorder_close(rec);
+        return;
+    }
+    first = snaps[cur].timestamp;
+    do {
+        ProcessSnapshot *snap = &snaps[cur];
+        double start = overhead_clock();
+        last_frame = recorder_append(rec, snap);
+        overhead_record(PHASE_RENDER, start);
+        if (last_frame < 0) {
+            printf("Writing %s failed: %s\n", path, strerror(errno));
+            break;
+        }
+        frames++;
+
+        char total[32], per_day[32];
+        unsigned long long bytes = recorder_bytes(rec);
+        double elapsed = snap->timestamp - first;
+        // Projection for a day at the current refresh rate from the frames so far
+        double frames_per_day = elapsed > 0 ? (frames - 1) * 86400.0 / elapsed : 86400.0;
+        format_size(bytes, total, sizeof(total));
+        format_size((unsigned long long)(bytes / (double)frames * frames_per_day), per_day, sizeof(per_day));
+
+        printf("\033[2J\033[H");
+        printf("===== Recording to %s =====\n", path);
+        printf("Scope: %s\n\n", scope);
+        printf("Frames:        %lu over %.0f s (keyframe every %d)\n", frames, elapsed, RECORDING_KEYFRAME_INTERVAL);
+        printf("Processes:     %d in the last frame, %d read\n", snap->count, snap->reads);
+        printf("File size:     %s, %llu B per frame on average, %ld B last frame\n",
+               total, bytes / frames, last_frame);
+        printf("One day:       about %s at this rate\n", per_day);
+        int interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to stop recording\n");
+        fflush(stdout);
+
+        if (wait_for_refresh(interval)) break;
+        cur ^= 1;
+    } while (snapshot_take(&snaps[cur], &snaps[cur ^ 1]) >= 0);
+
+    char total[32];
+    format_size(recorder_bytes(rec), total, sizeof(total));
+    printf("Recorded %lu frames to %s (%s)\n", frames, path, total);
+    recorder_close(rec);
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
+
+// Hands the views the cursor frame first, then plays forward one frame per refresh
+static int replay_source_take(ProcessSnapshot *snap, void *ctx) {
+    replay_view_t *view = ctx;
+    if (view->primed && view->cursor + 1 < replay_frame_count(view->replay)) view->cursor++;
+    view->primed = 1;
+    return replay_read(view->replay, view->cursor, snap);
+}
+
+static void replay_source_describe(char *buf, size_t size, void *ctx) {
+    replay_view_t *view = ctx;
+    replay_t *replay = view->replay;
+    replay_info_t info;
+    replay_info(replay, &info);
+    char when[32];
+    format_wall(replay_frame_time(replay, view->cursor), when, sizeof(when));
+    snprintf(buf, size, "replay of %s at %s (frame %d of %d)",
+             info.path, when, view->cursor + 1, replay_frame_count(replay));
+}
+
+// Accepts "YYYY-MM-DD HH:MM[:SS]" or "HH:MM[:SS]" on the day of the current frame
+static int parse_replay_time(const replay_view_t *view, const char *text, double *when) {
+    time_t base = (time_t)replay_frame_time(view->replay, view->cursor);
+    struct tm tm;
+    localtime_r(&base, &tm);
+    int year, month, day, hour, minute, second = 0;
+    if (sscanf(text, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) >= 5) {
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+    } else if (sscanf(text, "%d:%d:%d", &hour, &minute, &second) < 2) {
+        return 0;
+    }
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    tm.tm_isdst = -1;
+    *when = mktime(&tm);
+    return 1;
+}
+
+static int query_sort;
+
+static int compare_matches(const void *a, const void *b) {
+    const replay_match_t *ma = a, *mb = b;
+    double va, vb;
+    switch (query_sort) {
+        case 2:
+            va = ma->peak_rss_kb;
+            vb = mb->peak_rss_kb;
+            break;
+        case 3:
+            va = ma->last_ticks - ma->first_ticks;
+            vb = mb->last_ticks - mb->first_ticks;
+            break;
+        case 4:
+            va = ma->frames;
+            vb = mb->frames;
+            break;
+        default:
+            va = ma->cpu_sum / ma->frames;
+            vb = mb->cpu_sum / mb->frames;
+            break;
+    }
+    return va < vb ? 1 : va > vb ? -1 : ma->pid - mb->pid;
+}
+
+static void format_clock(double wall, char *out, size_t size) {
+    time_t when = (time_t)wall;
+    struct tm tm;
+    localtime_r(&when, &tm);
+    strftime(out, size, "%m-%d %H:%M:%S", &tm);
+}
+
+// Asks for a time range and a filter, then lists the matching processes
+static void run_query(replay_view_t *view) {
+    replay_t *replay = view->replay;
+    char input[256], error[128];
+    double from = replay_frame_time(replay, 0), to = replay_frame_time(replay, replay_frame_count(replay) - 1);
+
+    printf("From (YYYY-MM-DD HH:MM[:SS] or HH:MM[:SS], Enter for the start): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    if (input[0] != '\n' && !parse_replay_time(view, input, &from)) {
+        printf("Unrecognised time\n");
+        return;
+    }
+    printf("To (Enter for the end): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    if (input[0] != '\n' && !parse_replay_time(view, input, &to)) {
+        printf("Unrecognised time\n");
+        return;
+    }
+    printf("Filter, e.g. rss > 2G or subtree(1234) && cpu > 5 (Enter for all processes): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    filter_t *filter = filter_compile(input, error, sizeof(error));
+    if (!filter && error[0]) {
+        printf("Bad filter: %s\n", error);
+        return;
+    }
+    printf("Sort by 1. Average CPU 2. Peak RSS 3. CPU time 4. Frames matched (default 1): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) {
+        filter_free(filter);
+        return;
+    }
+    query_sort = atoi(input);
+
+    replay_match_t *matches;
+    replay_query_stats_t stats;
+    int count = replay_query(replay, from, to, filter, &matches, &stats);
+    filter_free(filter);
+    if (count < 0) {
+        printf("The recording has a damaged frame in that range\n");
+        return;
+    }
+    qsort(matches, count, sizeof(replay_match_t), compare_matches);
+    replay_info_t info;
+    replay_info(replay, &info);
+
+    printf("\n%d processes matched. Decoded %d of %d blocks (%d skipped by zone maps), %d frames, %ld rows in %.2f s\n",
+           count, stats.blocks - stats.blocks_skipped, stats.blocks, stats.blocks_skipped,
+           stats.frames, stats.rows, stats.seconds);
+    if (count > 0) {
+        printf("%8s %-12s %-20s %-14s %-14s %6s %6s %6s %10s %9s\n",
+               "PID", "USER", "COMMAND", "FIRST", "LAST", "FRAMES", "AVG%", "PEAK%", "PEAK RSS", "CPU TIME");
+    }
+    for (int i = 0; i < count && i < 25; i++) {
+        const replay_match_t *m = &matches[i];
+        char first_seen[32], last_seen[32], rss[32];
+        format_clock(m->first_seen, first_seen, sizeof(first_seen));
+        format_clock(m->last_seen, last_seen, sizeof(last_seen));
+        format_size(m->peak_rss_kb * 1024ULL, rss, sizeof(rss));
+        printf("%8d %-12.12s %-20.20s %-14s %-14s %6d %6.1f %6.1f %10s %8.1fs\n",
+               m->pid, m->username, m->command, first_seen, last_seen, m->frames, m->cpu_sum / m->frames,
+               m->peak_cpu, rss, (double)(m->last_ticks - m->first_ticks) / info.clock_ticks);
+    }
+    if (count > 25) printf("... and %d more\n", count - 25);
+    free(matches);
+}
+
+// Compares two frames; the current frame is the default for the newer side
+static void run_diff(replay_view_t *view) {
+    replay_t *replay = view->replay;
+    char input[256];
+    double when;
+    int frames[2] = {view->cursor, view->cursor};
+    const char *prompts[2] = {"Older point (YYYY-MM-DD HH:MM[:SS] or HH:MM[:SS]): ",
+                              "Newer point (Enter for the current frame): "};
+    for (int side = 0; side < 2; side++) {
+        printf("%s", prompts[side]);
+        if (fgets(input, sizeof(input), stdin) == NULL) return;
+        if (side == 1 && input[0] == '\n') break;
+        if (!parse_replay_time(view, input, &when)) {
+            printf("Unrecognised time\n");
+            return;
+        }
+        frames[side] = replay_find_time(replay, when);
+    }
+    if (frames[0] > frames[1]) {
+        int older = frames[1];
+        frames[1] = frames[0];
+        frames[0] = older;
+    }
+
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    SnapshotDiff diff = {0};
+    char labels[2][32];
+    if (replay_read(replay, frames[0], &snaps[0]) >= 0 && replay_read(replay, frames[1], &snaps[1]) >= 0 &&
+        snapshot_diff(&snaps[0], &snaps[1], &diff) >= 0) {
+        format_wall(replay_frame_time(replay, frames[0]), labels[0], sizeof(labels[0]));
+        format_wall(replay_frame_time(replay, frames[1]), labels[1], sizeof(labels[1]));
+        printf("\n");
+        snapshot_diff_print(&snaps[0], &snaps[1], &diff, labels[0], labels[1], 10);
+    } else {
+        printf("The recording has a damaged frame at one of those points\n");
+    }
+    snapshot_diff_free(&diff);
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
+
+void show_replay(void) {
+    char input[256], first[32], last[32], size[32];
+    printf("Recording to replay: ");
+    if (fgets(input, sizeof(input), stdin) == NULL) {
+        return;
+    }
+    input[strcspn(input, "\n")] = 0;
+
+    replay_t *replay = replay_open(input);
+    if (!replay) {
+        printf("%s is not a readable recording\n", input);
+        return;
+    }
+
+    replay_info_t info;
+    replay_info(replay, &info);
+    format_wall(replay_frame_time(replay, 0), first, sizeof(first));
+    format_wall(replay_frame_time(replay, replay_frame_count(replay) - 1), last, sizeof(last));
+    format_size(info.bytes, size, sizeof(size));
+    printf("\n%s: %d frames in %d blocks (%d with zone maps) from %s to %s\n",
+           info.path, replay_frame_count(replay), info.blocks, info.zoned_blocks, first, last);
+    printf("%s, %lu B per frame, %u distinct strings, %u processes in the last frame\n",
+           size, (unsigned long)(info.bytes / replay_frame_count(replay)), info.strings, info.last_rows);
+
+    replay_view_t view_state = { replay, 0, 0 };
+    replay_view_t *view = &view_state;
+    SnapshotSource source = { replay_source_take, replay_source_describe, view };
+    snapshot_set_source(&source);
+
+    while (1) {
+        char when[32];
+        format_wall(replay_frame_time(replay, view->cursor), when, sizeof(when));
+        printf("\nReplay position: frame %d of %d, recorded %s\n", view->cursor + 1, replay_frame_count(replay), when);
+        printf("1. List all processes\n");
+        printf("2. Display process tree\n");
+        printf("3. Top processes by CPU (plays forward)\n");
+        printf("4. Top processes by memory (plays forward)\n");
+        printf("5. Jump to time\n");
+        printf("6. Step frames\n");
+        printf("7. Query a time range\n");
+        printf("8. Diff two points\n");
+        printf("9. Totals by user or command (plays forward)\n");
+        printf("0. Stop replay\n");
+        printf("Enter choice: ");
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            break;
+        }
+
+        int choice = atoi(input);
+        if (choice == 0) break;
+        view->primed = 0;
+        switch (choice) {
+            case 1:
+                list_all_processes_with_threads();
+                printf("\nPress Enter to continue...");
+                while (getchar() != '\n');
+                break;
+            case 2:
+                printf("Enter root PID (0 for all): ");
+                if (fgets(input, sizeof(input), stdin) != NULL) {
+                    display_process_tree((pid_t)atoi(input));
+                    printf("\nPress Enter to continue...");
+                    while (getchar() != '\n');
+                }
+                break;
+            case 3:
+            case 4:
+                printf("Number of processes to show (default 10): ");
+                if (fgets(input, sizeof(input), stdin) != NULL) {
+                    show_top_resource_usage(choice == 3 ? 1 : 2, atoi(input), NULL);
+                }
+                break;
+            case 5: {
+                double target;
+                printf("Time (YYYY-MM-DD HH:MM[:SS] or HH:MM[:SS]): ");
+                if (fgets(input, sizeof(input), stdin) == NULL) break;
+                if (!parse_replay_time(view, input, &target)) {
+                    printf("Unrecognised time\n");
+                    break;
+                }
+                view->cursor = replay_find_time(replay, target);
+                break;
+            }
+            case 6: {
+                printf("Frames to step (negative steps back): ");
+                if (fgets(input, sizeof(input), stdin) == NULL) break;
+                long target = view->cursor + atol(input);
+                if (target < 0) target = 0;
+                if (target >= replay_frame_count(replay)) target = replay_frame_count(replay) - 1;
+                view->cursor = target;
+                break;
+            }
+            case 7:
+                run_query(view);
+                break;
+            case 8:
+                run_diff(view);
+                break;
+            case 9:
+                show_group_view();
+                break;
+            default:
+                printf("Invalid choice\n");
+        }
+    }
+
+    snapshot_set_source(NULL);
+    replay_close(replay);
+}
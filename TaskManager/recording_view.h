@@ -0,0 +1,15 @@
+#ifndef RECORDING_VIEW_H
+#define RECORDING_VIEW_H
+
+/**
+ * Records snapshots of the current scope to a file until Enter is pressed
+ */
+void show_recorder(void);
+
+/**
+ * Opens a recording and drives the process list, tree and top views
+ * from it instead of /proc
+ */
+void show_replay(void);
+
+#endif
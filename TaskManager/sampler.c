@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include "sampler.h"
+#include "history.h"
+#include "process_manager.h"
+
+/*
+ * The UI renders whatever `latest` points at and never waits on the
+ * sampler. To pin a buffer it bumps the buffer's reader count and then
+ * re-checks `latest`; the sampler publishes by swapping `latest` and only
+ * refills a buffer once its reader count is back to zero. Both sides use
+ * sequentially consistent atomics, so either the UI sees the swap and
+ * retries or the sampler sees the pin and waits for the render to finish.
+ */
+
+typedef struct {
+    ProcessSnapshot snap;
+    int readers;                    // UI pins; the sampler does not refill a pinned buffer
+} sampler_buffer_t;
+
+struct sampler {
+    sampler_buffer_t buffers[2];
+    sampler_buffer_t *latest;       // Swapped atomically by the sampler
+    int interval_ms;
+    int threaded;
+    int stop;
+    int failed;
+    int wake[2];                    // Sampler -> UI: a new snapshot is out
+    int quit[2];                    // UI -> sampler: cuts the sleep between refreshes short
+    pthread_t thread;
+    pid_t promotions[SAMPLER_PROMOTIONS];
+    unsigned int promote_head;      // Written by the UI only
+    unsigned int promote_tail;      // Written by the sampler only
+};
+
+// Marks queued processes hot in a snapshot that is not published yet, so no render sees the write
+static void apply_promotions(sampler_t *sampler, ProcessSnapshot *snap) {
+    unsigned int tail = sampler->promote_tail;
+    unsigned int head = __atomic_load_n(&sampler->promote_head, __ATOMIC_ACQUIRE);
+    while (tail != head) {
+        snapshot_promote(snap, sampler->promotions[tail % SAMPLER_PROMOTIONS]);
+        tail++;
+    }
+    __atomic_store_n(&sampler->promote_tail, tail, __ATOMIC_RELEASE);
+}
+
+// Refills the buffer that is not published and swaps it in
+static int refresh(sampler_t *sampler) {
+    sampler_buffer_t *current = __atomic_load_n(&sampler->latest, __ATOMIC_SEQ_CST);
+    sampler_buffer_t *back = current == &sampler->buffers[0] ? &sampler->buffers[1] : &sampler->buffers[0];
+
+    // A pin only lasts one render, so the sampler never waits long
+    while (__atomic_load_n(&back->readers, __ATOMIC_SEQ_CST) > 0) {
+        if (__atomic_load_n(&sampler->stop, __ATOMIC_RELAXED)) return 0;
+        sched_yield();
+    }
+
+    if (snapshot_take(&back->snap, &current->snap) < 0) return -1;
+    // The published buffer may be pinned by a render, so promotions land in the new one
+    apply_promotions(sampler, &back->snap);
+    // Histories are fed here so the UI thread only renders
+    history_record(&back->snap);
+    __atomic_store_n(&sampler->latest, back, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+// Wakeups are level-triggered, so a byte that does not fit a full pipe is not missed
+static void notify(int fd) {
+    char byte = 1;
+    ssize_t written = write(fd, &byte, 1);
+    (void)written;
+}
+
+static void *sampler_thread(void *arg) {
+    sampler_t *sampler = arg;
+    while (!__atomic_load_n(&sampler->stop, __ATOMIC_RELAXED)) {
+        struct pollfd pfd = { sampler->quit[0], POLLIN, 0 };
+        if (poll(&pfd, 1, __atomic_load_n(&sampler->interval_ms, __ATOMIC_RELAXED)) > 0) break;
+
+        int result = refresh(sampler);
+        if (result == 0) break;
+        if (result < 0) __atomic_store_n(&sampler->failed, 1, __ATOMIC_RELEASE);
+        notify(sampler->wake[1]);
+        if (result < 0) break;
+    }
+    return NULL;
+}
+
+sampler_t *sampler_start(int interval_ms) {
+    sampler_t *sampler = calloc(1, sizeof(sampler_t));
+    if (!sampler) return NULL;
+    sampler->interval_ms = interval_ms;
+    sampler->wake[0] = sampler->wake[1] = sampler->quit[0] = sampler->quit[1] = -1;
+
+    if (snapshot_take(&sampler->buffers[0].snap, NULL) < 0) {
+        free(sampler);
+        return NULL;
+    }
+    history_record(&sampler->buffers[0].snap);
+    sampler->latest = &sampler->buffers[0];
+
+    // Replays and the daemon are read inline; only /proc is slow enough for a thread
+    sampler->threaded = !snapshot_replaying() && pipe(sampler->wake) == 0 && pipe(sampler->quit) == 0 &&
+                        fcntl(sampler->wake[1], F_SETFL, O_NONBLOCK) == 0 &&
+                        pthread_create(&sampler->thread, NULL, sampler_thread, sampler) == 0;
+    if (!sampler->threaded) {
+        for (int i = 0; i < 2; i++) {
+            if (sampler->wake[i] >= 0) close(sampler->wake[i]);
+            if (sampler->quit[i] >= 0) close(sampler->quit[i]);
+        }
+    }
+    return sampler;
+}
+
+const ProcessSnapshot *sampler_acquire(sampler_t *sampler) {
+    if (__atomic_load_n(&sampler->failed, __ATOMIC_ACQUIRE)) return NULL;
+    while (1) {
+        sampler_buffer_t *buffer = __atomic_load_n(&sampler->latest, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&buffer->readers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sampler->latest, __ATOMIC_SEQ_CST) == buffer) return &buffer->snap;
+        // Swapped between the load and the pin; the new one is complete, take that
+        __atomic_sub_fetch(&buffer->readers, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void sampler_release(sampler_t *sampler, const ProcessSnapshot *snap) {
+    sampler_buffer_t *buffer = snap == &sampler->buffers[0].snap ? &sampler->buffers[0] : &sampler->buffers[1];
+    __atomic_sub_fetch(&buffer->readers, 1, __ATOMIC_SEQ_CST);
+}
+
+int sampler_wait(sampler_t *sampler) {
+    if (!sampler->threaded) {
+        if (wait_for_refresh(sampler->interval_ms)) return 1;
+        if (refresh(sampler) < 0) sampler->failed = 1;
+        return 0;
+    }
+
+    struct pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { sampler->wake[0], POLLIN, 0 } };
+    while (poll(fds, 2, -1) < 0 && errno == EINTR);
+    if (fds[0].revents & POLLIN) {
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF);
+        return 1;
+    }
+    char drain[64];
+    ssize_t drained = read(sampler->wake[0], drain, sizeof(drain));
+    (void)drained;
+    return 0;
+}
+
+void sampler_set_interval(sampler_t *sampler, int interval_ms) {
+    __atomic_store_n(&sampler->interval_ms, interval_ms, __ATOMIC_RELAXED);
+}
+
+void sampler_promote(sampler_t *sampler, pid_t pid) {
+    if (!sampler->threaded) {
+        snapshot_promote(&sampler->latest->snap, pid);
+        return;
+    }
+    unsigned int head = sampler->promote_head;
+    if (head - __atomic_load_n(&sampler->promote_tail, __ATOMIC_ACQUIRE) == SAMPLER_PROMOTIONS) return;
+    sampler->promotions[head % SAMPLER_PROMOTIONS] = pid;
+    __atomic_store_n(&sampler->promote_head, head + 1, __ATOMIC_RELEASE);
+}
+
+void sampler_stop(sampler_t *sampler) {
+    if (!sampler) return;
+    if (sampler->threaded) {
+        __atomic_store_n(&sampler->stop, 1, __ATOMIC_RELAXED);
+        notify(sampler->quit[1]);
+        pthread_join(sampler->thread, NULL);
+        for (int i = 0; i < 2; i++) {
+            close(sampler->wake[i]);
+            close(sampler->quit[i]);
+        }
+    }
+    snapshot_free(&sampler->buffers[0].snap);
+    snapshot_free(&sampler->buffers[1].snap);
+    free(sampler);
+}
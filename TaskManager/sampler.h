@@ -0,0 +1,65 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "proc_snapshot.h"
+
+#define SAMPLER_PROMOTIONS 1024     // Promotions queued per refresh; more are dropped until the next one
+
+typedef struct sampler sampler_t;
+
+/**
+ * Takes a first snapshot and starts a thread that refreshes into the
+ * other of two snapshot buffers and publishes it with an atomic pointer
+ * swap. Each refresh is passed to history_record() before it is
+ * published. Snapshot sources (replays, the daemon) are cheap to read
+ * and are sampled inline on the calling thread instead.
+ * @param interval_ms Time between refreshes
+ * @return The sampler, or NULL if the first snapshot failed
+ */
+sampler_t *sampler_start(int interval_ms);
+
+/**
+ * Pins the latest complete snapshot. Never blocks: if the sampler is
+ * busy, the previous snapshot is still the latest one.
+ * @param sampler The sampler
+ * @return The snapshot, or NULL if sampling has failed
+ */
+const ProcessSnapshot *sampler_acquire(sampler_t *sampler);
+
+/**
+ * Unpins a snapshot so the sampler may refill its buffer
+ * @param sampler The sampler
+ * @param snap The snapshot from sampler_acquire
+ */
+void sampler_release(sampler_t *sampler, const ProcessSnapshot *snap);
+
+/**
+ * Waits until a newer snapshot is published or a line is typed
+ * @param sampler The sampler
+ * @return 1 if a line was typed (it is consumed), 0 for a new snapshot
+ */
+int sampler_wait(sampler_t *sampler);
+
+/**
+ * Changes the refresh interval, e.g. to the one overhead_end_frame asks for
+ * @param sampler The sampler
+ * @param interval_ms Time between refreshes
+ */
+void sampler_set_interval(sampler_t *sampler, int interval_ms);
+
+/**
+ * Queues a process for the hot tier; the thread-safe counterpart of
+ * snapshot_promote. The sampler marks it in the next snapshot it takes,
+ * so the refresh after that re-reads it.
+ * @param sampler The sampler
+ * @param pid The process ID
+ */
+void sampler_promote(sampler_t *sampler, pid_t pid);
+
+/**
+ * Stops the sampling thread and frees both buffers
+ * @param sampler The sampler
+ */
+void sampler_stop(sampler_t *sampler);
+
+#endif
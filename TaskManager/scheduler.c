@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "scheduler.h"
+
+static scheduled_task_t tasks[MAX_SCHEDULED_TASKS];
+static int task_count = 0;
+static int next_task_id = 1;
+static int scheduler_running = 0;
+static pthread_t scheduler_thread;
+static pthread_mutex_t task_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void* scheduler_thread_function(void* arg) {
+    (void)arg;  // Suppress unused parameter warning
+    
+    while (__atomic_load_n(&scheduler_running, __ATOMIC_RELAXED)) {
+        time_t current_time = time(NULL);
+        
+        pthread_mutex_lock(&task_mutex);
+        for (int i = 0; i < task_count; i++) {
+            if (!tasks[i].is_active) continue;
+            
+            int should_run = 0;
+            switch (tasks[i].type) {
+                case ONCE:
+                    if (current_time >= tasks[i].execution_time) {
+                        should_run = 1;
+                        tasks[i].is_active = 0;  // Bir kerelik görev tamamlandı
+                    }
+                    break;
+                    
+                case INTERVAL:
+                    if (current_time >= tasks[i].execution_time) {
+                        should_run = 1;
+                        tasks[i].execution_time = current_time + tasks[i].interval_seconds;
+                    }
+                    break;
+                    
+                case DAILY: {
+                    // localtime_r: library callers may use localtime on their own threads
+                    struct tm tm_current, tm_scheduled;
+                    localtime_r(&current_time, &tm_current);
+                    localtime_r(&tasks[i].execution_time, &tm_scheduled);
+                    if (tm_current.tm_hour == tm_scheduled.tm_hour &&
+                        tm_current.tm_min == tm_scheduled.tm_min) {
+                        should_run = 1;
+                        //Schedule for tomorrow same time 
+                        tasks[i].execution_time += 24 * 60 * 60;
+                    }
+                    break;
+                }
+            }
+            
+            if (should_run) {
+                // Create a modified command with task identifier
+                char task_cmd[2 * sizeof(tasks[i].command) + 64];   // The command appears twice
+                
+                // For better identification in process listings
+                snprintf(task_cmd, sizeof(task_cmd), 
+                        "echo \"Running Task %d: %s\"; %s", 
+                        tasks[i].id, tasks[i].command, tasks[i].command);
+                
+                pid_t pid = fork();
+                if (pid == 0) {
+                    // Create identifiable process name using Task-ID prefix
+                    char process_name[256];
+                    snprintf(process_name, sizeof(process_name), "Task-%d", tasks[i].id);
+                    
+                    // Write the name to /proc/self/comm if available (Linux)
+                    FILE *comm_file = fopen("/proc/self/comm", "w");
+                    if (comm_file) {
+                        fputs(process_name, comm_file);
+                        fclose(comm_file);
+                    }
+                    
+                    // Execute the task
+                    execl("/bin/sh", "sh", "-c", task_cmd, NULL);
+                    exit(1);
+                } else if (pid > 0) {
+                    tasks[i].last_pid = pid;
+                }
+            }
+        }
+        pthread_mutex_unlock(&task_mutex);
+        
+        sleep(1); 
+    }
+    return NULL;
+}
+
+int add_scheduled_task(const char* command, schedule_type_t type, time_t execution_time, int interval_seconds) {
+    pthread_mutex_lock(&task_mutex);
+    
+    if (task_count >= MAX_SCHEDULED_TASKS) {
+        pthread_mutex_unlock(&task_mutex);
+        return -1;
+    }
+    
+    scheduled_task_t* task = &tasks[task_count];
+    memset(task, 0, sizeof(*task));
+    task->id = next_task_id++;
+    strncpy(task->command, command, sizeof(task->command) - 1);
+    task->type = type;
+    task->execution_time = execution_time;
+    task->interval_seconds = interval_seconds;
+    task->is_active = 1;
+    task->last_pid = 0;
+    
+    task_count++;
+    pthread_mutex_unlock(&task_mutex);
+    return task->id;
+}
+
+int remove_scheduled_task(int task_id) {
+    pthread_mutex_lock(&task_mutex);
+    
+    int task_index = 0;
+    while (task_index < task_count && tasks[task_index].id != task_id) task_index++;
+    if (task_index == task_count) {
+        pthread_mutex_unlock(&task_mutex);
+        return 0;
+    }
+    
+    // Later tasks close the gap so listings keep their order
+    memmove(&tasks[task_index], &tasks[task_index + 1],
+            (task_count - task_index - 1) * sizeof(scheduled_task_t));
+    task_count--;
+    
+    pthread_mutex_unlock(&task_mutex);
+    return 1;
+}
+
+int get_scheduled_tasks(scheduled_task_t *out, int max) {
+    pthread_mutex_lock(&task_mutex);
+    int count = task_count;
+    memcpy(out, tasks, (count < max ? count : max) * sizeof(scheduled_task_t));
+    pthread_mutex_unlock(&task_mutex);
+    return count;
+}
+
+int run_task_scheduler(void) {
+    // Library callers may race to start it; only one of them creates the thread
+    if (__atomic_exchange_n(&scheduler_running, 1, __ATOMIC_ACQ_REL)) return 0;
+    if (pthread_create(&scheduler_thread, NULL, scheduler_thread_function, NULL) != 0) {
+        __atomic_store_n(&scheduler_running, 0, __ATOMIC_RELEASE);
+        return 0;
+    }
+    return 1;
+}
+
+int stop_task_scheduler(void) {
+    if (!__atomic_exchange_n(&scheduler_running, 0, __ATOMIC_ACQ_REL)) return 0;
+    pthread_join(scheduler_thread, NULL);
+    return 1;
+}
@@ -0,0 +1,61 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <sys/types.h>
+#include <time.h>
+
+// Task Scheduler yapıları
+#define MAX_SCHEDULED_TASKS 100
+
+typedef enum {
+    ONCE,           // Bir kere çalıştır
+    INTERVAL,       // Belirli aralıklarla çalıştır
+    DAILY          // Her gün belirli saatte çalıştır
+} schedule_type_t;
+
+typedef struct {
+    int id;                      // Never reused, so it stays valid while other tasks come and go
+    char command[256];           // Çalıştırılacak komut
+    schedule_type_t type;        // Zamanlama tipi
+    time_t execution_time;       // Çalıştırma zamanı
+    int interval_seconds;        // INTERVAL tipi için aralık
+    int is_active;              // Task aktif mi?
+    pid_t last_pid;             // Son çalıştırılan process'in PID'i
+} scheduled_task_t;
+
+// Task Scheduler fonksiyonları
+
+/**
+ * Adds a task to the scheduler table
+ * @return ID of the new task, -1 if the table is full
+ */
+int add_scheduled_task(const char* command, schedule_type_t type, time_t execution_time, int interval_seconds);
+
+/**
+ * Removes a task; the others keep their IDs and order
+ * @param task_id ID of the task
+ * @return 1 if removed, 0 for an unknown ID
+ */
+int remove_scheduled_task(int task_id);
+
+/**
+ * Copies the task table
+ * @param out Receives up to max tasks
+ * @param max Capacity of out
+ * @return Number of tasks in the table
+ */
+int get_scheduled_tasks(scheduled_task_t *out, int max);
+
+/**
+ * Starts the scheduler thread
+ * @return 1 if it was started, 0 if it was already running or could not start
+ */
+int run_task_scheduler(void);
+
+/**
+ * Stops the scheduler thread
+ * @return 1 if it was running, 0 otherwise
+ */
+int stop_task_scheduler(void);
+
+#endif
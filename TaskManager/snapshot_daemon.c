@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "snapshot_daemon.h"
+#include "snapshot_shm.h"
+#include "overhead.h"
+
+static volatile sig_atomic_t daemon_stop;
+
+static void request_stop(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+int run_snapshot_daemon(int interval_ms) {
+    if (!snapshot_supported()) {
+        fprintf(stderr, "The daemon samples /proc, which this system does not have\n");
+        return EXIT_FAILURE;
+    }
+    if (interval_ms < SNAPSHOT_SHM_MIN_INTERVAL_MS) interval_ms = SNAPSHOT_SHM_MIN_INTERVAL_MS;
+
+    snapshot_publisher_t *pub = snapshot_publisher_open(SNAPSHOT_SHM_NAME, interval_ms);
+    if (!pub) {
+        if (errno == EEXIST) fprintf(stderr, "Another daemon is already publishing to %s\n", SNAPSHOT_SHM_NAME);
+        else perror("Cannot create " SNAPSHOT_SHM_NAME);
+        return EXIT_FAILURE;
+    }
+
+    // No SA_RESTART, so the signal also cuts the sleep between refreshes short
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = request_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    char scope[256];
+    snapshot_describe_scope(scope, sizeof(scope));
+    printf("Publishing snapshots of %s to %s every %d ms as PID %d; Ctrl-C stops\n",
+           scope, SNAPSHOT_SHM_NAME, interval_ms, (int)getpid());
+    fflush(stdout);
+
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    int cur = 0, status = EXIT_SUCCESS;
+    overhead_begin(interval_ms);
+    if (snapshot_take(&snaps[cur], NULL) < 0) status = EXIT_FAILURE;
+    while (status == EXIT_SUCCESS && !daemon_stop) {
+        double start = overhead_clock();
+        if (snapshot_publish(pub, &snaps[cur]) < snaps[cur].count && snaps[cur].frame == 0) {
+            fprintf(stderr, "Only the first %d of %d processes fit the shared buffer\n",
+                    SNAPSHOT_SHM_MAX_PROCESSES, snaps[cur].count);
+        }
+        overhead_record(PHASE_RENDER, start);
+
+        // The budget controller may stretch the interval; subscribers see the real one
+        int interval = overhead_end_frame();
+        if (interval < SNAPSHOT_SHM_MIN_INTERVAL_MS) interval = SNAPSHOT_SHM_MIN_INTERVAL_MS;
+        snapshot_publisher_set_interval(pub, interval);
+        struct timespec ts = { interval / 1000, (interval % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+        if (daemon_stop) break;
+
+        cur ^= 1;
+        if (snapshot_take(&snaps[cur], &snaps[cur ^ 1]) < 0) status = EXIT_FAILURE;
+    }
+
+    printf("\nPublished %llu snapshots\n", snapshot_publisher_count(pub));
+    snapshot_publisher_close(pub);
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+    return status;
+}
+
+void show_daemon_attach(void) {
+    if (snapshot_daemon_attached()) {
+        snapshot_daemon_detach();
+        printf("Detached; views sample /proc in this process again\n");
+        return;
+    }
+    if (!snapshot_daemon_attach()) {
+        printf("No monitoring daemon is publishing to %s\n", SNAPSHOT_SHM_NAME);
+        printf("Start one with: process_manager --daemon [--interval=MS]\n");
+        return;
+    }
+    char scope[600];
+    snapshot_describe_scope(scope, sizeof(scope));
+    printf("Attached to %s\n", scope);
+    printf("Views now read the daemon's snapshots; scope and tiering settings are the daemon's\n");
+}
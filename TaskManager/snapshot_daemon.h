@@ -0,0 +1,17 @@
+#ifndef SNAPSHOT_DAEMON_H
+#define SNAPSHOT_DAEMON_H
+
+/**
+ * Samples the current scope and publishes every snapshot until SIGINT or
+ * SIGTERM. This is what process_manager --daemon runs.
+ * @param interval_ms Sampling interval
+ * @return Exit status for main
+ */
+int run_snapshot_daemon(int interval_ms);
+
+/**
+ * Menu entry: attaches to the daemon, or detaches when already attached
+ */
+void show_daemon_attach(void);
+
+#endif
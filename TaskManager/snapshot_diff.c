@@ -0,0 +1,51 @@
+#include <stdlib.h>
+#include "snapshot_diff.h"
+#include "overhead.h"
+
+int snapshot_diff(const ProcessSnapshot *before, const ProcessSnapshot *after, SnapshotDiff *diff) {
+    int needed = before->count + after->count;
+    if (needed > diff->capacity) {
+        diff_row_t *grown = realloc(diff->rows, needed * sizeof(diff_row_t));
+        if (!grown) return -1;
+        diff->rows = grown;
+        diff->capacity = needed;
+    }
+    diff->count = diff->started = diff->exited = diff->common = 0;
+
+    double start = overhead_clock();
+    const ProcessSample *b = before->samples, *a = after->samples;
+    int i = 0, j = 0;
+    while (i < before->count || j < after->count) {
+        diff_row_t *row = &diff->rows[diff->count++];
+        if (j >= after->count || (i < before->count && b[i].pid < a[j].pid)) {
+            row->before = i++;
+            row->after = -1;
+            diff->exited++;
+        } else if (i >= before->count || a[j].pid < b[i].pid) {
+            row->before = -1;
+            row->after = j++;
+            diff->started++;
+        } else if (b[i].starttime == a[j].starttime) {
+            row->before = i++;
+            row->after = j++;
+            diff->common++;
+        } else {
+            // Same PID, different process: the old one exited and the PID was handed out again
+            row->before = i++;
+            row->after = -1;
+            diff->exited++;
+            row = &diff->rows[diff->count++];
+            row->before = -1;
+            row->after = j++;
+            diff->started++;
+        }
+    }
+    overhead_record(PHASE_SORT, start);
+    return diff->count;
+}
+
+void snapshot_diff_free(SnapshotDiff *diff) {
+    free(diff->rows);
+    diff->rows = NULL;
+    diff->count = diff->capacity = 0;
+}
@@ -0,0 +1,37 @@
+#ifndef SNAPSHOT_DIFF_H
+#define SNAPSHOT_DIFF_H
+
+#include "proc_snapshot.h"
+
+// One row of a diff; a process is the same on both sides only if PID and start time agree
+typedef struct {
+    int before;                     // Index in the older snapshot, -1 if the process started
+    int after;                      // Index in the newer snapshot, -1 if the process exited
+} diff_row_t;
+
+typedef struct {
+    diff_row_t *rows;               // In PID order
+    int count;
+    int capacity;
+    int started;
+    int exited;
+    int common;
+} SnapshotDiff;
+
+/**
+ * Pairs up the processes of two snapshots with one sorted merge on
+ * (PID, start time). A reused PID shows up as one exit and one start.
+ * @param before The older snapshot, sorted by PID
+ * @param after The newer snapshot, sorted by PID
+ * @param diff Receives the rows; its buffer is reused across calls
+ * @return Number of rows, -1 if out of memory
+ */
+int snapshot_diff(const ProcessSnapshot *before, const ProcessSnapshot *after, SnapshotDiff *diff);
+
+/**
+ * Frees the rows of a diff
+ * @param diff The diff
+ */
+void snapshot_diff_free(SnapshotDiff *diff);
+
+#endif
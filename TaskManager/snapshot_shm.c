@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot_shm.h"
+#include "overhead.h"
+
+/*
+ * Region layout: one page of header, then two buffers of
+ * SNAPSHOT_SHM_MAX_PROCESSES samples each. The daemon only ever writes the
+ * buffer that is not active, bracketing the write with an odd/even
+ * sequence number (a seqlock per buffer), then flips `active`. Subscribers
+ * map the region read-only and copy the metadata and rows out between two
+ * reads of the sequence, retrying if it moved, so attaching costs the
+ * daemon nothing and a subscriber one copy per refresh instead of a /proc
+ * walk.
+ */
+
+#define SHM_MAGIC 0x48534d54u               // "TMSH"
+#define SHM_VERSION 1
+#define SHM_HEADER_SIZE 4096
+#define SHM_READ_ATTEMPTS 100
+
+typedef struct {
+    uint32_t seq;                   // Odd while the daemon rewrites the buffer
+    int32_t count;
+    int32_t reads;
+    int32_t truncated;              // Processes left out because the buffer was full
+    double timestamp;               // CLOCK_MONOTONIC, which is the same clock in every process
+    double uptime;
+    uint64_t mem_total_kb;
+    uint64_t frame;
+} shm_buffer_meta_t;
+
+typedef struct {
+    uint32_t magic;                 // Written last, so a half-initialised region is never attached
+    uint32_t version;
+    uint32_t sample_size;           // sizeof(ProcessSample) of the daemon; another layout must not attach
+    uint32_t capacity;
+    int32_t daemon_pid;
+    int32_t interval_ms;
+    uint32_t active;                // Buffer subscribers should read
+    uint32_t reserved;
+    uint64_t publishes;
+    char scope[256];                // What the daemon samples
+    shm_buffer_meta_t buffers[2];
+} shm_header_t;
+
+_Static_assert(sizeof(shm_header_t) <= SHM_HEADER_SIZE, "shm header must fit its page");
+
+struct snapshot_publisher {
+    char name[64];
+    int fd;
+    size_t size;
+    shm_header_t *header;
+    ProcessSample *buffers[2];
+};
+
+struct snapshot_subscriber {
+    size_t size;
+    shm_header_t *header;
+    const ProcessSample *buffers[2];
+    uint32_t capacity;              // Checked against the mapping at attach; the header's copy may change later
+    int daemon_gone;
+};
+
+static snapshot_subscriber_t *attached;
+
+static size_t region_size(uint32_t capacity) {
+    return SHM_HEADER_SIZE + 2 * (size_t)capacity * sizeof(ProcessSample);
+}
+
+// Another user's daemon answers EPERM, which still means it is alive
+static int daemon_alive(pid_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// Looks at a region left by an earlier daemon; returns 1 if that daemon is still publishing
+static int region_in_use(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return 0;
+    struct stat st;
+    int in_use = 0;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(shm_header_t)) {
+        shm_header_t *header = mmap(NULL, sizeof(shm_header_t), PROT_READ, MAP_SHARED, fd, 0);
+        if (header != MAP_FAILED) {
+            in_use = header->magic == SHM_MAGIC && header->daemon_pid != getpid() &&
+                     daemon_alive(header->daemon_pid);
+            munmap(header, sizeof(shm_header_t));
+        }
+    }
+    close(fd);
+    return in_use;
+}
+
+snapshot_publisher_t *snapshot_publisher_open(const char *name, int interval_ms) {
+    if (region_in_use(name)) {
+        errno = EEXIST;
+        return NULL;
+    }
+    shm_unlink(name);
+
+    snapshot_publisher_t *pub = calloc(1, sizeof(snapshot_publisher_t));
+    if (!pub) return NULL;
+    snprintf(pub->name, sizeof(pub->name), "%s", name);
+    pub->size = region_size(SNAPSHOT_SHM_MAX_PROCESSES);
+
+    // Readable by everyone regardless of umask: other users' viewers attach read-only
+    pub->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (pub->fd < 0) {
+        free(pub);
+        return NULL;
+    }
+    void *base = MAP_FAILED;
+    if (fchmod(pub->fd, 0644) == 0 && ftruncate(pub->fd, pub->size) == 0) {
+        base = mmap(NULL, pub->size, PROT_READ | PROT_WRITE, MAP_SHARED, pub->fd, 0);
+    }
+    if (base == MAP_FAILED) {
+        int saved = errno;
+        close(pub->fd);
+        shm_unlink(name);
+        free(pub);
+        errno = saved;
+        return NULL;
+    }
+
+    pub->header = base;
+    pub->buffers[0] = (ProcessSample *)((char *)base + SHM_HEADER_SIZE);
+    pub->buffers[1] = pub->buffers[0] + SNAPSHOT_SHM_MAX_PROCESSES;
+    pub->header->version = SHM_VERSION;
+    pub->header->sample_size = sizeof(ProcessSample);
+    pub->header->capacity = SNAPSHOT_SHM_MAX_PROCESSES;
+    pub->header->daemon_pid = getpid();
+    pub->header->interval_ms = interval_ms;
+    snapshot_describe_scope(pub->header->scope, sizeof(pub->header->scope));
+    __atomic_store_n(&pub->header->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    return pub;
+}
+
+int snapshot_publish(snapshot_publisher_t *pub, const ProcessSnapshot *snap) {
+    shm_header_t *header = pub->header;
+    uint32_t b = header->active ^ 1;
+    shm_buffer_meta_t *meta = &header->buffers[b];
+    int count = snap->count < (int)header->capacity ? snap->count : (int)header->capacity;
+
+    __atomic_store_n(&meta->seq, meta->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(pub->buffers[b], snap->samples, count * sizeof(ProcessSample));
+    meta->count = count;
+    meta->reads = snap->reads;
+    meta->truncated = snap->count - count;
+    meta->timestamp = snap->timestamp;
+    meta->uptime = snap->uptime;
+    meta->mem_total_kb = snap->mem_total_kb;
+    meta->frame = snap->frame;
+    __atomic_store_n(&meta->seq, meta->seq + 1, __ATOMIC_RELEASE);
+
+    header->publishes++;
+    __atomic_store_n(&header->active, b, __ATOMIC_RELEASE);
+    return count;
+}
+
+void snapshot_publisher_set_interval(snapshot_publisher_t *pub, int interval_ms) {
+    pub->header->interval_ms = interval_ms;
+}
+
+unsigned long long snapshot_publisher_count(const snapshot_publisher_t *pub) {
+    return pub->header->publishes;
+}
+
+void snapshot_publisher_close(snapshot_publisher_t *pub) {
+    if (!pub) return;
+    munmap(pub->header, pub->size);
+    close(pub->fd);
+    shm_unlink(pub->name);
+    free(pub);
+}
+
+snapshot_subscriber_t *snapshot_subscribe(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+
+    // Anyone on the host can create the name, so nothing in the header is trusted blindly
+    struct stat st;
+    shm_header_t *header = MAP_FAILED;
+    size_t size = 0;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= SHM_HEADER_SIZE) {
+        size = st.st_size;
+        header = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (header == MAP_FAILED) return NULL;
+
+    // The capacity is read once: the daemon can rewrite the header at any time after this check
+    uint32_t capacity = 0;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == SHM_MAGIC) {
+        capacity = __atomic_load_n(&header->capacity, __ATOMIC_RELAXED);
+    }
+    if (capacity == 0 || header->version != SHM_VERSION || header->sample_size != sizeof(ProcessSample) ||
+        capacity > SNAPSHOT_SHM_MAX_PROCESSES || region_size(capacity) > size ||
+        !daemon_alive(header->daemon_pid)) {
+        munmap(header, size);
+        return NULL;
+    }
+
+    snapshot_subscriber_t *sub = calloc(1, sizeof(snapshot_subscriber_t));
+    if (!sub) {
+        munmap(header, size);
+        return NULL;
+    }
+    sub->size = size;
+    sub->header = header;
+    sub->capacity = capacity;
+    sub->buffers[0] = (const ProcessSample *)((const char *)header + SHM_HEADER_SIZE);
+    sub->buffers[1] = sub->buffers[0] + capacity;
+    return sub;
+}
+
+int snapshot_subscriber_read(snapshot_subscriber_t *sub, ProcessSnapshot *snap) {
+    const shm_header_t *header = sub->header;
+    if (sub->daemon_gone || !daemon_alive(header->daemon_pid)) {
+        sub->daemon_gone = 1;
+        return -1;
+    }
+
+    for (int attempt = 0; attempt < SHM_READ_ATTEMPTS; attempt++) {
+        uint32_t b = __atomic_load_n(&header->active, __ATOMIC_ACQUIRE) & 1;
+        const shm_buffer_meta_t *meta = &header->buffers[b];
+        uint32_t seq = __atomic_load_n(&meta->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            // Only happens if we sat on `active` through a whole publish; the next flip is imminent
+            sched_yield();
+            continue;
+        }
+        shm_buffer_meta_t copy = *meta;
+        // A torn count is caught by the sequence check below, but must not overrun the copy first
+        int count = copy.count < 0 ? 0 : (uint32_t)copy.count > sub->capacity ? (int)sub->capacity : copy.count;
+        if (count > snap->capacity) {
+            ProcessSample *grown = realloc(snap->samples, count * sizeof(ProcessSample));
+            if (!grown) return -1;
+            snap->samples = grown;
+            snap->capacity = count;
+        }
+        memcpy(snap->samples, sub->buffers[b], count * sizeof(ProcessSample));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&meta->seq, __ATOMIC_RELAXED) != seq) continue;
+        if (copy.count != count) return -1;
+
+        snap->count = count;
+        snap->reads = copy.reads;
+        snap->timestamp = copy.timestamp;
+        snap->uptime = copy.uptime;
+        snap->mem_total_kb = copy.mem_total_kb;
+        snap->frame = copy.frame;
+        return snap->count;
+    }
+    return -1;
+}
+
+void snapshot_unsubscribe(snapshot_subscriber_t *sub) {
+    if (!sub) return;
+    munmap(sub->header, sub->size);
+    free(sub);
+}
+
+static int daemon_source_take(ProcessSnapshot *snap, void *ctx) {
+    return snapshot_subscriber_read(ctx, snap);
+}
+
+static void daemon_source_describe(char *buf, size_t size, void *ctx) {
+    const snapshot_subscriber_t *sub = ctx;
+    if (sub->daemon_gone) {
+        snprintf(buf, size, "monitoring daemon (exited, detach to sample locally)");
+    } else {
+        // The daemon's header may be missing the terminator, so the field bounds the read
+        snprintf(buf, size, "%.*s via monitoring daemon PID %d, every %d ms",
+                 (int)sizeof(sub->header->scope), sub->header->scope, sub->header->daemon_pid, sub->header->interval_ms);
+    }
+}
+
+int snapshot_daemon_attach(void) {
+    if (attached) return 1;
+    attached = snapshot_subscribe(SNAPSHOT_SHM_NAME);
+    if (!attached) return 0;
+    SnapshotSource source = { daemon_source_take, daemon_source_describe, attached };
+    snapshot_set_source(&source);
+    return 1;
+}
+
+void snapshot_daemon_detach(void) {
+    if (!attached) return;
+    snapshot_set_source(NULL);
+    snapshot_unsubscribe(attached);
+    attached = NULL;
+}
+
+int snapshot_daemon_attached(void) {
+    return attached != NULL;
+}
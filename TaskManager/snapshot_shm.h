@@ -0,0 +1,91 @@
+#ifndef SNAPSHOT_SHM_H
+#define SNAPSHOT_SHM_H
+
+#include <sys/types.h>
+#include "proc_snapshot.h"
+
+#define SNAPSHOT_SHM_NAME "/taskmgr-snapshots"
+#define SNAPSHOT_SHM_MAX_PROCESSES 65536    // Per buffer; tmpfs only backs the pages a snapshot touches
+#define SNAPSHOT_SHM_MIN_INTERVAL_MS 250    // Leaves subscribers time to copy a buffer before it is rewritten
+
+typedef struct snapshot_publisher snapshot_publisher_t;
+typedef struct snapshot_subscriber snapshot_subscriber_t;
+
+/**
+ * Creates the shared-memory region snapshots are published to. A region
+ * left behind by a daemon that is no longer running is replaced.
+ * @param name POSIX shared-memory name, e.g. SNAPSHOT_SHM_NAME
+ * @param interval_ms Sampling interval advertised to subscribers
+ * @return The publisher, or NULL on failure (errno is set, EEXIST if a daemon is already publishing)
+ */
+snapshot_publisher_t *snapshot_publisher_open(const char *name, int interval_ms);
+
+/**
+ * Copies a snapshot into the buffer subscribers are not reading and then
+ * flips the active buffer. Costs the same however many subscribers there are.
+ * @param pub The publisher
+ * @param snap The snapshot
+ * @return Number of processes published (capped at SNAPSHOT_SHM_MAX_PROCESSES)
+ */
+int snapshot_publish(snapshot_publisher_t *pub, const ProcessSnapshot *snap);
+
+/**
+ * Updates the sampling interval advertised to subscribers
+ * @param pub The publisher
+ * @param interval_ms The interval the daemon currently samples at
+ */
+void snapshot_publisher_set_interval(snapshot_publisher_t *pub, int interval_ms);
+
+/**
+ * Returns the number of snapshots published so far
+ * @param pub The publisher
+ */
+unsigned long long snapshot_publisher_count(const snapshot_publisher_t *pub);
+
+/**
+ * Unlinks the region and frees the publisher
+ * @param pub The publisher
+ */
+void snapshot_publisher_close(snapshot_publisher_t *pub);
+
+/**
+ * Maps a published region read-only
+ * @param name POSIX shared-memory name
+ * @return The subscriber, or NULL if no compatible daemon is publishing
+ */
+snapshot_subscriber_t *snapshot_subscribe(const char *name);
+
+/**
+ * Copies the latest published buffer into a snapshot. The copy is checked
+ * against the buffer's sequence number and retried if the daemon rewrote
+ * the buffer meanwhile, so the rows are never torn and stay valid however
+ * long the caller keeps them.
+ * @param sub The subscriber
+ * @param snap Snapshot to fill; its buffer is reused and grown as needed
+ * @return Number of processes, -1 if the daemon has exited
+ */
+int snapshot_subscriber_read(snapshot_subscriber_t *sub, ProcessSnapshot *snap);
+
+/**
+ * Unmaps a region
+ * @param sub The subscriber
+ */
+void snapshot_unsubscribe(snapshot_subscriber_t *sub);
+
+/**
+ * Routes every view to the daemon's snapshots instead of /proc
+ * @return 1 if attached, 0 if no daemon is publishing
+ */
+int snapshot_daemon_attach(void);
+
+/**
+ * Goes back to sampling /proc in this process
+ */
+void snapshot_daemon_detach(void);
+
+/**
+ * Checks whether views currently read from the daemon
+ */
+int snapshot_daemon_attached(void);
+
+#endif
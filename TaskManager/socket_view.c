@@ -0,0 +1,600 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#endif
+#include "socket_view.h"
+#include "proc_snapshot.h"
+#include "overhead.h"
+#include "process_manager.h"
+
+#define SOCKET_REFRESH_MS 1000
+#define SOCKET_BUFFER_INITIAL 65536
+#define FD_CACHE_TTL 10             // Refreshes before an idle process has its fds walked again
+#define PROCESS_ROWS 10
+#define UNIX_ACCEPTCON 0x10000      // Listening flag in /proc/net/unix
+
+typedef enum { PROTO_TCP, PROTO_UDP, PROTO_UNIX, PROTO_COUNT } socket_proto_t;
+
+static const char *tcp_states[] = {"?", "ESTAB", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2",
+                                   "TIME_WAIT", "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING"};
+
+typedef struct {
+    unsigned char proto;            // socket_proto_t
+    unsigned char family;           // AF_INET, AF_INET6 or AF_UNIX
+    unsigned char state;            // TCP state number; UDP uses 1 connected, 7 unconnected
+    unsigned short local_port;
+    unsigned short remote_port;
+    unsigned char local[16];        // Network byte order, IPv4 in the first four bytes
+    unsigned char remote[16];
+    unsigned int rx_queue;
+    unsigned int tx_queue;
+    unsigned long inode;
+    int owner;                      // Index into the fd cache, -1 when no process in scope holds it
+    char path[64];                  // Unix socket path
+} socket_entry_t;
+
+// Socket inodes found in one process's fd table, reused while the process looks unchanged
+typedef struct {
+    pid_t pid;
+    unsigned long long starttime;
+    unsigned long long cpu_ticks;   // utime + stime when the fds were last walked
+    long fd_count;                  // st_size of /proc/<pid>/fd, the open fd count on newer kernels
+    unsigned long walked_frame;
+    int cached;                     // The fds have been walked at least once
+    unsigned long *inodes;
+    int inode_count;
+    int inode_capacity;
+    char command[64];
+    // Per refresh totals from the join
+    int sockets[PROTO_COUNT];
+    unsigned long rx_queue;
+    unsigned long tx_queue;
+} fd_cache_entry_t;
+
+typedef struct {
+    socket_entry_t *entries;
+    int count;
+    int capacity;
+    int from_diag;                  // Protocols served by sock_diag instead of /proc/net
+} socket_table_t;
+
+typedef struct {
+    fd_cache_entry_t *entries;
+    int count;
+    int capacity;
+    int walked;                     // Processes whose fds were read this refresh
+    unsigned long frame;            // Snapshot frame of the last refresh
+} fd_cache_t;
+
+// Open addressing map from socket inode to fd cache index; inode 0 marks an empty slot
+typedef struct {
+    unsigned long *keys;
+    int *values;
+    unsigned int mask;
+} inode_map_t;
+
+static char *file_buf;
+static size_t file_buf_size;
+
+static ssize_t read_whole_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    size_t len = 0;
+    while (1) {
+        if (len + 1 >= file_buf_size) {
+            size_t size = file_buf_size ? file_buf_size * 2 : SOCKET_BUFFER_INITIAL;
+            char *grown = realloc(file_buf, size);
+            if (!grown) break;
+            file_buf = grown;
+            file_buf_size = size;
+        }
+        ssize_t n = read(fd, file_buf + len, file_buf_size - len - 1);
+        if (n <= 0) break;
+        len += n;
+    }
+    close(fd);
+    if (file_buf) file_buf[len] = '\0';
+    return len;
+}
+
+static socket_entry_t *table_append(socket_table_t *table) {
+    if (table->count == table->capacity) {
+        int capacity = table->capacity ? table->capacity * 2 : 1024;
+        socket_entry_t *grown = realloc(table->entries, capacity * sizeof(socket_entry_t));
+        if (!grown) return NULL;
+        table->entries = grown;
+        table->capacity = capacity;
+    }
+    socket_entry_t *e = &table->entries[table->count++];
+    memset(e, 0, sizeof(*e));
+    e->owner = -1;
+    return e;
+}
+
+// Addresses are printed as the raw 32-bit words of the in-memory address
+static char *parse_address(char *p, unsigned char *addr, unsigned short *port, int family) {
+    int words = family == AF_INET6 ? 4 : 1;
+    for (int i = 0; i < words; i++) {
+        char chunk[9];
+        memcpy(chunk, p, 8);
+        chunk[8] = '\0';
+        uint32_t word = (uint32_t)strtoul(chunk, NULL, 16);
+        memcpy(addr + 4 * i, &word, 4);
+        p += 8;
+    }
+    if (*p == ':') p++;
+    *port = (unsigned short)strtoul(p, &p, 16);
+    return p;
+}
+
+static void parse_inet_table(socket_table_t *table, const char *path, socket_proto_t proto, int family) {
+    if (read_whole_file(path) <= 0) return;
+
+    char *line = strchr(file_buf, '\n');   // Skip the header
+    while (line && *++line) {
+        char *next = strchr(line, '\n');
+        char *p = strchr(line, ':');
+        if (!p) break;
+        socket_entry_t *e = table_append(table);
+        if (!e) break;
+        e->proto = proto;
+        e->family = family;
+        p = parse_address(p + 2, e->local, &e->local_port, family);
+        p = parse_address(p + 1, e->remote, &e->remote_port, family);
+        e->state = (unsigned char)strtoul(p, &p, 16);
+        e->tx_queue = (unsigned int)strtoul(p, &p, 16);
+        e->rx_queue = (unsigned int)strtoul(p + 1, &p, 16);
+        // tr:tm->when retrnsmt uid timeout inode
+        strtoul(p, &p, 16);
+        strtoul(p + 1, &p, 16);
+        strtoul(p, &p, 16);
+        strtoul(p, &p, 10);
+        strtoul(p, &p, 10);
+        e->inode = strtoul(p, &p, 10);
+        line = next;
+    }
+}
+
+static void parse_unix_table(socket_table_t *table) {
+    if (read_whole_file("/proc/net/unix") <= 0) return;
+
+    char *line = strchr(file_buf, '\n');
+    while (line && *++line) {
+        char *next = strchr(line, '\n');
+        if (next) *next = '\0';
+        unsigned long flags, inode;
+        unsigned int type, st;
+        int path_start = 0;
+        if (sscanf(line, "%*s %*s %*s %lx %x %x %lu %n", &flags, &type, &st, &inode, &path_start) >= 4) {
+            socket_entry_t *e = table_append(table);
+            if (!e) break;
+            e->proto = PROTO_UNIX;
+            e->family = AF_UNIX;
+            // Reuse the TCP state names: listening, connected or unconnected
+            e->state = flags & UNIX_ACCEPTCON ? 10 : st == 3 ? 1 : 7;
+            e->inode = inode;
+            if (path_start > 0) snprintf(e->path, sizeof(e->path), "%s", line + path_start);
+        }
+        line = next;
+    }
+}
+
+#ifdef __linux__
+/**
+ * Dumps one protocol/family through NETLINK_SOCK_DIAG, which skips the text
+ * formatting of /proc/net/tcp and is much cheaper with many sockets.
+ * @return 0 on success, -1 if the kernel lacks the diag module
+ */
+static int load_inet_diag(int diag_fd, socket_table_t *table, socket_proto_t proto, int family) {
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len = sizeof(request);
+    request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.req.sdiag_family = family;
+    request.req.sdiag_protocol = proto == PROTO_TCP ? IPPROTO_TCP : IPPROTO_UDP;
+    request.req.idiag_states = ~0U;
+
+    struct sockaddr_nl kernel = {.nl_family = AF_NETLINK};
+    if (sendto(diag_fd, &request, sizeof(request), 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0) return -1;
+
+    int start_count = table->count;
+    long buf[8192];
+    while (1) {
+        ssize_t len = recv(diag_fd, buf, sizeof(buf), 0);
+        if (len <= 0) break;
+        for (struct nlmsghdr *h = (struct nlmsghdr *)buf; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+            if (h->nlmsg_type == NLMSG_DONE) return 0;
+            if (h->nlmsg_type == NLMSG_ERROR) goto failed;
+
+            const struct inet_diag_msg *msg = NLMSG_DATA(h);
+            socket_entry_t *e = table_append(table);
+            if (!e) goto failed;
+            e->proto = proto;
+            e->family = family;
+            e->state = msg->idiag_state;
+            e->local_port = ntohs(msg->id.idiag_sport);
+            e->remote_port = ntohs(msg->id.idiag_dport);
+            memcpy(e->local, msg->id.idiag_src, 16);
+            memcpy(e->remote, msg->id.idiag_dst, 16);
+            e->rx_queue = msg->idiag_rqueue;
+            e->tx_queue = msg->idiag_wqueue;
+            e->inode = msg->idiag_inode;
+        }
+    }
+
+failed:
+    // Drop a partial dump so the /proc/net fallback does not list sockets twice
+    table->count = start_count;
+    return -1;
+}
+#endif
+
+static void load_sockets(socket_table_t *table, int diag_fd) {
+    static const struct { socket_proto_t proto; int family; const char *path; } inet_sources[] = {
+        {PROTO_TCP, AF_INET, "/proc/net/tcp"}, {PROTO_TCP, AF_INET6, "/proc/net/tcp6"},
+        {PROTO_UDP, AF_INET, "/proc/net/udp"}, {PROTO_UDP, AF_INET6, "/proc/net/udp6"},
+    };
+
+    table->count = 0;
+    table->from_diag = 0;
+    for (size_t i = 0; i < sizeof(inet_sources) / sizeof(inet_sources[0]); i++) {
+#ifdef __linux__
+        if (diag_fd >= 0 && load_inet_diag(diag_fd, table, inet_sources[i].proto, inet_sources[i].family) == 0) {
+            table->from_diag++;
+            continue;
+        }
+#endif
+        parse_inet_table(table, inet_sources[i].path, inet_sources[i].proto, inet_sources[i].family);
+    }
+    parse_unix_table(table);
+}
+
+static unsigned int hash_inode(unsigned long inode) {
+    return (unsigned int)((inode * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static int inode_map_build(inode_map_t *map, const fd_cache_t *cache) {
+    int total = 0;
+    for (int i = 0; i < cache->count; i++) total += cache->entries[i].inode_count;
+
+    unsigned int capacity = 64;
+    while (capacity < (unsigned int)total * 2) capacity *= 2;
+    if (capacity - 1 != map->mask || !map->keys) {
+        free(map->keys);
+        free(map->values);
+        map->keys = malloc(capacity * sizeof(unsigned long));
+        map->values = malloc(capacity * sizeof(int));
+        map->mask = capacity - 1;
+        if (!map->keys || !map->values) return -1;
+    }
+    memset(map->keys, 0, capacity * sizeof(unsigned long));
+
+    // A socket shared across fork stays with the lowest PID holding it
+    for (int i = 0; i < cache->count; i++) {
+        const fd_cache_entry_t *c = &cache->entries[i];
+        for (int j = 0; j < c->inode_count; j++) {
+            unsigned int slot = hash_inode(c->inodes[j]) & map->mask;
+            while (map->keys[slot] && map->keys[slot] != c->inodes[j]) slot = (slot + 1) & map->mask;
+            if (!map->keys[slot]) {
+                map->keys[slot] = c->inodes[j];
+                map->values[slot] = i;
+            }
+        }
+    }
+    return 0;
+}
+
+static int inode_map_find(const inode_map_t *map, unsigned long inode) {
+    if (inode == 0) return -1;
+    unsigned int slot = hash_inode(inode) & map->mask;
+    while (map->keys[slot]) {
+        if (map->keys[slot] == inode) return map->values[slot];
+        slot = (slot + 1) & map->mask;
+    }
+    return -1;
+}
+
+static void walk_fds(fd_cache_entry_t *c) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/fd", c->pid);
+    c->inode_count = 0;
+    DIR *dir = opendir(path);
+    if (!dir) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        char link[64];
+        ssize_t len = readlinkat(dirfd(dir), entry->d_name, link, sizeof(link) - 1);
+        if (len < 9 || strncmp(link, "socket:[", 8) != 0) continue;
+        link[len] = '\0';
+
+        if (c->inode_count == c->inode_capacity) {
+            int capacity = c->inode_capacity ? c->inode_capacity * 2 : 8;
+            unsigned long *grown = realloc(c->inodes, capacity * sizeof(unsigned long));
+            if (!grown) break;
+            c->inodes = grown;
+            c->inode_capacity = capacity;
+        }
+        c->inodes[c->inode_count++] = strtoul(link + 8, NULL, 10);
+    }
+    closedir(dir);
+}
+
+// Linux 6.2+ reports the open fd count as the size of /proc/<pid>/fd; older kernels report 0
+static int fd_count_reported(void) {
+    static int reported = -1;
+    if (reported < 0) {
+        struct stat st;
+        reported = stat("/proc/self/fd", &st) == 0 && st.st_size > 0;
+    }
+    return reported;
+}
+
+/**
+ * Rebuilds the fd cache in snapshot order. A process keeps its cached
+ * socket inodes unless it is new, used CPU, changed its fd count or has
+ * not been walked for FD_CACHE_TTL refreshes: an idle process cannot
+ * have opened or closed anything. CPU time only moves in clock ticks, so
+ * a short burst can still slip by; rows owned through a cached table are
+ * marked. Without fd counts (kernels before 6.2) every table is walked.
+ */
+static void refresh_fd_cache(fd_cache_t *cache, const ProcessSnapshot *snap) {
+    fd_cache_entry_t *entries = calloc(snap->count ? snap->count : 1, sizeof(fd_cache_entry_t));
+    if (!entries) return;
+
+    int old = 0;
+    unsigned long ttl = fd_count_reported() ? FD_CACHE_TTL : 1;
+    cache->walked = 0;
+    cache->frame = snap->frame;
+    for (int i = 0; i < snap->count; i++) {
+        const ProcessSample *s = &snap->samples[i];
+        fd_cache_entry_t *c = &entries[i];
+        while (old < cache->count && cache->entries[old].pid < s->pid) {
+            free(cache->entries[old++].inodes);
+        }
+        if (old < cache->count && cache->entries[old].pid == s->pid && cache->entries[old].starttime == s->starttime) {
+            *c = cache->entries[old++];
+        } else {
+            if (old < cache->count && cache->entries[old].pid == s->pid) free(cache->entries[old++].inodes);
+            c->pid = s->pid;
+            c->starttime = s->starttime;
+        }
+        snprintf(c->command, sizeof(c->command), "%s", s->command);
+
+        char path[64];
+        struct stat st;
+        snprintf(path, sizeof(path), "/proc/%d/fd", s->pid);
+        long fd_count = stat(path, &st) == 0 ? (long)st.st_size : 0;
+        unsigned long long ticks = s->utime + s->stime;
+
+        if (!c->cached || ticks != c->cpu_ticks || fd_count != c->fd_count ||
+            snap->frame - c->walked_frame >= ttl) {
+            walk_fds(c);
+            c->cpu_ticks = ticks;
+            c->fd_count = fd_count;
+            c->walked_frame = snap->frame;
+            c->cached = 1;
+            cache->walked++;
+        }
+    }
+    while (old < cache->count) free(cache->entries[old++].inodes);
+
+    free(cache->entries);
+    cache->entries = entries;
+    cache->count = snap->count;
+    cache->capacity = snap->count;
+}
+
+static void format_endpoint(const socket_entry_t *e, int remote, char *buf, size_t size) {
+    if (e->family == AF_UNIX) {
+        snprintf(buf, size, "%s", remote ? "" : e->path[0] ? e->path : "(unnamed)");
+        return;
+    }
+    char host[INET6_ADDRSTRLEN];
+    inet_ntop(e->family, remote ? e->remote : e->local, host, sizeof(host));
+    unsigned short port = remote ? e->remote_port : e->local_port;
+    if (e->family == AF_INET6) {
+        snprintf(buf, size, "[%s]:%u", host, port);
+    } else {
+        snprintf(buf, size, "%s:%u", host, port);
+    }
+}
+
+static const char *state_name(const socket_entry_t *e) {
+    if (e->proto != PROTO_TCP) return e->state == 10 ? "LISTEN" : e->state == 1 ? "CONN" : "UNCONN";
+    return e->state < sizeof(tcp_states) / sizeof(tcp_states[0]) ? tcp_states[e->state] : "?";
+}
+
+static const char *proto_name(const socket_entry_t *e) {
+    if (e->proto == PROTO_UNIX) return "unix";
+    if (e->proto == PROTO_TCP) return e->family == AF_INET6 ? "tcp6" : "tcp";
+    return e->family == AF_INET6 ? "udp6" : "udp";
+}
+
+static int compare_processes(const void *a, const void *b) {
+    const fd_cache_entry_t *ca = *(fd_cache_entry_t *const *)a, *cb = *(fd_cache_entry_t *const *)b;
+    unsigned long qa = ca->rx_queue + ca->tx_queue, qb = cb->rx_queue + cb->tx_queue;
+    if (qa != qb) return (qa < qb) - (qa > qb);
+    int sa = ca->sockets[PROTO_TCP] + ca->sockets[PROTO_UDP] + ca->sockets[PROTO_UNIX];
+    int sb = cb->sockets[PROTO_TCP] + cb->sockets[PROTO_UDP] + cb->sockets[PROTO_UNIX];
+    return sb - sa;
+}
+
+static int compare_queues(const void *a, const void *b) {
+    const socket_entry_t *ea = *(socket_entry_t *const *)a, *eb = *(socket_entry_t *const *)b;
+    unsigned long qa = ea->rx_queue + (unsigned long)ea->tx_queue, qb = eb->rx_queue + (unsigned long)eb->tx_queue;
+    if (qa != qb) return (qa < qb) - (qa > qb);
+    // Listeners next, so the ports a host serves show up even when queues are empty
+    return (eb->state == 10) - (ea->state == 10);
+}
+
+static int socket_visible(const socket_entry_t *e, int port, int scoped) {
+    if (scoped && e->owner < 0) return 0;
+    if (port > 0 && e->local_port != port && e->remote_port != port) return 0;
+    return 1;
+}
+
+static void render_sockets(socket_table_t *table, fd_cache_t *cache, int port) {
+    int scoped = snapshot_get_scope()->type != SCOPE_ALL;
+    int totals[PROTO_COUNT] = {0}, listening = 0, established = 0, unowned = 0;
+
+    double start = overhead_clock();
+    socket_entry_t **visible = malloc((table->count ? table->count : 1) * sizeof(socket_entry_t *));
+    fd_cache_entry_t **owners = malloc((cache->count ? cache->count : 1) * sizeof(fd_cache_entry_t *));
+    if (!visible || !owners) {
+        free(visible);
+        free(owners);
+        return;
+    }
+
+    int shown = 0, owner_count = 0;
+    for (int i = 0; i < table->count; i++) {
+        socket_entry_t *e = &table->entries[i];
+        if (!socket_visible(e, port, scoped)) continue;
+        visible[shown++] = e;
+        totals[e->proto]++;
+        if (e->state == 10) listening++;
+        if (e->proto == PROTO_TCP && e->state == 1) established++;
+        if (e->owner < 0) {
+            unowned++;
+            continue;
+        }
+        fd_cache_entry_t *c = &cache->entries[e->owner];
+        if (c->sockets[0] + c->sockets[1] + c->sockets[2] == 0) owners[owner_count++] = c;
+        c->sockets[e->proto]++;
+        c->rx_queue += e->rx_queue;
+        c->tx_queue += e->tx_queue;
+    }
+    qsort(owners, owner_count, sizeof(fd_cache_entry_t *), compare_processes);
+    qsort(visible, shown, sizeof(socket_entry_t *), compare_queues);
+    overhead_record(PHASE_SORT, start);
+
+    printf("\033[2J\033[H");
+    printf("===== Sockets =====\n");
+    char scope[600];
+    snapshot_describe_scope(scope, sizeof(scope));
+    printf("Scope: %s", scope);
+    if (port > 0) printf(" | port %d", port);
+    printf("\n%d sockets: tcp %d (%d listening, %d established), udp %d, unix %d | %d without an owner in scope\n",
+           shown, totals[PROTO_TCP], listening, established, totals[PROTO_UDP], totals[PROTO_UNIX], unowned);
+    printf("Source: %s | fd tables walked this refresh: %d of %d processes%s\n",
+           table->from_diag == 4 ? "sock_diag netlink" : table->from_diag ? "sock_diag + /proc/net" : "/proc/net",
+           cache->walked, cache->count,
+           fd_count_reported() ? " | ~ owner from a cached fd table" : " (no fd counts on this kernel, all walked)");
+
+    printf("\n%8s %-16s %6s %6s %6s %6s %10s %10s\n", "PID", "COMMAND", "SOCKS", "TCP", "UDP", "UNIX", "RECV-Q", "SEND-Q");
+    for (int i = 0; i < owner_count && i < PROCESS_ROWS; i++) {
+        const fd_cache_entry_t *c = owners[i];
+        printf("%8d %-16.16s %6d %6d %6d %6d %10lu %10lu\n", c->pid, c->command,
+               c->sockets[PROTO_TCP] + c->sockets[PROTO_UDP] + c->sockets[PROTO_UNIX],
+               c->sockets[PROTO_TCP], c->sockets[PROTO_UDP], c->sockets[PROTO_UNIX], c->rx_queue, c->tx_queue);
+    }
+    if (owner_count > PROCESS_ROWS) printf("  ... %d more processes\n", owner_count - PROCESS_ROWS);
+
+    int rows = terminal_rows() - PROCESS_ROWS - 14;
+    if (rows < 5) rows = 5;
+    printf("\n%-5s %-10s %8s %8s %-30s %-30s %s\n", "PROTO", "STATE", "RECV-Q", "SEND-Q", "LOCAL", "REMOTE", "PID/COMMAND");
+    for (int i = 0; i < shown && i < rows; i++) {
+        const socket_entry_t *e = visible[i];
+        char local[64], remote[64], owner[16 + sizeof(cache->entries[0].command)] = "-";
+        format_endpoint(e, 0, local, sizeof(local));
+        format_endpoint(e, 1, remote, sizeof(remote));
+        if (e->owner >= 0) {
+            const fd_cache_entry_t *c = &cache->entries[e->owner];
+            snprintf(owner, sizeof(owner), "%s%d/%s", c->walked_frame != cache->frame ? "~" : "", c->pid, c->command);
+        }
+        printf("%-5s %-10s %8u %8u %-30.30s %-30.30s %s\n", proto_name(e), state_name(e),
+               e->rx_queue, e->tx_queue, local, remote, owner);
+    }
+
+    free(visible);
+    free(owners);
+}
+
+void show_socket_view(void) {
+    if (!snapshot_supported()) {
+        printf("The socket view needs /proc (Linux only)\n");
+        return;
+    }
+
+    char input[32];
+    int port = 0;
+    printf("Show only sockets on port (Enter for all): ");
+    if (fgets(input, sizeof(input), stdin) != NULL) port = atoi(input);
+
+    int diag_fd = -1;
+#ifdef __linux__
+    diag_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+#endif
+
+    socket_table_t table = {0};
+    fd_cache_t cache = {0};
+    inode_map_t map = {0};
+    ProcessSnapshot snaps[2] = {{0}, {0}};
+    int cur = 0;
+
+    overhead_begin(SOCKET_REFRESH_MS);
+    int interval = SOCKET_REFRESH_MS;
+    while (snapshot_take(&snaps[cur], snaps[cur ^ 1].samples ? &snaps[cur ^ 1] : NULL) >= 0) {
+        double start = overhead_clock();
+        refresh_fd_cache(&cache, &snaps[cur]);
+        overhead_record(PHASE_ENUMERATE, start);
+
+        start = overhead_clock();
+        load_sockets(&table, diag_fd);
+        overhead_record(PHASE_READ, start);
+
+        start = overhead_clock();
+        if (inode_map_build(&map, &cache) == 0) {
+            for (int i = 0; i < table.count; i++) {
+                table.entries[i].owner = inode_map_find(&map, table.entries[i].inode);
+            }
+        }
+        for (int i = 0; i < cache.count; i++) {
+            memset(cache.entries[i].sockets, 0, sizeof(cache.entries[i].sockets));
+            cache.entries[i].rx_queue = cache.entries[i].tx_queue = 0;
+        }
+        overhead_record(PHASE_PARSE, start);
+
+        start = overhead_clock();
+        render_sockets(&table, &cache, port);
+        overhead_record(PHASE_RENDER, start);
+        interval = overhead_end_frame();
+        printf("\n");
+        overhead_print_status();
+        printf("Press Enter to return\n");
+        fflush(stdout);
+
+        if (wait_for_refresh(interval)) break;
+        cur ^= 1;
+    }
+
+    if (diag_fd >= 0) close(diag_fd);
+    for (int i = 0; i < cache.count; i++) free(cache.entries[i].inodes);
+    free(cache.entries);
+    free(table.entries);
+    free(map.keys);
+    free(map.values);
+    free(file_buf);
+    file_buf = NULL;
+    file_buf_size = 0;
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+}
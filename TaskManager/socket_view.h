@@ -0,0 +1,11 @@
+#ifndef SOCKET_VIEW_H
+#define SOCKET_VIEW_H
+
+/**
+ * Live view of TCP, UDP and unix sockets joined to their owning processes
+ * by inode. Shows per-process socket counts with summed Recv-Q/Send-Q and
+ * the sockets with the deepest queues, optionally filtered by port.
+ */
+void show_socket_view(void);
+
+#endif
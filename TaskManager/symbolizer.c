@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include "symbolizer.h"
+
+#ifdef __linux__
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SYM_CACHE_SIZE 8192     // Direct-mapped address -> name cache, power of two
+#define MAX_LOAD_SEGMENTS 16
+
+typedef struct {
+    uint64_t value;
+    uint64_t size;
+    const char *name;           // Points into the mapped string table
+} elf_symbol_t;
+
+typedef struct {
+    char path[PATH_MAX];
+    char module_name[128];      // "[libc.so.6]", used when no symbol matches
+    void *map;
+    size_t map_size;
+    elf_symbol_t *symbols;
+    int symbol_count;
+    struct {
+        uint64_t offset;
+        uint64_t vaddr;
+        uint64_t filesz;
+    } loads[MAX_LOAD_SEGMENTS];
+    int load_count;
+} elf_image_t;
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint64_t pgoff;
+    int image;                  // Index into images, -1 for anonymous memory
+} mapping_t;
+
+typedef struct {
+    uint64_t addr;
+    const char *name;
+} cache_entry_t;
+
+struct symbolizer {
+    pid_t pid;
+    mapping_t *maps;
+    int map_count;
+    elf_image_t **images;       // Pointers so names stay put when the array grows
+    int image_count;
+    int image_capacity;
+    cache_entry_t cache[SYM_CACHE_SIZE];
+};
+
+static int compare_symbols(const void *a, const void *b) {
+    const elf_symbol_t *sa = a, *sb = b;
+    return (sa->value > sb->value) - (sa->value < sb->value);
+}
+
+// Loads the function symbols and PT_LOAD segments of a 64-bit ELF file
+static void load_elf_image(elf_image_t *image, pid_t pid) {
+    int fd = open(image->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        // The file may live in another mount namespace (containers)
+        char root_path[PATH_MAX + 32];
+        snprintf(root_path, sizeof(root_path), "/proc/%d/root%s", pid, image->path);
+        fd = open(root_path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(Elf64_Ehdr)) {
+        close(fd);
+        return;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return;
+
+    const Elf64_Ehdr *ehdr = map;
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr->e_shoff == 0 || ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) > (uint64_t)st.st_size ||
+        ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Elf64_Phdr) > (uint64_t)st.st_size) {
+        munmap(map, st.st_size);
+        return;
+    }
+
+    image->map = map;
+    image->map_size = st.st_size;
+
+    const Elf64_Phdr *phdr = (const Elf64_Phdr *)((const char *)map + ehdr->e_phoff);
+    for (int i = 0; i < ehdr->e_phnum && image->load_count < MAX_LOAD_SEGMENTS; i++) {
+        if (phdr[i].p_type != PT_LOAD) continue;
+        image->loads[image->load_count].offset = phdr[i].p_offset;
+        image->loads[image->load_count].vaddr = phdr[i].p_vaddr;
+        image->loads[image->load_count].filesz = phdr[i].p_filesz;
+        image->load_count++;
+    }
+
+    // Prefer the full .symtab, stripped binaries only have .dynsym
+    const Elf64_Shdr *shdr = (const Elf64_Shdr *)((const char *)map + ehdr->e_shoff);
+    const Elf64_Shdr *symtab = NULL;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (shdr[i].sh_type == SHT_SYMTAB) {
+            symtab = &shdr[i];
+            break;
+        }
+        if (shdr[i].sh_type == SHT_DYNSYM && symtab == NULL) {
+            symtab = &shdr[i];
+        }
+    }
+    if (!symtab || symtab->sh_link >= ehdr->e_shnum ||
+        symtab->sh_offset + symtab->sh_size > (uint64_t)st.st_size) {
+        return;
+    }
+
+    const Elf64_Shdr *strtab = &shdr[symtab->sh_link];
+    if (strtab->sh_offset + strtab->sh_size > (uint64_t)st.st_size) return;
+
+    const Elf64_Sym *syms = (const Elf64_Sym *)((const char *)map + symtab->sh_offset);
+    const char *strings = (const char *)map + strtab->sh_offset;
+    size_t count = symtab->sh_size / sizeof(Elf64_Sym);
+
+    image->symbols = malloc(count * sizeof(elf_symbol_t));
+    if (!image->symbols) return;
+
+    for (size_t i = 0; i < count; i++) {
+        if (ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC || syms[i].st_value == 0) continue;
+        if (syms[i].st_name >= strtab->sh_size) continue;
+        elf_symbol_t *sym = &image->symbols[image->symbol_count++];
+        sym->value = syms[i].st_value;
+        sym->size = syms[i].st_size;
+        sym->name = strings + syms[i].st_name;
+    }
+    qsort(image->symbols, image->symbol_count, sizeof(elf_symbol_t), compare_symbols);
+}
+
+// Returns the index of the image for path, loading it on first use
+static int find_or_load_image(symbolizer_t *sym, const char *path) {
+    for (int i = 0; i < sym->image_count; i++) {
+        if (strcmp(sym->images[i]->path, path) == 0) return i;
+    }
+
+    if (sym->image_count == sym->image_capacity) {
+        int capacity = sym->image_capacity ? sym->image_capacity * 2 : 32;
+        elf_image_t **grown = realloc(sym->images, capacity * sizeof(elf_image_t *));
+        if (!grown) return -1;
+        sym->images = grown;
+        sym->image_capacity = capacity;
+    }
+
+    elf_image_t *image = calloc(1, sizeof(elf_image_t));
+    if (!image) return -1;
+    sym->images[sym->image_count] = image;
+    snprintf(image->path, sizeof(image->path), "%s", path);
+    const char *base = strrchr(path, '/');
+    snprintf(image->module_name, sizeof(image->module_name), "[%s]", base ? base + 1 : path);
+
+    if (path[0] == '/') {
+        load_elf_image(image, sym->pid);
+    }
+    return sym->image_count++;
+}
+
+void symbolizer_refresh(symbolizer_t *sym) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/maps", sym->pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+
+    int capacity = sym->map_count > 0 ? sym->map_count : 256;
+    mapping_t *maps = malloc(capacity * sizeof(mapping_t));
+    int count = 0;
+    char line[PATH_MAX + 128];
+
+    while (maps && fgets(line, sizeof(line), fp)) {
+        unsigned long long start, end, pgoff;
+        char perms[8];
+        int name_pos = 0;
+        if (sscanf(line, "%llx-%llx %7s %llx %*s %*s %n", &start, &end, &perms[0], &pgoff, &name_pos) < 4) {
+            continue;
+        }
+        if (perms[2] != 'x') continue; // Only executable mappings hold code
+
+        char *name = line + name_pos;
+        name[strcspn(name, "\n")] = '\0';
+
+        if (count == capacity) {
+            mapping_t *grown = realloc(maps, capacity * 2 * sizeof(mapping_t));
+            if (!grown) break;
+            maps = grown;
+            capacity *= 2;
+        }
+        maps[count].start = start;
+        maps[count].end = end;
+        maps[count].pgoff = pgoff;
+        maps[count].image = name[0] ? find_or_load_image(sym, name) : -1;
+        count++;
+    }
+    fclose(fp);
+
+    if (maps) {
+        free(sym->maps);
+        sym->maps = maps;
+        sym->map_count = count;
+        // Mappings may have moved, cached answers are no longer trustworthy
+        memset(sym->cache, 0, sizeof(sym->cache));
+    }
+}
+
+symbolizer_t *symbolizer_create(pid_t pid) {
+    symbolizer_t *sym = calloc(1, sizeof(symbolizer_t));
+    if (!sym) return NULL;
+    sym->pid = pid;
+
+    symbolizer_refresh(sym);
+    if (sym->maps == NULL) {
+        symbolizer_destroy(sym);
+        return NULL;
+    }
+    return sym;
+}
+
+static const char *resolve_address(symbolizer_t *sym, uint64_t addr) {
+    const mapping_t *map = NULL;
+    int lo = 0, hi = sym->map_count - 1;
+
+    // /proc/<pid>/maps is sorted by start address
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (addr < sym->maps[mid].start) {
+            hi = mid - 1;
+        } else if (addr >= sym->maps[mid].end) {
+            lo = mid + 1;
+        } else {
+            map = &sym->maps[mid];
+            break;
+        }
+    }
+    if (!map || map->image < 0) return "[unknown]";
+
+    elf_image_t *image = sym->images[map->image];
+    if (image->symbol_count == 0) return image->module_name;
+
+    // Translate the runtime address to the ELF virtual address
+    uint64_t file_offset = addr - map->start + map->pgoff;
+    uint64_t vaddr = 0;
+    int found = 0;
+    for (int i = 0; i < image->load_count; i++) {
+        if (file_offset >= image->loads[i].offset &&
+            file_offset < image->loads[i].offset + image->loads[i].filesz) {
+            vaddr = file_offset - image->loads[i].offset + image->loads[i].vaddr;
+            found = 1;
+            break;
+        }
+    }
+    if (!found) return image->module_name;
+
+    // Last symbol starting at or before vaddr
+    lo = 0;
+    hi = image->symbol_count - 1;
+    int best = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (image->symbols[mid].value <= vaddr) {
+            best = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (best < 0) return image->module_name;
+
+    const elf_symbol_t *s = &image->symbols[best];
+    if (s->size != 0 && vaddr >= s->value + s->size) return image->module_name;
+    return s->name;
+}
+
+const char *symbolizer_lookup(symbolizer_t *sym, uint64_t addr) {
+    if (!sym) return "[unknown]";
+
+    cache_entry_t *entry = &sym->cache[(addr >> 2) & (SYM_CACHE_SIZE - 1)];
+    if (entry->name && entry->addr == addr) {
+        return entry->name;
+    }
+
+    entry->addr = addr;
+    entry->name = resolve_address(sym, addr);
+    return entry->name;
+}
+
+void symbolizer_destroy(symbolizer_t *sym) {
+    if (!sym) return;
+    for (int i = 0; i < sym->image_count; i++) {
+        if (sym->images[i]->map) munmap(sym->images[i]->map, sym->images[i]->map_size);
+        free(sym->images[i]->symbols);
+        free(sym->images[i]);
+    }
+    free(sym->images);
+    free(sym->maps);
+    free(sym);
+}
+
+#else
+
+symbolizer_t *symbolizer_create(pid_t pid) {
+    (void)pid;
+    return NULL;
+}
+
+void symbolizer_refresh(symbolizer_t *sym) {
+    (void)sym;
+}
+
+const char *symbolizer_lookup(symbolizer_t *sym, uint64_t addr) {
+    (void)sym;
+    (void)addr;
+    return "[unknown]";
+}
+
+void symbolizer_destroy(symbolizer_t *sym) {
+    (void)sym;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SYMBOLIZER_H
+#define SYMBOLIZER_H
+
+#include <sys/types.h>
+#include <stdint.h>
+
+// Resolves user-space addresses of one process to function names using the
+// ELF symbol tables of its mapped files. Opaque; see symbolizer.c.
+typedef struct symbolizer symbolizer_t;
+
+/**
+ * Creates a symbolizer for a process by reading /proc/<pid>/maps
+ * @param pid The process ID
+ * @return New symbolizer, or NULL if the process maps cannot be read
+ */
+symbolizer_t *symbolizer_create(pid_t pid);
+
+/**
+ * Re-reads /proc/<pid>/maps so libraries loaded later are resolvable
+ * @param sym The symbolizer
+ */
+void symbolizer_refresh(symbolizer_t *sym);
+
+/**
+ * Resolves an address to a function name. Results are cached per address.
+ * @param sym The symbolizer
+ * @param addr User-space instruction address
+ * @return Function name, "[module]" if the module has no matching symbol,
+ *         or "[unknown]". The string stays valid until symbolizer_destroy.
+ */
+const char *symbolizer_lookup(symbolizer_t *sym, uint64_t addr);
+
+/**
+ * Releases the symbolizer, its mapped ELF images and its cache
+ * @param sym The symbolizer
+ */
+void symbolizer_destroy(symbolizer_t *sym);
+
+#endif
@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "taskmgr.h"
+#include "proc_snapshot.h"
+#include "proc_filter.h"
+#include "scheduler.h"
+
+struct tm_snapshot {
+    ProcessSnapshot snap;
+};
+
+_Static_assert(TM_COMMAND_MAX == sizeof(((ProcessSample *)0)->command), "command size mismatch");
+_Static_assert(TM_USER_MAX == sizeof(((ProcessSample *)0)->username), "username size mismatch");
+_Static_assert(TM_SCHED_MAX_TASKS == MAX_SCHEDULED_TASKS, "task table size mismatch");
+_Static_assert(TM_TASK_COMMAND_MAX == sizeof(((scheduled_task_t *)0)->command), "task command size mismatch");
+_Static_assert((int)TM_SCOPE_ALL == SCOPE_ALL && (int)TM_SCOPE_USER == SCOPE_USER &&
+               (int)TM_SCOPE_CGROUP == SCOPE_CGROUP && (int)TM_SCOPE_SUBTREE == SCOPE_SUBTREE,
+               "scope types out of sync");
+_Static_assert((int)TM_SCHED_ONCE == ONCE && (int)TM_SCHED_INTERVAL == INTERVAL && (int)TM_SCHED_DAILY == DAILY,
+               "schedule types out of sync");
+
+static void copy_process(const ProcessSample *s, tm_process_t *out) {
+    long ticks = sysconf(_SC_CLK_TCK);
+
+    out->pid = s->pid;
+    out->ppid = s->ppid;
+    out->uid = s->uid;
+    out->state = s->state;
+    memcpy(out->command, s->command, sizeof(out->command));
+    memcpy(out->user, s->username, sizeof(out->user));
+    out->cpu_percent = s->cpu_percent;
+    out->mem_percent = s->mem_percent;
+    out->rss_kb = s->rss_kb;
+    out->vsize_kb = s->vsize_kb;
+    out->minflt = s->minflt;
+    out->majflt = s->majflt;
+    out->threads = s->threads;
+    out->cpu_seconds = (double)(s->utime + s->stime) / ticks;
+    out->start_seconds = (double)s->starttime / ticks;
+}
+
+int tm_set_scope(const tm_scope_t *scope) {
+    if (!scope || scope->type == TM_SCOPE_ALL) {
+        snapshot_set_scope(NULL);
+        return 0;
+    }
+
+    SampleScope next;
+    memset(&next, 0, sizeof(next));
+    next.type = (scope_type_t)scope->type;
+    switch (scope->type) {
+        case TM_SCOPE_USER:
+            next.uid = scope->uid;
+            break;
+        case TM_SCOPE_CGROUP:
+            if (!scope->cgroup) {
+                errno = EINVAL;
+                return -1;
+            }
+            if (strlen(scope->cgroup) >= sizeof(next.cgroup_path)) {
+                errno = ENAMETOOLONG;
+                return -1;
+            }
+            strcpy(next.cgroup_path, scope->cgroup);
+            break;
+        case TM_SCOPE_SUBTREE:
+            if (scope->root_pid <= 0) {
+                errno = EINVAL;
+                return -1;
+            }
+            next.root_pid = scope->root_pid;
+            break;
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    snapshot_set_scope(&next);
+    return 0;
+}
+
+tm_snapshot_t *tm_snapshot_take(const tm_snapshot_t *previous) {
+    tm_snapshot_t *snapshot = calloc(1, sizeof(tm_snapshot_t));
+    if (!snapshot) return NULL;
+    if (tm_snapshot_refresh(snapshot, previous) < 0) {
+        tm_snapshot_free(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+int tm_snapshot_refresh(tm_snapshot_t *snap, const tm_snapshot_t *previous) {
+    if (snapshot_take(&snap->snap, previous ? &previous->snap : NULL) < 0) {
+        snap->snap.count = 0;
+        return -1;
+    }
+    return snap->snap.count;
+}
+
+int tm_snapshot_count(const tm_snapshot_t *snap) {
+    return snap->snap.count;
+}
+
+double tm_snapshot_time(const tm_snapshot_t *snap) {
+    return snap->snap.timestamp;
+}
+
+int tm_snapshot_find(const tm_snapshot_t *snap, pid_t pid, tm_process_t *out) {
+    const ProcessSample *s = snapshot_find(&snap->snap, pid);
+    if (!s) return 0;
+    copy_process(s, out);
+    return 1;
+}
+
+void tm_snapshot_free(tm_snapshot_t *snap) {
+    if (!snap) return;
+    snapshot_free(&snap->snap);
+    free(snap);
+}
+
+void tm_snapshot_iter(tm_iter_t *it, const tm_snapshot_t *snap, tm_filter_t *filter) {
+    filter_prepare(filter, &snap->snap);
+    it->snap = snap;
+    it->filter = filter;
+    it->next = 0;
+}
+
+int tm_iter_next(tm_iter_t *it, tm_process_t *out) {
+    const ProcessSnapshot *snap = &it->snap->snap;
+    while (it->next < snap->count) {
+        int i = it->next++;
+        if (filter_match(it->filter, snap, i)) {
+            copy_process(&snap->samples[i], out);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+tm_filter_t *tm_filter_compile(const char *text, char *error, size_t error_size) {
+    return filter_compile(text, error, error_size);
+}
+
+void tm_filter_free(tm_filter_t *filter) {
+    filter_free(filter);
+}
+
+// Signals a sampled process only while its PID still names it. A pidfd pins the
+// process between the check and the signal; without one a short window remains.
+static int signal_sample(const ProcessSample *s, int sig) {
+#if defined(SYS_pidfd_open) && defined(SYS_pidfd_send_signal)
+    int fd = syscall(SYS_pidfd_open, s->pid, 0);
+    if (fd >= 0) {
+        int result = -1;
+        if (snapshot_still_running(s)) result = syscall(SYS_pidfd_send_signal, fd, sig, NULL, 0);
+        else errno = ESRCH;
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return result;
+    }
+    if (errno != ENOSYS) return -1;
+#endif
+    if (!snapshot_still_running(s)) {
+        errno = ESRCH;
+        return -1;
+    }
+    return kill(s->pid, sig);
+}
+
+int tm_signal_group(const tm_snapshot_t *snap, tm_filter_t *filter, int sig, int *failed) {
+    if (failed) *failed = 0;
+    if (!filter) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const ProcessSnapshot *s = &snap->snap;
+    pid_t self = getpid();
+    int signalled = 0;
+    filter_prepare(filter, s);
+    for (int i = 0; i < s->count; i++) {
+        if (s->samples[i].pid == self || !filter_match(filter, s, i)) continue;
+        if (signal_sample(&s->samples[i], sig) == 0) {
+            signalled++;
+        } else if (failed) {
+            (*failed)++;
+        }
+    }
+    return signalled;
+}
+
+int tm_sched_add(const char *command, tm_sched_type_t type, time_t first_run, int interval_seconds) {
+    if (type == TM_SCHED_DAILY) interval_seconds = 24 * 60 * 60;
+    int id = add_scheduled_task(command, (schedule_type_t)type, first_run, interval_seconds);
+    if (id < 0) return -1;
+    run_task_scheduler();
+    return id;
+}
+
+int tm_sched_remove(int id) {
+    return remove_scheduled_task(id);
+}
+
+int tm_sched_list(tm_task_t *tasks, int max) {
+    scheduled_task_t table[MAX_SCHEDULED_TASKS];
+    int count = get_scheduled_tasks(table, MAX_SCHEDULED_TASKS);
+    for (int i = 0; i < count && i < max && i < MAX_SCHEDULED_TASKS; i++) {
+        tasks[i].id = table[i].id;
+        memcpy(tasks[i].command, table[i].command, sizeof(tasks[i].command));
+        tasks[i].type = (tm_sched_type_t)table[i].type;
+        tasks[i].next_run = table[i].execution_time;
+        tasks[i].interval_seconds = table[i].interval_seconds;
+        tasks[i].active = table[i].is_active;
+        tasks[i].last_pid = table[i].last_pid;
+    }
+    return count;
+}
+
+void tm_sched_stop(void) {
+    stop_task_scheduler();
+}
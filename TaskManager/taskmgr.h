@@ -0,0 +1,217 @@
+#ifndef TASKMGR_H
+#define TASKMGR_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <time.h>
+
+/*
+ * Embedding API of libtaskmgr. Everything returned here is plain data owned
+ * by the caller; nothing is printed. Neither library replaces the host's
+ * allocator.
+ *
+ * The sampler keeps process-wide state (the open /proc directory stream,
+ * the uid-to-name cache and the scope set with tm_set_scope), so the
+ * tm_snapshot_*, tm_iter_*, tm_signal_group and tm_set_scope calls must
+ * come from one thread at a time; a host sampling from several threads
+ * serialises them with its own lock. The tm_sched_* calls lock the task
+ * table themselves and may be made from any thread.
+ */
+
+#define TM_COMMAND_MAX 64
+#define TM_USER_MAX 32
+#define TM_TASK_COMMAND_MAX 256
+#define TM_SCHED_MAX_TASKS 100         // Size of the scheduler's task table
+
+typedef struct tm_snapshot tm_snapshot_t;
+typedef struct filter tm_filter_t;
+
+// One process of a snapshot, copied out for the caller
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    uid_t uid;
+    char state;                     // As in ps: R, S, D, Z, T, ...
+    char command[TM_COMMAND_MAX];
+    char user[TM_USER_MAX];
+    float cpu_percent;              // Relative to the previous snapshot, lifetime average without one
+    float mem_percent;
+    unsigned long rss_kb;
+    unsigned long vsize_kb;
+    unsigned long minflt;
+    unsigned long majflt;
+    int threads;
+    double cpu_seconds;             // User + system time consumed so far
+    double start_seconds;           // Seconds after boot the process started
+} tm_process_t;
+
+// Walks the processes of a snapshot that match a filter
+typedef struct {
+    const tm_snapshot_t *snap;
+    const tm_filter_t *filter;
+    int next;
+} tm_iter_t;
+
+typedef enum {
+    TM_SCHED_ONCE,                  // Run once at first_run
+    TM_SCHED_INTERVAL,              // Run at first_run, then every interval_seconds
+    TM_SCHED_DAILY                  // Run every day at the time of day of first_run
+} tm_sched_type_t;
+
+typedef enum {
+    TM_SCOPE_ALL,                   // Every process on the host
+    TM_SCOPE_USER,                  // Processes owned by uid
+    TM_SCOPE_CGROUP,                // Members of cgroup and its descendants
+    TM_SCOPE_SUBTREE                // root_pid and all of its descendants
+} tm_scope_type_t;
+
+// Which processes snapshots enumerate; only the field of the type is read
+typedef struct {
+    tm_scope_type_t type;
+    uid_t uid;
+    const char *cgroup;             // Relative to the cgroup v2 mount, e.g. "/system.slice"
+    pid_t root_pid;
+} tm_scope_t;
+
+// A scheduled task as copied out by tm_sched_list
+typedef struct {
+    int id;
+    char command[TM_TASK_COMMAND_MAX];
+    tm_sched_type_t type;
+    time_t next_run;
+    int interval_seconds;
+    int active;
+    pid_t last_pid;                 // 0 until the task ran
+} tm_task_t;
+
+/**
+ * Restricts every following snapshot to a scope. Processes start out
+ * sampling every process.
+ * @param scope The scope, or NULL for every process
+ * @return 0 on success, -1 with errno EINVAL for an unknown type or a
+ *         missing cgroup, or ENAMETOOLONG for a cgroup path that does not fit
+ */
+int tm_set_scope(const tm_scope_t *scope);
+
+/**
+ * Reads every process inside the scope set with tm_set_scope into a new
+ * snapshot
+ * @param previous Earlier snapshot for CPU rates, or NULL for lifetime averages
+ * @return The snapshot, freed with tm_snapshot_free; NULL on failure
+ */
+tm_snapshot_t *tm_snapshot_take(const tm_snapshot_t *previous);
+
+/**
+ * Retakes a snapshot in place, reusing its buffers; what a collector
+ * sampling in a loop calls instead of tm_snapshot_take
+ * @param snap The snapshot to refill
+ * @param previous Earlier snapshot for CPU rates, or NULL; must not be snap
+ * @return Number of processes, -1 on failure (snap is then empty)
+ */
+int tm_snapshot_refresh(tm_snapshot_t *snap, const tm_snapshot_t *previous);
+
+/**
+ * Number of processes in a snapshot
+ * @param snap The snapshot
+ */
+int tm_snapshot_count(const tm_snapshot_t *snap);
+
+/**
+ * When a snapshot was taken
+ * @param snap The snapshot
+ * @return CLOCK_MONOTONIC seconds
+ */
+double tm_snapshot_time(const tm_snapshot_t *snap);
+
+/**
+ * Copies out one process of a snapshot
+ * @param snap The snapshot
+ * @param pid The process ID
+ * @param out Receives the process
+ * @return 1 if the process is in the snapshot, 0 otherwise
+ */
+int tm_snapshot_find(const tm_snapshot_t *snap, pid_t pid, tm_process_t *out);
+
+/**
+ * Frees a snapshot
+ * @param snap The snapshot, or NULL
+ */
+void tm_snapshot_free(tm_snapshot_t *snap);
+
+/**
+ * Starts iterating a snapshot in PID order. The filter is prepared for
+ * this snapshot, so one filter must not iterate two snapshots at once.
+ * @param it The iterator to initialize
+ * @param snap The snapshot; it must outlive the iteration
+ * @param filter Compiled filter, or NULL for every process
+ */
+void tm_snapshot_iter(tm_iter_t *it, const tm_snapshot_t *snap, tm_filter_t *filter);
+
+/**
+ * Advances to the next matching process
+ * @param it The iterator
+ * @param out Receives the process
+ * @return 1 if a process was copied out, 0 at the end
+ */
+int tm_iter_next(tm_iter_t *it, tm_process_t *out);
+
+/**
+ * Compiles a filter expression, e.g. "rss > 2G && user == root"
+ * (the syntax of the top view's filter prompt)
+ * @param text The expression
+ * @param error Receives a message when compilation fails
+ * @param error_size Size of error
+ * @return The filter, or NULL for an empty expression (error is "") or on failure
+ */
+tm_filter_t *tm_filter_compile(const char *text, char *error, size_t error_size);
+
+/**
+ * Frees a compiled filter
+ * @param filter The filter, or NULL
+ */
+void tm_filter_free(tm_filter_t *filter);
+
+/**
+ * Sends a signal to every process of a snapshot that matches a filter.
+ * The calling process is never signalled, nor is a process that exited
+ * after the snapshot and whose PID was handed to another one.
+ * @param snap The snapshot
+ * @param filter The filter; required so a missing one cannot signal everything
+ * @param sig The signal, e.g. SIGTERM
+ * @param failed Receives the number of processes that were refused the signal
+ *               or are gone, or NULL
+ * @return Number of processes signalled, -1 with errno EINVAL without a filter
+ */
+int tm_signal_group(const tm_snapshot_t *snap, tm_filter_t *filter, int sig, int *failed);
+
+/**
+ * Schedules a shell command and starts the scheduler thread if needed
+ * @param command The command, run with /bin/sh -c
+ * @param type How the task repeats
+ * @param first_run When the task runs first
+ * @param interval_seconds Time between runs for TM_SCHED_INTERVAL, ignored otherwise
+ * @return The task ID, -1 when the task table is full
+ */
+int tm_sched_add(const char *command, tm_sched_type_t type, time_t first_run, int interval_seconds);
+
+/**
+ * Removes a scheduled task. IDs are never reused, so other tasks keep theirs.
+ * @param id The task ID
+ * @return 1 if removed, 0 for an unknown ID
+ */
+int tm_sched_remove(int id);
+
+/**
+ * Copies out the scheduled tasks
+ * @param tasks Receives up to max tasks
+ * @param max Capacity of tasks
+ * @return Number of tasks scheduled, which may exceed max
+ */
+int tm_sched_list(tm_task_t *tasks, int max);
+
+/**
+ * Stops the scheduler thread; scheduled tasks are kept
+ */
+void tm_sched_stop(void);
+
+#endif
@@ -0,0 +1,441 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include "taskstats.h"
+#include "proc_snapshot.h"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+
+// Requests sent per datagram. Each reply carries a full struct taskstats,
+// so keep the batch well below the default socket receive buffer.
+#define TASKSTATS_BATCH 64
+#define NL_ATTR_PAYLOAD(na) ((void *)((char *)(na) + NLA_HDRLEN))
+#define NL_MSG_PAYLOAD(n) ((char *)NLMSG_DATA(n) + GENL_HDRLEN)
+
+static int nl_sock = -1;
+static unsigned short family_id = 0;
+static unsigned int nl_seq = 1;
+static char last_error[128] = "";
+
+static void set_error(const char *msg) {
+    snprintf(last_error, sizeof(last_error), "%s", msg);
+}
+
+// Appends one attribute to a netlink message, returns 0 if it does not fit
+static int nl_add_attr(struct nlmsghdr *n, size_t maxlen, int type, const void *data, int len) {
+    size_t attr_len = NLA_HDRLEN + len;
+    if (NLMSG_ALIGN(n->nlmsg_len) + NLA_ALIGN(attr_len) > maxlen) {
+        return 0;
+    }
+
+    struct nlattr *na = (struct nlattr *)((char *)n + NLMSG_ALIGN(n->nlmsg_len));
+    na->nla_type = type;
+    na->nla_len = attr_len;
+    memcpy(NL_ATTR_PAYLOAD(na), data, len);
+    n->nlmsg_len = NLMSG_ALIGN(n->nlmsg_len) + NLA_ALIGN(attr_len);
+    return 1;
+}
+
+// Builds a generic netlink request header in buf, returns its nlmsghdr
+static struct nlmsghdr *nl_init_msg(char *buf, unsigned short type, unsigned char cmd, unsigned int seq) {
+    struct nlmsghdr *n = (struct nlmsghdr *)buf;
+    n->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    n->nlmsg_type = type;
+    n->nlmsg_flags = NLM_F_REQUEST;
+    n->nlmsg_seq = seq;
+    n->nlmsg_pid = 0;
+
+    struct genlmsghdr *g = (struct genlmsghdr *)NLMSG_DATA(n);
+    g->cmd = cmd;
+    g->version = 1;
+    g->reserved = 0;
+    return n;
+}
+
+static int nl_send(const void *buf, size_t len) {
+    struct sockaddr_nl dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.nl_family = AF_NETLINK;
+
+    while (sendto(nl_sock, buf, len, 0, (struct sockaddr *)&dest, sizeof(dest)) < 0) {
+        if (errno != EINTR) return 0;
+    }
+    return 1;
+}
+
+// Asks the generic netlink controller for the TASKSTATS family id
+static int resolve_family_id(void) {
+    char buf[256];
+    struct nlmsghdr *n = nl_init_msg(buf, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, nl_seq++);
+    if (!nl_add_attr(n, sizeof(buf), CTRL_ATTR_FAMILY_NAME,
+                     TASKSTATS_GENL_NAME, strlen(TASKSTATS_GENL_NAME) + 1)) {
+        return 0;
+    }
+    if (!nl_send(buf, n->nlmsg_len)) {
+        set_error("Failed to query the generic netlink controller");
+        return 0;
+    }
+
+    char reply[4096];
+    ssize_t len = recv(nl_sock, reply, sizeof(reply), 0);
+    if (len < 0) {
+        set_error("No answer from the generic netlink controller");
+        return 0;
+    }
+
+    struct nlmsghdr *r = (struct nlmsghdr *)reply;
+    if (!NLMSG_OK(r, (size_t)len) || r->nlmsg_type == NLMSG_ERROR) {
+        set_error("TASKSTATS netlink family not available (kernel built without CONFIG_TASKSTATS?)");
+        return 0;
+    }
+
+    int attr_len = r->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    struct nlattr *na = (struct nlattr *)NL_MSG_PAYLOAD(r);
+    while (attr_len >= NLA_HDRLEN && na->nla_len >= NLA_HDRLEN && na->nla_len <= attr_len) {
+        if (na->nla_type == CTRL_ATTR_FAMILY_ID) {
+            family_id = *(unsigned short *)NL_ATTR_PAYLOAD(na);
+            return 1;
+        }
+        attr_len -= NLA_ALIGN(na->nla_len);
+        na = (struct nlattr *)((char *)na + NLA_ALIGN(na->nla_len));
+    }
+
+    set_error("TASKSTATS family id missing from controller reply");
+    return 0;
+}
+
+int taskstats_open(void) {
+    if (nl_sock >= 0) return 1;
+
+    nl_sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (nl_sock < 0) {
+        set_error("Cannot open generic netlink socket");
+        return 0;
+    }
+
+    struct sockaddr_nl local;
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    if (bind(nl_sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        set_error("Cannot bind generic netlink socket");
+        taskstats_close();
+        return 0;
+    }
+
+    // Never let a missing reply hang the UI
+    struct timeval tv = {1, 0};
+    setsockopt(nl_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    if (!resolve_family_id()) {
+        taskstats_close();
+        return 0;
+    }
+    return 1;
+}
+
+void taskstats_close(void) {
+    if (nl_sock >= 0) {
+        close(nl_sock);
+        nl_sock = -1;
+    }
+    family_id = 0;
+}
+
+const char *taskstats_error(void) {
+    return last_error[0] ? last_error : "Unknown error";
+}
+
+// Copies the delay fields of a struct taskstats attribute into out
+static void fill_delay_stats(DelayStats *out, const struct nlattr *stats_attr) {
+    struct taskstats ts;
+    size_t len = stats_attr->nla_len - NLA_HDRLEN;
+
+    // Older kernels send a shorter struct, newer ones a longer one
+    memset(&ts, 0, sizeof(ts));
+    memcpy(&ts, NL_ATTR_PAYLOAD(stats_attr), len < sizeof(ts) ? len : sizeof(ts));
+
+    out->cpu_count = ts.cpu_count;
+    out->cpu_delay_ns = ts.cpu_delay_total;
+    out->blkio_count = ts.blkio_count;
+    out->blkio_delay_ns = ts.blkio_delay_total;
+    out->swapin_count = ts.swapin_count;
+    out->swapin_delay_ns = ts.swapin_delay_total;
+    out->reclaim_count = ts.freepages_count;
+    out->reclaim_delay_ns = ts.freepages_delay_total;
+    out->cpu_run_ns = ts.cpu_run_real_total;
+    out->valid = 1;
+}
+
+// Walks the (possibly nested) attributes of one reply looking for the stats
+static void parse_taskstats_reply(struct nlmsghdr *r, DelayStats *out) {
+    int attr_len = r->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    struct nlattr *na = (struct nlattr *)NL_MSG_PAYLOAD(r);
+
+    while (attr_len >= NLA_HDRLEN && na->nla_len >= NLA_HDRLEN && na->nla_len <= attr_len) {
+        if (na->nla_type == TASKSTATS_TYPE_AGGR_TGID || na->nla_type == TASKSTATS_TYPE_AGGR_PID) {
+            int nested_len = na->nla_len - NLA_HDRLEN;
+            struct nlattr *nested = (struct nlattr *)NL_ATTR_PAYLOAD(na);
+            while (nested_len >= NLA_HDRLEN && nested->nla_len >= NLA_HDRLEN &&
+                   nested->nla_len <= nested_len) {
+                if (nested->nla_type == TASKSTATS_TYPE_STATS) {
+                    fill_delay_stats(out, nested);
+                    return;
+                }
+                nested_len -= NLA_ALIGN(nested->nla_len);
+                nested = (struct nlattr *)((char *)nested + NLA_ALIGN(nested->nla_len));
+            }
+        }
+        attr_len -= NLA_ALIGN(na->nla_len);
+        na = (struct nlattr *)((char *)na + NLA_ALIGN(na->nla_len));
+    }
+}
+
+// Sends one datagram with up to TASKSTATS_BATCH requests and collects the replies
+static int query_chunk(DelayStats *stats, int count) {
+    char buf[TASKSTATS_BATCH * 64];
+    size_t used = 0;
+    unsigned int base_seq = nl_seq;
+
+    for (int i = 0; i < count; i++) {
+        __u32 tgid = stats[i].pid;
+        struct nlmsghdr *n = nl_init_msg(buf + used, family_id, TASKSTATS_CMD_GET, base_seq + i);
+        nl_add_attr(n, sizeof(buf) - used, TASKSTATS_CMD_ATTR_TGID, &tgid, sizeof(tgid));
+        used += NLMSG_ALIGN(n->nlmsg_len);
+    }
+    nl_seq += count;
+
+    if (!nl_send(buf, used)) {
+        set_error("Failed to send taskstats request");
+        return -1;
+    }
+
+    int pending = count;
+    int answered = 0;
+    char reply[16384];
+
+    while (pending > 0) {
+        ssize_t len = recv(nl_sock, reply, sizeof(reply), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            break; // Timed out, treat the rest as unanswered
+        }
+
+        for (struct nlmsghdr *r = (struct nlmsghdr *)reply; NLMSG_OK(r, (size_t)len);
+             r = NLMSG_NEXT(r, len)) {
+            unsigned int idx = r->nlmsg_seq - base_seq;
+            if (idx >= (unsigned int)count) continue;
+
+            if (r->nlmsg_type == NLMSG_ERROR) {
+                struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(r);
+                if (err->error == -EPERM) {
+                    set_error("Permission denied: taskstats needs CAP_NET_ADMIN (try sudo)");
+                    return -1;
+                }
+                // ESRCH and friends: the process went away, leave it invalid
+                pending--;
+                continue;
+            }
+
+            if (r->nlmsg_type == family_id) {
+                parse_taskstats_reply(r, &stats[idx]);
+                if (stats[idx].valid) answered++;
+                pending--;
+            }
+        }
+    }
+    return answered;
+}
+
+int taskstats_query_batch(DelayStats *stats, int count) {
+    if (!taskstats_open()) return -1;
+
+    for (int i = 0; i < count; i++) {
+        pid_t pid = stats[i].pid;
+        memset(&stats[i], 0, sizeof(stats[i]));
+        stats[i].pid = pid;
+    }
+
+    int answered = 0;
+    for (int start = 0; start < count; start += TASKSTATS_BATCH) {
+        int chunk = count - start < TASKSTATS_BATCH ? count - start : TASKSTATS_BATCH;
+        int n = query_chunk(stats + start, chunk);
+        if (n < 0) return -1;
+        answered += n;
+    }
+    return answered;
+}
+
+// Delay accounting is compiled in but off by default since Linux 5.14
+static int delay_accounting_enabled(void) {
+    FILE *fp = fopen("/proc/sys/kernel/task_delayacct", "r");
+    if (!fp) return 1; // Older kernels have no switch and always account
+    int enabled = 1;
+    if (fscanf(fp, "%d", &enabled) != 1) enabled = 1;
+    fclose(fp);
+    return enabled;
+}
+
+static void print_delay_warning(void) {
+    if (!delay_accounting_enabled()) {
+        printf("Note: delay accounting is disabled, I/O, swap-in and reclaim delays read as zero.\n");
+        printf("      Enable it with: sudo sysctl kernel.task_delayacct=1\n");
+    }
+}
+
+static void read_comm(pid_t pid, char *comm, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    snprintf(comm, size, "?");
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    if (fgets(comm, size, fp)) {
+        comm[strcspn(comm, "\n")] = '\0';
+    }
+    fclose(fp);
+}
+
+static void print_delay_row(const char *name, uint64_t count, uint64_t delay_ns) {
+    double avg_us = count ? (double)delay_ns / count / 1000.0 : 0.0;
+    printf("%-20s %12llu %16.3f %14.2f\n", name, (unsigned long long)count,
+           delay_ns / 1e6, avg_us);
+}
+
+void show_process_delay_accounting(pid_t pid) {
+    DelayStats stats;
+    stats.pid = pid;
+
+    if (taskstats_query_batch(&stats, 1) < 0) {
+        printf("Delay accounting unavailable: %s\n", taskstats_error());
+        return;
+    }
+    if (!stats.valid) {
+        printf("Kernel returned no delay accounting for PID %d\n", pid);
+        return;
+    }
+
+    printf("\n===== Delay Accounting for PID %d (taskstats) =====\n", pid);
+    printf("%-20s %12s %16s %14s\n", "DELAY", "EVENTS", "TOTAL (ms)", "AVG (us)");
+    printf("-------------------------------------------------------------------\n");
+    print_delay_row("CPU run queue", stats.cpu_count, stats.cpu_delay_ns);
+    print_delay_row("Block I/O", stats.blkio_count, stats.blkio_delay_ns);
+    print_delay_row("Swap-in", stats.swapin_count, stats.swapin_delay_ns);
+    print_delay_row("Memory reclaim", stats.reclaim_count, stats.reclaim_delay_ns);
+    printf("-------------------------------------------------------------------\n");
+    printf("CPU run time: %.3f ms", stats.cpu_run_ns / 1e6);
+    if (stats.cpu_run_ns > 0) {
+        printf(" (waited %.1f%% as long as it ran)",
+               100.0 * stats.cpu_delay_ns / stats.cpu_run_ns);
+    }
+    printf("\n");
+    print_delay_warning();
+}
+
+static uint64_t delay_for_key(const DelayStats *s, delay_sort_t key) {
+    switch (key) {
+        case DELAY_SORT_BLKIO: return s->blkio_delay_ns;
+        case DELAY_SORT_SWAPIN: return s->swapin_delay_ns;
+        case DELAY_SORT_RECLAIM: return s->reclaim_delay_ns;
+        case DELAY_SORT_CPU:
+        default: return s->cpu_delay_ns;
+    }
+}
+
+static delay_sort_t current_sort_key = DELAY_SORT_CPU;
+
+static int compare_delay_desc(const void *a, const void *b) {
+    uint64_t da = delay_for_key((const DelayStats *)a, current_sort_key);
+    uint64_t db = delay_for_key((const DelayStats *)b, current_sort_key);
+    return (da < db) - (da > db);
+}
+
+void show_top_delay_usage(delay_sort_t sort_key, int count) {
+    if (count <= 0) {
+        count = 10;
+    }
+
+    // Only the processes inside the monitoring scope are queried
+    pid_t *pids;
+    int total = snapshot_scope_pids(&pids);
+    if (total < 0) {
+        printf("Failed to enumerate processes in scope\n");
+        return;
+    }
+
+    DelayStats *stats = malloc((total ? total : 1) * sizeof(DelayStats));
+    if (!stats) {
+        free(pids);
+        perror("Out of memory");
+        return;
+    }
+    for (int i = 0; i < total; i++) {
+        stats[i].pid = pids[i];
+    }
+    free(pids);
+
+    if (taskstats_query_batch(stats, total) < 0) {
+        printf("Delay accounting unavailable: %s\n", taskstats_error());
+        free(stats);
+        return;
+    }
+
+    current_sort_key = sort_key;
+    qsort(stats, total, sizeof(DelayStats), compare_delay_desc);
+
+    static const char *titles[] = {"CPU Run-Queue", "Block I/O", "Swap-in", "Memory Reclaim"};
+    printf("\n===== Top %d Processes by %s Delay =====\n", count, titles[sort_key]);
+    printf("%-8s %-16s %12s %12s %12s %12s\n",
+           "PID", "COMMAND", "CPU(ms)", "BLKIO(ms)", "SWAP(ms)", "RECLAIM(ms)");
+
+    for (int i = 0, shown = 0; i < total && shown < count; i++) {
+        if (!stats[i].valid) continue;
+        char comm[64];
+        read_comm(stats[i].pid, comm, sizeof(comm));
+        printf("%-8d %-16.16s %12.1f %12.1f %12.1f %12.1f\n",
+               stats[i].pid, comm,
+               stats[i].cpu_delay_ns / 1e6, stats[i].blkio_delay_ns / 1e6,
+               stats[i].swapin_delay_ns / 1e6, stats[i].reclaim_delay_ns / 1e6);
+        shown++;
+    }
+    print_delay_warning();
+    free(stats);
+}
+
+#else
+
+int taskstats_open(void) {
+    return 0;
+}
+
+void taskstats_close(void) {
+}
+
+const char *taskstats_error(void) {
+    return "Delay accounting requires the Linux taskstats interface";
+}
+
+int taskstats_query_batch(DelayStats *stats, int count) {
+    (void)stats;
+    (void)count;
+    return -1;
+}
+
+void show_process_delay_accounting(pid_t pid) {
+    (void)pid;
+    printf("Delay accounting unavailable: %s\n", taskstats_error());
+}
+
+void show_top_delay_usage(delay_sort_t sort_key, int count) {
+    (void)sort_key;
+    (void)count;
+    printf("Delay accounting unavailable: %s\n", taskstats_error());
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TASKSTATS_VIEW_H
+#define TASKSTATS_VIEW_H
+
+#include <sys/types.h>
+#include <stdint.h>
+
+// Delay accounting values reported by the kernel TASKSTATS family.
+// All *_delay_ns values are cumulative since the process started.
+typedef struct {
+    pid_t pid;
+    int valid;                      // 1 if the kernel answered for this PID
+    uint64_t cpu_count;
+    uint64_t cpu_delay_ns;          // Time spent waiting on a run queue
+    uint64_t blkio_count;
+    uint64_t blkio_delay_ns;        // Time spent waiting for block I/O
+    uint64_t swapin_count;
+    uint64_t swapin_delay_ns;       // Time spent waiting for swap-in
+    uint64_t reclaim_count;
+    uint64_t reclaim_delay_ns;      // Time spent in direct memory reclaim
+    uint64_t cpu_run_ns;            // Time actually spent running on a CPU
+} DelayStats;
+
+typedef enum {
+    DELAY_SORT_CPU,
+    DELAY_SORT_BLKIO,
+    DELAY_SORT_SWAPIN,
+    DELAY_SORT_RECLAIM
+} delay_sort_t;
+
+/**
+ * Opens the generic-netlink socket and resolves the TASKSTATS family.
+ * Calling it again while the socket is open is a no-op.
+ * @return 1 if taskstats can be queried, 0 otherwise (see taskstats_error)
+ */
+int taskstats_open(void);
+
+/**
+ * Closes the netlink socket opened by taskstats_open
+ */
+void taskstats_close(void);
+
+/**
+ * Returns a human readable reason for the last taskstats failure
+ */
+const char *taskstats_error(void);
+
+/**
+ * Queries delay accounting for a batch of processes over one netlink socket.
+ * The pid field of every entry must be set; the rest is filled in.
+ * @param stats Array of DelayStats to fill
+ * @param count Number of entries in the array
+ * @return Number of entries the kernel answered for, -1 if taskstats is unavailable
+ */
+int taskstats_query_batch(DelayStats *stats, int count);
+
+/**
+ * Shows the delay accounting detail view for one process
+ * @param pid The process ID
+ */
+void show_process_delay_accounting(pid_t pid);
+
+/**
+ * Shows the processes with the largest cumulative delay of the given kind
+ * @param sort_key Which delay to sort by
+ * @param count Number of processes to show (top N)
+ */
+void show_top_delay_usage(delay_sort_t sort_key, int count);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Each test binary counts its failed checks and reports them from check_done()
+static int check_failures;
+static int check_count;
+
+#define CHECK(cond) do {                                                        \
+        check_count++;                                                          \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                   \
+        }                                                                       \
+    } while (0)
+
+/**
+ * Prints the summary line of a test binary
+ * @param name The component under test
+ * @return Exit status for main
+ */
+static inline int check_done(const char *name) {
+    printf("%-12s %d checks, %d failed\n", name, check_count, check_failures);
+    return check_failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "check.h"
+#include "../arena.h"
+
+static int aligned(const void *p) {
+    return ((uintptr_t)p & 15) == 0;
+}
+
+// Stands in for one refresh: a run of variable-sized allocations, each filled with its own byte
+static int fill_cycle(arena_t *arena, int count, size_t size, char **out) {
+    for (int i = 0; i < count; i++) {
+        size_t n = size + i % 7;
+        out[i] = arena_alloc(arena, n);
+        if (!out[i] || !aligned(out[i])) return 0;
+        memset(out[i], 'a' + i % 26, n);
+    }
+    for (int i = 0; i < count; i++) {
+        size_t n = size + i % 7;
+        for (size_t k = 0; k < n; k++) if (out[i][k] != 'a' + i % 26) return 0;
+    }
+    return 1;
+}
+
+static void test_empty(void) {
+    arena_t arena = {0};
+    arena_reset(&arena);
+    CHECK(arena.base == NULL && arena.used == 0);
+    arena_free(&arena);
+
+    // A zero-byte request still gets its own aligned slot
+    void *a = arena_alloc(&arena, 0), *b = arena_alloc(&arena, 0);
+    CHECK(a && b && a != b && aligned(a) && aligned(b));
+    arena_free(&arena);
+    CHECK(arena.base == NULL && arena.overflow == NULL && arena.size == 0);
+}
+
+// The first cycle spills to chunks; after the reset the same work fits the arena
+static void test_spill_and_grow(void) {
+    arena_t arena = {0};
+    static char *ptrs[4000];
+    CHECK(fill_cycle(&arena, 4000, 40, ptrs));
+    CHECK(arena.spilled > 0 && arena.overflow != NULL);
+
+    arena_reset(&arena);
+    CHECK(arena.overflow == NULL && arena.spilled == 0 && arena.used == 0);
+    size_t size = arena.size;
+    CHECK(size >= 4000 * 48);
+
+    char *base = arena.base;
+    for (int cycle = 0; cycle < 5; cycle++) {
+        CHECK(fill_cycle(&arena, 4000, 40, ptrs));
+        CHECK(arena.spilled == 0 && arena.overflow == NULL);
+        CHECK(ptrs[0] == base);
+        arena_reset(&arena);
+    }
+    // Cycles that fit leave the arena alone
+    CHECK(arena.base == base && arena.size == size);
+
+    // A smaller cycle keeps the grown arena rather than shrinking it
+    CHECK(fill_cycle(&arena, 10, 8, ptrs));
+    arena_reset(&arena);
+    CHECK(arena.size == size);
+    arena_free(&arena);
+}
+
+static void test_extend(void) {
+    arena_t arena = {0};
+    char *warm = arena_alloc(&arena, 1);
+    arena_reset(&arena);
+    CHECK(warm != NULL && arena.base != NULL);
+
+    // The last allocation grows in place
+    char *p = arena_alloc(&arena, 10);
+    memcpy(p, "0123456789", 10);
+    char *q = arena_extend(&arena, p, 10, 100);
+    CHECK(q == p && memcmp(q, "0123456789", 10) == 0);
+
+    // Anything else moves, keeping its bytes
+    char *other = arena_alloc(&arena, 16);
+    char *moved = arena_extend(&arena, p, 100, 200);
+    CHECK(moved != p && moved != NULL && memcmp(moved, "0123456789", 10) == 0);
+    CHECK(other != NULL && aligned(moved));
+
+    // Shrinking, or growing to the same size, keeps the allocation
+    CHECK(arena_extend(&arena, moved, 200, 20) == moved);
+    CHECK(arena_extend(&arena, moved, 200, 200) == moved);
+    CHECK(arena_extend(&arena, moved, 200, 0) == moved);
+
+    // Growing past the arena goes to an overflow chunk
+    char *big = arena_extend(&arena, moved, 200, arena.size * 2);
+    CHECK(big != NULL && arena.spilled > 0 && memcmp(big, "0123456789", 10) == 0);
+
+    // No previous allocation is a plain allocation
+    CHECK(arena_extend(&arena, NULL, 0, 32) != NULL);
+    arena_free(&arena);
+
+    // Extending in an arena that has no memory yet
+    char *first = arena_extend(&arena, NULL, 0, 8);
+    CHECK(first != NULL && aligned(first));
+    arena_free(&arena);
+}
+
+// Sizes near SIZE_MAX must fail instead of wrapping into a tiny allocation
+static void test_overflowing_sizes(void) {
+    arena_t arena = {0};
+    arena_reset(&arena);
+    CHECK(arena_alloc(&arena, SIZE_MAX) == NULL);
+    CHECK(arena_alloc(&arena, SIZE_MAX - 8) == NULL);
+    CHECK(arena_alloc(&arena, SIZE_MAX - 20) == NULL);
+    char *p = arena_alloc(&arena, 16);
+    CHECK(p != NULL);
+    CHECK(arena_extend(&arena, p, 16, SIZE_MAX) == NULL);
+    CHECK(arena_extend(&arena, p, 16, SIZE_MAX - 15) == NULL);
+    CHECK(arena.spilled < 64);
+    arena_free(&arena);
+}
+
+int main(void) {
+    test_empty();
+    test_spill_and_grow();
+    test_extend();
+    test_overflowing_sizes();
+    return check_done("arena");
+}
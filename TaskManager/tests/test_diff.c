@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "check.h"
+#include "../snapshot_diff.h"
+
+#define MAX_ROWS 200
+
+static unsigned int seed = 4242;
+
+static unsigned int next_random(void) {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static void set_rows(ProcessSnapshot *snap, ProcessSample *samples, const pid_t *pids,
+                     const unsigned long long *starttimes, int count) {
+    memset(snap, 0, sizeof(*snap));
+    snap->samples = samples;
+    snap->count = count;
+    snap->capacity = count;
+    for (int i = 0; i < count; i++) {
+        memset(&samples[i], 0, sizeof(samples[i]));
+        samples[i].pid = pids[i];
+        samples[i].starttime = starttimes[i];
+    }
+}
+
+static pid_t row_pid(const ProcessSnapshot *before, const ProcessSnapshot *after, const diff_row_t *row) {
+    return row->before >= 0 ? before->samples[row->before].pid : after->samples[row->after].pid;
+}
+
+// Checks what must hold for any diff: every index once, PID order, counts that add up
+static int consistent(const ProcessSnapshot *before, const ProcessSnapshot *after, const SnapshotDiff *diff) {
+    static unsigned char seen_before[MAX_ROWS], seen_after[MAX_ROWS];
+    memset(seen_before, 0, sizeof(seen_before));
+    memset(seen_after, 0, sizeof(seen_after));
+    int started = 0, exited = 0, common = 0;
+    pid_t last = 0;
+    for (int r = 0; r < diff->count; r++) {
+        const diff_row_t *row = &diff->rows[r];
+        if (row->before < 0 && row->after < 0) return 0;
+        if (row->before >= 0 && (row->before >= before->count || seen_before[row->before]++)) return 0;
+        if (row->after >= 0 && (row->after >= after->count || seen_after[row->after]++)) return 0;
+        if (row->before >= 0 && row->after >= 0) {
+            const ProcessSample *b = &before->samples[row->before], *a = &after->samples[row->after];
+            if (b->pid != a->pid || b->starttime != a->starttime) return 0;
+            common++;
+        } else if (row->before >= 0) {
+            exited++;
+        } else {
+            started++;
+        }
+        if (row_pid(before, after, row) < last) return 0;
+        last = row_pid(before, after, row);
+    }
+    for (int i = 0; i < before->count; i++) if (!seen_before[i]) return 0;
+    for (int i = 0; i < after->count; i++) if (!seen_after[i]) return 0;
+    return started == diff->started && exited == diff->exited && common == diff->common &&
+           diff->count == started + exited + common;
+}
+
+static void test_empty(void) {
+    ProcessSnapshot none = {0};
+    ProcessSample samples[3];
+    ProcessSnapshot some;
+    static const pid_t pids[] = { 1, 2, 3 };
+    static const unsigned long long starts[] = { 10, 20, 30 };
+    set_rows(&some, samples, pids, starts, 3);
+    SnapshotDiff diff = {0};
+
+    CHECK(snapshot_diff(&none, &none, &diff) == 0);
+    CHECK(diff.started == 0 && diff.exited == 0 && diff.common == 0);
+    CHECK(snapshot_diff(&none, &some, &diff) == 3);
+    CHECK(diff.started == 3 && diff.exited == 0 && consistent(&none, &some, &diff));
+    CHECK(snapshot_diff(&some, &none, &diff) == 3);
+    CHECK(diff.exited == 3 && diff.started == 0 && consistent(&some, &none, &diff));
+    CHECK(snapshot_diff(&some, &some, &diff) == 3);
+    CHECK(diff.common == 3 && consistent(&some, &some, &diff));
+    // The counters start over when the buffer is reused
+    CHECK(snapshot_diff(&none, &none, &diff) == 0);
+    CHECK(diff.common == 0);
+    snapshot_diff_free(&diff);
+    CHECK(diff.rows == NULL && diff.capacity == 0);
+}
+
+static void test_reused_pids(void) {
+    ProcessSample b_samples[5], a_samples[5];
+    ProcessSnapshot before, after;
+    static const pid_t b_pids[] = { 1, 7, 9, 300, INT_MAX };
+    static const unsigned long long b_starts[] = { 5, 70, 90, 3000, 1 };
+    static const pid_t a_pids[] = { 1, 7, 8, 300, INT_MAX };
+    static const unsigned long long a_starts[] = { 5, 71, 80, 3000, 2 };
+    set_rows(&before, b_samples, b_pids, b_starts, 5);
+    set_rows(&after, a_samples, a_pids, a_starts, 5);
+    SnapshotDiff diff = {0};
+
+    // 7 and INT_MAX were handed out again, 9 exited and 8 started
+    CHECK(snapshot_diff(&before, &after, &diff) == 8);
+    CHECK(diff.common == 2 && diff.exited == 3 && diff.started == 3);
+    CHECK(consistent(&before, &after, &diff));
+    // The exit of the old process comes before the start of the new one
+    CHECK(diff.rows[1].before == 1 && diff.rows[1].after == -1);
+    CHECK(diff.rows[2].before == -1 && diff.rows[2].after == 1);
+    CHECK(diff.rows[3].after == 2 && diff.rows[4].before == 2);
+    CHECK(diff.rows[6].before == 4 && diff.rows[7].after == 4);
+    snapshot_diff_free(&diff);
+}
+
+// Random churn between two snapshots, checked against the invariants and a count by hand
+static void test_churn(void) {
+    static ProcessSample b_samples[MAX_ROWS / 2], a_samples[MAX_ROWS / 2];
+    static pid_t b_pids[MAX_ROWS / 2], a_pids[MAX_ROWS / 2];
+    static unsigned long long b_starts[MAX_ROWS / 2], a_starts[MAX_ROWS / 2];
+    SnapshotDiff diff = {0};
+    int ok = 1;
+
+    for (int round = 0; round < 200 && ok; round++) {
+        int nb = 0, na = 0, common = 0, reused = 0;
+        pid_t pid = 1 + next_random() % 5;
+        while (nb < MAX_ROWS / 2 && na < MAX_ROWS / 2) {
+            unsigned int roll = next_random() % 8;
+            if (roll == 0) {
+                b_pids[nb] = pid;
+                b_starts[nb++] = pid;
+            } else if (roll == 1) {
+                a_pids[na] = pid;
+                a_starts[na++] = pid;
+            } else if (roll == 2) {
+                b_pids[nb] = a_pids[na] = pid;
+                b_starts[nb++] = pid;
+                a_starts[na++] = pid + 1;
+                reused++;
+            } else if (roll < 7) {
+                b_pids[nb] = a_pids[na] = pid;
+                b_starts[nb++] = a_starts[na++] = pid;
+                common++;
+            } else if (round % 3 == 0) {
+                break;
+            }
+            pid += 1 + next_random() % 4;
+        }
+        ProcessSnapshot before, after;
+        set_rows(&before, b_samples, b_pids, b_starts, nb);
+        set_rows(&after, a_samples, a_pids, a_starts, na);
+        int rows = snapshot_diff(&before, &after, &diff);
+        ok = rows == nb + na - common && diff.common == common &&
+             diff.exited == nb - common && diff.started == na - common &&
+             consistent(&before, &after, &diff) && reused <= diff.exited;
+    }
+    CHECK(ok);
+    snapshot_diff_free(&diff);
+}
+
+int main(void) {
+    test_empty();
+    test_reused_pids();
+    test_churn();
+    return check_done("diff");
+}
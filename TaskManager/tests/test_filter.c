@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "../proc_filter.h"
+
+#define ROWS 6
+
+static ProcessSample rows[ROWS];
+static ProcessSnapshot snap = { .samples = rows, .count = ROWS, .capacity = ROWS };
+
+static void add_row(int i, pid_t pid, pid_t ppid, const char *user, const char *command,
+                    unsigned long rss_kb, float cpu, char state) {
+    memset(&rows[i], 0, sizeof(rows[i]));
+    rows[i].pid = pid;
+    rows[i].ppid = ppid;
+    rows[i].uid = strcmp(user, "root") == 0 ? 0 : 1000;
+    rows[i].state = state;
+    snprintf(rows[i].command, sizeof(rows[i].command), "%s", command);
+    snprintf(rows[i].username, sizeof(rows[i].username), "%s", user);
+    rows[i].rss_kb = rss_kb;
+    rows[i].vsize_kb = rss_kb * 4;
+    rows[i].cpu_percent = cpu;
+    rows[i].threads = i + 1;
+}
+
+// pid 1 is the root; 20 and 21 sit under 10, and 40 and 41 are each other's parent
+static void build_rows(void) {
+    add_row(0, 1, 0, "root", "init", 10000, 0.5f, 'S');
+    add_row(1, 10, 1, "alice", "bash", 4000, 1.0f, 'S');
+    add_row(2, 20, 10, "alice", "Firefox", 3 * 1024 * 1024, 75.0f, 'R');
+    add_row(3, 21, 10, "alice", "kworker/0:1", 0, 0.0f, 'I');
+    add_row(4, 40, 41, "bob", "loop-a", 512, 5.0f, 'D');
+    add_row(5, 41, 40, "bob", "loop-b", 512, 5.0f, 'Z');
+}
+
+// Bitmask of the rows an expression matches, -1 if it does not compile
+static int matches(const char *text) {
+    char error[128];
+    filter_t *filter = filter_compile(text, error, sizeof(error));
+    if (!filter) {
+        if (error[0]) fprintf(stderr, "'%s': %s\n", text, error);
+        return -1;
+    }
+    int mask = 0;
+    filter_prepare(filter, &snap);
+    for (int i = 0; i < ROWS; i++) {
+        if (filter_match(filter, &snap, i)) mask |= 1 << i;
+    }
+    filter_free(filter);
+    return mask;
+}
+
+// Compiles an expression that must be rejected and returns its message
+static const char *rejects(const char *text) {
+    static char error[128];
+    filter_t *filter = filter_compile(text, error, sizeof(error));
+    if (filter) {
+        filter_free(filter);
+        return NULL;
+    }
+    return error[0] ? error : NULL;
+}
+
+static int rejected_with(const char *text, const char *message) {
+    const char *error = rejects(text);
+    return error && strstr(error, message);
+}
+
+static void test_comparisons(void) {
+    CHECK(matches("pid == 20") == 0x04);
+    CHECK(matches("pid = 20") == 0x04);
+    CHECK(matches("pid != 20") == 0x3b);
+    CHECK(matches("ppid < 10") == 0x03);
+    CHECK(matches("threads >= 5") == 0x30);
+    CHECK(matches("uid > 0") == 0x3e);
+    CHECK(matches("cpu > 50%") == 0x04);
+    CHECK(matches("cpu <= 1") == 0x0b);
+    CHECK(matches("rss > 1G") == 0x04);
+    CHECK(matches("rss > 2GB") == 0x04);
+    CHECK(matches("rss >= 4M") == 0x05);
+    CHECK(matches("rss == 512") == 0x30);
+    CHECK(matches("rss < 1k") == 0x08);
+    CHECK(matches("vsz > 10G") == 0x04);
+    CHECK(matches("vsize > 1T") == 0x00);
+    CHECK(matches("state == R") == 0x04);
+    CHECK(matches("state != S") == 0x3c);
+    CHECK(matches("user == alice") == 0x0e);
+    CHECK(matches("USER != alice") == 0x31);
+    CHECK(matches("comm ~ FIRE") == 0x04);
+    CHECK(matches("command !~ loop") == 0x0f);
+    CHECK(matches("name == \"kworker/0:1\"") == 0x08);
+    CHECK(matches("comm == \"\"") == 0x00);
+    CHECK(matches("comm ~ \"\"") == 0x3f);
+}
+
+static void test_logic(void) {
+    CHECK(matches("user == alice && cpu > 0.5") == 0x06);
+    CHECK(matches("user == bob || pid == 1") == 0x31);
+    // && binds tighter than ||
+    CHECK(matches("pid == 1 || user == alice && cpu > 50") == 0x05);
+    CHECK(matches("(pid == 1 || user == alice) && cpu > 50") == 0x04);
+    CHECK(matches("!(user == alice)") == 0x31);
+    CHECK(matches("!!(user == alice)") == 0x0e);
+    CHECK(matches("not user == alice and not pid == 1") == 0x30);
+    CHECK(matches("NOT comm ~ kworker AND user == alice OR state == Z") == 0x26);
+    CHECK(matches("  ( ( (pid==10) ) )  ") == 0x02);
+    CHECK(matches("user==alice&&rss>1G") == 0x04);
+}
+
+static void test_bare_words(void) {
+    CHECK(matches("fire") == 0x04);
+    CHECK(matches("  LOOP  ") == 0x30);
+    CHECK(matches("nothing-like-this") == 0x00);
+    // A bare word that starts like a keyword is still a name
+    CHECK(matches("notepad") == 0x00);
+    CHECK(matches("kworker/0:1") == 0x08);
+    CHECK(matches("not") == 0x00);
+    CHECK(matches("Init\t") == 0x01);
+}
+
+static void test_subtree(void) {
+    CHECK(matches("subtree(10)") == 0x0e);
+    CHECK(matches("subtree 10") == 0x0e);
+    CHECK(matches("subtree(1)") == 0x0f);
+    CHECK(matches("subtree(1) && cpu > 50") == 0x04);
+    CHECK(matches("!subtree(10)") == 0x31);
+    // A parent cycle ends the walk instead of looping
+    CHECK(matches("subtree(40)") == 0x30);
+    CHECK(matches("subtree(999)") == 0x00);
+
+    // The membership follows the snapshot it was prepared for
+    char error[128];
+    filter_t *filter = filter_compile("subtree(10)", error, sizeof(error));
+    CHECK(filter != NULL);
+    if (!filter) return;
+    ProcessSnapshot small = { .samples = rows, .count = 3, .capacity = 3 };
+    filter_prepare(filter, &small);
+    CHECK(filter_match(filter, &small, 1) && filter_match(filter, &small, 2) && !filter_match(filter, &small, 0));
+    ProcessSnapshot empty = { .samples = NULL, .count = 0 };
+    filter_prepare(filter, &empty);
+    filter_prepare(filter, &snap);
+    CHECK(filter_match(filter, &snap, 3));
+    filter_free(filter);
+}
+
+static void test_empty(void) {
+    char error[16] = "stale";
+    CHECK(filter_compile("", error, sizeof(error)) == NULL && error[0] == '\0');
+    strcpy(error, "stale");
+    CHECK(filter_compile(" \t\n ", error, sizeof(error)) == NULL && error[0] == '\0');
+    CHECK(filter_match(NULL, &snap, 0) == 1);
+    CHECK(strcmp(filter_text(NULL), "") == 0);
+    filter_prepare(NULL, &snap);
+    filter_free(NULL);
+}
+
+static void test_malformed(void) {
+    static const char *bad[] = {
+        "rss >", "rss > abc", "rss > 5X", "cpu > 5G", "pid == 1.5.2",
+        "foo == 1", "== 1", "&& pid == 1", "pid == 1 &&", "pid == 1 || ",
+        "(pid == 1", "pid == 1)", "((pid == 1)", "()", "!", "pid >> 1",
+        "user > root", "comm < a", "cpu ~ 5", "state == RS", "state > R", "subtree()", "subtree(0)", "subtree(-4)",
+        "subtree(10", "comm == \"unterminated", "pid == 1 pid == 2", "user == alice,"
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        const char *error = rejects(bad[i]);
+        if (!error) fprintf(stderr, "accepted malformed filter '%s'\n", bad[i]);
+        CHECK(error != NULL);
+    }
+
+    CHECK(rejected_with("foo == 1", "unknown field foo"));
+    CHECK(rejected_with("(pid == 1", "missing ')'"));
+    CHECK(rejected_with("rss > 5X", "bad number 5X"));
+}
+
+// Words, names and expressions that do not fit are refused instead of cut short
+static void test_overlong(void) {
+    char text[600];
+    memset(text, 'a', 63);
+    text[63] = '\0';
+    CHECK(matches(text) == 0x00);
+    memset(text, 'a', 64);
+    text[64] = '\0';
+    CHECK(rejected_with(text, "name longer than 63"));
+
+    snprintf(text, sizeof(text), "comm == %0100d", 7);
+    CHECK(rejected_with(text, "word longer than 63"));
+    snprintf(text, sizeof(text), "comm == \"%0100d\"", 7);
+    CHECK(rejected_with(text, "word longer than 63"));
+    memset(text, 'x', 100);
+    snprintf(text + 100, sizeof(text) - 100, " == 1");
+    CHECK(rejected_with(text, "word longer than 63"));
+
+    // 255 characters fit the source buffer, 256 do not
+    memset(text, ' ', sizeof(text));
+    memcpy(text, "pid == 1", 8);
+    text[255] = '\0';
+    CHECK(matches(text) == 0x01);
+    text[255] = ' ';
+    text[256] = '\0';
+    CHECK(rejected_with(text, "expression longer than 255"));
+
+    // Every negation is a node, so a long chain runs out of them
+    memset(text, '!', 100);
+    snprintf(text + 100, sizeof(text) - 100, "pid == 1");
+    CHECK(rejected_with(text, "too complex"));
+
+    // A small error buffer gets a truncated message, never an overflow
+    char small[8];
+    memset(small, '#', sizeof(small));
+    CHECK(filter_compile("foo == 1", small, sizeof(small)) == NULL);
+    CHECK(strlen(small) == sizeof(small) - 1);
+}
+
+static void test_zones(void) {
+    filter_zone_t zone;
+    memset(&zone, 0, sizeof(zone));
+    zone.min[FILTER_RSS] = 100;
+    zone.max[FILTER_RSS] = 2000;
+    zone.min[FILTER_CPU] = 0;
+    zone.max[FILTER_CPU] = 10;
+
+    static const struct {
+        const char *text;
+        int may_match;
+    } cases[] = {
+        {"rss > 1G", 0}, {"rss > 1999", 1}, {"rss >= 2000", 1}, {"rss > 2000", 0},
+        {"rss < 100", 0}, {"rss <= 100", 1}, {"rss == 50", 0}, {"rss == 1500", 1},
+        {"rss != 1500", 1}, {"cpu > 50 || rss > 1G", 0}, {"cpu > 5 || rss > 1G", 1},
+        {"cpu > 5 && rss > 1G", 0}, {"!(rss > 1G)", 1}, {"not rss < 1", 1},
+        {"user == root && rss > 1G", 0}, {"user == root", 1}, {"subtree(1)", 1},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        char error[128];
+        filter_t *filter = filter_compile(cases[i].text, error, sizeof(error));
+        CHECK(filter != NULL);
+        if (!filter) continue;
+        if (filter_may_match(filter, &zone) != cases[i].may_match) fprintf(stderr, "zone: '%s'\n", cases[i].text);
+        CHECK(filter_may_match(filter, &zone) == cases[i].may_match);
+        filter_free(filter);
+    }
+
+    zone.min[FILTER_RSS] = zone.max[FILTER_RSS] = 1500;
+    char error[128];
+    filter_t *filter = filter_compile("rss != 1500", error, sizeof(error));
+    CHECK(filter && filter_may_match(filter, &zone) == 0);
+    CHECK(filter && strcmp(filter_text(filter), "rss != 1500") == 0);
+    filter_free(filter);
+    CHECK(filter_may_match(NULL, &zone) == 1);
+}
+
+int main(void) {
+    build_rows();
+    test_comparisons();
+    test_logic();
+    test_bare_words();
+    test_subtree();
+    test_empty();
+    test_malformed();
+    test_overlong();
+    test_zones();
+    return check_done("filter");
+}
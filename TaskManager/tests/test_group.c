@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "../group_view.h"
+
+#define MANY 3000
+
+static ProcessSample samples[MANY];
+static ProcessSample old_samples[MANY];
+
+static void set_sample(ProcessSample *s, pid_t pid, uid_t uid, const char *user, const char *command) {
+    memset(s, 0, sizeof(*s));
+    s->pid = pid;
+    s->uid = uid;
+    snprintf(s->username, sizeof(s->username), "%s", user);
+    snprintf(s->command, sizeof(s->command), "%s", command);
+    s->starttime = pid;
+    s->threads = 1;
+    s->io_bytes = SNAPSHOT_IO_UNKNOWN;
+}
+
+static ProcessSnapshot make_snapshot(ProcessSample *rows, int count, double timestamp) {
+    ProcessSnapshot snap = { .samples = rows, .count = count, .capacity = count, .timestamp = timestamp };
+    return snap;
+}
+
+// Walks a group's member chain and checks it against the group's totals
+static int members_add_up(const GroupTable *table, const ProcessSnapshot *snap, const process_group_t *g) {
+    int processes = 0, threads = 0, last = -1;
+    unsigned long rss = 0;
+    for (int i = g->first; i >= 0; i = table->next[i]) {
+        if (i <= last || i >= snap->count) return 0;
+        const ProcessSample *s = &snap->samples[i];
+        if (table->key == GROUP_BY_USER ? s->uid != g->uid : strcmp(s->command, g->name) != 0) return 0;
+        processes++;
+        threads += s->threads;
+        rss += s->rss_kb;
+        last = i;
+    }
+    return last == g->last && processes == g->processes && threads == g->threads && rss == g->rss_kb;
+}
+
+static void test_empty(void) {
+    GroupTable table = {0};
+    ProcessSnapshot empty = make_snapshot(NULL, 0, 1);
+    int order[4];
+    CHECK(group_find(&table, 0, "init") == -1);
+    CHECK(group_snapshot(&table, GROUP_BY_USER, &empty, NULL, NULL) == 0);
+    CHECK(group_find(&table, 0, "") == -1);
+    CHECK(group_top(&table, GROUP_SORT_CPU, order, 4) == 0);
+    group_table_free(&table);
+    group_table_free(&table);
+}
+
+static void test_small(void) {
+    set_sample(&samples[0], 1, 0, "root", "init");
+    set_sample(&samples[1], 2, 1000, "alice", "bash");
+    set_sample(&samples[2], 3, 1000, "alice", "vim");
+    set_sample(&samples[3], 4, 0, "root", "bash");
+    set_sample(&samples[4], 5, 1001, "bob", "bash");
+    for (int i = 0; i < 5; i++) {
+        samples[i].cpu_percent = i * 10.0f;
+        samples[i].rss_kb = 100 * (i + 1);
+        samples[i].threads = i + 1;
+    }
+    ProcessSnapshot snap = make_snapshot(samples, 5, 1);
+    GroupTable table = {0};
+
+    CHECK(group_snapshot(&table, GROUP_BY_USER, &snap, NULL, NULL) == 3);
+    int root = group_find(&table, 0, NULL), alice = group_find(&table, 1000, NULL);
+    CHECK(root == 0 && alice == 1 && group_find(&table, 1001, NULL) == 2);
+    CHECK(group_find(&table, 4242, NULL) == -1);
+    CHECK(strcmp(table.groups[alice].name, "alice") == 0);
+    CHECK(table.groups[root].processes == 2 && table.groups[root].rss_kb == 500);
+    CHECK(table.groups[alice].cpu_percent == 30.0f && table.groups[alice].threads == 5);
+    for (int g = 0; g < table.count; g++) CHECK(members_add_up(&table, &snap, &table.groups[g]));
+
+    // The same table regroups by another key without stale slots
+    CHECK(group_snapshot(&table, GROUP_BY_COMMAND, &snap, NULL, NULL) == 3);
+    int bash = group_find(&table, 0, "bash");
+    CHECK(bash >= 0 && table.groups[bash].processes == 3 && table.groups[bash].rss_kb == 1100);
+    CHECK(group_find(&table, 0, "root") == -1 && group_find(&table, 0, "bas") == -1);
+    for (int g = 0; g < table.count; g++) CHECK(members_add_up(&table, &snap, &table.groups[g]));
+
+    int order[3];
+    CHECK(group_top(&table, GROUP_SORT_PROCESSES, order, 3) == 3);
+    CHECK(order[0] == bash);
+    CHECK(group_top(&table, GROUP_SORT_RSS, order, 1) == 1 && order[0] == bash);
+    CHECK(group_top(&table, GROUP_SORT_CPU, order, 0) == 0);
+
+    // Only matching processes are counted
+    char error[64];
+    filter_t *filter = filter_compile("cpu >= 20", error, sizeof(error));
+    CHECK(group_snapshot(&table, GROUP_BY_USER, &snap, NULL, filter) == 3);
+    CHECK(table.groups[group_find(&table, 1000, NULL)].processes == 1);
+    filter_free(filter);
+    group_table_free(&table);
+}
+
+// Far more groups than the first slot array holds, so the table rehashes while it fills
+static void test_growth(void) {
+    char name[64];
+    for (int i = 0; i < MANY; i++) {
+        // Names share a long prefix, and the first thousand appear twice
+        snprintf(name, sizeof(name), "worker-with-a-long-shared-prefix-%d", i % 2000);
+        set_sample(&samples[i], i + 1, i % 977, "u", name);
+        samples[i].rss_kb = i;
+        samples[i].cpu_percent = (i % 100) / 4.0f;
+    }
+    ProcessSnapshot snap = make_snapshot(samples, MANY, 1);
+    GroupTable table = {0};
+
+    CHECK(group_snapshot(&table, GROUP_BY_COMMAND, &snap, NULL, NULL) == 2000);
+    int found = 0, sums = 0;
+    for (int i = 0; i < 2000; i++) {
+        snprintf(name, sizeof(name), "worker-with-a-long-shared-prefix-%d", i);
+        int g = group_find(&table, 0, name);
+        if (g == i) found++;
+        if (g >= 0 && table.groups[g].processes == (i < MANY - 2000 ? 2 : 1) &&
+            members_add_up(&table, &snap, &table.groups[g])) sums++;
+    }
+    CHECK(found == 2000 && sums == 2000);
+    CHECK(table.slot_mask + 1 >= 2 * 2000);
+
+    CHECK(group_snapshot(&table, GROUP_BY_USER, &snap, NULL, NULL) == 977);
+    int users = 0;
+    for (uid_t uid = 0; uid < 977; uid++) users += group_find(&table, uid, NULL) == (int)uid;
+    CHECK(users == 977);
+
+    // The top ten by RSS agree with a full scan
+    int order[10];
+    CHECK(group_top(&table, GROUP_SORT_RSS, order, 10) == 10);
+    int sorted = 1;
+    for (int k = 1; k < 10; k++) sorted &= table.groups[order[k - 1]].rss_kb >= table.groups[order[k]].rss_kb;
+    unsigned long best = 0;
+    for (int g = 0; g < table.count; g++) if (table.groups[g].rss_kb > best) best = table.groups[g].rss_kb;
+    CHECK(sorted && table.groups[order[0]].rss_kb == best);
+
+    // Shrinking back to a handful of groups reuses the grown buffers
+    int *slots = table.slots;
+    snap.count = 3;
+    CHECK(group_snapshot(&table, GROUP_BY_COMMAND, &snap, NULL, NULL) == 3);
+    CHECK(table.slots == slots && group_find(&table, 0, "worker-with-a-long-shared-prefix-1999") == -1);
+    group_table_free(&table);
+}
+
+// I/O rates only pair a process with itself: a reused PID or a counter that went back is skipped
+static void test_io_rates(void) {
+    for (int i = 0; i < 4; i++) {
+        set_sample(&old_samples[i], 10 + i, 0, "root", "io");
+        set_sample(&samples[i], 10 + i, 0, "root", "io");
+        old_samples[i].io_bytes = 1000;
+        samples[i].io_bytes = 3000;
+    }
+    samples[1].starttime = 99;
+    samples[2].io_bytes = 10;
+    samples[3].io_bytes = SNAPSHOT_IO_UNKNOWN;
+    ProcessSnapshot before = make_snapshot(old_samples, 4, 10);
+    ProcessSnapshot after = make_snapshot(samples, 4, 12);
+    GroupTable table = {0};
+
+    CHECK(group_snapshot(&table, GROUP_BY_COMMAND, &after, &before, NULL) == 1);
+    CHECK(table.groups[0].io_members == 1 && table.groups[0].io_rate == 1000.0);
+    CHECK(group_snapshot(&table, GROUP_BY_COMMAND, &after, NULL, NULL) == 1);
+    CHECK(table.groups[0].io_members == 0 && table.groups[0].io_rate == 0);
+    ProcessSnapshot empty = make_snapshot(NULL, 0, 11);
+    CHECK(group_snapshot(&table, GROUP_BY_COMMAND, &after, &empty, NULL) == 1);
+    CHECK(table.groups[0].io_members == 0);
+    group_table_free(&table);
+}
+
+int main(void) {
+    test_empty();
+    test_small();
+    test_growth();
+    test_io_rates();
+    return check_done("group");
+}
@@ -0,0 +1,245 @@
+#include <limits.h>
+#include <math.h>
+#include <fcntl.h>
+#include "check.h"
+// The writer is private to headless.c, so the test compiles it in
+#include "../headless.c"
+
+static FILE *capture_file;
+static int saved_stdout = -1;
+static char captured[1 << 21];
+
+// Points stdout at a temporary file until capture_end
+static void capture_begin(void) {
+    fflush(stdout);
+    capture_file = tmpfile();
+    saved_stdout = dup(STDOUT_FILENO);
+    dup2(fileno(capture_file), STDOUT_FILENO);
+}
+
+// Flushes the writer and returns everything written since capture_begin
+static const char *capture_end(writer_t *w) {
+    flush_output(w);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    rewind(capture_file);
+    size_t n = fread(captured, 1, sizeof(captured) - 1, capture_file);
+    captured[n] = '\0';
+    fclose(capture_file);
+    return captured;
+}
+
+static writer_t w;
+
+static const char *fixed(double value, int decimals) {
+    capture_begin();
+    put_fixed(&w, value, decimals);
+    return capture_end(&w);
+}
+
+static const char *json(const char *s) {
+    capture_begin();
+    put_json_string(&w, s);
+    return capture_end(&w);
+}
+
+static const char *csv(const char *s) {
+    capture_begin();
+    put_csv_string(&w, s);
+    return capture_end(&w);
+}
+
+static void test_numbers(void) {
+    capture_begin();
+    put_uint(&w, 0);
+    put_char(&w, ' ');
+    put_uint(&w, 7);
+    put_char(&w, ' ');
+    put_uint(&w, ULLONG_MAX);
+    CHECK(strcmp(capture_end(&w), "0 7 18446744073709551615") == 0);
+
+    CHECK(strcmp(fixed(0, 1), "0.0") == 0);
+    CHECK(strcmp(fixed(12.346, 2), "12.35") == 0);
+    CHECK(strcmp(fixed(99.96, 1), "100.0") == 0);
+    CHECK(strcmp(fixed(0.004, 2), "0.00") == 0);
+    CHECK(strcmp(fixed(1.5, 0), "2") == 0);
+    CHECK(strcmp(fixed(-2.25, 3), "-2.250") == 0);
+    // Rounds to zero without a sign
+    CHECK(strcmp(fixed(-0.0001, 1), "0.0") == 0);
+    CHECK(strcmp(fixed(1700000000.1234, 3), "1700000000.123") == 0);
+
+    // Past what fits 64 bits once scaled
+    CHECK(strcmp(fixed(1e17, 3), "100000000000000000.000") == 0);
+    CHECK(strcmp(fixed(-1e20, 1), "-100000000000000000000.0") == 0);
+    CHECK(strcmp(fixed(NAN, 2), "0.00") == 0);
+    const char *huge = fixed(INFINITY, 1);
+    CHECK(strlen(huge) == 311 && strncmp(huge, "17976931348623157", 17) == 0);
+    CHECK(fixed(-INFINITY, 1)[0] == '-');
+}
+
+static void test_strings(void) {
+    CHECK(strcmp(json(""), "\"\"") == 0);
+    CHECK(strcmp(json("bash"), "\"bash\"") == 0);
+    CHECK(strcmp(json("say \"hi\" \\ bye"), "\"say \\\"hi\\\" \\\\ bye\"") == 0);
+    CHECK(strcmp(json("a\nb\tc\x01\x1f"), "\"a\\u000ab\\u0009c\\u0001\\u001f\"") == 0);
+    // Bytes above ASCII are UTF-8 and pass through
+    CHECK(strcmp(json("görev \x7f"), "\"görev \x7f\"") == 0);
+
+    CHECK(strcmp(csv(""), "") == 0);
+    CHECK(strcmp(csv("kworker/0:1"), "kworker/0:1") == 0);
+    CHECK(strcmp(csv("a,b"), "\"a,b\"") == 0);
+    CHECK(strcmp(csv("say \"hi\""), "\"say \"\"hi\"\"\"") == 0);
+    CHECK(strcmp(csv("two\nlines"), "\"two\nlines\"") == 0);
+    CHECK(strcmp(csv("cr\r"), "\"cr\r\"") == 0);
+    CHECK(strcmp(csv("\""), "\"\"\"\"") == 0);
+}
+
+static tm_process_t sample_process(void) {
+    tm_process_t p;
+    memset(&p, 0, sizeof(p));
+    p.pid = 42;
+    p.ppid = 1;
+    p.uid = 1000;
+    p.state = 'R';
+    snprintf(p.command, sizeof(p.command), "my,\"app\"");
+    snprintf(p.user, sizeof(p.user), "alice");
+    p.cpu_percent = 12.34f;
+    p.mem_percent = 0.5f;
+    p.rss_kb = 2048;
+    p.vsize_kb = ULONG_MAX;
+    p.threads = 3;
+    p.minflt = 10;
+    p.majflt = 0;
+    p.cpu_seconds = 1.239;
+    p.start_seconds = 100.5;
+    return p;
+}
+
+static void test_records(void) {
+    headless_options_t opts;
+    headless_options_init(&opts);
+    CHECK(headless_set_columns(&opts, "pid,ppid,uid,user,state,cpu,mem,rss,vsz,threads,minflt,majflt,time,start,cmd"));
+    tm_process_t p = sample_process();
+
+    capture_begin();
+    put_object(&w, &opts, 1700000000.5, &p);
+    CHECK(strcmp(capture_end(&w),
+                 "{\"ts\":1700000000.500,\"pid\":42,\"ppid\":1,\"uid\":1000,\"user\":\"alice\",\"state\":\"R\","
+                 "\"cpu\":12.3,\"mem\":0.5,\"rss\":2048,\"vsz\":18446744073709551615,\"threads\":3,"
+                 "\"minflt\":10,\"majflt\":0,\"time\":1.24,\"start\":100.50,\"cmd\":\"my,\\\"app\\\"\"}") == 0);
+
+    // JSON documents carry ts once per sample, not per process
+    CHECK(headless_set_format(&opts, "json"));
+    CHECK(headless_set_columns(&opts, "pid,cmd"));
+    capture_begin();
+    put_object(&w, &opts, 1, &p);
+    CHECK(strcmp(capture_end(&w), "{\"pid\":42,\"cmd\":\"my,\\\"app\\\"\"}") == 0);
+
+    CHECK(headless_set_format(&opts, "csv"));
+    CHECK(headless_set_columns(&opts, "cmd,state,pid,cmd"));
+    capture_begin();
+    for (int i = 0; i < opts.column_count; i++) {
+        if (i > 0) put_char(&w, ',');
+        put_value(&w, opts.format, opts.columns[i], &p);
+    }
+    CHECK(strcmp(capture_end(&w), "\"my,\"\"app\"\"\",R,42,\"my,\"\"app\"\"\"") == 0);
+
+    // Fields at their full width
+    memset(p.command, 'c', sizeof(p.command) - 1);
+    memset(p.user, '"', sizeof(p.user) - 1);
+    CHECK(headless_set_columns(&opts, "user,cmd"));
+    capture_begin();
+    put_value(&w, opts.format, COLUMN_USER, &p);
+    put_value(&w, opts.format, COLUMN_CMD, &p);
+    CHECK(strlen(capture_end(&w)) == 2 + 2 * (sizeof(p.user) - 1) + sizeof(p.command) - 1);
+}
+
+// Many more rows than the buffer holds come out whole and in order
+static void test_buffer_boundaries(void) {
+    headless_options_t opts;
+    headless_options_init(&opts);
+    tm_process_t p = sample_process();
+    int rows = 3 * HEADLESS_BUFFER_SIZE / 40;
+    capture_begin();
+    for (int i = 0; i < rows; i++) {
+        p.pid = i;
+        put_object(&w, &opts, i, &p);
+        put_char(&w, '\n');
+    }
+    const char *text = capture_end(&w);
+
+    int lines = 0, ordered = 1;
+    for (const char *line = text; *line; lines++) {
+        const char *end = strchr(line, '\n');
+        if (!end) break;
+        char expect[64];
+        int n = snprintf(expect, sizeof(expect), "{\"ts\":%d.000,\"pid\":%d,", lines, lines);
+        if (strncmp(line, expect, n) != 0 || end[-1] != '}') ordered = 0;
+        line = end + 1;
+    }
+    CHECK(lines == rows && ordered);
+    CHECK(w.used == 0 && w.failed == 0);
+}
+
+// A reader that went away stops the writer instead of killing the process
+static void test_closed_pipe(void) {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    close(fds[0]);
+    signal(SIGPIPE, SIG_IGN);
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[1]);
+
+    writer_t broken = {0};
+    put_str(&broken, "lost");
+    flush_output(&broken);
+    int failed = broken.failed;
+    for (int i = 0; i < HEADLESS_BUFFER_SIZE; i++) put_char(&broken, 'x');
+    flush_output(&broken);
+
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    CHECK(failed == EPIPE && broken.failed == EPIPE && broken.used == 0);
+}
+
+static void test_options(void) {
+    headless_options_t opts;
+    headless_options_init(&opts);
+    CHECK(opts.format == HEADLESS_NDJSON && opts.interval_ms == 1000 && !opts.once && !opts.filter);
+    CHECK(opts.column_count == 6 && opts.columns[0] == COLUMN_PID && opts.columns[5] == COLUMN_CMD);
+
+    char many[HEADLESS_MAX_COLUMNS * 4 + 8] = "";
+    for (int i = 0; i < HEADLESS_MAX_COLUMNS; i++) strcat(many, i ? ",pid" : "pid");
+    CHECK(headless_set_columns(&opts, many) && opts.column_count == HEADLESS_MAX_COLUMNS);
+    CHECK(headless_set_columns(&opts, "cpu,") && opts.column_count == 1 && opts.columns[0] == COLUMN_CPU);
+
+    // Rejected lists leave the previous selection alone; the messages go to stderr
+    fflush(stderr);
+    int saved = dup(STDERR_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDERR_FILENO);
+    close(null);
+    strcat(many, ",pid");
+    int rejected = !headless_set_columns(&opts, many) + !headless_set_columns(&opts, "") +
+                   !headless_set_columns(&opts, ",") + !headless_set_columns(&opts, "pid,,cpu") +
+                   !headless_set_columns(&opts, "pid,bogus") + !headless_set_columns(&opts, "PID") +
+                   !headless_set_columns(&opts, "pi") + !headless_set_format(&opts, "xml") +
+                   !headless_set_format(&opts, "") + !headless_set_format(&opts, "CSV");
+    fflush(stderr);
+    dup2(saved, STDERR_FILENO);
+    close(saved);
+    CHECK(rejected == 10);
+    CHECK(opts.column_count == 1 && opts.columns[0] == COLUMN_CPU && opts.format == HEADLESS_NDJSON);
+}
+
+int main(void) {
+    test_numbers();
+    test_strings();
+    test_records();
+    test_buffer_boundaries();
+    test_closed_pipe();
+    test_options();
+    return check_done("headless");
+}
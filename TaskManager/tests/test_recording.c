@@ -0,0 +1,269 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include "check.h"
+#include "../recording.h"
+
+#define FRAMES 40
+#define KEYFRAME_INTERVAL 8
+#define MAX_ROWS 64
+
+static ProcessSnapshot frames[FRAMES];
+static unsigned int seed = 12345;
+
+static unsigned int next_random(void) {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// Values that stress the varint and zigzag widths in both directions
+static unsigned long long edge_value(void) {
+    static const unsigned long long edges[] = {
+        0, 1, 127, 128, 16383, 16384, (1ULL << 32) - 1, 1ULL << 32,
+        INT64_MAX, (unsigned long long)INT64_MAX + 1, UINT64_MAX - 1, UINT64_MAX
+    };
+    if (next_random() % 3) return next_random() % 1000;
+    return edges[next_random() % (sizeof(edges) / sizeof(edges[0]))];
+}
+
+static void fill_sample(ProcessSample *s, pid_t pid, unsigned long long starttime) {
+    memset(s, 0, sizeof(*s));
+    s->pid = pid;
+    s->ppid = next_random() % 2 ? 1 : INT_MAX;
+    s->uid = next_random() % 2 ? 0 : UINT_MAX - 1;
+    s->state = "RSDZT"[next_random() % 5];
+    snprintf(s->command, sizeof(s->command), "cmd-%u", next_random() % 7);
+    if (next_random() % 5 == 0) memset(s->command, 'x', sizeof(s->command) - 1);
+    snprintf(s->username, sizeof(s->username), "user%u", next_random() % 3);
+    s->starttime = starttime;
+    s->cpu_percent = (next_random() % 4000) / 10.0f;
+}
+
+// Moves every counter, sometimes backwards and sometimes across the whole range
+static void mutate_sample(ProcessSample *s) {
+    if (next_random() % 4 == 0) return;
+    s->utime = edge_value();
+    s->stime = edge_value();
+    s->minflt = edge_value();
+    s->majflt = next_random() % 2 ? 0 : ULONG_MAX;
+    s->vsize_kb = edge_value();
+    s->rss_kb = next_random() % 2 ? s->rss_kb / 2 : ULONG_MAX - next_random() % 10;
+    s->threads = next_random() % 2 ? 1 : INT_MAX;
+    s->state = "RSDZT"[next_random() % 5];
+    s->cpu_percent = (next_random() % 4000) / 10.0f;
+    if (next_random() % 6 == 0) snprintf(s->command, sizeof(s->command), "renamed-%u", next_random() % 3);
+}
+
+// Frame f keeps most of frame f - 1, drops some PIDs, adds new ones and reuses old ones
+static void build_frames(void) {
+    pid_t next_pid = 100;
+    for (int f = 0; f < FRAMES; f++) {
+        ProcessSnapshot *snap = &frames[f];
+        snap->samples = calloc(MAX_ROWS, sizeof(ProcessSample));
+        snap->capacity = MAX_ROWS;
+        snap->timestamp = 1000.0 + f;
+        snap->uptime = 500.0 + f;
+        snap->mem_total_kb = 16 * 1024 * 1024;
+        // Frames 0, 9 and 21 are empty; 21 is inside a block, 9 follows a keyframe
+        if (f == 0 || f == 9 || f == 21) continue;
+
+        const ProcessSnapshot *prev = &frames[f - 1];
+        int n = 0;
+        for (int i = 0; i < prev->count && n < MAX_ROWS; i++) {
+            unsigned int roll = next_random() % 10;
+            if (roll == 0) continue;
+            snap->samples[n] = prev->samples[i];
+            // Same PID, new process: the start time tells them apart
+            if (roll == 1) fill_sample(&snap->samples[n], prev->samples[i].pid, 5000 + f);
+            mutate_sample(&snap->samples[n]);
+            n++;
+        }
+        int arrivals = prev->count == 0 ? 20 : next_random() % 4;
+        for (int i = 0; i < arrivals && n < MAX_ROWS; i++) {
+            fill_sample(&snap->samples[n], next_pid, 100 + f);
+            next_pid += 1 + next_random() % 300;
+            n++;
+        }
+        snap->count = n;
+    }
+}
+
+static int same_sample(const ProcessSample *a, const ProcessSample *b) {
+    return a->pid == b->pid && a->ppid == b->ppid && a->uid == b->uid && a->state == b->state &&
+           strcmp(a->command, b->command) == 0 && strcmp(a->username, b->username) == 0 &&
+           a->utime == b->utime && a->stime == b->stime && a->starttime == b->starttime &&
+           a->minflt == b->minflt && a->majflt == b->majflt && a->vsize_kb == b->vsize_kb &&
+           a->rss_kb == b->rss_kb && a->threads == b->threads &&
+           (int)(a->cpu_percent * 10 + 0.5f) == (int)(b->cpu_percent * 10 + 0.5f);
+}
+
+static int same_frame(const ProcessSnapshot *expected, const ProcessSnapshot *got) {
+    if (expected->count != got->count || expected->timestamp != got->timestamp ||
+        expected->uptime != got->uptime || expected->mem_total_kb != got->mem_total_kb) return 0;
+    for (int i = 0; i < expected->count; i++) {
+        if (!same_sample(&expected->samples[i], &got->samples[i])) return 0;
+    }
+    return 1;
+}
+
+static void test_round_trip(const char *path) {
+    recorder_t *rec = recorder_open(path, KEYFRAME_INTERVAL);
+    CHECK(rec != NULL);
+    if (!rec) return;
+    for (int f = 0; f < FRAMES; f++) CHECK(recorder_append(rec, &frames[f]) > 0);
+    recorder_close(rec);
+
+    replay_t *replay = replay_open(path);
+    CHECK(replay != NULL);
+    if (!replay) return;
+    CHECK(replay_frame_count(replay) == FRAMES);
+
+    replay_info_t info;
+    replay_info(replay, &info);
+    CHECK(info.blocks == (FRAMES + KEYFRAME_INTERVAL - 1) / KEYFRAME_INTERVAL);
+    CHECK(info.last_rows == frames[FRAMES - 1].count);
+
+    ProcessSnapshot snap = {0};
+    int sequential_ok = 1;
+    for (int f = 0; f < FRAMES; f++) {
+        if (replay_read(replay, f, &snap) != frames[f].count || !same_frame(&frames[f], &snap)) sequential_ok = 0;
+    }
+    CHECK(sequential_ok);
+
+    // Seeks backwards, within a block and across several keyframes
+    static const int order[] = { 39, 0, 17, 16, 15, 23, 24, 8, 7, 31, 9, 21, 22, 38, 1, 20 };
+    int seek_ok = 1;
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        int f = order[i];
+        if (replay_read(replay, f, &snap) != frames[f].count || !same_frame(&frames[f], &snap)) seek_ok = 0;
+    }
+    CHECK(seek_ok);
+
+    CHECK(replay_read(replay, -1, &snap) == -1);
+    CHECK(replay_read(replay, FRAMES, &snap) == -1);
+    CHECK(replay_find_time(replay, 0) == 0);
+    CHECK(replay_find_time(replay, replay_frame_time(replay, 12)) == 12);
+    CHECK(replay_find_time(replay, 1e18) == FRAMES - 1);
+
+    snapshot_free(&snap);
+    replay_close(replay);
+}
+
+// A recorder killed mid-frame leaves a partial frame that replay must ignore
+static void test_truncated(const char *path) {
+    recorder_t *rec = recorder_open(path, KEYFRAME_INTERVAL);
+    CHECK(rec != NULL);
+    if (!rec) return;
+    for (int f = 0; f < 12; f++) recorder_append(rec, &frames[f]);
+    unsigned long long complete = recorder_bytes(rec);
+    long last = recorder_append(rec, &frames[12]);
+    recorder_close(rec);
+    CHECK(last > 1);
+    CHECK(truncate(path, complete + last / 2) == 0);
+
+    replay_t *replay = replay_open(path);
+    CHECK(replay != NULL);
+    if (!replay) return;
+    CHECK(replay_frame_count(replay) == 12);
+    ProcessSnapshot snap = {0};
+    CHECK(replay_read(replay, 11, &snap) == frames[11].count && same_frame(&frames[11], &snap));
+    CHECK(replay_read(replay, 12, &snap) == -1);
+    snapshot_free(&snap);
+    replay_close(replay);
+}
+
+// Three blocks of four frames; only the middle one holds a process above 1G
+static void test_query(const char *path) {
+    recorder_t *rec = recorder_open(path, 4);
+    CHECK(rec != NULL);
+    if (!rec) return;
+    ProcessSample samples[2];
+    ProcessSnapshot snap = { .samples = samples, .count = 2, .capacity = 2 };
+    for (int f = 0; f < 12; f++) {
+        fill_sample(&samples[0], 100, 10);
+        fill_sample(&samples[1], 200, f < 10 ? 20 : 30);
+        samples[0].rss_kb = samples[1].rss_kb = 100;
+        if (f >= 4 && f < 8) samples[1].rss_kb = 5 * 1024 * 1024 + f;
+        samples[1].utime = f;
+        snap.timestamp = f;
+        CHECK(recorder_append(rec, &snap) > 0);
+        // Frames need distinct wall clock times to be told apart by range
+        usleep(2000);
+    }
+    recorder_close(rec);
+
+    replay_t *replay = replay_open(path);
+    CHECK(replay != NULL);
+    if (!replay) return;
+    char error[128];
+    filter_t *big = filter_compile("rss > 1G", error, sizeof(error));
+    filter_t *pid = filter_compile("pid == 200", error, sizeof(error));
+    double first = replay_frame_time(replay, 0), last = replay_frame_time(replay, 11);
+    replay_match_t *matches = NULL;
+    replay_query_stats_t stats;
+
+    CHECK(replay_query(replay, first, last, big, &matches, &stats) == 1);
+    CHECK(stats.blocks == 3 && stats.blocks_skipped == 2 && stats.frames == 4);
+    CHECK(matches && matches[0].pid == 200 && matches[0].frames == 4);
+    CHECK(matches && matches[0].peak_rss_kb == 5 * 1024 * 1024 + 7);
+    CHECK(matches && matches[0].first_ticks == 4 && matches[0].last_ticks == 7);
+    CHECK(matches && matches[0].first_seen == replay_frame_time(replay, 4));
+    free(matches);
+
+    // A reused PID is a second process
+    CHECK(replay_query(replay, first, last, pid, &matches, &stats) == 2);
+    CHECK(matches && matches[0].frames + matches[1].frames == 12);
+    CHECK(matches && matches[0].starttime != matches[1].starttime);
+    free(matches);
+
+    // Two frames in the middle block, every process
+    CHECK(replay_query(replay, replay_frame_time(replay, 5), replay_frame_time(replay, 6), NULL, &matches, &stats) == 2);
+    CHECK(stats.blocks == 1 && stats.frames == 2 && stats.rows == 4);
+    free(matches);
+
+    CHECK(replay_query(replay, first - 100, first - 50, NULL, &matches, &stats) == 0);
+    CHECK(stats.frames == 0);
+    free(matches);
+    CHECK(replay_query(replay, last + 50, last + 100, NULL, &matches, &stats) == 0);
+    free(matches);
+
+    filter_free(big);
+    filter_free(pid);
+    replay_close(replay);
+}
+
+static void test_not_a_recording(const char *path) {
+    FILE *fp = fopen(path, "w");
+    CHECK(fp != NULL);
+    if (!fp) return;
+    fputs("pid,user,cpu\n1,root,0.0\n", fp);
+    fclose(fp);
+    CHECK(replay_open(path) == NULL);
+
+    fp = fopen(path, "w");
+    fclose(fp);
+    CHECK(replay_open(path) == NULL);
+    CHECK(replay_open("/nonexistent/recording") == NULL);
+}
+
+int main(void) {
+    char path[] = "/tmp/taskmgr-test-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    build_frames();
+    test_round_trip(path);
+    test_truncated(path);
+    test_query(path);
+    test_not_a_recording(path);
+
+    unlink(path);
+    for (int f = 0; f < FRAMES; f++) snapshot_free(&frames[f]);
+    return check_done("recording");
+}
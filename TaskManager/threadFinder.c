@@ -1,13 +1,18 @@
-#include <mach/mach.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
-#include <sys/sysctl.h>
-#include <libproc.h>
 #include <errno.h>
 #include <pwd.h>
+#include "process_manager.h"
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#include <sys/sysctl.h>
+#include <libproc.h>
+
 
 void list_threads_of_process(pid_t pid) {
     task_t task;
@@ -92,7 +97,10 @@ static int get_thread_info_proc(pid_t pid, int *count, char *summary, size_t sum
 }
 
 // Helper for table: fills thread_count and a summary string (id:STATE, ...)
-void get_thread_summary_for_table(pid_t pid, int *thread_count, char *summary, size_t summary_size) {
+void get_thread_summary_for_table(pid_t pid, char *scratch, size_t scratch_size,
+                                  int *thread_count, char *summary, size_t summary_size) {
+    (void)scratch;
+    (void)scratch_size;
     // Initialize outputs
     if (thread_count) *thread_count = 0;
     if (summary && summary_size > 0) summary[0] = '\0';
@@ -183,4 +191,471 @@ void get_thread_summary_for_table(pid_t pid, int *thread_count, char *summary, s
     }
     vm_deallocate(mach_task_self(), (vm_address_t)thread_list, tcount * sizeof(thread_act_t));
     mach_port_deallocate(mach_task_self(), task);
-}
\ No newline at end of file
+}
+
+int profile_process(pid_t pid, int seconds, const char *output_path) {
+    (void)pid;
+    (void)seconds;
+    (void)output_path;
+    printf("Profiling requires perf_event_open and is only available on Linux\n");
+    return 0;
+}
+
+#else
+#include <ctype.h>
+#include <dirent.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counters.h"
+#include "symbolizer.h"
+
+#define PROFILE_MAX_THREADS 64      // Each sampled thread holds an fd and a mapped ring; the rest are reported
+#define PROFILE_RING_PAGES 16       // Data pages per thread, must be a power of two
+#define PROFILE_FREQUENCY 99        // Samples per second, off-beat with common timers
+#define PROFILE_MAX_STACK 8192
+
+// Reads the state letter and utime ticks of one thread from /proc
+// Plain open/read: fopen would allocate a FILE and its buffer per thread
+static int read_thread_stat(pid_t pid, pid_t tid, char *state, unsigned long *utime) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, tid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return 0;
+    buf[len] = '\0';
+
+    // comm may contain spaces and parentheses, fields start after the last ')'
+    char *p = strrchr(buf, ')');
+    if (!p) return 0;
+    return sscanf(p + 2, "%c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu", state, utime) == 2;
+}
+
+static const char *thread_state_name(char state, int short_name) {
+    switch (state) {
+        case 'R': return short_name ? "RUN" : "RUNNING";
+        case 'S': return short_name ? "WAIT" : "WAITING";
+        case 'D': return short_name ? "UNINT" : "UNINTERRUPTIBLE";
+        case 'T':
+        case 't': return short_name ? "STOP" : "STOPPED";
+        case 'Z':
+        case 'X': return short_name ? "HALT" : "HALTED";
+        case 'I': return short_name ? "IDLE" : "IDLE";
+        default: return short_name ? "UNK" : "UNKNOWN";
+    }
+}
+
+void list_threads_of_process(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return;
+    }
+
+    pid_t tids[1024];
+    int thread_count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && thread_count < 1024) {
+        if (isdigit((unsigned char)entry->d_name[0])) {
+            tids[thread_count++] = atoi(entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    printf("PID %d için %d thread found:\n", pid, thread_count);
+    for (int i = 0; i < thread_count; i++) {
+        char state;
+        unsigned long utime;
+        if (read_thread_stat(pid, tids[i], &state, &utime)) {
+            printf("Thread %d: state: %s, user_time: %lu.%06lu sec\n",
+                   tids[i], thread_state_name(state, 0),
+                   utime / ticks, (utime % ticks) * 1000000 / ticks);
+        }
+    }
+}
+
+// What getdents64 fills the scratch buffer with
+typedef struct {
+    uint64_t ino;
+    int64_t off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[];
+} task_dirent_t;
+
+// Helper for table: fills thread_count and a summary string (id:STATE, ...). The task
+// directory is read with getdents64 into the caller's scratch buffer, since opendir
+// would allocate its own for every process of a listing.
+void get_thread_summary_for_table(pid_t pid, char *scratch, size_t scratch_size,
+                                  int *thread_count, char *summary, size_t summary_size) {
+    if (thread_count) *thread_count = 0;
+    if (summary && summary_size > 0) summary[0] = '\0';
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    int fd = scratch ? open(path, O_RDONLY | O_DIRECTORY) : -1;
+    if (fd < 0) {
+        if (summary && summary_size > 0) {
+            snprintf(summary, summary_size, "Limited info");
+        }
+        return;
+    }
+
+    char *ptr = summary;
+    size_t left = summary_size;
+    int count = 0;
+    long len;
+    while ((len = syscall(SYS_getdents64, fd, scratch, scratch_size)) > 0) {
+        for (long offset = 0; offset < len;) {
+            const task_dirent_t *entry = (const task_dirent_t *)(scratch + offset);
+            offset += entry->reclen;
+            if (!isdigit((unsigned char)entry->name[0])) continue;
+            pid_t tid = atoi(entry->name);
+            count++;
+
+            // Keep counting once the summary is full, but stop reading stat files
+            if (!summary || left <= 1) continue;
+            char state;
+            unsigned long utime;
+            if (!read_thread_stat(pid, tid, &state, &utime)) continue;
+
+            int written = snprintf(ptr, left, "%s%d:%s", ptr == summary ? "" : ", ",
+                                   tid, thread_state_name(state, 1));
+            if (written < 0 || (size_t)written >= left) {
+                left = 0;
+                continue;
+            }
+            ptr += written;
+            left -= written;
+        }
+    }
+    close(fd);
+
+    if (thread_count) *thread_count = count;
+}
+
+typedef struct {
+    int fd;
+    struct perf_event_mmap_page *meta;
+    size_t map_size;
+} sample_ring_t;
+
+typedef struct {
+    char *stack;
+    unsigned long count;
+} folded_entry_t;
+
+// Open-addressing table from folded stack string to sample count
+typedef struct {
+    folded_entry_t *entries;
+    size_t capacity;
+    size_t used;
+} folded_table_t;
+
+static uint64_t hash_string(const char *s) {
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int folded_table_add(folded_table_t *table, const char *stack) {
+    if ((table->used + 1) * 2 > table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 1024;
+        folded_entry_t *entries = calloc(capacity, sizeof(folded_entry_t));
+        if (!entries) return 0;
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (!table->entries[i].stack) continue;
+            size_t slot = hash_string(table->entries[i].stack) & (capacity - 1);
+            while (entries[slot].stack) slot = (slot + 1) & (capacity - 1);
+            entries[slot] = table->entries[i];
+        }
+        free(table->entries);
+        table->entries = entries;
+        table->capacity = capacity;
+    }
+
+    size_t slot = hash_string(stack) & (table->capacity - 1);
+    while (table->entries[slot].stack) {
+        if (strcmp(table->entries[slot].stack, stack) == 0) {
+            table->entries[slot].count++;
+            return 1;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    table->entries[slot].stack = strdup(stack);
+    if (!table->entries[slot].stack) return 0;
+    table->entries[slot].count = 1;
+    table->used++;
+    return 1;
+}
+
+static void folded_table_free(folded_table_t *table) {
+    for (size_t i = 0; i < table->capacity; i++) {
+        free(table->entries[i].stack);
+    }
+    free(table->entries);
+}
+
+// Appends "name" to the folded stack, separated by ';'
+static size_t append_frame(char *out, size_t pos, const char *name) {
+    size_t len = strlen(name);
+    if (pos + len + 2 >= PROFILE_MAX_STACK) return pos;
+    if (pos > 0) out[pos++] = ';';
+    memcpy(out + pos, name, len);
+    pos += len;
+    out[pos] = '\0';
+    return pos;
+}
+
+// Turns one PERF_RECORD_SAMPLE (TID | CALLCHAIN) into a folded stack entry
+static void record_sample(const char *record, const char *comm, symbolizer_t *sym,
+                          folded_table_t *table) {
+    const uint64_t *nr = (const uint64_t *)(record + sizeof(struct perf_event_header) + 2 * sizeof(uint32_t));
+    const uint64_t *ips = nr + 1;
+    char kernel_frame[PERF_MAX_STACK_DEPTH];
+    uint64_t depth = *nr < PERF_MAX_STACK_DEPTH ? *nr : PERF_MAX_STACK_DEPTH;
+
+    // Context markers precede the frames they describe, so resolve them first
+    int in_kernel = 0;
+    for (uint64_t i = 0; i < depth; i++) {
+        if (ips[i] >= (uint64_t)PERF_CONTEXT_MAX) {
+            in_kernel = (ips[i] == (uint64_t)PERF_CONTEXT_KERNEL);
+        }
+        kernel_frame[i] = in_kernel;
+    }
+
+    char stack[PROFILE_MAX_STACK];
+    size_t pos = append_frame(stack, 0, comm);
+    int last_was_kernel = 0;
+
+    // The callchain is leaf first; folded stacks are root first
+    for (uint64_t i = depth; i-- > 0;) {
+        if (ips[i] >= (uint64_t)PERF_CONTEXT_MAX) continue;
+        if (kernel_frame[i]) {
+            if (!last_was_kernel) pos = append_frame(stack, pos, "[kernel]");
+            last_was_kernel = 1;
+        } else {
+            pos = append_frame(stack, pos, symbolizer_lookup(sym, ips[i]));
+            last_was_kernel = 0;
+        }
+    }
+    folded_table_add(table, stack);
+}
+
+// Consumes every complete record between data_tail and data_head
+static void drain_ring(sample_ring_t *ring, size_t page_size, const char *comm,
+                       symbolizer_t *sym, folded_table_t *table,
+                       unsigned long *samples, unsigned long *lost) {
+    struct perf_event_mmap_page *meta = ring->meta;
+    char *data = (char *)meta + page_size;
+    uint64_t data_size = (uint64_t)PROFILE_RING_PAGES * page_size;
+
+    uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    uint64_t tail = meta->data_tail;
+    char record[sizeof(struct perf_event_header) + 16 + 8 * (PERF_MAX_STACK_DEPTH + 8)];
+
+    while (tail < head) {
+        struct perf_event_header header;
+        uint64_t offset = tail & (data_size - 1);
+
+        // Records can wrap around the end of the buffer
+        for (size_t i = 0; i < sizeof(header); i++) {
+            ((char *)&header)[i] = data[(offset + i) & (data_size - 1)];
+        }
+        if (header.size == 0) break;
+
+        if (header.size <= sizeof(record)) {
+            for (size_t i = 0; i < header.size; i++) {
+                record[i] = data[(offset + i) & (data_size - 1)];
+            }
+            if (header.type == PERF_RECORD_SAMPLE) {
+                record_sample(record, comm, sym, table);
+                (*samples)++;
+            } else if (header.type == PERF_RECORD_LOST) {
+                *lost += ((const uint64_t *)(record + sizeof(header)))[1];
+            }
+        }
+        tail += header.size;
+    }
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+static int open_sampling_event(pid_t tid, int hardware, int user_only) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = hardware ? PERF_TYPE_HARDWARE : PERF_TYPE_SOFTWARE;
+    attr.config = hardware ? PERF_COUNT_HW_CPU_CYCLES : PERF_COUNT_SW_CPU_CLOCK;
+    attr.freq = 1;
+    attr.sample_freq = PROFILE_FREQUENCY;
+    attr.sample_type = PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+    attr.disabled = 1;
+    attr.exclude_kernel = user_only;
+    attr.exclude_hv = user_only;
+    attr.exclude_callchain_kernel = user_only;
+    attr.wakeup_events = 32;
+    return syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void read_process_comm(pid_t pid, char *comm, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    snprintf(comm, size, "pid-%d", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    if (fgets(comm, size, fp)) comm[strcspn(comm, "\n")] = '\0';
+    fclose(fp);
+
+    // Spaces and ';' would break the folded format
+    for (char *c = comm; *c; c++) {
+        if (*c == ' ' || *c == ';') *c = '_';
+    }
+}
+
+int profile_process(pid_t pid, int seconds, const char *output_path) {
+    if (pid <= 0 || seconds <= 0 || output_path == NULL) {
+        printf("Invalid profiling parameters\n");
+        return 0;
+    }
+
+    char reason[128];
+    if (!perf_counters_available(reason, sizeof(reason))) {
+        printf("Profiling unavailable: %s\n", reason);
+        return 0;
+    }
+
+    // Inherited events cannot be mmapped per task, so sample each thread
+    pid_t tids[PROFILE_MAX_THREADS];
+    int tid_count = 0;
+    int skipped = 0;                // Threads over the limit or whose event did not open
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        printf("Process with PID %d not found\n", pid);
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)entry->d_name[0])) continue;
+        if (tid_count < PROFILE_MAX_THREADS) tids[tid_count++] = atoi(entry->d_name);
+        else skipped++;
+    }
+    closedir(dir);
+
+    int user_only = (geteuid() != 0);
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t map_size = (1 + PROFILE_RING_PAGES) * page_size;
+    sample_ring_t rings[PROFILE_MAX_THREADS];
+    struct pollfd pfds[PROFILE_MAX_THREADS];
+    int ring_count = 0;
+    int hardware = 1;
+
+    for (int i = 0; i < tid_count; i++) {
+        int fd = open_sampling_event(tids[i], hardware, user_only);
+        if (fd < 0 && hardware && ring_count == 0 &&
+            (errno == ENOENT || errno == EOPNOTSUPP || errno == ENODEV || errno == EINVAL)) {
+            // No usable PMU (VMs): sample on the CPU clock instead
+            hardware = 0;
+            fd = open_sampling_event(tids[i], hardware, user_only);
+        }
+        if (fd < 0) {
+            if (ring_count == 0 && (errno == EACCES || errno == EPERM)) {
+                printf("Permission denied profiling PID %d (need CAP_PERFMON or same user)\n", pid);
+                return 0;
+            }
+            if (errno != ESRCH) skipped++;
+            continue;
+        }
+
+        void *base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            skipped++;
+            continue;
+        }
+        rings[ring_count].fd = fd;
+        rings[ring_count].meta = base;
+        rings[ring_count].map_size = map_size;
+        pfds[ring_count].fd = fd;
+        pfds[ring_count].events = POLLIN;
+        ring_count++;
+    }
+
+    if (ring_count == 0) {
+        printf("Could not open sampling events for PID %d: %s\n", pid, strerror(errno));
+        return 0;
+    }
+
+    char comm[64];
+    read_process_comm(pid, comm, sizeof(comm));
+    symbolizer_t *sym = symbolizer_create(pid);
+    folded_table_t table = {0};
+    unsigned long samples = 0, lost = 0;
+
+    printf("Profiling PID %d (%s) for %d s at %d Hz on %d threads using %s...\n",
+           pid, comm, seconds, PROFILE_FREQUENCY, ring_count,
+           hardware ? "cpu-cycles" : "cpu-clock");
+    if (skipped > 0) {
+        printf("%d threads are not sampled (at most %d, or their event failed to open)\n",
+               skipped, PROFILE_MAX_THREADS);
+    }
+    fflush(stdout);
+
+    for (int i = 0; i < ring_count; i++) ioctl(rings[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+
+    time_t deadline = time(NULL) + seconds;
+    time_t last_refresh = time(NULL);
+    while (time(NULL) < deadline) {
+        poll(pfds, ring_count, 100);
+        for (int i = 0; i < ring_count; i++) {
+            drain_ring(&rings[i], page_size, comm, sym, &table, &samples, &lost);
+        }
+        // Pick up libraries loaded while profiling
+        if (time(NULL) != last_refresh && sym) {
+            symbolizer_refresh(sym);
+            last_refresh = time(NULL);
+        }
+    }
+
+    for (int i = 0; i < ring_count; i++) {
+        ioctl(rings[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+        drain_ring(&rings[i], page_size, comm, sym, &table, &samples, &lost);
+        munmap(rings[i].meta, rings[i].map_size);
+        close(rings[i].fd);
+    }
+    symbolizer_destroy(sym);
+
+    FILE *out = fopen(output_path, "w");
+    if (!out) {
+        perror("Failed to open profile output");
+        folded_table_free(&table);
+        return 0;
+    }
+    for (size_t i = 0; i < table.capacity; i++) {
+        if (table.entries[i].stack) {
+            fprintf(out, "%s %lu\n", table.entries[i].stack, table.entries[i].count);
+        }
+    }
+    fclose(out);
+
+    printf("Collected %lu samples (%lu lost), %zu unique stacks\n", samples, lost, table.used);
+    printf("Folded stacks written to %s\n", output_path);
+    printf("Render with: flamegraph.pl %s > profile.svg\n", output_path);
+    folded_table_free(&table);
+    return 1;
+}
+
+#endif